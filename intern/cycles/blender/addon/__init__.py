@@ -71,6 +71,9 @@ class CyclesRender(bpy.types.RenderEngine):
     def bake(self, scene, obj, pass_type, pass_filter, object_id, pixel_array, num_pixels, depth, result):
         engine.bake(self, obj, pass_type, pass_filter, object_id, pixel_array, num_pixels, depth, result)
 
+    def bake_multi(self, scene, jobs, num_jobs, pass_type, pass_filter, depth):
+        engine.bake_multi(self, jobs, num_jobs, pass_type, pass_filter, depth)
+
     # viewport render
     def view_update(self, context):
         if not self.session:
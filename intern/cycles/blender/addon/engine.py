@@ -151,6 +151,20 @@ def bake(engine, obj, pass_type, pass_filter, object_id, pixel_array, num_pixels
         _cycles.bake(engine.session, obj.as_pointer(), pass_type, pass_filter, object_id, pixel_array.as_pointer(), num_pixels, depth, result.as_pointer())
 
 
+# jobs is the first of num_jobs BakeJob, all baked with a single scene synchronization
+def bake_multi(engine, jobs, num_jobs, pass_type, pass_filter, depth):
+    import _cycles
+    session = getattr(engine, "session", None)
+    if session is not None:
+        job_list = []
+        job = jobs
+        for i in range(num_jobs):
+            job_list.append((job.object.as_pointer(), pass_type, pass_filter, job.object_id,
+                             job.pixel_array.as_pointer(), job.num_pixels, depth, job.result.as_pointer()))
+            job = job.next
+        _cycles.bake_multi(engine.session, job_list)
+
+
 def reset(engine, data, scene):
     import _cycles
     data = data.as_pointer()
@@ -857,12 +857,79 @@ void BlenderSync::sync_curve_settings()
 		curve_system_manager->tag_update(scene);
 }
 
-void BlenderSync::sync_curves(Mesh *mesh,
-                              BL::Mesh& b_mesh,
-                              BL::Object& b_ob,
-                              bool motion,
-                              int time_index)
+void BlenderSync::sync_curves_extract(Mesh *mesh,
+                                      BL::Mesh& b_mesh,
+                                      BL::Object& b_ob,
+                                      bool motion,
+                                      CurveSyncData *data)
+{
+	/* obtain general settings */
+	data->use_curves = scene->curve_system_manager->use_curves &&
+	                   b_ob.mode() != b_ob.mode_PARTICLE_EDIT;
+
+	if(!data->use_curves)
+		return;
+
+	/* extract particle hair data - should be combined with connecting to mesh later*/
+
+	if(!preview)
+		set_resolution(&b_ob, &b_scene, true);
+
+	ObtainCacheParticleData(mesh, &b_mesh, &b_ob, &data->CData, !preview);
+
+	data->tfm = get_transform(b_ob.matrix_world());
+
+	if(!motion) {
+		/* generated coordinates texture space */
+		if(mesh->need_attribute(scene, ATTR_STD_GENERATED))
+			mesh_texture_space(b_mesh, data->texspace_loc, data->texspace_size);
+
+		/* vertex colors */
+		BL::Mesh::tessface_vertex_colors_iterator l;
+		int vcol_num = 0;
+
+		for(b_mesh.tessface_vertex_colors.begin(l); l != b_mesh.tessface_vertex_colors.end(); ++l, vcol_num++) {
+			ustring name = ustring(l->name().c_str());
+
+			if(!mesh->need_attribute(scene, name))
+				continue;
+
+			ObtainCacheParticleVcol(mesh, &b_mesh, &b_ob, &data->CData, !preview, vcol_num);
+
+			data->vcol_layers.push_back(CurveSyncLayer(name, false));
+			data->vcol_layers.back().data.steal_data(data->CData.curve_vcol);
+		}
+
+		/* UVs */
+		BL::Mesh::tessface_uv_textures_iterator t;
+		int uv_num = 0;
+
+		for(b_mesh.tessface_uv_textures.begin(t); t != b_mesh.tessface_uv_textures.end(); ++t, uv_num++) {
+			bool active_render = t->active_render();
+			AttributeStandard std = (active_render)? ATTR_STD_UV: ATTR_STD_NONE;
+			ustring name = ustring(t->name().c_str());
+
+			if(!(mesh->need_attribute(scene, name) || mesh->need_attribute(scene, std)))
+				continue;
+
+			ObtainCacheParticleUV(mesh, &b_mesh, &b_ob, &data->CData, !preview, uv_num);
+
+			data->uv_layers.push_back(CurveSyncLayer(name, active_render));
+			data->uv_layers.back().data.steal_data(data->CData.curve_uv);
+		}
+	}
+
+	if(!preview)
+		set_resolution(&b_ob, &b_scene, false);
+}
+
+void BlenderSync::sync_curves_build(Mesh *mesh,
+                                    CurveSyncData *data,
+                                    bool motion,
+                                    int time_index)
 {
+	/* Might be run from the geometry task pool, only builds Cycles data
+	 * from what sync_curves_extract() read from Blender. */
 	if(!motion) {
 		/* Clear stored curve data */
 		mesh->curve_keys.clear();
@@ -872,10 +939,7 @@ void BlenderSync::sync_curves(Mesh *mesh,
 		mesh->curve_attributes.clear();
 	}
 
-	/* obtain general settings */
-	bool use_curves = scene->curve_system_manager->use_curves;
-
-	if(!(use_curves && b_ob.mode() != b_ob.mode_PARTICLE_EDIT)) {
+	if(!data->use_curves) {
 		if(!motion)
 			mesh->compute_bounds();
 		return;
@@ -888,14 +952,7 @@ void BlenderSync::sync_curves(Mesh *mesh,
 	size_t tri_num = mesh->num_triangles();
 	int used_res = 1;
 
-	/* extract particle hair data - should be combined with connecting to mesh later*/
-
-	ParticleCurveData CData;
-
-	if(!preview)
-		set_resolution(&b_ob, &b_scene, true);
-
-	ObtainCacheParticleData(mesh, &b_mesh, &b_ob, &CData, !preview);
+	ParticleCurveData& CData = data->CData;
 
 	/* add hair geometry to mesh */
 	if(primitive == CURVE_TRIANGLES) {
@@ -908,8 +965,7 @@ void BlenderSync::sync_curves(Mesh *mesh,
 				RotCam = -make_float3(ctfm.x.z, ctfm.y.z, ctfm.z.z);
 			}
 			else {
-				Transform tfm = get_transform(b_ob.matrix_world());
-				Transform itfm = transform_quick_inverse(tfm);
+				Transform itfm = transform_quick_inverse(data->tfm);
 				RotCam = transform_point(&itfm, make_float3(ctfm.x.w,
 				                                            ctfm.y.w,
 				                                            ctfm.z.w));
@@ -933,8 +989,7 @@ void BlenderSync::sync_curves(Mesh *mesh,
 	 * blender to handle deforming objects */
 	if(!motion) {
 		if(mesh->need_attribute(scene, ATTR_STD_GENERATED)) {
-			float3 loc, size;
-			mesh_texture_space(b_mesh, loc, size);
+			float3 loc = data->texspace_loc, size = data->texspace_size;
 
 			if(primitive == CURVE_TRIANGLES) {
 				Attribute *attr_generated = mesh->attributes.add(ATTR_STD_GENERATED);
@@ -957,18 +1012,14 @@ void BlenderSync::sync_curves(Mesh *mesh,
 
 	/* create vertex color attributes */
 	if(!motion) {
-		BL::Mesh::tessface_vertex_colors_iterator l;
-		int vcol_num = 0;
+		for(size_t layer = 0; layer < data->vcol_layers.size(); layer++) {
+			CurveSyncLayer& l = data->vcol_layers[layer];
 
-		for(b_mesh.tessface_vertex_colors.begin(l); l != b_mesh.tessface_vertex_colors.end(); ++l, vcol_num++) {
-			if(!mesh->need_attribute(scene, ustring(l->name().c_str())))
-				continue;
-
-			ObtainCacheParticleVcol(mesh, &b_mesh, &b_ob, &CData, !preview, vcol_num);
+			CData.curve_vcol.steal_data(l.data);
 
 			if(primitive == CURVE_TRIANGLES) {
 				Attribute *attr_vcol = mesh->attributes.add(
-					ustring(l->name().c_str()), TypeDesc::TypeColor, ATTR_ELEMENT_CORNER_BYTE);
+					l.name, TypeDesc::TypeColor, ATTR_ELEMENT_CORNER_BYTE);
 
 				uchar4 *cdata = attr_vcol->data_uchar4();
 
@@ -976,7 +1027,7 @@ void BlenderSync::sync_curves(Mesh *mesh,
 			}
 			else {
 				Attribute *attr_vcol = mesh->curve_attributes.add(
-					ustring(l->name().c_str()), TypeDesc::TypeColor, ATTR_ELEMENT_CURVE);
+					l.name, TypeDesc::TypeColor, ATTR_ELEMENT_CURVE);
 
 				float3 *fdata = attr_vcol->data_float3();
 
@@ -993,55 +1044,56 @@ void BlenderSync::sync_curves(Mesh *mesh,
 
 	/* create UV attributes */
 	if(!motion) {
-		BL::Mesh::tessface_uv_textures_iterator l;
-		int uv_num = 0;
+		for(size_t layer = 0; layer < data->uv_layers.size(); layer++) {
+			CurveSyncLayer& l = data->uv_layers[layer];
+			AttributeStandard std = (l.active_render)? ATTR_STD_UV: ATTR_STD_NONE;
+			Attribute *attr_uv;
 
-		for(b_mesh.tessface_uv_textures.begin(l); l != b_mesh.tessface_uv_textures.end(); ++l, uv_num++) {
-			bool active_render = l->active_render();
-			AttributeStandard std = (active_render)? ATTR_STD_UV: ATTR_STD_NONE;
-			ustring name = ustring(l->name().c_str());
-
-			/* UV map */
-			if(mesh->need_attribute(scene, name) || mesh->need_attribute(scene, std)) {
-				Attribute *attr_uv;
+			CData.curve_uv.steal_data(l.data);
 
-				ObtainCacheParticleUV(mesh, &b_mesh, &b_ob, &CData, !preview, uv_num);
-
-				if(primitive == CURVE_TRIANGLES) {
-					if(active_render)
-						attr_uv = mesh->attributes.add(std, name);
-					else
-						attr_uv = mesh->attributes.add(name, TypeDesc::TypePoint, ATTR_ELEMENT_CORNER);
+			if(primitive == CURVE_TRIANGLES) {
+				if(l.active_render)
+					attr_uv = mesh->attributes.add(std, l.name);
+				else
+					attr_uv = mesh->attributes.add(l.name, TypeDesc::TypePoint, ATTR_ELEMENT_CORNER);
 
-					float3 *uv = attr_uv->data_float3();
+				float3 *uv = attr_uv->data_float3();
 
-					ExportCurveTriangleUV(&CData, tri_num * 3, used_res, uv);
-				}
-				else {
-					if(active_render)
-						attr_uv = mesh->curve_attributes.add(std, name);
-					else
-						attr_uv = mesh->curve_attributes.add(name, TypeDesc::TypePoint,  ATTR_ELEMENT_CURVE);
+				ExportCurveTriangleUV(&CData, tri_num * 3, used_res, uv);
+			}
+			else {
+				if(l.active_render)
+					attr_uv = mesh->curve_attributes.add(std, l.name);
+				else
+					attr_uv = mesh->curve_attributes.add(l.name, TypeDesc::TypePoint,  ATTR_ELEMENT_CURVE);
 
-					float3 *uv = attr_uv->data_float3();
+				float3 *uv = attr_uv->data_float3();
 
-					if(uv) {
-						size_t i = 0;
+				if(uv) {
+					size_t i = 0;
 
-						for(size_t curve = 0; curve < CData.curve_uv.size(); curve++)
-							if(!(CData.curve_keynum[curve] <= 1 || CData.curve_length[curve] == 0.0f))
-								uv[i++] = CData.curve_uv[curve];
-					}
+					for(size_t curve = 0; curve < CData.curve_uv.size(); curve++)
+						if(!(CData.curve_keynum[curve] <= 1 || CData.curve_length[curve] == 0.0f))
+							uv[i++] = CData.curve_uv[curve];
 				}
 			}
 		}
 	}
 
-	if(!preview)
-		set_resolution(&b_ob, &b_scene, false);
-
 	mesh->compute_bounds();
 }
 
+void BlenderSync::sync_curves(Mesh *mesh,
+                              BL::Mesh& b_mesh,
+                              BL::Object& b_ob,
+                              bool motion,
+                              int time_index)
+{
+	CurveSyncData data;
+
+	sync_curves_extract(mesh, b_mesh, b_ob, motion, &data);
+	sync_curves_build(mesh, &data, motion, time_index);
+}
+
 CCL_NAMESPACE_END
 
@@ -30,6 +30,7 @@
 #include "util_foreach.h"
 #include "util_logging.h"
 #include "util_math.h"
+#include "util_task.h"
 
 #include "mikktspace.h"
 
@@ -184,6 +185,41 @@ static void mikk_set_tangent_space(const SMikkTSpaceContext *context, const floa
 	userdata->tangent[face*4 + vert] = make_float4(T[0], T[1], T[2], sign);
 }
 
+/* Spread the work of the tangent space generation over the task scheduler,
+ * ranges are run by the pool's own thread too so this can be used from the
+ * geometry conversion tasks. */
+#define MIKK_PARALLEL_CHUNK_SIZE 1024
+
+static void mikk_run_range(void (*func)(void *data, const int start, const int end),
+                           void *data,
+                           const int start,
+                           const int end)
+{
+	func(data, start, end);
+}
+
+static void mikk_run_parallel(const SMikkTSpaceContext * /*context*/,
+                              const int num_items,
+                              void (*func)(void *data, const int start, const int end),
+                              void *data)
+{
+	if(num_items <= MIKK_PARALLEL_CHUNK_SIZE) {
+		func(data, 0, num_items);
+		return;
+	}
+
+	TaskPool pool;
+
+	for(int start = 0; start < num_items; start += MIKK_PARALLEL_CHUNK_SIZE) {
+		int end = min(start + MIKK_PARALLEL_CHUNK_SIZE, num_items);
+		pool.push(function_bind(&mikk_run_range, func, data, start, end));
+	}
+
+	pool.wait_work();
+}
+
+#undef MIKK_PARALLEL_CHUNK_SIZE
+
 static void mikk_compute_tangents(BL::Mesh& b_mesh,
                                   BL::MeshTextureFaceLayer *b_layer,
                                   Mesh *mesh,
@@ -204,6 +240,7 @@ static void mikk_compute_tangents(BL::Mesh& b_mesh,
 	sm_interface.m_getTexCoord = mikk_get_texture_coordinate;
 	sm_interface.m_getNormal = mikk_get_normal;
 	sm_interface.m_setTSpaceBasic = mikk_set_tangent_space;
+	sm_interface.m_runParallel = mikk_run_parallel;
 
 	/* setup context */
 	SMikkTSpaceContext context;
@@ -775,7 +812,8 @@ static void create_subd_mesh(Scene *scene,
                              BL::Mesh& b_mesh,
                              const vector<Shader*>& used_shaders,
                              float dicing_rate,
-                             int max_subdivisions)
+                             int max_subdivisions,
+                             bool use_dice_cache)
 {
 	BL::SubsurfModifier subsurf_mod(b_ob.modifiers[b_ob.modifiers.length()-1]);
 	bool subdivide_uvs = subsurf_mod.use_subsurf_uv();
@@ -815,8 +853,8 @@ static void create_subd_mesh(Scene *scene,
 
 	sdparams.dicing_rate = max(0.1f, RNA_float_get(&cobj, "dicing_rate") * dicing_rate);
 	sdparams.max_level = max_subdivisions;
+	sdparams.use_dice_cache = use_dice_cache;
 
-	scene->camera->update();
 	sdparams.camera = scene->camera;
 	sdparams.objecttoworld = get_transform(b_ob.matrix_world());
 }
@@ -860,18 +898,12 @@ static void sync_mesh_fluid_motion(BL::Object& b_ob, Scene *scene, Mesh *mesh)
 	}
 }
 
-Mesh *BlenderSync::sync_mesh(BL::Object& b_ob,
+Mesh *BlenderSync::sync_mesh(BL::Object& b_parent,
+                             BL::Object& b_ob,
                              bool object_updated,
-                             bool hide_tris)
+                             bool hide_tris,
+                             TaskPool *geom_task_pool)
 {
-	/* When viewport display is not needed during render we can force some
-	 * caches to be releases from blender side in order to reduce peak memory
-	 * footprint during synchronization process.
-	 */
-	const bool is_interface_locked = b_engine.render() &&
-	                                 b_engine.render().use_lock_interface();
-	const bool can_free_caches = BlenderSession::headless || is_interface_locked;
-
 	/* test if we can instance or if the object is modified */
 	BL::ID b_ob_data = b_ob.data();
 	BL::ID key = (BKE_object_is_modified(b_ob))? b_ob: b_ob_data;
@@ -947,6 +979,8 @@ Mesh *BlenderSync::sync_mesh(BL::Object& b_ob,
 	mesh->used_shaders = used_shaders;
 	mesh->name = ustring(b_ob_data.name().c_str());
 
+	BL::Mesh b_mesh(PointerRNA_NULL);
+
 	if(requested_geometry_flags != Mesh::GEOMETRY_NONE) {
 		/* mesh objects does have special handle in the dependency graph,
 		 * they're ensured to have properly updated.
@@ -961,34 +995,96 @@ Mesh *BlenderSync::sync_mesh(BL::Object& b_ob,
 
 		mesh->subdivision_type = object_subdivision_type(b_ob, preview, experimental);
 
-		BL::Mesh b_mesh = object_to_mesh(b_data, b_ob, b_scene, true, !preview, need_undeformed, mesh->subdivision_type);
+		/* dicing uses the camera matrices, update them here rather than
+		 * from the conversion tasks which run in parallel */
+		if(mesh->subdivision_type != Mesh::SUBDIVISION_NONE)
+			scene->camera->update();
 
-		if(b_mesh) {
-			if(render_layer.use_surfaces && !hide_tris) {
-				if(mesh->subdivision_type != Mesh::SUBDIVISION_NONE)
-					create_subd_mesh(scene, mesh, b_ob, b_mesh, used_shaders,
-					                 dicing_rate, max_subdivisions);
-				else
-					create_mesh(scene, mesh, b_mesh, used_shaders, false);
+		/* Creating the derived mesh adds it to the Main database, so it is
+		 * done here on the main thread, only the conversion is threaded. */
+		b_mesh = object_to_mesh(b_data, b_ob, b_scene, true, !preview, need_undeformed, mesh->subdivision_type);
+	}
+	mesh->geometry_flags = requested_geometry_flags;
 
-				create_mesh_volume_attributes(scene, b_ob, mesh, b_scene.frame_current());
-			}
+	/* Tag the mesh for update right away, so the object sync which follows
+	 * sees the change before the conversion task is finished. Topology
+	 * changes are detected by the conversion and tagged once it's finished. */
+	mesh->tag_update(scene, false);
 
-			if(render_layer.use_hair && mesh->subdivision_type == Mesh::SUBDIVISION_NONE)
-				sync_curves(mesh, b_mesh, b_ob, false);
+	/* the conversion creates the motion attributes from these settings */
+	sync_mesh_motion_blur(b_parent, b_ob, mesh);
 
-			if(can_free_caches) {
-				b_ob.cache_release();
-			}
+	/* Reading the hair updates the particle systems, which is not safe to do
+	 * from the conversion tasks, only the curves are built there. */
+	CurveSyncData *curve_data = NULL;
+
+	if(b_mesh && render_layer.use_hair && mesh->subdivision_type == Mesh::SUBDIVISION_NONE &&
+	   !progress.get_cancel())
+	{
+		curve_data = new CurveSyncData();
+		sync_curves_extract(mesh, b_mesh, b_ob, false, curve_data);
+	}
+
+	if(geom_task_pool) {
+		geom_task_pool->push(function_bind(&BlenderSync::sync_mesh_geometry,
+		                                   this,
+		                                   b_ob,
+		                                   b_mesh,
+		                                   mesh,
+		                                   hide_tris,
+		                                   oldtriangle,
+		                                   oldcurve_keys,
+		                                   oldcurve_radius,
+		                                   curve_data));
+	}
+	else {
+		sync_mesh_geometry(b_ob,
+		                   b_mesh,
+		                   mesh,
+		                   hide_tris,
+		                   oldtriangle,
+		                   oldcurve_keys,
+		                   oldcurve_radius,
+		                   curve_data);
+		sync_mesh_geometry_free();
+	}
 
-			/* free derived mesh */
-			b_data.meshes.remove(b_mesh, false);
+	return mesh;
+}
+
+void BlenderSync::sync_mesh_geometry(BL::Object b_ob,
+                                     BL::Mesh b_mesh,
+                                     Mesh *mesh,
+                                     bool hide_tris,
+                                     const array<int>& oldtriangle,
+                                     const array<float3>& oldcurve_keys,
+                                     const array<float>& oldcurve_radius,
+                                     CurveSyncData *curve_data)
+{
+	/* Might be run from the geometry task pool, so only the derived mesh of
+	 * this object is read and the Cycles mesh modified here. The hair was read
+	 * from the particle systems by the main thread into curve_data. */
+	if(b_mesh && !progress.get_cancel()) {
+		if(render_layer.use_surfaces && !hide_tris) {
+			if(mesh->subdivision_type != Mesh::SUBDIVISION_NONE)
+				create_subd_mesh(scene, mesh, b_ob, b_mesh, mesh->used_shaders,
+				                 dicing_rate, max_subdivisions,
+				                 preview || scene->params.persistent_data);
+			else
+				create_mesh(scene, mesh, b_mesh, mesh->used_shaders, false);
+
+			create_mesh_volume_attributes(scene, b_ob, mesh, b_scene.frame_current());
 		}
+
+		if(curve_data)
+			sync_curves_build(mesh, curve_data, false, 0);
 	}
-	mesh->geometry_flags = requested_geometry_flags;
+
+	delete curve_data;
 
 	/* fluid motion */
-	sync_mesh_fluid_motion(b_ob, scene, mesh);
+	if(!progress.get_cancel())
+		sync_mesh_fluid_motion(b_ob, scene, mesh);
 
 	/* tag update */
 	bool rebuild = false;
@@ -1014,9 +1110,60 @@ Mesh *BlenderSync::sync_mesh(BL::Object& b_ob,
 			rebuild = true;
 	}
 	
-	mesh->tag_update(scene, rebuild);
+	/* the derived mesh is freed and the mesh tagged by the main thread */
+	thread_scoped_lock lock(geom_sync_done_mutex);
+	geom_sync_done.push_back(GeometrySyncResult(b_ob, b_mesh, mesh, rebuild));
+}
 
-	return mesh;
+void BlenderSync::sync_mesh_geometry_free()
+{
+	/* When viewport display is not needed during render we can force some
+	 * caches to be releases from blender side in order to reduce peak memory
+	 * footprint during synchronization process.
+	 */
+	const bool is_interface_locked = b_engine.render() &&
+	                                 b_engine.render().use_lock_interface();
+	const bool can_free_caches = BlenderSession::headless || is_interface_locked;
+
+	/* take the finished conversions, so tasks finishing meanwhile don't
+	 * wait for the derived meshes to be freed */
+	vector<GeometrySyncResult> done;
+	{
+		thread_scoped_lock lock(geom_sync_done_mutex);
+		done.swap(geom_sync_done);
+	}
+
+	for(size_t i = 0; i < done.size(); i++) {
+		GeometrySyncResult& result = done[i];
+
+		if(result.rebuild)
+			result.mesh->tag_update(scene, true);
+
+		if(!result.b_mesh)
+			continue;
+
+		if(can_free_caches) {
+			result.b_ob.cache_release();
+		}
+
+		/* free derived mesh */
+		b_data.meshes.remove(result.b_mesh, false);
+	}
+}
+
+void BlenderSync::sync_mesh_motion_blur(BL::Object& b_parent,
+                                        BL::Object& b_ob,
+                                        Mesh *mesh)
+{
+	if(scene->need_motion() != Scene::MOTION_BLUR)
+		return;
+
+	mesh->use_motion_blur = false;
+
+	if(object_use_motion(b_parent, b_ob) && object_use_deform_motion(b_parent, b_ob)) {
+		mesh->motion_steps = object_motion_steps(b_ob);
+		mesh->use_motion_blur = true;
+	}
 }
 
 void BlenderSync::sync_mesh_motion(BL::Object& b_ob,
@@ -32,6 +32,7 @@
 #include "util_foreach.h"
 #include "util_hash.h"
 #include "util_logging.h"
+#include "util_task.h"
 
 CCL_NAMESPACE_BEGIN
 
@@ -244,7 +245,8 @@ Object *BlenderSync::sync_object(BL::Object& b_parent,
                                  float motion_time,
                                  bool hide_tris,
                                  BlenderObjectCulling& culling,
-                                 bool *use_portal)
+                                 bool *use_portal,
+                                 TaskPool *geom_task_pool)
 {
 	BL::Object b_ob = (b_dupli_ob ? b_dupli_ob.object() : b_parent);
 	bool motion = motion_time != 0.0f;
@@ -311,7 +313,7 @@ Object *BlenderSync::sync_object(BL::Object& b_parent,
 	bool use_holdout = (layer_flag & render_layer.holdout_layer) != 0;
 	
 	/* mesh sync */
-	object->mesh = sync_mesh(b_ob, object_updated, hide_tris);
+	object->mesh = sync_mesh(b_parent, b_ob, object_updated, hide_tris, geom_task_pool);
 
 	/* special case not tracked by object update flags */
 
@@ -358,14 +360,12 @@ Object *BlenderSync::sync_object(BL::Object& b_parent,
 		if(scene->need_motion() == Scene::MOTION_BLUR && object->mesh) {
 			Mesh *mesh = object->mesh;
 
-			mesh->use_motion_blur = false;
+			/* meshes synced in this update got their settings before the
+			 * conversion was pushed, and might still be converting */
+			if(mesh_synced.find(mesh) == mesh_synced.end())
+				sync_mesh_motion_blur(b_parent, b_ob, mesh);
 
 			if(object_use_motion(b_parent, b_ob)) {
-				if(object_use_deform_motion(b_parent, b_ob)) {
-					mesh->motion_steps = object_motion_steps(b_ob);
-					mesh->use_motion_blur = true;
-				}
-
 				vector<float> times = object->motion_times();
 				foreach(float time, times)
 					motion_times.insert(time);
@@ -503,6 +503,10 @@ void BlenderSync::sync_objects(BL::SpaceView3D& b_v3d, float motion_time)
 	/* initialize culling */
 	BlenderObjectCulling culling(scene, b_scene);
 
+	/* conversion of mesh and curve geometry is pushed to this pool by
+	 * sync_mesh(), so multiple meshes are converted in parallel */
+	TaskPool geom_task_pool;
+
 	/* object loop */
 	BL::Scene::object_bases_iterator b_base;
 	BL::Scene b_sce = b_scene;
@@ -563,7 +567,8 @@ void BlenderSync::sync_objects(BL::SpaceView3D& b_v3d, float motion_time)
 							                             motion_time,
 							                             hide_tris,
 							                             culling,
-							                             &use_portal);
+							                             &use_portal,
+							                             &geom_task_pool);
 
 							/* sync possible particle data, note particle_id
 							 * starts counting at 1, first is dummy particle */
@@ -592,14 +597,24 @@ void BlenderSync::sync_objects(BL::SpaceView3D& b_v3d, float motion_time)
 					            motion_time,
 					            hide_tris,
 					            culling,
-					            &use_portal);
+					            &use_portal,
+					            &geom_task_pool);
 				}
 			}
 
 			cancel = progress.get_cancel();
+
+			/* free the derived meshes of finished conversions */
+			sync_mesh_geometry_free();
 		}
 	}
 
+	/* wait for geometry conversion, tasks skip the conversion when
+	 * cancelled but still hand back their derived mesh to be freed */
+	geom_task_pool.wait_work();
+
+	sync_mesh_geometry_free();
+
 	progress.set_sync_status("");
 
 	if(!cancel && !motion) {
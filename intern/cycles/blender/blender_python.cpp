@@ -318,6 +318,57 @@ static PyObject *bake_func(PyObject * /*self*/, PyObject *args)
 	Py_RETURN_NONE;
 }
 
+/* sequence of (object, pass_type, pass_filter, object_id, pixel_array, num_pixels, depth, result)
+ * tuples, with pixel_array and result passed as pointers, baked with a single scene sync */
+static PyObject *bake_multi_func(PyObject * /*self*/, PyObject *args)
+{
+	PyObject *pysession, *pyjobs;
+
+	if(!PyArg_ParseTuple(args, "OO", &pysession, &pyjobs))
+		return NULL;
+
+	BlenderSession *session = (BlenderSession*)PyLong_AsVoidPtr(pysession);
+
+	PyObject *pyjobs_fast = PySequence_Fast(pyjobs, "bake jobs must be a sequence");
+	if(pyjobs_fast == NULL)
+		return NULL;
+
+	Py_ssize_t num_jobs = PySequence_Fast_GET_SIZE(pyjobs_fast);
+	vector<BlenderBakeJob> jobs;
+
+	for(Py_ssize_t i = 0; i < num_jobs; i++) {
+		PyObject *pyjob = PySequence_Fast_GET_ITEM(pyjobs_fast, i);
+		PyObject *pyobject, *pypixel_array, *pyresult;
+		const char *pass_type;
+		int num_pixels, depth, object_id, pass_filter;
+
+		if(!PyArg_ParseTuple(pyjob, "OsiiOiiO", &pyobject, &pass_type, &pass_filter, &object_id, &pypixel_array, &num_pixels, &depth, &pyresult)) {
+			Py_DECREF(pyjobs_fast);
+			return NULL;
+		}
+
+		PointerRNA objectptr;
+		RNA_id_pointer_create((ID*)PyLong_AsVoidPtr(pyobject), &objectptr);
+		BL::Object b_object(objectptr);
+
+		PointerRNA bakepixelptr;
+		RNA_pointer_create(NULL, &RNA_BakePixel, PyLong_AsVoidPtr(pypixel_array), &bakepixelptr);
+		BL::BakePixel b_bake_pixel(bakepixelptr);
+
+		jobs.push_back(BlenderBakeJob(b_object, pass_type, pass_filter, object_id, b_bake_pixel, (size_t)num_pixels, depth, (float *)PyLong_AsVoidPtr(pyresult)));
+	}
+
+	Py_DECREF(pyjobs_fast);
+
+	python_thread_state_save(&session->python_thread_state);
+
+	session->bake(jobs);
+
+	python_thread_state_restore(&session->python_thread_state);
+
+	Py_RETURN_NONE;
+}
+
 static PyObject *draw_func(PyObject * /*self*/, PyObject *args)
 {
 	PyObject *pysession, *pyv3d, *pyrv3d;
@@ -697,6 +748,7 @@ static PyMethodDef methods[] = {
 	{"free", free_func, METH_O, ""},
 	{"render", render_func, METH_O, ""},
 	{"bake", bake_func, METH_VARARGS, ""},
+	{"bake_multi", bake_multi_func, METH_VARARGS, ""},
 	{"draw", draw_func, METH_VARARGS, ""},
 	{"sync", sync_func, METH_O, ""},
 	{"reset", reset_func, METH_VARARGS, ""},
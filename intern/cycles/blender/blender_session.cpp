@@ -34,7 +34,9 @@
 #include "util_function.h"
 #include "util_hash.h"
 #include "util_logging.h"
+#include "util_map.h"
 #include "util_progress.h"
+#include "util_task.h"
 #include "util_time.h"
 
 #include "blender_sync.h"
@@ -574,7 +576,7 @@ void BlenderSession::render()
 
 static void populate_bake_data(BakeData *data, const
                                int object_id,
-                               BL::BakePixel& pixel_array,
+                               BL::BakePixel pixel_array,
                                const int num_pixels)
 {
 	BL::BakePixel bp = pixel_array;
@@ -624,13 +626,17 @@ void BlenderSession::bake(BL::Object& b_object,
                           const int object_id,
                           BL::BakePixel& pixel_array,
                           const size_t num_pixels,
-                          const int /*depth*/,
+                          const int depth,
                           float result[])
 {
-	ShaderEvalType shader_type = get_shader_type(pass_type);
-	size_t object_index = OBJECT_NONE;
-	int tri_offset = 0;
+	vector<BlenderBakeJob> jobs;
+	jobs.push_back(BlenderBakeJob(b_object, pass_type, pass_filter, object_id, pixel_array, num_pixels, depth, result));
 
+	bake(jobs);
+}
+
+void BlenderSession::bake(vector<BlenderBakeJob>& jobs)
+{
 	/* Set baking flag in advance, so kernel loading can check if we need
 	 * any baking capabilities.
 	 */
@@ -642,24 +648,32 @@ void BlenderSession::bake(BL::Object& b_object,
 	if(session->progress.get_cancel())
 		return;
 
-	if(shader_type == SHADER_EVAL_UV) {
-		/* force UV to be available */
-		Pass::add(PASS_UV, scene->film->passes);
-	}
+	vector<BakeJob> bake_jobs;
+
+	foreach(BlenderBakeJob& job, jobs) {
+		ShaderEvalType shader_type = get_shader_type(job.pass_type);
 
-	int bake_pass_filter = bake_pass_filter_get(pass_filter);
-	bake_pass_filter = BakeManager::shader_type_to_pass_filter(shader_type, bake_pass_filter);
+		if(shader_type == SHADER_EVAL_UV) {
+			/* force UV to be available */
+			Pass::add(PASS_UV, scene->film->passes);
+		}
+
+		int bake_pass_filter = bake_pass_filter_get(job.pass_filter);
+		bake_pass_filter = BakeManager::shader_type_to_pass_filter(shader_type, bake_pass_filter);
+
+		/* force use_light_pass to be true if we bake more than just colors */
+		if(bake_pass_filter & ~BAKE_FILTER_COLOR) {
+			Pass::add(PASS_LIGHT, scene->film->passes);
+		}
 
-	/* force use_light_pass to be true if we bake more than just colors */
-	if(bake_pass_filter & ~BAKE_FILTER_COLOR) {
-		Pass::add(PASS_LIGHT, scene->film->passes);
+		bake_jobs.push_back(BakeJob(shader_type, bake_pass_filter, NULL, job.result));
 	}
 
 	/* create device and update scene */
 	scene->film->tag_update(scene);
 	scene->integrator->tag_update(scene);
 
-	/* update scene */
+	/* update scene, done once for all objects and passes */
 	BL::Object b_camera_override(b_engine.camera_override());
 	sync->sync_camera(b_render, b_camera_override, width, height, "");
 	sync->sync_data(b_render,
@@ -680,20 +694,35 @@ void BlenderSession::bake(BL::Object& b_object,
 	session->reset(buffer_params, session_params.samples);
 	session->update_scene();
 
-	/* find object index. todo: is arbitrary - copied from mesh_displace.cpp */
-	for(size_t i = 0; i < scene->objects.size(); i++) {
-		if(strcmp(scene->objects[i]->name.c_str(), b_object.name().c_str()) == 0) {
-			object_index = i;
-			tri_offset = scene->objects[i]->mesh->tri_offset;
-			break;
+	/* find object indices. todo: is arbitrary - copied from mesh_displace.cpp */
+	map<string, size_t> object_index_map;
+
+	for(size_t i = scene->objects.size(); i > 0; i--)
+		object_index_map[scene->objects[i - 1]->name.string()] = i - 1;
+
+	/* fill in bake data of all jobs in parallel */
+	TaskPool pool;
+
+	for(size_t i = 0; i < jobs.size(); i++) {
+		BlenderBakeJob& job = jobs[i];
+		map<string, size_t>::iterator it = object_index_map.find(job.b_object.name());
+		size_t object_index = OBJECT_NONE;
+		int tri_offset = 0;
+
+		if(it != object_index_map.end()) {
+			object_index = it->second;
+			tri_offset = scene->objects[object_index]->mesh->tri_offset;
 		}
-	}
 
-	int object = object_index;
+		int object = object_index;
 
-	BakeData *bake_data = scene->bake_manager->init(object, tri_offset, num_pixels);
+		BakeData *bake_data = scene->bake_manager->init(object, tri_offset, job.num_pixels);
+		bake_jobs[i].bake_data = bake_data;
+
+		pool.push(function_bind(&populate_bake_data, bake_data, job.object_id, job.pixel_array, (int)job.num_pixels));
+	}
 
-	populate_bake_data(bake_data, object_id, pixel_array, num_pixels);
+	pool.wait_work();
 
 	/* set number of samples */
 	session->tile_manager.set_samples(session_params.samples);
@@ -702,7 +731,7 @@ void BlenderSession::bake(BL::Object& b_object,
 
 	session->progress.set_update_callback(function_bind(&BlenderSession::update_bake_progress, this));
 
-	scene->bake_manager->bake(scene->device, &scene->dscene, scene, session->progress, shader_type, bake_pass_filter, bake_data, result);
+	scene->bake_manager->bake(scene->device, &scene->dscene, scene, session->progress, bake_jobs);
 
 	/* free all memory used (host and device), so we wouldn't leave render
 	 * engine with extra memory allocated
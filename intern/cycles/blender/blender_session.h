@@ -31,6 +31,33 @@ class Session;
 class RenderBuffers;
 class RenderTile;
 
+/* Pixels of one object to be baked into one result buffer, several of these
+ * can be baked with a single scene synchronization. */
+
+struct BlenderBakeJob {
+	BlenderBakeJob(BL::Object& b_object,
+	               const string& pass_type,
+	               const int pass_filter,
+	               const int object_id,
+	               BL::BakePixel& pixel_array,
+	               const size_t num_pixels,
+	               const int depth,
+	               float *result)
+	: b_object(b_object), pass_type(pass_type), pass_filter(pass_filter),
+	  object_id(object_id), pixel_array(pixel_array), num_pixels(num_pixels),
+	  depth(depth), result(result)
+	{}
+
+	BL::Object b_object;
+	string pass_type;
+	int pass_filter;
+	int object_id;
+	BL::BakePixel pixel_array;
+	size_t num_pixels;
+	int depth;
+	float *result;
+};
+
 class BlenderSession {
 public:
 	BlenderSession(BL::RenderEngine& b_engine,
@@ -68,6 +95,7 @@ public:
 	          const size_t num_pixels,
 	          const int depth,
 	          float pixels[]);
+	void bake(vector<BlenderBakeJob>& jobs);
 
 	void write_render_result(BL::RenderResult& b_rr,
 	                         BL::RenderLayer& b_rlay,
@@ -24,11 +24,13 @@
 
 #include "blender_util.h"
 
+#include "curves.h"
 #include "scene.h"
 #include "session.h"
 
 #include "util_map.h"
 #include "util_set.h"
+#include "util_thread.h"
 #include "util_transform.h"
 #include "util_vector.h"
 
@@ -46,6 +48,7 @@ class Scene;
 class Shader;
 class ShaderGraph;
 class ShaderNode;
+class TaskPool;
 
 class BlenderSync {
 public:
@@ -94,6 +97,28 @@ public:
 	                                      int width, int height);
 
 private:
+	/* Hair read from the particle systems of an object. Reading it switches the
+	 * particle resolution, so it is done on the main thread, the curves are then
+	 * built from it by sync_curves_build() which may run in the geometry task pool. */
+	struct CurveSyncLayer {
+		CurveSyncLayer(ustring name, bool active_render)
+		: name(name), active_render(active_render) {}
+
+		ustring name;
+		bool active_render;
+		array<float3> data;
+	};
+	struct CurveSyncData {
+		CurveSyncData() : use_curves(false) {}
+
+		bool use_curves;
+		ParticleCurveData CData;
+		Transform tfm;
+		float3 texspace_loc, texspace_size;
+		vector<CurveSyncLayer> vcol_layers;
+		vector<CurveSyncLayer> uv_layers;
+	};
+
 	/* sync */
 	void sync_lamps(bool update_all);
 	void sync_materials(bool update_all);
@@ -110,12 +135,37 @@ private:
 	void sync_curve_settings();
 
 	void sync_nodes(Shader *shader, BL::ShaderNodeTree& b_ntree);
-	Mesh *sync_mesh(BL::Object& b_ob, bool object_updated, bool hide_tris);
+	Mesh *sync_mesh(BL::Object& b_parent,
+	                BL::Object& b_ob,
+	                bool object_updated,
+	                bool hide_tris,
+	                TaskPool *geom_task_pool);
+	void sync_mesh_geometry(BL::Object b_ob,
+	                        BL::Mesh b_mesh,
+	                        Mesh *mesh,
+	                        bool hide_tris,
+	                        const array<int>& oldtriangle,
+	                        const array<float3>& oldcurve_keys,
+	                        const array<float>& oldcurve_radius,
+	                        CurveSyncData *curve_data);
+	void sync_mesh_geometry_free();
+	void sync_mesh_motion_blur(BL::Object& b_parent,
+	                           BL::Object& b_ob,
+	                           Mesh *mesh);
 	void sync_curves(Mesh *mesh,
 	                 BL::Mesh& b_mesh,
 	                 BL::Object& b_ob,
 	                 bool motion,
 	                 int time_index = 0);
+	void sync_curves_extract(Mesh *mesh,
+	                         BL::Mesh& b_mesh,
+	                         BL::Object& b_ob,
+	                         bool motion,
+	                         CurveSyncData *data);
+	void sync_curves_build(Mesh *mesh,
+	                       CurveSyncData *data,
+	                       bool motion,
+	                       int time_index);
 	Object *sync_object(BL::Object& b_parent,
 	                    int persistent_id[OBJECT_PERSISTENT_ID_SIZE],
 	                    BL::DupliObject& b_dupli_ob,
@@ -124,7 +174,8 @@ private:
 	                    float motion_time,
 	                    bool hide_tris,
 	                    BlenderObjectCulling& culling,
-	                    bool *use_portal);
+	                    bool *use_portal,
+	                    TaskPool *geom_task_pool);
 	void sync_light(BL::Object& b_parent,
 	                int persistent_id[OBJECT_PERSISTENT_ID_SIZE],
 	                BL::Object& b_ob,
@@ -165,6 +216,19 @@ private:
 	id_map<ParticleSystemKey, ParticleSystem> particle_system_map;
 	set<Mesh*> mesh_synced;
 	set<Mesh*> mesh_motion_synced;
+	/* Finished conversions of the geometry task pool, the derived mesh is freed
+	 * and the mesh tagged for update from the main thread. */
+	struct GeometrySyncResult {
+		GeometrySyncResult(BL::Object b_ob, BL::Mesh b_mesh, Mesh *mesh, bool rebuild)
+		: b_ob(b_ob), b_mesh(b_mesh), mesh(mesh), rebuild(rebuild) {}
+
+		BL::Object b_ob;
+		BL::Mesh b_mesh;
+		Mesh *mesh;
+		bool rebuild;
+	};
+	vector<GeometrySyncResult> geom_sync_done;
+	thread_mutex geom_sync_done_mutex;
 	set<float> motion_times;
 	void *world_map;
 	bool world_recalc;
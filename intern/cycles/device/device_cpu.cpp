@@ -223,40 +223,40 @@ public:
 		KernelGlobals kg = thread_kernel_globals_init();
 		RenderTile tile;
 
-		void(*path_trace_kernel)(KernelGlobals*, float*, unsigned int*, int, int, int, int, int);
+		void(*path_trace_kernel)(KernelGlobals*, float*, unsigned int*, int, int, int, int, int, int);
 
 #ifdef WITH_CYCLES_OPTIMIZED_KERNEL_AVX2
 		if(system_cpu_support_avx2()) {
-			path_trace_kernel = kernel_cpu_avx2_path_trace;
+			path_trace_kernel = kernel_cpu_avx2_path_trace_packet;
 		}
 		else
 #endif
 #ifdef WITH_CYCLES_OPTIMIZED_KERNEL_AVX
 		if(system_cpu_support_avx()) {
-			path_trace_kernel = kernel_cpu_avx_path_trace;
+			path_trace_kernel = kernel_cpu_avx_path_trace_packet;
 		}
 		else
 #endif
 #ifdef WITH_CYCLES_OPTIMIZED_KERNEL_SSE41
 		if(system_cpu_support_sse41()) {
-			path_trace_kernel = kernel_cpu_sse41_path_trace;
+			path_trace_kernel = kernel_cpu_sse41_path_trace_packet;
 		}
 		else
 #endif
 #ifdef WITH_CYCLES_OPTIMIZED_KERNEL_SSE3
 		if(system_cpu_support_sse3()) {
-			path_trace_kernel = kernel_cpu_sse3_path_trace;
+			path_trace_kernel = kernel_cpu_sse3_path_trace_packet;
 		}
 		else
 #endif
 #ifdef WITH_CYCLES_OPTIMIZED_KERNEL_SSE2
 		if(system_cpu_support_sse2()) {
-			path_trace_kernel = kernel_cpu_sse2_path_trace;
+			path_trace_kernel = kernel_cpu_sse2_path_trace_packet;
 		}
 		else
 #endif
 		{
-			path_trace_kernel = kernel_cpu_path_trace;
+			path_trace_kernel = kernel_cpu_path_trace_packet;
 		}
 		
 		while(task.acquire_tile(this, tile)) {
@@ -271,11 +271,11 @@ public:
 						break;
 				}
 
+				/* trace rows at once, so the kernel can intersect camera
+				 * rays of neighbouring pixels together */
 				for(int y = tile.y; y < tile.y + tile.h; y++) {
-					for(int x = tile.x; x < tile.x + tile.w; x++) {
-						path_trace_kernel(&kg, render_buffer, rng_state,
-						                  sample, x, y, tile.offset, tile.stride);
-					}
+					path_trace_kernel(&kg, render_buffer, rng_state,
+					                  sample, tile.x, y, tile.w, tile.offset, tile.stride);
 				}
 
 				tile.sample = sample + 1;
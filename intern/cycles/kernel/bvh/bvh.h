@@ -66,6 +66,13 @@ CCL_NAMESPACE_BEGIN
 #  include "bvh_traversal.h"
 #endif
 
+/* Packet BVH traversal for coherent rays */
+
+#if defined(__KERNEL_CPU__) && defined(__QBVH__)
+#  define __BVH_PACKET__
+#  include "bvh_packet.h"
+#endif
+
 /* Subsurface scattering BVH traversal */
 
 #if defined(__SUBSURFACE__)
@@ -201,6 +208,37 @@ ccl_device_intersect bool scene_intersect(KernelGlobals *kg,
 #endif /* __KERNEL_CPU__ */
 }
 
+#ifdef __KERNEL_CPU__
+/* Intersect a number of coherent rays, such as camera rays of neighbouring
+ * pixels, tracing them together as packets. Returns the mask of rays which
+ * were intersected, the others must be traced with scene_intersect(). */
+ccl_device_intersect int scene_intersect_packet(KernelGlobals *kg,
+                                                const Ray *rays,
+                                                Intersection *isects,
+                                                const uint visibility,
+                                                const int num_rays)
+{
+	int done_mask = 0;
+
+	kernel_assert(num_rays <= 32);
+
+#  ifdef __BVH_PACKET__
+	if(bvh_packet_supported(kg)) {
+		for(int i = 0; i < num_rays; i += BVH_PACKET_SIZE) {
+			int num_packet_rays = min(num_rays - i, BVH_PACKET_SIZE);
+			done_mask |= bvh_intersect_packet(kg,
+			                                  rays + i,
+			                                  isects + i,
+			                                  visibility,
+			                                  num_packet_rays) << i;
+		}
+	}
+#  endif  /* __BVH_PACKET__ */
+
+	return done_mask;
+}
+#endif  /* __KERNEL_CPU__ */
+
 #ifdef __SUBSURFACE__
 ccl_device_intersect void scene_intersect_subsurface(KernelGlobals *kg,
                                                      const Ray *ray,
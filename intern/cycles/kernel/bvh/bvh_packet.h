@@ -0,0 +1,342 @@
+/*
+ * Copyright 2011-2016, Blender Foundation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Packet traversal of the QBVH, intended for coherent rays such as camera
+ * rays of neighbouring pixels.
+ *
+ * All rays of a packet traverse the tree together, nodes are fetched once for
+ * the whole packet and each child box is tested against all rays at once with
+ * one ray per SIMD lane. Every stack entry keeps the mask of rays which entered
+ * it, so rays which missed a node don't pay for its subtree primitives.
+ *
+ * Only the simple case is supported: triangles without instancing, motion blur
+ * or hair. Rays must share direction signs, so the same near and far planes
+ * can be used for the whole packet. */
+
+#define BVH_PACKET_SIZE 4
+
+struct QBVHPacketStackItem {
+	int addr;
+	/* Rays of the packet which intersected the node. */
+	int mask;
+	/* Entry distance of every ray. */
+	ssef dist;
+};
+
+ccl_device_inline bool bvh_packet_supported(KernelGlobals *kg)
+{
+	return kernel_data.bvh.use_qbvh &&
+	       !kernel_data.bvh.have_motion &&
+	       !kernel_data.bvh.have_curves &&
+	       !kernel_data.bvh.have_instancing;
+}
+
+/* Intersect rays of the packet with all four children of a node, returns mask
+ * of rays hitting each child and their entry distances. */
+
+ccl_device_inline void qbvh_packet_node_intersect(KernelGlobals *ccl_restrict kg,
+                                                  const sse3f& org,
+                                                  const sse3f& idir,
+                                                  const ssef& isect_far,
+                                                  const int ray_mask,
+                                                  const int near_x,
+                                                  const int near_y,
+                                                  const int near_z,
+                                                  const int far_x,
+                                                  const int far_y,
+                                                  const int far_z,
+                                                  const int node_addr,
+                                                  int child_mask[4],
+                                                  ssef child_dist[4])
+{
+	const int offset = node_addr + 1;
+	const ssef bnear_x = kernel_tex_fetch_ssef(__bvh_nodes, offset+near_x);
+	const ssef bnear_y = kernel_tex_fetch_ssef(__bvh_nodes, offset+near_y);
+	const ssef bnear_z = kernel_tex_fetch_ssef(__bvh_nodes, offset+near_z);
+	const ssef bfar_x = kernel_tex_fetch_ssef(__bvh_nodes, offset+far_x);
+	const ssef bfar_y = kernel_tex_fetch_ssef(__bvh_nodes, offset+far_y);
+	const ssef bfar_z = kernel_tex_fetch_ssef(__bvh_nodes, offset+far_z);
+	const ssef isect_near(0.0f);
+
+	for(int i = 0; i < 4; i++) {
+		const ssef tnear_x = (ssef(bnear_x.f[i]) - org.x) * idir.x;
+		const ssef tnear_y = (ssef(bnear_y.f[i]) - org.y) * idir.y;
+		const ssef tnear_z = (ssef(bnear_z.f[i]) - org.z) * idir.z;
+		const ssef tfar_x = (ssef(bfar_x.f[i]) - org.x) * idir.x;
+		const ssef tfar_y = (ssef(bfar_y.f[i]) - org.y) * idir.y;
+		const ssef tfar_z = (ssef(bfar_z.f[i]) - org.z) * idir.z;
+
+		const ssef tnear = max4(tnear_x, tnear_y, tnear_z, isect_near);
+		const ssef tfar = min4(tfar_x, tfar_y, tfar_z, isect_far);
+
+		child_mask[i] = (int)movemask(tnear <= tfar) & ray_mask;
+		child_dist[i] = tnear;
+	}
+}
+
+/* Closest entry distance of the rays in the mask, used to order children. */
+
+ccl_device_inline float qbvh_packet_min_dist(const ssef& dist, int mask)
+{
+	float min_dist = FLT_MAX;
+
+	while(mask != 0) {
+		int i = __bscf(mask);
+		min_dist = min(min_dist, dist.f[i]);
+	}
+
+	return min_dist;
+}
+
+/* Returns the mask of rays traced by the packet, rays which don't have the same
+ * direction signs as the first one are left for the caller to trace. */
+
+ccl_device int bvh_intersect_packet(KernelGlobals *kg,
+                                    const Ray *rays,
+                                    Intersection *isects,
+                                    const uint visibility,
+                                    const int num_rays)
+{
+	kernel_assert(num_rays <= BVH_PACKET_SIZE);
+
+	/* Traversal stack in thread-local memory. */
+	QBVHPacketStackItem traversal_stack[BVH_QSTACK_SIZE];
+	traversal_stack[0].addr = ENTRYPOINT_SENTINEL;
+
+	/* Ray parameters, one ray per lane. Inactive lanes get a negative
+	 * distance so they never hit anything. */
+	float3 P[BVH_PACKET_SIZE];
+	IsectPrecalc isect_precalc[BVH_PACKET_SIZE];
+	sse3f org4(ssef(0.0f), ssef(0.0f), ssef(0.0f));
+	sse3f idir4(ssef(1.0f), ssef(1.0f), ssef(1.0f));
+	ssef tfar(-1.0f);
+
+	int ray_mask = 0;
+	int done_mask = 0;
+	int sign_mask = -1;
+
+	for(int i = 0; i < num_rays; i++) {
+		const Ray *ray = &rays[i];
+		Intersection *isect = &isects[i];
+
+		isect->t = ray->t;
+		isect->u = 0.0f;
+		isect->v = 0.0f;
+		isect->prim = PRIM_NONE;
+		isect->object = OBJECT_NONE;
+
+		BVH_DEBUG_INIT();
+
+		float3 dir = bvh_clamp_direction(ray->D);
+		float3 idir = bvh_inverse_direction(dir);
+		int ray_sign_mask = ((idir.x < 0.0f)? 1: 0) |
+		                    ((idir.y < 0.0f)? 2: 0) |
+		                    ((idir.z < 0.0f)? 4: 0);
+
+		if(!isfinite(ray->P.x)) {
+			/* Can't hit anything, same as single ray traversal. */
+			done_mask |= (1 << i);
+			continue;
+		}
+		else if(sign_mask == -1) {
+			sign_mask = ray_sign_mask;
+		}
+		else if(ray_sign_mask != sign_mask) {
+			/* Incoherent ray, leave it for the caller. */
+			continue;
+		}
+
+		P[i] = ray->P;
+		triangle_intersect_precalc(dir, &isect_precalc[i]);
+
+		org4.x.f[i] = P[i].x;
+		org4.y.f[i] = P[i].y;
+		org4.z.f[i] = P[i].z;
+		idir4.x.f[i] = idir.x;
+		idir4.y.f[i] = idir.y;
+		idir4.z.f[i] = idir.z;
+		tfar.f[i] = ray->t;
+
+		ray_mask |= (1 << i);
+	}
+
+	done_mask |= ray_mask;
+
+	if(ray_mask == 0) {
+		return done_mask;
+	}
+
+	/* Offsets to select the side that becomes the lower or upper bound,
+	 * shared by all rays of the packet. */
+	const int near_x = 0 + (sign_mask & 1), far_x = 1 - (sign_mask & 1);
+	const int near_y = 2 + ((sign_mask & 2) >> 1), far_y = 3 - ((sign_mask & 2) >> 1);
+	const int near_z = 4 + ((sign_mask & 4) >> 2), far_z = 5 - ((sign_mask & 4) >> 2);
+
+	/* Traversal variables in registers. */
+	int stack_ptr = 0;
+	int node_addr = kernel_data.bvh.root;
+	int node_mask = ray_mask;
+	ssef node_dist(-FLT_MAX);
+
+	/* Traversal loop. */
+	do {
+		/* Traverse internal nodes. */
+		while(node_addr >= 0 && node_addr != ENTRYPOINT_SENTINEL) {
+			float4 inodes = kernel_tex_fetch(__bvh_nodes, node_addr+0);
+
+			/* Drop rays which found a closer hit since the node was pushed. */
+			node_mask &= (int)movemask(node_dist <= tfar);
+
+			if(node_mask == 0
+#ifdef __VISIBILITY_FLAG__
+			   || (__float_as_uint(inodes.x) & visibility) == 0
+#endif
+			   )
+			{
+				/* Pop. */
+				node_addr = traversal_stack[stack_ptr].addr;
+				node_mask = traversal_stack[stack_ptr].mask;
+				node_dist = traversal_stack[stack_ptr].dist;
+				--stack_ptr;
+				continue;
+			}
+
+			int child_mask[4];
+			ssef child_dist[4];
+
+			qbvh_packet_node_intersect(kg,
+			                           org4,
+			                           idir4,
+			                           tfar,
+			                           node_mask,
+			                           near_x, near_y, near_z,
+			                           far_x, far_y, far_z,
+			                           node_addr,
+			                           child_mask,
+			                           child_dist);
+
+#ifdef __KERNEL_DEBUG__
+			for(int i = 0; i < BVH_PACKET_SIZE; i++) {
+				if(node_mask & (1 << i))
+					++isects[i].num_traversal_steps;
+			}
+#endif
+
+			/* Sort hit children by closest ray entry distance. */
+			float4 cnodes = kernel_tex_fetch(__bvh_nodes, node_addr+7);
+			int hit_child[4];
+			float hit_dist[4];
+			int num_hit = 0;
+
+			for(int i = 0; i < 4; i++) {
+				if(child_mask[i] == 0)
+					continue;
+
+				float d = qbvh_packet_min_dist(child_dist[i], child_mask[i]);
+				int j = num_hit++;
+
+				for(; j > 0 && hit_dist[j - 1] < d; j--) {
+					hit_child[j] = hit_child[j - 1];
+					hit_dist[j] = hit_dist[j - 1];
+				}
+
+				hit_child[j] = i;
+				hit_dist[j] = d;
+			}
+
+			if(num_hit == 0) {
+				/* Pop. */
+				node_addr = traversal_stack[stack_ptr].addr;
+				node_mask = traversal_stack[stack_ptr].mask;
+				node_dist = traversal_stack[stack_ptr].dist;
+				--stack_ptr;
+				continue;
+			}
+
+			/* Push farther children, continue with the closest one. */
+			for(int j = 0; j < num_hit - 1; j++) {
+				int i = hit_child[j];
+				++stack_ptr;
+				kernel_assert(stack_ptr < BVH_QSTACK_SIZE);
+				traversal_stack[stack_ptr].addr = __float_as_int(cnodes[i]);
+				traversal_stack[stack_ptr].mask = child_mask[i];
+				traversal_stack[stack_ptr].dist = child_dist[i];
+			}
+
+			int i = hit_child[num_hit - 1];
+			node_addr = __float_as_int(cnodes[i]);
+			node_mask = child_mask[i];
+			node_dist = child_dist[i];
+		}
+
+		/* If node is leaf, intersect its triangles with the rays in the mask. */
+		if(node_addr < 0) {
+			float4 leaf = kernel_tex_fetch(__bvh_leaf_nodes, (-node_addr-1));
+
+			node_mask &= (int)movemask(node_dist <= tfar);
+
+			if(node_mask != 0
+#ifdef __VISIBILITY_FLAG__
+			   && (__float_as_uint(leaf.z) & visibility) != 0
+#endif
+			   )
+			{
+				int prim_addr = __float_as_int(leaf.x);
+				const int prim_addr2 = __float_as_int(leaf.y);
+				const uint type = __float_as_int(leaf.w);
+
+				kernel_assert((type & PRIMITIVE_ALL) == PRIMITIVE_TRIANGLE);
+				(void)type;
+
+				for(; prim_addr < prim_addr2; prim_addr++) {
+					kernel_assert(kernel_tex_fetch(__prim_type, prim_addr) == type);
+
+					int mask = node_mask;
+					while(mask != 0) {
+						int i = __bscf(mask);
+						Intersection *isect = &isects[i];
+
+						BVH_DEBUG_NEXT_STEP();
+						if(triangle_intersect(kg,
+						                      &isect_precalc[i],
+						                      isect,
+						                      P[i],
+						                      visibility,
+						                      OBJECT_NONE,
+						                      prim_addr))
+						{
+							tfar.f[i] = isect->t;
+
+							/* Shadow ray early termination. */
+							if(visibility == PATH_RAY_SHADOW_OPAQUE) {
+								tfar.f[i] = -1.0f;
+								node_mask &= ~(1 << i);
+							}
+						}
+					}
+				}
+			}
+
+			/* Pop. */
+			node_addr = traversal_stack[stack_ptr].addr;
+			node_mask = traversal_stack[stack_ptr].mask;
+			node_dist = traversal_stack[stack_ptr].dist;
+			--stack_ptr;
+		}
+	} while(node_addr != ENTRYPOINT_SENTINEL);
+
+	return done_mask;
+}
@@ -577,7 +577,8 @@ ccl_device_inline float4 kernel_path_integrate(KernelGlobals *kg,
                                                RNG *rng,
                                                int sample,
                                                Ray ray,
-                                               ccl_global float *buffer)
+                                               ccl_global float *buffer,
+                                               const Intersection *camera_isect)
 {
 	/* initialize */
 	PathRadiance L;
@@ -611,26 +612,36 @@ ccl_device_inline float4 kernel_path_integrate(KernelGlobals *kg,
 		/* intersect scene */
 		Intersection isect;
 		uint visibility = path_state_ray_visibility(kg, &state);
-
+		bool hit;
+
+		if(camera_isect != NULL) {
+			/* camera ray was already traced together with neighbouring pixels */
+			kernel_assert(visibility == PATH_RAY_CAMERA);
+			isect = *camera_isect;
+			hit = (isect.prim != PRIM_NONE);
+			camera_isect = NULL;
+		}
+		else {
 #ifdef __HAIR__
-		float difl = 0.0f, extmax = 0.0f;
-		uint lcg_state = 0;
-
-		if(kernel_data.bvh.have_curves) {
-			if((kernel_data.cam.resolution == 1) && (state.flag & PATH_RAY_CAMERA)) {	
-				float3 pixdiff = ray.dD.dx + ray.dD.dy;
-				/*pixdiff = pixdiff - dot(pixdiff, ray.D)*ray.D;*/
-				difl = kernel_data.curve.minimum_width * len(pixdiff) * 0.5f;
-			}
+			float difl = 0.0f, extmax = 0.0f;
+			uint lcg_state = 0;
+
+			if(kernel_data.bvh.have_curves) {
+				if((kernel_data.cam.resolution == 1) && (state.flag & PATH_RAY_CAMERA)) {	
+					float3 pixdiff = ray.dD.dx + ray.dD.dy;
+					/*pixdiff = pixdiff - dot(pixdiff, ray.D)*ray.D;*/
+					difl = kernel_data.curve.minimum_width * len(pixdiff) * 0.5f;
+				}
 
-			extmax = kernel_data.curve.maximum_width;
-			lcg_state = lcg_state_init(rng, &state, 0x51633e2d);
-		}
+				extmax = kernel_data.curve.maximum_width;
+				lcg_state = lcg_state_init(rng, &state, 0x51633e2d);
+			}
 
-		bool hit = scene_intersect(kg, ray, visibility, &isect, &lcg_state, difl, extmax);
+			hit = scene_intersect(kg, ray, visibility, &isect, &lcg_state, difl, extmax);
 #else
-		bool hit = scene_intersect(kg, ray, visibility, &isect, NULL, 0.0f, 0.0f);
+			hit = scene_intersect(kg, ray, visibility, &isect, NULL, 0.0f, 0.0f);
 #endif  /* __HAIR__ */
+		}
 
 #ifdef __KERNEL_DEBUG__
 		if(state.flag & PATH_RAY_CAMERA) {
@@ -919,7 +930,7 @@ ccl_device void kernel_path_trace(KernelGlobals *kg,
 	float4 L;
 
 	if(ray.t != 0.0f)
-		L = kernel_path_integrate(kg, &rng, sample, ray, buffer);
+		L = kernel_path_integrate(kg, &rng, sample, ray, buffer, NULL);
 	else
 		L = make_float4(0.0f, 0.0f, 0.0f, 0.0f);
 
@@ -929,5 +940,72 @@ ccl_device void kernel_path_trace(KernelGlobals *kg,
 	path_rng_end(kg, rng_state, rng);
 }
 
+#ifdef __KERNEL_CPU__
+
+#define PATH_TRACE_PACKET_SIZE 4
+
+/* Path trace a row of pixels, with the camera rays of neighbouring pixels
+ * intersected together as a packet, since they are highly coherent. */
+
+ccl_device void kernel_path_trace_packet(KernelGlobals *kg,
+	ccl_global float *buffer, ccl_global uint *rng_state,
+	int sample, int x, int y, int num_pixels, int offset, int stride)
+{
+	int pass_stride = kernel_data.film.pass_stride;
+
+	for(int start = 0; start < num_pixels; start += PATH_TRACE_PACKET_SIZE) {
+		int num = min(num_pixels - start, PATH_TRACE_PACKET_SIZE);
+
+		/* initialize random numbers and rays */
+		RNG rng[PATH_TRACE_PACKET_SIZE];
+		Ray ray[PATH_TRACE_PACKET_SIZE];
+		Ray packet_ray[PATH_TRACE_PACKET_SIZE];
+		Intersection packet_isect[PATH_TRACE_PACKET_SIZE];
+		int packet_index[PATH_TRACE_PACKET_SIZE];
+		int num_packet_rays = 0;
+
+		for(int i = 0; i < num; i++) {
+			int index = offset + x + start + i + y*stride;
+
+			kernel_path_trace_setup(kg, rng_state + index, sample, x + start + i, y, &rng[i], &ray[i]);
+
+			packet_index[i] = -1;
+			if(ray[i].t != 0.0f) {
+				packet_index[i] = num_packet_rays;
+				packet_ray[num_packet_rays++] = ray[i];
+			}
+		}
+
+		/* intersect camera rays, rays which could not be traced as part of
+		 * a packet are intersected by kernel_path_integrate() as usual */
+		int packet_mask = scene_intersect_packet(kg, packet_ray, packet_isect, PATH_RAY_CAMERA, num_packet_rays);
+
+		/* integrate */
+		for(int i = 0; i < num; i++) {
+			int index = offset + x + start + i + y*stride;
+			ccl_global float *pixel_buffer = buffer + index*pass_stride;
+			float4 L;
+
+			if(packet_index[i] != -1) {
+				const Intersection *camera_isect = NULL;
+
+				if(packet_mask & (1 << packet_index[i]))
+					camera_isect = &packet_isect[packet_index[i]];
+
+				L = kernel_path_integrate(kg, &rng[i], sample, ray[i], pixel_buffer, camera_isect);
+			}
+			else
+				L = make_float4(0.0f, 0.0f, 0.0f, 0.0f);
+
+			/* accumulate result in output buffer */
+			kernel_write_pass_float4(pixel_buffer, sample, L);
+
+			path_rng_end(kg, rng_state + index, rng[i]);
+		}
+	}
+}
+
+#endif  /* __KERNEL_CPU__ */
+
 CCL_NAMESPACE_END
 
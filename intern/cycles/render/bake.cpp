@@ -17,6 +17,8 @@
 #include "bake.h"
 #include "integrator.h"
 
+#include "util_foreach.h"
+
 CCL_NAMESPACE_BEGIN
 
 BakeData::BakeData(const int object, const size_t tri_offset, const size_t num_pixels):
@@ -97,7 +99,6 @@ uint4 BakeData::differentials(int i)
 
 BakeManager::BakeManager()
 {
-	m_bake_data = NULL;
 	m_is_baking = false;
 	need_update = true;
 	m_shader_limit = 512 * 512;
@@ -105,8 +106,7 @@ BakeManager::BakeManager()
 
 BakeManager::~BakeManager()
 {
-	if(m_bake_data)
-		delete m_bake_data;
+	free_bake_data();
 }
 
 bool BakeManager::get_baking()
@@ -121,8 +121,17 @@ void BakeManager::set_baking(const bool value)
 
 BakeData *BakeManager::init(const int object, const size_t tri_offset, const size_t num_pixels)
 {
-	m_bake_data = new BakeData(object, tri_offset, num_pixels);
-	return m_bake_data;
+	BakeData *bake_data = new BakeData(object, tri_offset, num_pixels);
+	m_bake_data.push_back(bake_data);
+	return bake_data;
+}
+
+void BakeManager::free_bake_data()
+{
+	foreach(BakeData *bake_data, m_bake_data)
+		delete bake_data;
+
+	m_bake_data.clear();
 }
 
 void BakeManager::set_shader_limit(const size_t x, const size_t y)
@@ -133,21 +142,98 @@ void BakeManager::set_shader_limit(const size_t x, const size_t y)
 
 bool BakeManager::bake(Device *device, DeviceScene *dscene, Scene *scene, Progress& progress, ShaderEvalType shader_type, const int pass_filter, BakeData *bake_data, float result[])
 {
-	size_t num_pixels = bake_data->size();
+	vector<BakeJob> jobs;
+	jobs.push_back(BakeJob(shader_type, pass_filter, bake_data, result));
 
-	int num_samples = is_aa_pass(shader_type)? scene->integrator->aa_samples : 1;
+	return bake(device, dscene, scene, progress, jobs);
+}
+
+bool BakeManager::bake(Device *device, DeviceScene *dscene, Scene *scene, Progress& progress, const vector<BakeJob>& jobs)
+{
+	/* group jobs which can be evaluated by the same device tasks */
+	vector<vector<int> > groups;
+
+	for(size_t i = 0; i < jobs.size(); i++) {
+		size_t g;
+
+		for(g = 0; g < groups.size(); g++) {
+			const BakeJob& job = jobs[groups[g][0]];
+
+			if(job.shader_type == jobs[i].shader_type && job.pass_filter == jobs[i].pass_filter)
+				break;
+		}
+
+		if(g == groups.size())
+			groups.push_back(vector<int>());
+
+		groups[g].push_back(i);
+	}
 
 	/* calculate the total pixel samples for the progress bar */
 	total_pixel_samples = 0;
-	for(size_t shader_offset = 0; shader_offset < num_pixels; shader_offset += m_shader_limit) {
-		size_t shader_size = (size_t)fminf(num_pixels - shader_offset, m_shader_limit);
-		total_pixel_samples += shader_size * num_samples;
+
+	foreach(const BakeJob& job, jobs) {
+		int num_samples = is_aa_pass(job.shader_type)? scene->integrator->aa_samples : 1;
+
+		for(size_t i = 0; i < job.bake_data->size(); i++) {
+			if(job.bake_data->is_valid(i))
+				total_pixel_samples += num_samples;
+		}
 	}
+
 	progress.reset_sample();
 	progress.set_total_pixel_samples(total_pixel_samples);
 
-	for(size_t shader_offset = 0; shader_offset < num_pixels; shader_offset += m_shader_limit) {
-		size_t shader_size = (size_t)fminf(num_pixels - shader_offset, m_shader_limit);
+	bool success = true;
+
+	foreach(const vector<int>& group, groups) {
+		if(!bake_points(device, dscene, scene, progress, jobs, group)) {
+			success = false;
+			break;
+		}
+	}
+
+	/* bake data created by init() is only needed for a single bake */
+	free_bake_data();
+
+	m_is_baking = false;
+	return success;
+}
+
+bool BakeManager::bake_points(Device *device,
+                              DeviceScene *dscene,
+                              Scene *scene,
+                              Progress& progress,
+                              const vector<BakeJob>& jobs,
+                              const vector<int>& group)
+{
+	ShaderEvalType shader_type = jobs[group[0]].shader_type;
+	int pass_filter = jobs[group[0]].pass_filter;
+	int num_samples = is_aa_pass(shader_type)? scene->integrator->aa_samples : 1;
+
+	/* gather valid pixels of all jobs, pixels without a primitive are not
+	 * written to the result so there is no need to evaluate them */
+	vector<int> point_job;
+	vector<size_t> point_pixel;
+
+	foreach(int j, group) {
+		BakeData *bake_data = jobs[j].bake_data;
+
+		for(size_t i = 0; i < bake_data->size(); i++) {
+			if(bake_data->is_valid(i)) {
+				point_job.push_back(j);
+				point_pixel.push_back(i);
+			}
+		}
+	}
+
+	size_t num_points = point_pixel.size();
+
+	if(num_points == 0)
+		return false;
+
+	for(size_t shader_offset = 0; shader_offset < num_points; shader_offset += m_shader_limit) {
+		size_t shader_size = min(num_points - shader_offset, m_shader_limit);
 
 		/* setup input for device task */
 		device_vector<uint4> d_input;
@@ -155,13 +241,10 @@ bool BakeManager::bake(Device *device, DeviceScene *dscene, Scene *scene, Progre
 		size_t d_input_size = 0;
 
 		for(size_t i = shader_offset; i < (shader_offset + shader_size); i++) {
-			d_input_data[d_input_size++] = bake_data->data(i);
-			d_input_data[d_input_size++] = bake_data->differentials(i);
-		}
+			BakeData *bake_data = jobs[point_job[i]].bake_data;
 
-		if(d_input_size == 0) {
-			m_is_baking = false;
-			return false;
+			d_input_data[d_input_size++] = bake_data->data(point_pixel[i]);
+			d_input_data[d_input_size++] = bake_data->differentials(point_pixel[i]);
 		}
 
 		/* run device task */
@@ -193,7 +276,6 @@ bool BakeManager::bake(Device *device, DeviceScene *dscene, Scene *scene, Progre
 		if(progress.get_cancel()) {
 			device->mem_free(d_input);
 			device->mem_free(d_output);
-			m_is_baking = false;
 			return false;
 		}
 
@@ -207,19 +289,17 @@ bool BakeManager::bake(Device *device, DeviceScene *dscene, Scene *scene, Progre
 		float4 *offset = (float4*)d_output.data_pointer;
 
 		size_t depth = 4;
-		for(size_t i=shader_offset; i < (shader_offset + shader_size); i++) {
-			size_t index = i * depth;
+		for(size_t i = shader_offset; i < (shader_offset + shader_size); i++) {
+			float *result = jobs[point_job[i]].result;
+			size_t index = point_pixel[i] * depth;
 			float4 out = offset[k++];
 
-			if(bake_data->is_valid(i)) {
-				for(size_t j=0; j < 4; j++) {
-					result[index + j] = out[j];
-				}
+			for(size_t j = 0; j < 4; j++) {
+				result[index + j] = out[j];
 			}
 		}
 	}
 
-	m_is_baking = false;
 	return true;
 }
 
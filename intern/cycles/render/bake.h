@@ -51,6 +51,23 @@ private:
 	vector<float>m_dvdy;
 };
 
+/* Bake Job
+ *
+ * Pixels of an object to be baked for a single pass. Multiple jobs are baked
+ * together, with the pixels of all jobs sharing the same shader type and pass
+ * filter evaluated by the same device tasks. */
+
+struct BakeJob {
+	BakeJob(ShaderEvalType shader_type, int pass_filter, BakeData *bake_data, float *result)
+	: shader_type(shader_type), pass_filter(pass_filter), bake_data(bake_data), result(result)
+	{}
+
+	ShaderEvalType shader_type;
+	int pass_filter;
+	BakeData *bake_data;
+	float *result;
+};
+
 class BakeManager {
 public:
 	BakeManager();
@@ -64,6 +81,7 @@ public:
 	void set_shader_limit(const size_t x, const size_t y);
 
 	bool bake(Device *device, DeviceScene *dscene, Scene *scene, Progress& progress, ShaderEvalType shader_type, const int pass_filter, BakeData *bake_data, float result[]);
+	bool bake(Device *device, DeviceScene *dscene, Scene *scene, Progress& progress, const vector<BakeJob>& jobs);
 
 	void device_update(Device *device, DeviceScene *dscene, Scene *scene, Progress& progress);
 	void device_free(Device *device, DeviceScene *dscene);
@@ -76,7 +94,15 @@ public:
 	int total_pixel_samples;
 
 private:
-	BakeData *m_bake_data;
+	bool bake_points(Device *device,
+	                 DeviceScene *dscene,
+	                 Scene *scene,
+	                 Progress& progress,
+	                 const vector<BakeJob>& jobs,
+	                 const vector<int>& group);
+	void free_bake_data();
+
+	vector<BakeData*> m_bake_data;
 	bool m_is_baking;
 	size_t m_shader_limit;
 };
@@ -30,7 +30,7 @@
 
 #include "osl_globals.h"
 
-#include "subd_split.h"
+#include "subd_dice_cache.h"
 #include "subd_patch_table.h"
 
 #include "util_foreach.h"
@@ -174,6 +174,7 @@ Mesh::Mesh()
 
 	subdivision_type = SUBDIVISION_NONE;
 	subd_params = NULL;
+	subd_dice_cache = NULL;
 
 	patch_table = NULL;
 }
@@ -183,6 +184,7 @@ Mesh::~Mesh()
 	delete bvh;
 	delete patch_table;
 	delete subd_params;
+	delete subd_dice_cache;
 }
 
 void Mesh::resize_mesh(int numverts, int numtris)
@@ -1743,8 +1745,7 @@ void MeshManager::device_update(Device *device, DeviceScene *dscene, Scene *scen
 
 			progress.set_status("Updating Mesh", msg);
 
-			DiagSplit dsplit(*mesh->subd_params);
-			mesh->tessellate(&dsplit);
+			mesh->tessellate();
 
 			i++;
 
@@ -40,7 +40,7 @@ class Scene;
 class SceneParams;
 class AttributeRequest;
 struct SubdParams;
-class DiagSplit;
+class SubdDiceCache;
 struct PackedPatchTable;
 
 /* Mesh */
@@ -158,6 +158,7 @@ public:
 	array<SubdEdgeCrease> subd_creases;
 
 	SubdParams *subd_params;
+	SubdDiceCache *subd_dice_cache;
 
 	vector<Shader*> used_shaders;
 	AttributeSet attributes;
@@ -254,7 +255,7 @@ public:
 	/* Check if the mesh should be treated as instanced. */
 	bool is_instanced() const;
 
-	void tessellate(DiagSplit *split);
+	void tessellate();
 };
 
 /* Mesh Manager */
@@ -18,7 +18,7 @@
 #include "attribute.h"
 #include "camera.h"
 
-#include "subd_split.h"
+#include "subd_dice_cache.h"
 #include "subd_patch.h"
 #include "subd_patch_table.h"
 
@@ -335,7 +335,7 @@ struct OsdPatch : Patch {
 
 #endif
 
-void Mesh::tessellate(DiagSplit *split)
+void Mesh::tessellate()
 {
 #ifdef WITH_OPENSUBDIV
 	OsdData osd_data;
@@ -365,6 +365,24 @@ void Mesh::tessellate(DiagSplit *split)
 	Attribute *attr_vN = subd_attributes.find(ATTR_STD_VERTEX_NORMAL);
 	float3* vN = attr_vN->data_float3();
 
+	/* count patches, so patch storage is not reallocated while gathering */
+	size_t num_patches = 0;
+
+	for(int f = 0; f < num_faces; f++) {
+		num_patches += subd_faces[f].num_ptex_faces();
+	}
+
+	vector<LinearQuadPatch> linear_patches;
+	linear_patches.reserve(num_patches);
+#ifdef WITH_OPENSUBDIV
+	vector<OsdPatch> osd_patches;
+	osd_patches.reserve(num_patches);
+#endif
+
+	/* top level patches to be split and diced */
+	vector<QuadDice::SubPatch> subpatches;
+	subpatches.reserve(num_patches + num_faces*3);
+
 	for(int f = 0; f < num_faces; f++) {
 		SubdFace& face = subd_faces[f];
 
@@ -372,11 +390,11 @@ void Mesh::tessellate(DiagSplit *split)
 			/* quad */
 			QuadDice::SubPatch subpatch;
 
-			LinearQuadPatch quad_patch;
 #ifdef WITH_OPENSUBDIV
-			OsdPatch osd_patch(&osd_data);
-
 			if(subdivision_type == SUBDIVISION_CATMULL_CLARK) {
+				osd_patches.push_back(OsdPatch(&osd_data));
+				OsdPatch& osd_patch = osd_patches.back();
+
 				osd_patch.patch_index = face.ptex_offset;
 
 				subpatch.patch = &osd_patch;
@@ -384,6 +402,9 @@ void Mesh::tessellate(DiagSplit *split)
 			else
 #endif
 			{
+				linear_patches.push_back(LinearQuadPatch());
+				LinearQuadPatch& quad_patch = linear_patches.back();
+
 				float3 *hull = quad_patch.hull;
 				float3 *normals = quad_patch.normals;
 
@@ -420,38 +441,46 @@ void Mesh::tessellate(DiagSplit *split)
 			subpatch.P10 = make_float2(0.5f, 0.0f);
 			subpatch.P01 = make_float2(0.0f, 0.5f);
 			subpatch.P11 = make_float2(0.5f, 0.5f);
-			split->split_quad(subpatch.patch, &subpatch);
+			subpatches.push_back(subpatch);
 
 			subpatch.P00 = make_float2(0.5f, 0.0f);
 			subpatch.P10 = make_float2(1.0f, 0.0f);
 			subpatch.P01 = make_float2(0.5f, 0.5f);
 			subpatch.P11 = make_float2(1.0f, 0.5f);
-			split->split_quad(subpatch.patch, &subpatch);
+			subpatches.push_back(subpatch);
 
 			subpatch.P00 = make_float2(0.0f, 0.5f);
 			subpatch.P10 = make_float2(0.5f, 0.5f);
 			subpatch.P01 = make_float2(0.0f, 1.0f);
 			subpatch.P11 = make_float2(0.5f, 1.0f);
-			split->split_quad(subpatch.patch, &subpatch);
+			subpatches.push_back(subpatch);
 
 			subpatch.P00 = make_float2(0.5f, 0.5f);
 			subpatch.P10 = make_float2(1.0f, 0.5f);
 			subpatch.P01 = make_float2(0.5f, 1.0f);
 			subpatch.P11 = make_float2(1.0f, 1.0f);
-			split->split_quad(subpatch.patch, &subpatch);
+			subpatches.push_back(subpatch);
 		}
 		else {
 			/* ngon */
-#ifdef WITH_OPENSUBDIV
-			if(subdivision_type == SUBDIVISION_CATMULL_CLARK) {
-				OsdPatch patch(&osd_data);
+			QuadDice::SubPatch subpatch;
 
-				patch.shader = face.shader;
+			subpatch.P00 = make_float2(0.0f, 0.0f);
+			subpatch.P10 = make_float2(1.0f, 0.0f);
+			subpatch.P01 = make_float2(0.0f, 1.0f);
+			subpatch.P11 = make_float2(1.0f, 1.0f);
 
+#ifdef WITH_OPENSUBDIV
+			if(subdivision_type == SUBDIVISION_CATMULL_CLARK) {
 				for(int corner = 0; corner < face.num_corners; corner++) {
+					osd_patches.push_back(OsdPatch(&osd_data));
+					OsdPatch& patch = osd_patches.back();
+
+					patch.shader = face.shader;
 					patch.patch_index = face.ptex_offset + corner;
 
-					split->split_quad(&patch);
+					subpatch.patch = &patch;
+					subpatches.push_back(subpatch);
 				}
 			}
 			else
@@ -467,7 +496,8 @@ void Mesh::tessellate(DiagSplit *split)
 				}
 
 				for(int corner = 0; corner < face.num_corners; corner++) {
-					LinearQuadPatch patch;
+					linear_patches.push_back(LinearQuadPatch());
+					LinearQuadPatch& patch = linear_patches.back();
 					float3 *hull = patch.hull;
 					float3 *normals = patch.normals;
 
@@ -499,12 +529,88 @@ void Mesh::tessellate(DiagSplit *split)
 						}
 					}
 
-					split->split_quad(&patch);
+					subpatch.patch = &patch;
+					subpatches.push_back(subpatch);
 				}
 			}
 		}
 	}
 
+	/* split and dice, reusing patches diced by the previous tessellation when
+	 * the dice cache is enabled */
+	SubdDiceCache *dice_cache = subd_dice_cache;
+
+	if(!subd_params->use_dice_cache) {
+		delete subd_dice_cache;
+		subd_dice_cache = NULL;
+		dice_cache = new SubdDiceCache();
+	}
+	else if(!subd_dice_cache) {
+		subd_dice_cache = dice_cache = new SubdDiceCache();
+	}
+
+	dice_cache->dice(this, *subd_params, subpatches);
+
+	/* copy diced patches into the mesh */
+	size_t num_diced_verts = 0;
+	size_t num_diced_tris = 0;
+
+	foreach(DicedPatch& diced, dice_cache->diced) {
+		num_diced_verts += diced.verts.size();
+		num_diced_tris += diced.triangles.size() / 3;
+	}
+
+	size_t vert_offset = verts.size();
+	size_t tri_offset = num_triangles();
+
+	attributes.add(ATTR_STD_VERTEX_NORMAL);
+
+	if(subd_params->ptex) {
+		attributes.add(ATTR_STD_PTEX_UV);
+		attributes.add(ATTR_STD_PTEX_FACE_ID);
+	}
+
+	resize_mesh(vert_offset + num_diced_verts, tri_offset + num_diced_tris);
+
+	float3 *mesh_N = attributes.find(ATTR_STD_VERTEX_NORMAL)->data_float3();
+	float3 *ptex_uv = (subd_params->ptex)? attributes.find(ATTR_STD_PTEX_UV)->data_float3(): NULL;
+	float *ptex_face_id = (subd_params->ptex)? attributes.find(ATTR_STD_PTEX_FACE_ID)->data_float(): NULL;
+
+	foreach(DicedPatch& diced, dice_cache->diced) {
+		for(size_t i = 0; i < diced.verts.size(); i++, vert_offset++) {
+			const DicedPatch::Vertex& vert = diced.verts[i];
+
+			verts[vert_offset] = vert.P;
+			mesh_N[vert_offset] = vert.N;
+			vert_patch_uv[vert_offset] = vert.uv;
+
+			if(ptex_uv) {
+				ptex_uv[vert_offset] = make_float3(vert.uv.x, vert.uv.y, 0.0f);
+			}
+		}
+
+		int patch_vert_offset = vert_offset - diced.verts.size();
+
+		for(size_t i = 0; i < diced.triangles.size(); i += 3, tri_offset++) {
+			triangles[tri_offset*3 + 0] = patch_vert_offset + diced.triangles[i + 0];
+			triangles[tri_offset*3 + 1] = patch_vert_offset + diced.triangles[i + 1];
+			triangles[tri_offset*3 + 2] = patch_vert_offset + diced.triangles[i + 2];
+			shader[tri_offset] = diced.shader;
+			smooth[tri_offset] = true;
+			triangle_patch[tri_offset] = diced.patch_index;
+
+			if(ptex_face_id) {
+				ptex_face_id[tri_offset] = (float)diced.ptex_face_id;
+			}
+		}
+	}
+
+	num_subd_verts += num_diced_verts;
+
+	if(dice_cache != subd_dice_cache) {
+		delete dice_cache;
+	}
+
 	/* interpolate center points for attributes */
 	foreach(Attribute& attr, subd_attributes.attributes) {
 #ifdef WITH_OPENSUBDIV
@@ -15,7 +15,6 @@
  */
 
 #include "camera.h"
-#include "mesh.h"
 
 #include "subd_dice.h"
 #include "subd_patch.h"
@@ -26,89 +25,37 @@ CCL_NAMESPACE_BEGIN
 
 /* EdgeDice Base */
 
-EdgeDice::EdgeDice(const SubdParams& params_)
-: params(params_)
+EdgeDice::EdgeDice(const SubdParams& params_, DicedPatch *diced_)
+: params(params_), diced(diced_)
 {
-	mesh_P = NULL;
-	mesh_N = NULL;
-	vert_offset = 0;
-
-	params.mesh->attributes.add(ATTR_STD_VERTEX_NORMAL);
-
-	if(params.ptex) {
-		params.mesh->attributes.add(ATTR_STD_PTEX_UV);
-		params.mesh->attributes.add(ATTR_STD_PTEX_FACE_ID);
-	}
+	vert_offset = diced->verts.size();
 }
 
 void EdgeDice::reserve(int num_verts)
 {
-	Mesh *mesh = params.mesh;
-
-	vert_offset = mesh->verts.size();
-	tri_offset = mesh->num_triangles();
-
-	/* todo: optimize so we can reserve in advance, this is like push_back_slow() */
-	if(vert_offset + num_verts > mesh->verts.capacity()) {
-		mesh->reserve_mesh(size_t((vert_offset + num_verts) * 1.2), mesh->num_triangles());
-	}
-
-	mesh->resize_mesh(vert_offset + num_verts, tri_offset);
-
-	Attribute *attr_vN = mesh->attributes.add(ATTR_STD_VERTEX_NORMAL);
-
-	mesh_P = mesh->verts.data();
-	mesh_N = attr_vN->data_float3();
+	vert_offset = diced->verts.size();
+	diced->verts.resize(vert_offset + num_verts);
 }
 
 int EdgeDice::add_vert(Patch *patch, float2 uv)
 {
-	float3 P, N;
-
-	patch->eval(&P, NULL, NULL, &N, uv.x, uv.y);
-
-	assert(vert_offset < params.mesh->verts.size());
+	assert(vert_offset < diced->verts.size());
 
-	mesh_P[vert_offset] = P;
-	mesh_N[vert_offset] = N;
-	params.mesh->vert_patch_uv[vert_offset] = make_float2(uv.x, uv.y);
-
-	if(params.ptex) {
-		Attribute *attr_ptex_uv = params.mesh->attributes.add(ATTR_STD_PTEX_UV);
-		params.mesh->attributes.resize();
-
-		float3 *ptex_uv = attr_ptex_uv->data_float3();
-		ptex_uv[vert_offset] = make_float3(uv.x, uv.y, 0.0f);
-	}
-
-	params.mesh->num_subd_verts++;
+	DicedPatch::Vertex& vert = diced->verts[vert_offset];
+	patch->eval(&vert.P, NULL, NULL, &vert.N, uv.x, uv.y);
+	vert.uv = uv;
 
 	return vert_offset++;
 }
 
-void EdgeDice::add_triangle(Patch *patch, int v0, int v1, int v2)
+void EdgeDice::add_triangle(int v0, int v1, int v2)
 {
-	Mesh *mesh = params.mesh;
-
-	/* todo: optimize so we can reserve in advance, this is like push_back_slow() */
-	if(mesh->triangles.size() == mesh->triangles.capacity())
-		mesh->reserve_mesh(mesh->verts.size(), size_t(max(mesh->num_triangles() + 1, 1) * 1.2));
-
-	mesh->add_triangle(v0, v1, v2, patch->shader, true);
-	params.mesh->triangle_patch[params.mesh->num_triangles()-1] = patch->patch_index;
-
-	if(params.ptex) {
-		Attribute *attr_ptex_face_id = params.mesh->attributes.add(ATTR_STD_PTEX_FACE_ID);
-		params.mesh->attributes.resize();
-
-		float *ptex_face_id = attr_ptex_face_id->data_float();
-		ptex_face_id[tri_offset] = (float)patch->ptex_face_id();
-	}
-
-	tri_offset++;
+	diced->triangles.push_back(v0);
+	diced->triangles.push_back(v1);
+	diced->triangles.push_back(v2);
 }
 
-void EdgeDice::stitch_triangles(Patch *patch, vector<int>& outer, vector<int>& inner)
+void EdgeDice::stitch_triangles(vector<int>& outer, vector<int>& inner)
 {
 	if(inner.size() == 0 || outer.size() == 0)
 		return; // XXX avoid crashes for Mu or Mv == 1, missing polygons
@@ -131,8 +78,8 @@ void EdgeDice::stitch_triangles(Patch *patch, vector<int>& outer, vector<int>& i
 		}
 		else {
 			/* length of diagonals */
-			float len1 = len_squared(mesh_P[inner[i]] - mesh_P[outer[j+1]]);
-			float len2 = len_squared(mesh_P[outer[j]] - mesh_P[inner[i+1]]);
+			float len1 = len_squared(diced->verts[inner[i]].P - diced->verts[outer[j+1]].P);
+			float len2 = len_squared(diced->verts[outer[j]].P - diced->verts[inner[i+1]].P);
 
 			/* use smallest diagonal */
 			if(len1 < len2)
@@ -141,14 +88,14 @@ void EdgeDice::stitch_triangles(Patch *patch, vector<int>& outer, vector<int>& i
 				v2 = inner[++i];
 		}
 
-		add_triangle(patch, v0, v1, v2);
+		add_triangle(v0, v1, v2);
 	}
 }
 
 /* QuadDice */
 
-QuadDice::QuadDice(const SubdParams& params_)
-: EdgeDice(params_)
+QuadDice::QuadDice(const SubdParams& params_, DicedPatch *diced_)
+: EdgeDice(params_, diced_)
 {
 }
 
@@ -298,8 +245,8 @@ void QuadDice::add_grid(SubPatch& sub, int Mu, int Mv, int offset)
 				int i3 = offset + 4 + i + j*(Mu-1);
 				int i4 = offset + 4 + (i-1) + j*(Mu-1);
 
-				add_triangle(sub.patch, i1, i2, i3);
-				add_triangle(sub.patch, i1, i3, i4);
+				add_triangle(i1, i2, i3);
+				add_triangle(i1, i3, i4);
 			}
 		}
 	}
@@ -321,7 +268,7 @@ void QuadDice::dice(SubPatch& sub, EdgeFactors& ef)
 	Mv = max((int)ceil(S*Mv), 2); // XXX handle 0 & 1?
 
 	/* reserve space for new verts */
-	int offset = params.mesh->verts.size();
+	int offset = diced->verts.size();
 	reserve(ef, Mu, Mv);
 
 	/* corners and inner grid */
@@ -332,21 +279,21 @@ void QuadDice::dice(SubPatch& sub, EdgeFactors& ef)
 	vector<int> outer, inner;
 
 	add_side_u(sub, outer, inner, Mu, Mv, ef.tu0, 0, offset);
-	stitch_triangles(sub.patch, outer, inner);
+	stitch_triangles(outer, inner);
 
 	/* top side */
 	add_side_u(sub, outer, inner, Mu, Mv, ef.tu1, 1, offset);
-	stitch_triangles(sub.patch, inner, outer);
+	stitch_triangles(inner, outer);
 
 	/* left side */
 	add_side_v(sub, outer, inner, Mu, Mv, ef.tv0, 0, offset);
-	stitch_triangles(sub.patch, inner, outer);
+	stitch_triangles(inner, outer);
 
 	/* right side */
 	add_side_v(sub, outer, inner, Mu, Mv, ef.tv1, 1, offset);
-	stitch_triangles(sub.patch, outer, inner);
+	stitch_triangles(outer, inner);
 
-	assert(vert_offset == params.mesh->verts.size());
+	assert(vert_offset == diced->verts.size());
 }
 
 CCL_NAMESPACE_END
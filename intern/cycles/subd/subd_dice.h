@@ -42,6 +42,11 @@ struct SubdParams {
 	Camera *camera;
 	Transform objecttoworld;
 
+	/* keep diced patches around for the next tessellation, and reuse them
+	 * when edge factors differ less than the given relative tolerance */
+	bool use_dice_cache;
+	float dice_cache_tolerance;
+
 	SubdParams(Mesh *mesh_, bool ptex_ = false)
 	{
 		mesh = mesh_;
@@ -52,28 +57,56 @@ struct SubdParams {
 		dicing_rate = 1.0f;
 		max_level = 12;
 		camera = NULL;
+
+		use_dice_cache = false;
+		dice_cache_tolerance = 0.1f;
 	}
 
 };
 
+/* Diced Patch
+ *
+ * Tessellation of a single top level patch, with vertex indices local to the
+ * patch. Patches are diced into their own storage so they can be diced in
+ * parallel and cached, and are appended to the mesh afterwards. */
+
+struct DicedPatch {
+	struct Vertex {
+		float3 P;
+		float3 N;
+		float2 uv;
+	};
+
+	vector<Vertex> verts;
+	vector<int> triangles;
+
+	int shader;
+	int patch_index;
+	int ptex_face_id;
+
+	void clear()
+	{
+		verts.clear();
+		triangles.clear();
+	}
+};
+
 /* EdgeDice Base */
 
 class EdgeDice {
 public:
 	SubdParams params;
-	float3 *mesh_P;
-	float3 *mesh_N;
+	DicedPatch *diced;
 	size_t vert_offset;
-	size_t tri_offset;
 
-	explicit EdgeDice(const SubdParams& params);
+	EdgeDice(const SubdParams& params, DicedPatch *diced);
 
 	void reserve(int num_verts);
 
 	int add_vert(Patch *patch, float2 uv);
-	void add_triangle(Patch *patch, int v0, int v1, int v2);
+	void add_triangle(int v0, int v1, int v2);
 
-	void stitch_triangles(Patch *patch, vector<int>& outer, vector<int>& inner);
+	void stitch_triangles(vector<int>& outer, vector<int>& inner);
 };
 
 /* Quad EdgeDice
@@ -107,7 +140,7 @@ public:
 		int tv1;
 	};
 
-	explicit QuadDice(const SubdParams& params);
+	QuadDice(const SubdParams& params, DicedPatch *diced);
 
 	void reserve(EdgeFactors& ef, int Mu, int Mv);
 	float3 eval_projected(SubPatch& sub, float u, float v);
@@ -0,0 +1,286 @@
+/*
+ * Copyright 2011-2016 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "camera.h"
+#include "mesh.h"
+
+#include "subd_dice_cache.h"
+#include "subd_patch.h"
+#include "subd_split.h"
+
+#include "util_foreach.h"
+#include "util_logging.h"
+#include "util_math.h"
+#include "util_task.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Keep the cached edge factor of an edge if the new one is within tolerance,
+ * returns false when the edge changed. Non-uniform edges are split further
+ * with factors depending on the view, so these are only kept when the view
+ * did not change at all. */
+static bool keep_edge_factor(int *t, int t_cached, bool view_changed, float tolerance)
+{
+	if(*t == t_cached) {
+		return (t_cached != DSPLIT_NON_UNIFORM || !view_changed);
+	}
+	else if(*t == DSPLIT_NON_UNIFORM || t_cached == DSPLIT_NON_UNIFORM) {
+		return false;
+	}
+	else if(fabsf((float)(*t - t_cached)) <= tolerance * t_cached) {
+		*t = t_cached;
+		return true;
+	}
+
+	return false;
+}
+
+/* Split patches into ranges to be handled by a single task, small enough for
+ * load balancing but large enough for the task overhead to be negligible. */
+static int task_range_size(int num)
+{
+	int num_threads = max(TaskScheduler::num_threads(), 1);
+	return max(num / (num_threads * 16), 32);
+}
+
+static void edge_factors_range(const SubdParams *params,
+                               vector<QuadDice::SubPatch> *subpatches,
+                               vector<QuadDice::EdgeFactors> *edge_factors,
+                               int start,
+                               int end)
+{
+	DiagSplit split(*params);
+
+	for(int i = start; i < end; i++) {
+		split.edge_factors((*subpatches)[i], (*edge_factors)[i]);
+	}
+}
+
+SubdDiceCache::SubdDiceCache()
+{
+	num_reused = 0;
+	num_diced = 0;
+	has_camera = false;
+	worldtoraster = transform_identity();
+	objecttoworld = transform_identity();
+}
+
+void SubdDiceCache::clear()
+{
+	diced.clear();
+	edge_factors.clear();
+	cage.clear();
+}
+
+bool SubdDiceCache::update_cage(Mesh *mesh, const SubdParams& params)
+{
+	/* Store everything that affects dicing besides the view in a single array,
+	 * with floats stored as their bit pattern for exact comparison. */
+	Attribute *attr_vN = mesh->subd_attributes.find(ATTR_STD_VERTEX_NORMAL);
+	float3 *vN = (attr_vN)? attr_vN->data_float3(): NULL;
+
+	vector<int> new_cage;
+	new_cage.reserve(6 + mesh->verts.size()*6 + mesh->subd_faces.size()*5 +
+	                 mesh->subd_face_corners.size() + mesh->subd_creases.size()*3);
+
+	new_cage.push_back(mesh->subdivision_type);
+	new_cage.push_back(params.ptex);
+	new_cage.push_back(params.test_steps);
+	new_cage.push_back(params.split_threshold);
+	new_cage.push_back(__float_as_int(params.dicing_rate));
+	new_cage.push_back(params.max_level);
+
+	for(size_t i = 0; i < mesh->verts.size(); i++) {
+		new_cage.push_back(__float_as_int(mesh->verts[i].x));
+		new_cage.push_back(__float_as_int(mesh->verts[i].y));
+		new_cage.push_back(__float_as_int(mesh->verts[i].z));
+
+		if(vN) {
+			new_cage.push_back(__float_as_int(vN[i].x));
+			new_cage.push_back(__float_as_int(vN[i].y));
+			new_cage.push_back(__float_as_int(vN[i].z));
+		}
+	}
+
+	for(size_t i = 0; i < mesh->subd_faces.size(); i++) {
+		const Mesh::SubdFace& face = mesh->subd_faces[i];
+
+		new_cage.push_back(face.start_corner);
+		new_cage.push_back(face.num_corners);
+		new_cage.push_back(face.shader);
+		new_cage.push_back(face.smooth);
+		new_cage.push_back(face.ptex_offset);
+	}
+
+	for(size_t i = 0; i < mesh->subd_face_corners.size(); i++) {
+		new_cage.push_back(mesh->subd_face_corners[i]);
+	}
+
+	for(size_t i = 0; i < mesh->subd_creases.size(); i++) {
+		const Mesh::SubdEdgeCrease& crease = mesh->subd_creases[i];
+
+		new_cage.push_back(crease.v[0]);
+		new_cage.push_back(crease.v[1]);
+		new_cage.push_back(__float_as_int(crease.crease));
+	}
+
+	bool changed = (new_cage != cage);
+	cage.swap(new_cage);
+
+	return changed;
+}
+
+bool SubdDiceCache::update_view(const SubdParams& params)
+{
+	bool new_has_camera = (params.camera != NULL);
+	Transform new_worldtoraster = (new_has_camera)? params.camera->worldtoraster: transform_identity();
+
+	bool changed = (new_has_camera != has_camera ||
+	                !(new_worldtoraster == worldtoraster) ||
+	                !(params.objecttoworld == objecttoworld));
+
+	has_camera = new_has_camera;
+	worldtoraster = new_worldtoraster;
+	objecttoworld = params.objecttoworld;
+
+	return changed;
+}
+
+void SubdDiceCache::dice_range(const SubdParams *params,
+                               vector<QuadDice::SubPatch> *subpatches,
+                               const vector<int> *indices,
+                               int start,
+                               int end)
+{
+	DiagSplit split(*params);
+
+	for(int i = start; i < end; i++) {
+		int index = (*indices)[i];
+		QuadDice::SubPatch& sub = (*subpatches)[index];
+		DicedPatch& patch = diced[index];
+
+		patch.clear();
+		patch.shader = sub.patch->shader;
+		patch.patch_index = sub.patch->patch_index;
+		patch.ptex_face_id = sub.patch->ptex_face_id();
+
+		split.split_quad(sub, edge_factors[index], &patch);
+	}
+}
+
+void SubdDiceCache::dice(Mesh *mesh,
+                         const SubdParams& params,
+                         vector<QuadDice::SubPatch>& subpatches)
+{
+	int num_patches = subpatches.size();
+
+	/* a changed control mesh or dicing parameters invalidate all patches */
+	bool use_cached = false;
+
+	if(params.use_dice_cache) {
+		bool cage_changed = update_cage(mesh, params);
+		use_cached = !cage_changed && diced.size() == num_patches;
+	}
+	else {
+		cage.clear();
+	}
+
+	bool view_changed = update_view(params);
+
+	if(!use_cached) {
+		diced.clear();
+		edge_factors.clear();
+	}
+
+	diced.resize(num_patches);
+	edge_factors.resize(num_patches);
+
+	/* estimate edge factors of top level patches */
+	vector<QuadDice::EdgeFactors> new_edge_factors(num_patches);
+	int range_size = task_range_size(num_patches);
+
+	TaskPool pool;
+
+	for(int start = 0; start < num_patches; start += range_size) {
+		int end = min(start + range_size, num_patches);
+
+		pool.push(function_bind(&edge_factors_range,
+		                        &params,
+		                        &subpatches,
+		                        &new_edge_factors,
+		                        start,
+		                        end));
+	}
+
+	pool.wait_work();
+
+	/* find patches that need to be diced */
+	vector<int> indices;
+
+	for(int i = 0; i < num_patches; i++) {
+		QuadDice::EdgeFactors& ef = new_edge_factors[i];
+
+		if(use_cached) {
+			const QuadDice::EdgeFactors& ef_cached = edge_factors[i];
+			float tolerance = params.dice_cache_tolerance;
+
+			/* all edges are tested, also when one already changed, so
+			 * the patch is diced with the same factors as its neighbors
+			 * use for the edges they share */
+			bool keep = keep_edge_factor(&ef.tu0, ef_cached.tu0, view_changed, tolerance);
+			keep = keep_edge_factor(&ef.tu1, ef_cached.tu1, view_changed, tolerance) && keep;
+			keep = keep_edge_factor(&ef.tv0, ef_cached.tv0, view_changed, tolerance) && keep;
+			keep = keep_edge_factor(&ef.tv1, ef_cached.tv1, view_changed, tolerance) && keep;
+
+			if(keep)
+				continue;
+		}
+
+		edge_factors[i] = ef;
+		indices.push_back(i);
+	}
+
+	/* split and dice */
+	int num_indices = indices.size();
+	range_size = task_range_size(num_indices);
+
+	for(int start = 0; start < num_indices; start += range_size) {
+		int end = min(start + range_size, num_indices);
+
+		pool.push(function_bind(&SubdDiceCache::dice_range,
+		                        this,
+		                        &params,
+		                        &subpatches,
+		                        &indices,
+		                        start,
+		                        end));
+	}
+
+	pool.wait_work();
+
+	num_diced = num_indices;
+	num_reused = num_patches - num_indices;
+
+	VLOG(1) << "Diced " << num_diced << " patches, reused "
+	        << num_reused << " cached patches.";
+
+	if(!params.use_dice_cache) {
+		/* results are only needed until they are copied to the mesh */
+		edge_factors.clear();
+	}
+}
+
+CCL_NAMESPACE_END
@@ -0,0 +1,84 @@
+/*
+ * Copyright 2011-2016 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __SUBD_DICE_CACHE_H__
+#define __SUBD_DICE_CACHE_H__
+
+/* Dice Cache
+ *
+ * Splits and dices the top level patches of a mesh in parallel, and keeps the
+ * diced patches for the next tessellation. As long as the control mesh and
+ * dicing parameters are unchanged, a patch is reused when the edge factors of
+ * all its edges stay within tolerance of the cached ones, which is the case
+ * for small camera movements in the viewport or in animation.
+ *
+ * The decision to keep the cached edge factor is made per edge, and only
+ * depends on the new and cached factor of that edge, so the patches on both
+ * sides of an edge always agree and the tessellation stays watertight. */
+
+#include "subd_dice.h"
+
+#include "util_transform.h"
+#include "util_types.h"
+#include "util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+class Mesh;
+
+class SubdDiceCache {
+public:
+	SubdDiceCache();
+
+	/* Split and dice the given top level patches, patches of which the cached
+	 * result is still valid are not diced again. Results are in diced, in the
+	 * same order as subpatches. */
+	void dice(Mesh *mesh,
+	          const SubdParams& params,
+	          vector<QuadDice::SubPatch>& subpatches);
+
+	/* Free cached patches. */
+	void clear();
+
+	vector<DicedPatch> diced;
+
+	/* Statistics of the last tessellation. */
+	size_t num_reused;
+	size_t num_diced;
+
+protected:
+	bool update_cage(Mesh *mesh, const SubdParams& params);
+	bool update_view(const SubdParams& params);
+
+	void dice_range(const SubdParams *params,
+	                vector<QuadDice::SubPatch> *subpatches,
+	                const vector<int> *indices,
+	                int start,
+	                int end);
+
+	/* Edge factors each diced patch was split with. */
+	vector<QuadDice::EdgeFactors> edge_factors;
+
+	/* Control mesh and parameters the cached patches were diced with. */
+	vector<int> cage;
+	bool has_camera;
+	Transform worldtoraster;
+	Transform objecttoworld;
+};
+
+CCL_NAMESPACE_END
+
+#endif /* __SUBD_DICE_CACHE_H__ */
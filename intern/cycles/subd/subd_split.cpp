@@ -215,43 +215,35 @@ void DiagSplit::split(QuadDice::SubPatch& sub, QuadDice::EdgeFactors& ef, int de
 	}
 }
 
-void DiagSplit::split_quad(Patch *patch, QuadDice::SubPatch *subpatch)
+void DiagSplit::edge_factors(QuadDice::SubPatch& sub, QuadDice::EdgeFactors& ef)
 {
-	QuadDice::SubPatch sub_split;
-	QuadDice::EdgeFactors ef_split;
+	ef.tu0 = T(sub.patch, sub.P00, sub.P10);
+	ef.tu1 = T(sub.patch, sub.P01, sub.P11);
+	ef.tv0 = T(sub.patch, sub.P00, sub.P01);
+	ef.tv1 = T(sub.patch, sub.P10, sub.P11);
 
-	if(subpatch) {
-		sub_split = *subpatch;
-	}
-	else {
-		sub_split.patch = patch;
-		sub_split.P00 = make_float2(0.0f, 0.0f);
-		sub_split.P10 = make_float2(1.0f, 0.0f);
-		sub_split.P01 = make_float2(0.0f, 1.0f);
-		sub_split.P11 = make_float2(1.0f, 1.0f);
-	}
-
-	ef_split.tu0 = T(patch, sub_split.P00, sub_split.P10);
-	ef_split.tu1 = T(patch, sub_split.P01, sub_split.P11);
-	ef_split.tv0 = T(patch, sub_split.P00, sub_split.P01);
-	ef_split.tv1 = T(patch, sub_split.P10, sub_split.P11);
+	limit_edge_factors(sub, ef, 1 << params.max_level);
+}
 
-	limit_edge_factors(sub_split, ef_split, 1 << params.max_level);
+void DiagSplit::split_quad(QuadDice::SubPatch& sub, QuadDice::EdgeFactors& ef, DicedPatch *diced)
+{
+	QuadDice::SubPatch sub_split = sub;
+	QuadDice::EdgeFactors ef_split = ef;
 
 	split(sub_split, ef_split);
 
-	QuadDice dice(params);
+	QuadDice dice(params, diced);
 
 	for(size_t i = 0; i < subpatches_quad.size(); i++) {
-		QuadDice::SubPatch& sub = subpatches_quad[i];
-		QuadDice::EdgeFactors& ef = edgefactors_quad[i];
+		QuadDice::SubPatch& sub_dice = subpatches_quad[i];
+		QuadDice::EdgeFactors& ef_dice = edgefactors_quad[i];
 
-		ef.tu0 = max(ef.tu0, 1);
-		ef.tu1 = max(ef.tu1, 1);
-		ef.tv0 = max(ef.tv0, 1);
-		ef.tv1 = max(ef.tv1, 1);
+		ef_dice.tu0 = max(ef_dice.tu0, 1);
+		ef_dice.tu1 = max(ef_dice.tu1, 1);
+		ef_dice.tv0 = max(ef_dice.tv0, 1);
+		ef_dice.tv1 = max(ef_dice.tv1, 1);
 
-		dice.dice(sub, ef);
+		dice.dice(sub_dice, ef_dice);
 	}
 
 	subpatches_quad.clear();
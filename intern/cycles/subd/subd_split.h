@@ -51,7 +51,8 @@ public:
 	void dispatch(QuadDice::SubPatch& sub, QuadDice::EdgeFactors& ef);
 	void split(QuadDice::SubPatch& sub, QuadDice::EdgeFactors& ef, int depth=0);
 
-	void split_quad(Patch *patch, QuadDice::SubPatch *subpatch=NULL);
+	void edge_factors(QuadDice::SubPatch& sub, QuadDice::EdgeFactors& ef);
+	void split_quad(QuadDice::SubPatch& sub, QuadDice::EdgeFactors& ef, DicedPatch *diced);
 };
 
 CCL_NAMESPACE_END
@@ -129,8 +129,9 @@ void *mmap(void *UNUSED(start), size_t len, int prot, int flags, int fd, off_t o
 		}
 	}
 
-	/* note len is passed to a 32 bit DWORD, so can't be > 4 GB */
-	maphandle = CreateFileMapping(fhandle, NULL, prot_flags, 0, len, NULL);
+	/* the maximum size is passed as two 32 bit DWORDs, so files > 4 GB can be mapped */
+	maphandle = CreateFileMapping(fhandle, NULL, prot_flags,
+	                              (DWORD)((unsigned __int64)len >> 32), (DWORD)(len & 0xffffffff), NULL);
 	if (maphandle == 0) {
 		errno = EBADF;
 		return MAP_FAILED;
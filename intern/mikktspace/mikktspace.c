@@ -220,6 +220,79 @@ static SVec3 GetTexCoord(const SMikkTSpaceContext * pContext, const int index);
 static void DegenPrologue(STriInfo pTriInfos[], int piTriList_out[], const int iNrTrianglesIn, const int iTotTris);
 static void DegenEpilogue(STSpace psTspace[], STriInfo pTriInfos[], int piTriListIn[], const SMikkTSpaceContext * pContext, const int iNrTrianglesIn, const int iTotTris);
 
+// runs func() over {0, 1, ..., iNrItems-1}, in parallel when the application supports it
+static void RunParallel(const SMikkTSpaceContext * pContext, const int iNrItems,
+                        void (*func)(void * pData, const int iStart, const int iEnd), void * pData)
+{
+	if (iNrItems<=0) return;
+
+	if (pContext->m_pInterface->m_runParallel!=NULL && iNrItems>1)
+		pContext->m_pInterface->m_runParallel(pContext, iNrItems, func, pData);
+	else
+		func(pData, 0, iNrItems);
+}
+
+typedef struct {
+	STriInfo * pTriInfos;
+	const int * piTriListIn;
+	const SMikkTSpaceContext * pContext;
+} SMarkDegenerateData;
+
+static void MarkDegenerateRange(void * pData, const int iStart, const int iEnd)
+{
+	const SMarkDegenerateData * pDegenData = (const SMarkDegenerateData *) pData;
+	const int * piTriListIn = pDegenData->piTriListIn;
+	int t=0;
+	for (t=iStart; t<iEnd; t++)
+	{
+		const int i0 = piTriListIn[t*3+0];
+		const int i1 = piTriListIn[t*3+1];
+		const int i2 = piTriListIn[t*3+2];
+		const SVec3 p0 = GetPosition(pDegenData->pContext, i0);
+		const SVec3 p1 = GetPosition(pDegenData->pContext, i1);
+		const SVec3 p2 = GetPosition(pDegenData->pContext, i2);
+		if (veq(p0,p1) || veq(p0,p2) || veq(p1,p2))	// degenerate
+			pDegenData->pTriInfos[t].iFlag |= MARK_DEGENERATE;
+	}
+}
+
+typedef struct {
+	const STSpace * psTspace;
+	const int * piFaceTSpacesOffs;
+	const SMikkTSpaceContext * pContext;
+} SSetTSpaceData;
+
+static void SetTSpaceRange(void * pData, const int iStart, const int iEnd)
+{
+	const SSetTSpaceData * pSetData = (const SSetTSpaceData *) pData;
+	const SMikkTSpaceContext * pContext = pSetData->pContext;
+	int f=0, i=0;
+	for (f=iStart; f<iEnd; f++)
+	{
+		const int verts = pContext->m_pInterface->m_getNumVerticesOfFace(pContext, f);
+		int index = pSetData->piFaceTSpacesOffs[f];
+		if (verts!=3 && verts!=4) continue;
+
+		// I've decided to let degenerate triangles and group-with-anythings
+		// vary between left/right hand coordinate systems at the vertices.
+		// All healthy triangles on the other hand are built to always be either or.
+
+		// set data
+		for (i=0; i<verts; i++)
+		{
+			const STSpace * pTSpace = &pSetData->psTspace[index];
+			float tang[] = {pTSpace->vOs.x, pTSpace->vOs.y, pTSpace->vOs.z};
+			float bitang[] = {pTSpace->vOt.x, pTSpace->vOt.y, pTSpace->vOt.z};
+			if (pContext->m_pInterface->m_setTSpace!=NULL)
+				pContext->m_pInterface->m_setTSpace(pContext, tang, bitang, pTSpace->fMagS, pTSpace->fMagT, pTSpace->bOrient, f, i);
+			if (pContext->m_pInterface->m_setTSpaceBasic!=NULL)
+				pContext->m_pInterface->m_setTSpaceBasic(pContext, tang, pTSpace->bOrient==TTRUE ? 1.0f : (-1.0f), f, i);
+
+			++index;
+		}
+	}
+}
+
 
 tbool genTangSpaceDefault(const SMikkTSpaceContext * pContext)
 {
@@ -229,16 +302,18 @@ tbool genTangSpaceDefault(const SMikkTSpaceContext * pContext)
 tbool genTangSpace(const SMikkTSpaceContext * pContext, const float fAngularThreshold)
 {
 	// count nr_triangles
-	int * piTriListIn = NULL, * piGroupTrianglesBuffer = NULL;
+	int * piTriListIn = NULL, * piGroupTrianglesBuffer = NULL, * piFaceTSpacesOffs = NULL;
 	STriInfo * pTriInfos = NULL;
 	SGroup * pGroups = NULL;
 	STSpace * psTspace = NULL;
-	int iNrTrianglesIn = 0, f=0, t=0, i=0;
+	int iNrTrianglesIn = 0, f=0, t=0;
 	int iNrTSPaces = 0, iTotTris = 0, iDegenTriangles = 0, iNrMaxGroups = 0;
 	int iNrActiveGroups = 0, index = 0;
 	const int iNrFaces = pContext->m_pInterface->m_getNumFaces(pContext);
 	tbool bRes = TFALSE;
 	const float fThresCos = (float) cos((fAngularThreshold*(float)M_PI)/180.0f);
+	SMarkDegenerateData sDegenData;
+	SSetTSpaceData sSetData;
 
 	// verify all call-backs have been set
 	if ( pContext->m_pInterface->m_getNumFaces==NULL ||
@@ -260,10 +335,12 @@ tbool genTangSpace(const SMikkTSpaceContext * pContext, const float fAngularThre
 	// allocate memory for an index list
 	piTriListIn = (int *) malloc(sizeof(int)*3*iNrTrianglesIn);
 	pTriInfos = (STriInfo *) malloc(sizeof(STriInfo)*iNrTrianglesIn);
-	if (piTriListIn==NULL || pTriInfos==NULL)
+	piFaceTSpacesOffs = (int *) malloc(sizeof(int)*iNrFaces);
+	if (piTriListIn==NULL || pTriInfos==NULL || piFaceTSpacesOffs==NULL)
 	{
 		if (piTriListIn!=NULL) free(piTriListIn);
 		if (pTriInfos!=NULL) free(pTriInfos);
+		if (piFaceTSpacesOffs!=NULL) free(piFaceTSpacesOffs);
 		return TFALSE;
 	}
 
@@ -277,21 +354,15 @@ tbool genTangSpace(const SMikkTSpaceContext * pContext, const float fAngularThre
 
 	// Mark all degenerate triangles
 	iTotTris = iNrTrianglesIn;
+	sDegenData.pTriInfos = pTriInfos;
+	sDegenData.piTriListIn = piTriListIn;
+	sDegenData.pContext = pContext;
+	RunParallel(pContext, iTotTris, MarkDegenerateRange, &sDegenData);
+
 	iDegenTriangles = 0;
 	for (t=0; t<iTotTris; t++)
-	{
-		const int i0 = piTriListIn[t*3+0];
-		const int i1 = piTriListIn[t*3+1];
-		const int i2 = piTriListIn[t*3+2];
-		const SVec3 p0 = GetPosition(pContext, i0);
-		const SVec3 p1 = GetPosition(pContext, i1);
-		const SVec3 p2 = GetPosition(pContext, i2);
-		if (veq(p0,p1) || veq(p0,p2) || veq(p1,p2))	// degenerate
-		{
-			pTriInfos[t].iFlag |= MARK_DEGENERATE;
+		if ((pTriInfos[t].iFlag&MARK_DEGENERATE)!=0)
 			++iDegenTriangles;
-		}
-	}
 	iNrTrianglesIn = iTotTris - iDegenTriangles;
 
 	// mark all triangle pairs that belong to a quad with only one
@@ -318,6 +389,7 @@ tbool genTangSpace(const SMikkTSpaceContext * pContext, const float fAngularThre
 		if (piGroupTrianglesBuffer!=NULL) free(piGroupTrianglesBuffer);
 		free(piTriListIn);
 		free(pTriInfos);
+		free(piFaceTSpacesOffs);
 		return TFALSE;
 	}
 	//printf("gen 4rule groups begin\n");
@@ -334,6 +406,7 @@ tbool genTangSpace(const SMikkTSpaceContext * pContext, const float fAngularThre
 		free(pTriInfos);
 		free(pGroups);
 		free(piGroupTrianglesBuffer);
+		free(piFaceTSpacesOffs);
 		return TFALSE;
 	}
 	memset(psTspace, 0, sizeof(STSpace)*iNrTSPaces);
@@ -357,7 +430,7 @@ tbool genTangSpace(const SMikkTSpaceContext * pContext, const float fAngularThre
 	if (!bRes)	// if an allocation in GenerateTSpaces() failed
 	{
 		// clean up and return false
-		free(pTriInfos); free(piTriListIn); free(psTspace);
+		free(pTriInfos); free(piTriListIn); free(psTspace); free(piFaceTSpacesOffs);
 		return TFALSE;
 	}
 
@@ -370,49 +443,39 @@ tbool genTangSpace(const SMikkTSpaceContext * pContext, const float fAngularThre
 
 	free(pTriInfos); free(piTriListIn);
 
+	// offsets of the tangent spaces of every face
 	index = 0;
 	for (f=0; f<iNrFaces; f++)
 	{
 		const int verts = pContext->m_pInterface->m_getNumVerticesOfFace(pContext, f);
-		if (verts!=3 && verts!=4) continue;
-		
-
-		// I've decided to let degenerate triangles and group-with-anythings
-		// vary between left/right hand coordinate systems at the vertices.
-		// All healthy triangles on the other hand are built to always be either or.
-
-		/*// force the coordinate system orientation to be uniform for every face.
-		// (this is already the case for good triangles but not for
-		// degenerate ones and those with bGroupWithAnything==true)
-		bool bOrient = psTspace[index].bOrient;
-		if (psTspace[index].iCounter == 0)	// tspace was not derived from a group
-		{
-			// look for a space created in GenerateTSpaces() by iCounter>0
-			bool bNotFound = true;
-			int i=1;
-			while (i<verts && bNotFound)
-			{
-				if (psTspace[index+i].iCounter > 0) bNotFound=false;
-				else ++i;
-			}
-			if (!bNotFound) bOrient = psTspace[index+i].bOrient;
-		}*/
+		piFaceTSpacesOffs[f] = index;
+		if (verts==3 || verts==4) index += verts;
+	}
 
-		// set data
-		for (i=0; i<verts; i++)
+	/*// force the coordinate system orientation to be uniform for every face.
+	// (this is already the case for good triangles but not for
+	// degenerate ones and those with bGroupWithAnything==true)
+	bool bOrient = psTspace[index].bOrient;
+	if (psTspace[index].iCounter == 0)	// tspace was not derived from a group
+	{
+		// look for a space created in GenerateTSpaces() by iCounter>0
+		bool bNotFound = true;
+		int i=1;
+		while (i<verts && bNotFound)
 		{
-			const STSpace * pTSpace = &psTspace[index];
-			float tang[] = {pTSpace->vOs.x, pTSpace->vOs.y, pTSpace->vOs.z};
-			float bitang[] = {pTSpace->vOt.x, pTSpace->vOt.y, pTSpace->vOt.z};
-			if (pContext->m_pInterface->m_setTSpace!=NULL)
-				pContext->m_pInterface->m_setTSpace(pContext, tang, bitang, pTSpace->fMagS, pTSpace->fMagT, pTSpace->bOrient, f, i);
-			if (pContext->m_pInterface->m_setTSpaceBasic!=NULL)
-				pContext->m_pInterface->m_setTSpaceBasic(pContext, tang, pTSpace->bOrient==TTRUE ? 1.0f : (-1.0f), f, i);
-
-			++index;
+			if (psTspace[index+i].iCounter > 0) bNotFound=false;
+			else ++i;
 		}
-	}
+		if (!bNotFound) bOrient = psTspace[index+i].bOrient;
+	}*/
+
+	// set data
+	sSetData.psTspace = psTspace;
+	sSetData.piFaceTSpacesOffs = piFaceTSpacesOffs;
+	sSetData.pContext = pContext;
+	RunParallel(pContext, iNrFaces, SetTSpaceRange, &sSetData);
 
+	free(piFaceTSpacesOffs);
 	free(psTspace);
 
 	
@@ -448,85 +511,208 @@ static void MergeVertsFast(int piTriList_in_and_out[], STmpVert pTmpVert[], cons
 static void MergeVertsSlow(int piTriList_in_and_out[], const SMikkTSpaceContext * pContext, const int pTable[], const int iEntries);
 static void GenerateSharedVerticesIndexListSlow(int piTriList_in_and_out[], const SMikkTSpaceContext * pContext, const int iNrTrianglesIn);
 
-static void GenerateSharedVerticesIndexList(int piTriList_in_and_out[], const SMikkTSpaceContext * pContext, const int iNrTrianglesIn)
-{
+// bounding box of a range of vertices, initialized with vertex 0 like the single threaded version
+typedef struct {
+	const int * piTriList;
+	const SMikkTSpaceContext * pContext;
+	SVec3 vMin, vMax;
+} SBoundsRange;
 
-	// Generate bounding box
-	int * piHashTable=NULL, * piHashCount=NULL, * piHashOffsets=NULL, * piHashCount2=NULL;
-	STmpVert * pTmpVert = NULL;
-	int i=0, iChannel=0, k=0, e=0;
-	int iMaxCount=0;
-	SVec3 vMin = GetPosition(pContext, 0), vMax = vMin, vDim;
-	float fMin, fMax;
-	for (i=1; i<(iNrTrianglesIn*3); i++)
-	{
-		const int index = piTriList_in_and_out[i];
+typedef struct {
+	const int * piTriList;
+	const SMikkTSpaceContext * pContext;
+	SBoundsRange * pRanges;
+	int iRangeSize, iNrVerts;
+} SBoundsData;
 
-		const SVec3 vP = GetPosition(pContext, index);
-		if (vMin.x > vP.x) vMin.x = vP.x;
-		else if (vMax.x < vP.x) vMax.x = vP.x;
-		if (vMin.y > vP.y) vMin.y = vP.y;
-		else if (vMax.y < vP.y) vMax.y = vP.y;
-		if (vMin.z > vP.z) vMin.z = vP.z;
-		else if (vMax.z < vP.z) vMax.z = vP.z;
+static void BoundsRange(void * pData, const int iStart, const int iEnd)
+{
+	const SBoundsData * pBoundsData = (const SBoundsData *) pData;
+	int r=0;
+	for (r=iStart; r<iEnd; r++)
+	{
+		SBoundsRange * pRange = &pBoundsData->pRanges[r];
+		const int iFirst = r*pBoundsData->iRangeSize;
+		const int iLast = (iFirst + pBoundsData->iRangeSize) < pBoundsData->iNrVerts ? (iFirst + pBoundsData->iRangeSize) : pBoundsData->iNrVerts;
+		int i=0;
+		pRange->vMin = GetPosition(pBoundsData->pContext, 0);
+		pRange->vMax = pRange->vMin;
+		for (i=(iFirst>0 ? iFirst : 1); i<iLast; i++)
+		{
+			const int index = pBoundsData->piTriList[i];
+
+			const SVec3 vP = GetPosition(pBoundsData->pContext, index);
+			if (pRange->vMin.x > vP.x) pRange->vMin.x = vP.x;
+			else if (pRange->vMax.x < vP.x) pRange->vMax.x = vP.x;
+			if (pRange->vMin.y > vP.y) pRange->vMin.y = vP.y;
+			else if (pRange->vMax.y < vP.y) pRange->vMax.y = vP.y;
+			if (pRange->vMin.z > vP.z) pRange->vMin.z = vP.z;
+			else if (pRange->vMax.z < vP.z) pRange->vMax.z = vP.z;
+		}
 	}
+}
 
-	vDim = vsub(vMax,vMin);
-	iChannel = 0;
-	fMin = vMin.x; fMax=vMax.x;
-	if (vDim.y>vDim.x && vDim.y>vDim.z)
+typedef struct {
+	const int * piTriList;
+	const SMikkTSpaceContext * pContext;
+	int * piCells;
+	int iChannel;
+	float fMin, fMax;
+} SGridCellData;
+
+static void GridCellRange(void * pData, const int iStart, const int iEnd)
+{
+	const SGridCellData * pCellData = (const SGridCellData *) pData;
+	int i=0;
+	for (i=iStart; i<iEnd; i++)
 	{
-		iChannel=1;
-		fMin = vMin.y;
-		fMax = vMax.y;
+		const int index = pCellData->piTriList[i];
+		const SVec3 vP = GetPosition(pCellData->pContext, index);
+		const float fVal = pCellData->iChannel==0 ? vP.x : (pCellData->iChannel==1 ? vP.y : vP.z);
+		pCellData->piCells[i] = FindGridCell(pCellData->fMin, pCellData->fMax, fVal);
 	}
-	else if (vDim.z>vDim.x)
+}
+
+// cells only reference their own vertices, so they can be merged independently
+typedef struct {
+	int * piTriList_in_and_out;
+	const SMikkTSpaceContext * pContext;
+	const int * piHashTable;
+	const int * piHashCount;
+	const int * piHashOffsets;
+	int iMaxCount;
+} SMergeCellsData;
+
+static void MergeCellsRange(void * pData, const int iStart, const int iEnd)
+{
+	const SMergeCellsData * pMergeData = (const SMergeCellsData *) pData;
+	int * piTriList_in_and_out = pMergeData->piTriList_in_and_out;
+	STmpVert * pTmpVert = (STmpVert *) malloc(sizeof(STmpVert)*pMergeData->iMaxCount);
+	int k=0, e=0;
+
+	for (k=iStart; k<iEnd; k++)
 	{
-		iChannel=2;
-		fMin = vMin.z;
-		fMax = vMax.z;
+		// extract table of cell k and amount of entries in it
+		const int * pTable = &pMergeData->piHashTable[pMergeData->piHashOffsets[k]];
+		const int iEntries = pMergeData->piHashCount[k];
+		if (iEntries < 2) continue;
+
+		if (pTmpVert!=NULL)
+		{
+			for (e=0; e<iEntries; e++)
+			{
+				int i = pTable[e];
+				const SVec3 vP = GetPosition(pMergeData->pContext, piTriList_in_and_out[i]);
+				pTmpVert[e].vert[0] = vP.x; pTmpVert[e].vert[1] = vP.y;
+				pTmpVert[e].vert[2] = vP.z; pTmpVert[e].index = i;
+			}
+			MergeVertsFast(piTriList_in_and_out, pTmpVert, pMergeData->pContext, 0, iEntries-1);
+		}
+		else
+			MergeVertsSlow(piTriList_in_and_out, pMergeData->pContext, pTable, iEntries);
 	}
 
+	if (pTmpVert!=NULL) { free(pTmpVert); }
+}
+
+static void GenerateSharedVerticesIndexList(int piTriList_in_and_out[], const SMikkTSpaceContext * pContext, const int iNrTrianglesIn)
+{
+
+	// Generate bounding box
+	int * piHashTable=NULL, * piHashCount=NULL, * piHashOffsets=NULL, * piHashCount2=NULL, * piCells=NULL;
+	SBoundsRange * pBoundsRanges = NULL;
+	int i=0, iChannel=0, k=0;
+	int iMaxCount=0;
+	const int iNrVerts = iNrTrianglesIn*3;
+	const int iBoundsRangeSize = 4096;
+	const int iNrBoundsRanges = (iNrVerts + iBoundsRangeSize - 1) / iBoundsRangeSize;
+	SVec3 vMin, vMax, vDim;
+	float fMin, fMax;
+	SBoundsData sBoundsData;
+	SGridCellData sCellData;
+	SMergeCellsData sMergeData;
+
 	// make allocations
+	pBoundsRanges = (SBoundsRange *) malloc(sizeof(SBoundsRange)*iNrBoundsRanges);
 	piHashTable = (int *) malloc(sizeof(int)*iNrTrianglesIn*3);
 	piHashCount = (int *) malloc(sizeof(int)*g_iCells);
 	piHashOffsets = (int *) malloc(sizeof(int)*g_iCells);
 	piHashCount2 = (int *) malloc(sizeof(int)*g_iCells);
+	piCells = (int *) malloc(sizeof(int)*iNrTrianglesIn*3);
 
-	if (piHashTable==NULL || piHashCount==NULL || piHashOffsets==NULL || piHashCount2==NULL)
+	if (pBoundsRanges==NULL || piHashTable==NULL || piHashCount==NULL || piHashOffsets==NULL || piHashCount2==NULL || piCells==NULL)
 	{
+		if (pBoundsRanges!=NULL) free(pBoundsRanges);
 		if (piHashTable!=NULL) free(piHashTable);
 		if (piHashCount!=NULL) free(piHashCount);
 		if (piHashOffsets!=NULL) free(piHashOffsets);
 		if (piHashCount2!=NULL) free(piHashCount2);
+		if (piCells!=NULL) free(piCells);
 		GenerateSharedVerticesIndexListSlow(piTriList_in_and_out, pContext, iNrTrianglesIn);
 		return;
 	}
 	memset(piHashCount, 0, sizeof(int)*g_iCells);
 	memset(piHashCount2, 0, sizeof(int)*g_iCells);
 
-	// count amount of elements in each cell unit
-	for (i=0; i<(iNrTrianglesIn*3); i++)
+	// bounding box of ranges of vertices, combined in order
+	sBoundsData.piTriList = piTriList_in_and_out;
+	sBoundsData.pContext = pContext;
+	sBoundsData.pRanges = pBoundsRanges;
+	sBoundsData.iRangeSize = iBoundsRangeSize;
+	sBoundsData.iNrVerts = iNrVerts;
+	RunParallel(pContext, iNrBoundsRanges, BoundsRange, &sBoundsData);
+
+	vMin = pBoundsRanges[0].vMin; vMax = pBoundsRanges[0].vMax;
+	for (k=1; k<iNrBoundsRanges; k++)
 	{
-		const int index = piTriList_in_and_out[i];
-		const SVec3 vP = GetPosition(pContext, index);
-		const float fVal = iChannel==0 ? vP.x : (iChannel==1 ? vP.y : vP.z);
-		const int iCell = FindGridCell(fMin, fMax, fVal);
-		++piHashCount[iCell];
+		const SVec3 vRangeMin = pBoundsRanges[k].vMin, vRangeMax = pBoundsRanges[k].vMax;
+		if (vMin.x > vRangeMin.x) vMin.x = vRangeMin.x;
+		if (vMax.x < vRangeMax.x) vMax.x = vRangeMax.x;
+		if (vMin.y > vRangeMin.y) vMin.y = vRangeMin.y;
+		if (vMax.y < vRangeMax.y) vMax.y = vRangeMax.y;
+		if (vMin.z > vRangeMin.z) vMin.z = vRangeMin.z;
+		if (vMax.z < vRangeMax.z) vMax.z = vRangeMax.z;
+	}
+	free(pBoundsRanges);
+
+	vDim = vsub(vMax,vMin);
+	iChannel = 0;
+	fMin = vMin.x; fMax=vMax.x;
+	if (vDim.y>vDim.x && vDim.y>vDim.z)
+	{
+		iChannel=1;
+		fMin = vMin.y;
+		fMax = vMax.y;
+	}
+	else if (vDim.z>vDim.x)
+	{
+		iChannel=2;
+		fMin = vMin.z;
+		fMax = vMax.z;
 	}
 
+	// evaluate the cell of each vertex
+	sCellData.piTriList = piTriList_in_and_out;
+	sCellData.pContext = pContext;
+	sCellData.piCells = piCells;
+	sCellData.iChannel = iChannel;
+	sCellData.fMin = fMin;
+	sCellData.fMax = fMax;
+	RunParallel(pContext, iNrVerts, GridCellRange, &sCellData);
+
+	// count amount of elements in each cell unit
+	for (i=0; i<iNrVerts; i++)
+		++piHashCount[piCells[i]];
+
 	// evaluate start index of each cell.
 	piHashOffsets[0]=0;
 	for (k=1; k<g_iCells; k++)
 		piHashOffsets[k]=piHashOffsets[k-1]+piHashCount[k-1];
 
 	// insert vertices
-	for (i=0; i<(iNrTrianglesIn*3); i++)
+	for (i=0; i<iNrVerts; i++)
 	{
-		const int index = piTriList_in_and_out[i];
-		const SVec3 vP = GetPosition(pContext, index);
-		const float fVal = iChannel==0 ? vP.x : (iChannel==1 ? vP.y : vP.z);
-		const int iCell = FindGridCell(fMin, fMax, fVal);
+		const int iCell = piCells[i];
 		int * pTable = NULL;
 
 		assert(piHashCount2[iCell]<piHashCount[iCell]);
@@ -537,39 +723,23 @@ static void GenerateSharedVerticesIndexList(int piTriList_in_and_out[], const SM
 	for (k=0; k<g_iCells; k++)
 		assert(piHashCount2[k] == piHashCount[k]);	// verify the count
 	free(piHashCount2);
+	free(piCells);
 
 	// find maximum amount of entries in any hash entry
 	iMaxCount = piHashCount[0];
 	for (k=1; k<g_iCells; k++)
 		if (iMaxCount<piHashCount[k])
 			iMaxCount=piHashCount[k];
-	pTmpVert = (STmpVert *) malloc(sizeof(STmpVert)*iMaxCount);
-	
 
 	// complete the merge
-	for (k=0; k<g_iCells; k++)
-	{
-		// extract table of cell k and amount of entries in it
-		int * pTable = &piHashTable[piHashOffsets[k]];
-		const int iEntries = piHashCount[k];
-		if (iEntries < 2) continue;
-
-		if (pTmpVert!=NULL)
-		{
-			for (e=0; e<iEntries; e++)
-			{
-				int i = pTable[e];
-				const SVec3 vP = GetPosition(pContext, piTriList_in_and_out[i]);
-				pTmpVert[e].vert[0] = vP.x; pTmpVert[e].vert[1] = vP.y;
-				pTmpVert[e].vert[2] = vP.z; pTmpVert[e].index = i;
-			}
-			MergeVertsFast(piTriList_in_and_out, pTmpVert, pContext, 0, iEntries-1);
-		}
-		else
-			MergeVertsSlow(piTriList_in_and_out, pContext, pTable, iEntries);
-	}
+	sMergeData.piTriList_in_and_out = piTriList_in_and_out;
+	sMergeData.pContext = pContext;
+	sMergeData.piHashTable = piHashTable;
+	sMergeData.piHashCount = piHashCount;
+	sMergeData.piHashOffsets = piHashOffsets;
+	sMergeData.iMaxCount = iMaxCount;
+	RunParallel(pContext, g_iCells, MergeCellsRange, &sMergeData);
 
-	if (pTmpVert!=NULL) { free(pTmpVert); }
 	free(piHashTable);
 	free(piHashCount);
 	free(piHashOffsets);
@@ -941,13 +1111,23 @@ static float CalcTexArea(const SMikkTSpaceContext * pContext, const int indices[
 	return fSignedAreaSTx2<0 ? (-fSignedAreaSTx2) : fSignedAreaSTx2;
 }
 
-static void InitTriInfo(STriInfo pTriInfos[], const int piTriListIn[], const SMikkTSpaceContext * pContext, const int iNrTrianglesIn)
+typedef struct {
+	STriInfo * pTriInfos;
+	const int * piTriListIn;
+	const SMikkTSpaceContext * pContext;
+} STriInfoData;
+
+static void InitTriInfoRange(void * pData, const int iStart, const int iEnd)
 {
-	int f=0, i=0, t=0;
-	// pTriInfos[f].iFlag is cleared in GenerateInitialVerticesIndexList() which is called before this function.
+	const STriInfoData * pTriData = (const STriInfoData *) pData;
+	STriInfo * pTriInfos = pTriData->pTriInfos;
+	const int * piTriListIn = pTriData->piTriListIn;
+	const SMikkTSpaceContext * pContext = pTriData->pContext;
+	int f=0, i=0;
 
-	// generate neighbor info list
-	for (f=0; f<iNrTrianglesIn; f++)
+	for (f=iStart; f<iEnd; f++)
+	{
+		// generate neighbor info list
 		for (i=0; i<3; i++)
 		{
 			pTriInfos[f].FaceNeighbors[i] = -1;
@@ -962,49 +1142,62 @@ static void InitTriInfo(STriInfo pTriInfos[], const int piTriListIn[], const SMi
 			pTriInfos[f].iFlag |= GROUP_WITH_ANY;
 		}
 
-	// evaluate first order derivatives
-	for (f=0; f<iNrTrianglesIn; f++)
-	{
-		// initial values
-		const SVec3 v1 = GetPosition(pContext, piTriListIn[f*3+0]);
-		const SVec3 v2 = GetPosition(pContext, piTriListIn[f*3+1]);
-		const SVec3 v3 = GetPosition(pContext, piTriListIn[f*3+2]);
-		const SVec3 t1 = GetTexCoord(pContext, piTriListIn[f*3+0]);
-		const SVec3 t2 = GetTexCoord(pContext, piTriListIn[f*3+1]);
-		const SVec3 t3 = GetTexCoord(pContext, piTriListIn[f*3+2]);
-
-		const float t21x = t2.x-t1.x;
-		const float t21y = t2.y-t1.y;
-		const float t31x = t3.x-t1.x;
-		const float t31y = t3.y-t1.y;
-		const SVec3 d1 = vsub(v2,v1);
-		const SVec3 d2 = vsub(v3,v1);
-
-		const float fSignedAreaSTx2 = t21x*t31y - t21y*t31x;
-		//assert(fSignedAreaSTx2!=0);
-		SVec3 vOs = vsub(vscale(t31y,d1), vscale(t21y,d2));	// eq 18
-		SVec3 vOt = vadd(vscale(-t31x,d1), vscale(t21x,d2)); // eq 19
-
-		pTriInfos[f].iFlag |= (fSignedAreaSTx2>0 ? ORIENT_PRESERVING : 0);
-
-		if ( NotZero(fSignedAreaSTx2) )
+		// evaluate first order derivatives
 		{
-			const float fAbsArea = fabsf(fSignedAreaSTx2);
-			const float fLenOs = Length(vOs);
-			const float fLenOt = Length(vOt);
-			const float fS = (pTriInfos[f].iFlag&ORIENT_PRESERVING)==0 ? (-1.0f) : 1.0f;
-			if ( NotZero(fLenOs) ) pTriInfos[f].vOs = vscale(fS/fLenOs, vOs);
-			if ( NotZero(fLenOt) ) pTriInfos[f].vOt = vscale(fS/fLenOt, vOt);
-
-			// evaluate magnitudes prior to normalization of vOs and vOt
-			pTriInfos[f].fMagS = fLenOs / fAbsArea;
-			pTriInfos[f].fMagT = fLenOt / fAbsArea;
-
-			// if this is a good triangle
-			if ( NotZero(pTriInfos[f].fMagS) && NotZero(pTriInfos[f].fMagT))
-				pTriInfos[f].iFlag &= (~GROUP_WITH_ANY);
+			// initial values
+			const SVec3 v1 = GetPosition(pContext, piTriListIn[f*3+0]);
+			const SVec3 v2 = GetPosition(pContext, piTriListIn[f*3+1]);
+			const SVec3 v3 = GetPosition(pContext, piTriListIn[f*3+2]);
+			const SVec3 t1 = GetTexCoord(pContext, piTriListIn[f*3+0]);
+			const SVec3 t2 = GetTexCoord(pContext, piTriListIn[f*3+1]);
+			const SVec3 t3 = GetTexCoord(pContext, piTriListIn[f*3+2]);
+
+			const float t21x = t2.x-t1.x;
+			const float t21y = t2.y-t1.y;
+			const float t31x = t3.x-t1.x;
+			const float t31y = t3.y-t1.y;
+			const SVec3 d1 = vsub(v2,v1);
+			const SVec3 d2 = vsub(v3,v1);
+
+			const float fSignedAreaSTx2 = t21x*t31y - t21y*t31x;
+			//assert(fSignedAreaSTx2!=0);
+			SVec3 vOs = vsub(vscale(t31y,d1), vscale(t21y,d2));	// eq 18
+			SVec3 vOt = vadd(vscale(-t31x,d1), vscale(t21x,d2)); // eq 19
+
+			pTriInfos[f].iFlag |= (fSignedAreaSTx2>0 ? ORIENT_PRESERVING : 0);
+
+			if ( NotZero(fSignedAreaSTx2) )
+			{
+				const float fAbsArea = fabsf(fSignedAreaSTx2);
+				const float fLenOs = Length(vOs);
+				const float fLenOt = Length(vOt);
+				const float fS = (pTriInfos[f].iFlag&ORIENT_PRESERVING)==0 ? (-1.0f) : 1.0f;
+				if ( NotZero(fLenOs) ) pTriInfos[f].vOs = vscale(fS/fLenOs, vOs);
+				if ( NotZero(fLenOt) ) pTriInfos[f].vOt = vscale(fS/fLenOt, vOt);
+
+				// evaluate magnitudes prior to normalization of vOs and vOt
+				pTriInfos[f].fMagS = fLenOs / fAbsArea;
+				pTriInfos[f].fMagT = fLenOt / fAbsArea;
+
+				// if this is a good triangle
+				if ( NotZero(pTriInfos[f].fMagS) && NotZero(pTriInfos[f].fMagT))
+					pTriInfos[f].iFlag &= (~GROUP_WITH_ANY);
+			}
 		}
 	}
+}
+
+static void InitTriInfo(STriInfo pTriInfos[], const int piTriListIn[], const SMikkTSpaceContext * pContext, const int iNrTrianglesIn)
+{
+	int t=0;
+	STriInfoData sTriData;
+	// pTriInfos[f].iFlag is cleared in GenerateInitialVerticesIndexList() which is called before this function.
+
+	// generate neighbor info list and evaluate first order derivatives, triangles are independent
+	sTriData.pTriInfos = pTriInfos;
+	sTriData.piTriListIn = piTriListIn;
+	sTriData.pContext = pContext;
+	RunParallel(pContext, iNrTrianglesIn, InitTriInfoRange, &sTriData);
 
 	// force otherwise healthy quads to a fixed orientation
 	while (t<(iNrTrianglesIn-1))
@@ -1195,140 +1388,243 @@ static tbool CompareSubGroups(const SSubGroup * pg1, const SSubGroup * pg2);
 static void QuickSort(int* pSortBuffer, int iLeft, int iRight, unsigned int uSeed);
 static STSpace EvalTspace(int face_indices[], const int iFaces, const int piTriListIn[], const STriInfo pTriInfos[], const SMikkTSpaceContext * pContext, const int iVertexRepresentitive);
 
+typedef struct {
+	const STriInfo * pTriInfos;
+	const SGroup * pGroups;
+	const int * piTriListIn;
+	const SMikkTSpaceContext * pContext;
+	float fThresCos;
+	int iMaxNrFaces;
+	int iFirstGroup;
+	const int * piMemberOffs;	// offset of the first member of each group in pMemberTspace
+	STSpace * pMemberTspace;	// resulting tangent space of each member of the groups
+	tbool * pbFailed;
+} SGroupTSpacesData;
+
+static int GroupCornerIndex(const STriInfo * pTriInfo, const SGroup * pGroup)
+{
+	int index=-1;
+	if (pTriInfo->AssignedGroup[0]==pGroup) index=0;
+	else if (pTriInfo->AssignedGroup[1]==pGroup) index=1;
+	else if (pTriInfo->AssignedGroup[2]==pGroup) index=2;
+	assert(index>=0 && index<3);
+	return index;
+}
+
+// split a group up into subgroups and evaluate the tangent space of every member, groups are independent
+static tbool EvalGroupTSpaces(const SGroupTSpacesData * pGroupData, const SGroup * pGroup, STSpace pMemberTspace[],
+                              STSpace pSubGroupTspace[], SSubGroup pUniSubGroups[], int pTmpMembers[])
+{
+	const STriInfo * pTriInfos = pGroupData->pTriInfos;
+	const int * piTriListIn = pGroupData->piTriListIn;
+	const SMikkTSpaceContext * pContext = pGroupData->pContext;
+	const float fThresCos = pGroupData->fThresCos;
+	int iUniqueSubGroups = 0, s=0, i=0;
+
+	for (i=0; i<pGroup->iNrFaces; i++)	// triangles
+	{
+		const int f = pGroup->pFaceIndices[i];	// triangle number
+		int index=-1, iVertIndex=-1, iOF_1=-1, iMembers=0, j=0, l=0;
+		SSubGroup tmp_group;
+		tbool bFound;
+		SVec3 n, vOs, vOt;
+		index = GroupCornerIndex(&pTriInfos[f], pGroup);
+
+		iVertIndex = piTriListIn[f*3+index];
+		assert(iVertIndex==pGroup->iVertexRepresentitive);
+
+		// is normalized already
+		n = GetNormal(pContext, iVertIndex);
+		
+		// project
+		vOs = vsub(pTriInfos[f].vOs, vscale(vdot(n,pTriInfos[f].vOs), n));
+		vOt = vsub(pTriInfos[f].vOt, vscale(vdot(n,pTriInfos[f].vOt), n));
+		if ( VNotZero(vOs) ) vOs = Normalize(vOs);
+		if ( VNotZero(vOt) ) vOt = Normalize(vOt);
+
+		// original face number
+		iOF_1 = pTriInfos[f].iOrgFaceNumber;
+		
+		iMembers = 0;
+		for (j=0; j<pGroup->iNrFaces; j++)
+		{
+			const int t = pGroup->pFaceIndices[j];	// triangle number
+			const int iOF_2 = pTriInfos[t].iOrgFaceNumber;
+
+			// project
+			SVec3 vOs2 = vsub(pTriInfos[t].vOs, vscale(vdot(n,pTriInfos[t].vOs), n));
+			SVec3 vOt2 = vsub(pTriInfos[t].vOt, vscale(vdot(n,pTriInfos[t].vOt), n));
+			if ( VNotZero(vOs2) ) vOs2 = Normalize(vOs2);
+			if ( VNotZero(vOt2) ) vOt2 = Normalize(vOt2);
+
+			{
+				const tbool bAny = ( (pTriInfos[f].iFlag | pTriInfos[t].iFlag) & GROUP_WITH_ANY )!=0 ? TTRUE : TFALSE;
+				// make sure triangles which belong to the same quad are joined.
+				const tbool bSameOrgFace = iOF_1==iOF_2 ? TTRUE : TFALSE;
+
+				const float fCosS = vdot(vOs,vOs2);
+				const float fCosT = vdot(vOt,vOt2);
+
+				assert(f!=t || bSameOrgFace);	// sanity check
+				if (bAny || bSameOrgFace || (fCosS>fThresCos && fCosT>fThresCos))
+					pTmpMembers[iMembers++] = t;
+			}
+		}
+
+		// sort pTmpMembers
+		tmp_group.iNrFaces = iMembers;
+		tmp_group.pTriMembers = pTmpMembers;
+		if (iMembers>1)
+		{
+			unsigned int uSeed = INTERNAL_RND_SORT_SEED;	// could replace with a random seed?
+			QuickSort(pTmpMembers, 0, iMembers-1, uSeed);
+		}
+
+		// look for an existing match
+		bFound = TFALSE;
+		l=0;
+		while (l<iUniqueSubGroups && !bFound)
+		{
+			bFound = CompareSubGroups(&tmp_group, &pUniSubGroups[l]);
+			if (!bFound) ++l;
+		}
+		
+		// assign tangent space index
+		assert(bFound || l==iUniqueSubGroups);
+
+		// if no match was found we allocate a new subgroup
+		if (!bFound)
+		{
+			// insert new subgroup
+			int * pIndices = (int *) malloc(sizeof(int)*iMembers);
+			if (pIndices==NULL)
+			{
+				// clean up and return false
+				for (s=0; s<iUniqueSubGroups; s++)
+					free(pUniSubGroups[s].pTriMembers);
+				return TFALSE;
+			}
+			pUniSubGroups[iUniqueSubGroups].iNrFaces = iMembers;
+			pUniSubGroups[iUniqueSubGroups].pTriMembers = pIndices;
+			memcpy(pIndices, tmp_group.pTriMembers, iMembers*sizeof(int));
+			pSubGroupTspace[iUniqueSubGroups] =
+				EvalTspace(tmp_group.pTriMembers, iMembers, piTriListIn, pTriInfos, pContext, pGroup->iVertexRepresentitive);
+			++iUniqueSubGroups;
+		}
+
+		pMemberTspace[i] = pSubGroupTspace[l];
+	}
+
+	// clean up
+	for (s=0; s<iUniqueSubGroups; s++)
+		free(pUniSubGroups[s].pTriMembers);
+
+	return TTRUE;
+}
+
+static void EvalGroupTSpacesRange(void * pData, const int iStart, const int iEnd)
+{
+	const SGroupTSpacesData * pGroupData = (const SGroupTSpacesData *) pData;
+	const int iMaxNrFaces = pGroupData->iMaxNrFaces;
+	STSpace * pSubGroupTspace = (STSpace *) malloc(sizeof(STSpace)*iMaxNrFaces);
+	SSubGroup * pUniSubGroups = (SSubGroup *) malloc(sizeof(SSubGroup)*iMaxNrFaces);
+	int * pTmpMembers = (int *) malloc(sizeof(int)*iMaxNrFaces);
+	int g=0;
+
+	for (g=iStart; g<iEnd; g++)
+	{
+		const SGroup * pGroup = &pGroupData->pGroups[pGroupData->iFirstGroup+g];
+		STSpace * pMemberTspace = &pGroupData->pMemberTspace[pGroupData->piMemberOffs[g]];
+		pGroupData->pbFailed[g] = TFALSE;
+		if (pSubGroupTspace==NULL || pUniSubGroups==NULL || pTmpMembers==NULL ||
+		    !EvalGroupTSpaces(pGroupData, pGroup, pMemberTspace, pSubGroupTspace, pUniSubGroups, pTmpMembers))
+		{
+			pGroupData->pbFailed[g] = TTRUE;
+		}
+	}
+
+	if (pSubGroupTspace!=NULL) free(pSubGroupTspace);
+	if (pUniSubGroups!=NULL) free(pUniSubGroups);
+	if (pTmpMembers!=NULL) free(pTmpMembers);
+}
+
 static tbool GenerateTSpaces(STSpace psTspace[], const STriInfo pTriInfos[], const SGroup pGroups[],
                              const int iNrActiveGroups, const int piTriListIn[], const float fThresCos,
                              const SMikkTSpaceContext * pContext)
 {
-	STSpace * pSubGroupTspace = NULL;
-	SSubGroup * pUniSubGroups = NULL;
-	int * pTmpMembers = NULL;
-	int iMaxNrFaces=0, iUniqueTspaces=0, g=0, i=0;
+	// groups are evaluated in batches of roughly this many members to bound the memory use
+	const int iBatchSize = 65536;
+	SGroupTSpacesData sGroupData;
+	STSpace * pMemberTspace = NULL;
+	int * piMemberOffs = NULL;
+	tbool * pbFailed = NULL;
+	int iMaxNrFaces=0, iMaxBatchSize=0, iFirstGroup=0, g=0, i=0;
 	for (g=0; g<iNrActiveGroups; g++)
 		if (iMaxNrFaces < pGroups[g].iNrFaces)
 			iMaxNrFaces = pGroups[g].iNrFaces;
 
 	if (iMaxNrFaces == 0) return TTRUE;
 
-	// make initial allocations
-	pSubGroupTspace = (STSpace *) malloc(sizeof(STSpace)*iMaxNrFaces);
-	pUniSubGroups = (SSubGroup *) malloc(sizeof(SSubGroup)*iMaxNrFaces);
-	pTmpMembers = (int *) malloc(sizeof(int)*iMaxNrFaces);
-	if (pSubGroupTspace==NULL || pUniSubGroups==NULL || pTmpMembers==NULL)
+	// make initial allocations, every group has at least one member
+	iMaxBatchSize = iMaxNrFaces > iBatchSize ? iMaxNrFaces : iBatchSize;
+	pMemberTspace = (STSpace *) malloc(sizeof(STSpace)*iMaxBatchSize);
+	piMemberOffs = (int *) malloc(sizeof(int)*iMaxBatchSize);
+	pbFailed = (tbool *) malloc(sizeof(tbool)*iMaxBatchSize);
+	if (pMemberTspace==NULL || piMemberOffs==NULL || pbFailed==NULL)
 	{
-		if (pSubGroupTspace!=NULL) free(pSubGroupTspace);
-		if (pUniSubGroups!=NULL) free(pUniSubGroups);
-		if (pTmpMembers!=NULL) free(pTmpMembers);
+		if (pMemberTspace!=NULL) free(pMemberTspace);
+		if (piMemberOffs!=NULL) free(piMemberOffs);
+		if (pbFailed!=NULL) free(pbFailed);
 		return TFALSE;
 	}
 
-
-	iUniqueTspaces = 0;
-	for (g=0; g<iNrActiveGroups; g++)
+	sGroupData.pTriInfos = pTriInfos;
+	sGroupData.pGroups = pGroups;
+	sGroupData.piTriListIn = piTriListIn;
+	sGroupData.pContext = pContext;
+	sGroupData.fThresCos = fThresCos;
+	sGroupData.iMaxNrFaces = iMaxNrFaces;
+	sGroupData.piMemberOffs = piMemberOffs;
+	sGroupData.pMemberTspace = pMemberTspace;
+	sGroupData.pbFailed = pbFailed;
+
+	while (iFirstGroup<iNrActiveGroups)
 	{
-		const SGroup * pGroup = &pGroups[g];
-		int iUniqueSubGroups = 0, s=0;
+		int iNrBatchGroups = 0, iNrBatchMembers = 0;
 
-		for (i=0; i<pGroup->iNrFaces; i++)	// triangles
+		// gather the batch
+		while ((iFirstGroup+iNrBatchGroups)<iNrActiveGroups &&
+		       (iNrBatchGroups==0 || (iNrBatchMembers+pGroups[iFirstGroup+iNrBatchGroups].iNrFaces)<=iMaxBatchSize))
 		{
-			const int f = pGroup->pFaceIndices[i];	// triangle number
-			int index=-1, iVertIndex=-1, iOF_1=-1, iMembers=0, j=0, l=0;
-			SSubGroup tmp_group;
-			tbool bFound;
-			SVec3 n, vOs, vOt;
-			if (pTriInfos[f].AssignedGroup[0]==pGroup) index=0;
-			else if (pTriInfos[f].AssignedGroup[1]==pGroup) index=1;
-			else if (pTriInfos[f].AssignedGroup[2]==pGroup) index=2;
-			assert(index>=0 && index<3);
-
-			iVertIndex = piTriListIn[f*3+index];
-			assert(iVertIndex==pGroup->iVertexRepresentitive);
-
-			// is normalized already
-			n = GetNormal(pContext, iVertIndex);
-			
-			// project
-			vOs = vsub(pTriInfos[f].vOs, vscale(vdot(n,pTriInfos[f].vOs), n));
-			vOt = vsub(pTriInfos[f].vOt, vscale(vdot(n,pTriInfos[f].vOt), n));
-			if ( VNotZero(vOs) ) vOs = Normalize(vOs);
-			if ( VNotZero(vOt) ) vOt = Normalize(vOt);
-
-			// original face number
-			iOF_1 = pTriInfos[f].iOrgFaceNumber;
-			
-			iMembers = 0;
-			for (j=0; j<pGroup->iNrFaces; j++)
-			{
-				const int t = pGroup->pFaceIndices[j];	// triangle number
-				const int iOF_2 = pTriInfos[t].iOrgFaceNumber;
-
-				// project
-				SVec3 vOs2 = vsub(pTriInfos[t].vOs, vscale(vdot(n,pTriInfos[t].vOs), n));
-				SVec3 vOt2 = vsub(pTriInfos[t].vOt, vscale(vdot(n,pTriInfos[t].vOt), n));
-				if ( VNotZero(vOs2) ) vOs2 = Normalize(vOs2);
-				if ( VNotZero(vOt2) ) vOt2 = Normalize(vOt2);
-
-				{
-					const tbool bAny = ( (pTriInfos[f].iFlag | pTriInfos[t].iFlag) & GROUP_WITH_ANY )!=0 ? TTRUE : TFALSE;
-					// make sure triangles which belong to the same quad are joined.
-					const tbool bSameOrgFace = iOF_1==iOF_2 ? TTRUE : TFALSE;
-
-					const float fCosS = vdot(vOs,vOs2);
-					const float fCosT = vdot(vOt,vOt2);
-
-					assert(f!=t || bSameOrgFace);	// sanity check
-					if (bAny || bSameOrgFace || (fCosS>fThresCos && fCosT>fThresCos))
-						pTmpMembers[iMembers++] = t;
-				}
-			}
+			piMemberOffs[iNrBatchGroups] = iNrBatchMembers;
+			iNrBatchMembers += pGroups[iFirstGroup+iNrBatchGroups].iNrFaces;
+			++iNrBatchGroups;
+		}
 
-			// sort pTmpMembers
-			tmp_group.iNrFaces = iMembers;
-			tmp_group.pTriMembers = pTmpMembers;
-			if (iMembers>1)
-			{
-				unsigned int uSeed = INTERNAL_RND_SORT_SEED;	// could replace with a random seed?
-				QuickSort(pTmpMembers, 0, iMembers-1, uSeed);
-			}
+		// evaluate the tangent spaces of all groups in the batch
+		sGroupData.iFirstGroup = iFirstGroup;
+		RunParallel(pContext, iNrBatchGroups, EvalGroupTSpacesRange, &sGroupData);
 
-			// look for an existing match
-			bFound = TFALSE;
-			l=0;
-			while (l<iUniqueSubGroups && !bFound)
-			{
-				bFound = CompareSubGroups(&tmp_group, &pUniSubGroups[l]);
-				if (!bFound) ++l;
-			}
-			
-			// assign tangent space index
-			assert(bFound || l==iUniqueSubGroups);
-			//piTempTangIndices[f*3+index] = iUniqueTspaces+l;
+		// output tspaces in group order, so that vertices shared by
+		// two groups are averaged the same way as if evaluated in sequence
+		for (g=0; g<iNrBatchGroups; g++)
+		{
+			const SGroup * pGroup = &pGroups[iFirstGroup+g];
 
-			// if no match was found we allocate a new subgroup
-			if (!bFound)
+			if (pbFailed[g])
 			{
-				// insert new subgroup
-				int * pIndices = (int *) malloc(sizeof(int)*iMembers);
-				if (pIndices==NULL)
-				{
-					// clean up and return false
-					int s=0;
-					for (s=0; s<iUniqueSubGroups; s++)
-						free(pUniSubGroups[s].pTriMembers);
-					free(pUniSubGroups);
-					free(pTmpMembers);
-					free(pSubGroupTspace);
-					return TFALSE;
-				}
-				pUniSubGroups[iUniqueSubGroups].iNrFaces = iMembers;
-				pUniSubGroups[iUniqueSubGroups].pTriMembers = pIndices;
-				memcpy(pIndices, tmp_group.pTriMembers, iMembers*sizeof(int));
-				pSubGroupTspace[iUniqueSubGroups] =
-					EvalTspace(tmp_group.pTriMembers, iMembers, piTriListIn, pTriInfos, pContext, pGroup->iVertexRepresentitive);
-				++iUniqueSubGroups;
+				// clean up and return false
+				free(pMemberTspace);
+				free(piMemberOffs);
+				free(pbFailed);
+				return TFALSE;
 			}
 
-			// output tspace
+			for (i=0; i<pGroup->iNrFaces; i++)	// triangles
 			{
+				const int f = pGroup->pFaceIndices[i];	// triangle number
+				const int index = GroupCornerIndex(&pTriInfos[f], pGroup);
+				const STSpace * pTS_in = &pMemberTspace[piMemberOffs[g]+i];
 				const int iOffs = pTriInfos[f].iTSpacesOffs;
 				const int iVert = pTriInfos[f].vert_num[index];
 				STSpace * pTS_out = &psTspace[iOffs+iVert];
@@ -1336,30 +1632,27 @@ static tbool GenerateTSpaces(STSpace psTspace[], const STriInfo pTriInfos[], con
 				assert(((pTriInfos[f].iFlag&ORIENT_PRESERVING)!=0) == pGroup->bOrientPreservering);
 				if (pTS_out->iCounter==1)
 				{
-					*pTS_out = AvgTSpace(pTS_out, &pSubGroupTspace[l]);
+					*pTS_out = AvgTSpace(pTS_out, pTS_in);
 					pTS_out->iCounter = 2;	// update counter
 					pTS_out->bOrient = pGroup->bOrientPreservering;
 				}
 				else
 				{
 					assert(pTS_out->iCounter==0);
-					*pTS_out = pSubGroupTspace[l];
+					*pTS_out = *pTS_in;
 					pTS_out->iCounter = 1;	// update counter
 					pTS_out->bOrient = pGroup->bOrientPreservering;
 				}
 			}
 		}
 
-		// clean up and offset iUniqueTspaces
-		for (s=0; s<iUniqueSubGroups; s++)
-			free(pUniSubGroups[s].pTriMembers);
-		iUniqueTspaces += iUniqueSubGroups;
+		iFirstGroup += iNrBatchGroups;
 	}
 
 	// clean up
-	free(pUniSubGroups);
-	free(pTmpMembers);
-	free(pSubGroupTspace);
+	free(pMemberTspace);
+	free(piMemberOffs);
+	free(pbFailed);
 
 	return TTRUE;
 }
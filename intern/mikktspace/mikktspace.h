@@ -101,6 +101,14 @@ typedef struct {
 	// DO NOT! use an already existing index list.
 	void (*m_setTSpace)(const SMikkTSpaceContext * pContext, const float fvTangent[], const float fvBiTangent[], const float fMagS, const float fMagT,
 						const tbool bIsOrientationPreserving, const int iFace, const int iVert);
+
+	// Optional call-back used to spread the work over multiple threads.
+	// It must call func(pData, iStart, iEnd) for ranges which together cover {0, 1, ..., iNrItems-1}
+	// exactly once, possibly from several threads at the same time, and return when all of them are done.
+	// When set, all the other call-backs may be called concurrently, m_setTSpace() and m_setTSpaceBasic()
+	// only ever for different faces. The results are identical to those of the single threaded version.
+	void (*m_runParallel)(const SMikkTSpaceContext * pContext, const int iNrItems,
+						  void (*func)(void * pData, const int iStart, const int iEnd), void * pData);
 } SMikkTSpaceInterface;
 
 struct SMikkTSpaceContext
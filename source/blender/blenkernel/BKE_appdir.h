@@ -62,6 +62,7 @@ enum {
 	BLENDER_USER_DATAFILES      = 32,
 	BLENDER_USER_SCRIPTS        = 33,
 	BLENDER_USER_AUTOSAVE       = 34,
+	BLENDER_USER_CACHE          = 35,
 
 	/* system */
 	BLENDER_SYSTEM_DATAFILES    = 52,
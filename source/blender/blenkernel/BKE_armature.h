@@ -33,6 +33,7 @@
  *  \author nzc
  */
 
+struct ArmatureSkinCache;
 struct Bone;
 struct GHash;
 struct Main;
@@ -92,6 +93,7 @@ struct GHash *BKE_armature_bone_from_name_map(struct bArmature *arm);
 bool         BKE_armature_bone_flag_test_recursive(const struct Bone *bone, int flag);
 
 float distfactor_to_bone(const float vec[3], const float b1[3], const float b2[3], float r1, float r2, float rdist);
+void BKE_armature_skin_cache_free(struct ArmatureSkinCache *skin);
 
 void BKE_armature_where_is(struct bArmature *arm);
 void BKE_armature_where_is_bone(struct Bone *bone, struct Bone *prevbone, const bool use_recursion);
@@ -180,6 +180,11 @@ enum {
 /* On write, restore paths after editing them (G_FILE_RELATIVE_REMAP) */
 #define G_FILE_SAVE_COPY         (1 << 27)
 #define G_FILE_GLSL_NO_ENV_LIGHTING (1 << 28)
+/* Compressed files are written as chunks compressed in parallel, see G_FILE_COMPRESS */
+#define G_FILE_COMPRESS_CHUNKED  (1 << 29)
+/* Mesh shape keys are saved as their changes to the reference key,
+ * older Blender versions read these keys empty */
+#define G_FILE_KEYS_SPARSE       (1 << 30)
 
 #define G_FILE_FLAGS_RUNTIME (G_FILE_NO_UI | G_FILE_RELATIVE_REMAP | G_FILE_MESH_COMPAT | G_FILE_SAVE_COPY)
 
@@ -56,6 +56,7 @@ struct Key *BKE_key_copy_nolib(struct Key *key);
 void        BKE_key_sort(struct Key *key);
 
 void key_curve_position_weights(float t, float data[4], int type);
+void key_curve_position_weights_array(const float *t, float (*data)[4], const int tot, const int type);
 void key_curve_tangent_weights(float t, float data[4], int type);
 void key_curve_normal_weights(float t, float data[4], int type);
 
@@ -90,6 +91,10 @@ void BKE_keyblock_free_per_block_weights(struct Key *key, float **per_keyblock_w
 void BKE_key_evaluate_relative(const int start, int end, const int tot, char *basispoin, struct Key *key, struct KeyBlock *actkb,
                                float **per_keyblock_weights, const int mode);
 
+/* must be called when shape key coordinates are modified in place */
+void BKE_keyblock_delta_cache_invalidate(struct Key *key, struct KeyBlock *kb);
+void BKE_key_delta_cache_free(struct Key *key);
+
 /* conversion functions */
 /* Note: 'update_from' versions do not (re)allocate mem in kb, while 'convert_from' do. */
 void    BKE_keyblock_update_from_lattice(struct Lattice *lt, struct KeyBlock *kb);
@@ -43,6 +43,7 @@ struct Scene;
 struct DerivedMesh;
 struct BPoint;
 struct MDeformVert;
+struct ArmatureSkinCache;
 
 void BKE_lattice_resize(struct Lattice *lt, int u, int v, int w, struct Object *ltOb);
 void BKE_lattice_init(struct Lattice *lt);
@@ -53,6 +54,7 @@ void BKE_lattice_make_local(struct Main *bmain, struct Lattice *lt, const bool l
 void calc_lat_fudu(int flag, int res, float *r_fu, float *r_du);
 
 struct LatticeDeformData;
+struct LatticeDeformCache;
 struct LatticeDeformData *init_latt_deform(struct Object *oblatt, struct Object *ob) ATTR_WARN_UNUSED_RESULT;
 void calc_latt_deform(struct LatticeDeformData *lattice_deform_data, float co[3], float weight);
 void end_latt_deform(struct LatticeDeformData *lattice_deform_data);
@@ -69,10 +71,20 @@ void curve_deform_vector(struct Scene *scene, struct Object *cuOb, struct Object
 void lattice_deform_verts(struct Object *laOb, struct Object *target,
                           struct DerivedMesh *dm, float (*vertexCos)[3],
                           int numVerts, const char *vgroup, float influence);
+void lattice_deform_verts_ex(struct Object *laOb, struct Object *target,
+                             struct DerivedMesh *dm, float (*vertexCos)[3],
+                             int numVerts, const char *vgroup, float influence,
+                             struct LatticeDeformCache **cache);
+void BKE_lattice_deform_cache_free(struct LatticeDeformCache *cache);
 void armature_deform_verts(struct Object *armOb, struct Object *target,
                            struct DerivedMesh *dm, float (*vertexCos)[3],
                            float (*defMats)[3][3], int numVerts, int deformflag,
                            float (*prevCos)[3], const char *defgrp_name);
+void armature_deform_verts_ex(struct Object *armOb, struct Object *target,
+                              struct DerivedMesh *dm, float (*vertexCos)[3],
+                              float (*defMats)[3][3], int numVerts, int deformflag,
+                              float (*prevCos)[3], const char *defgrp_name,
+                              struct ArmatureSkinCache **skin_cache);
 
 float (*BKE_lattice_vertexcos_get(struct Object *ob, int *r_numVerts))[3];
 void    BKE_lattice_vertexcos_apply(struct Object *ob, float (*vertexCos)[3]);
@@ -56,6 +56,7 @@ struct DerivedMesh;
 struct Scene;
 struct MLoopUV;
 struct ReportList;
+struct SMikkTSpaceContext;
 
 #ifdef __cplusplus
 extern "C" {
@@ -194,6 +195,9 @@ void BKE_mesh_loop_tangents_ex(
         struct ReportList *reports);
 void BKE_mesh_loop_tangents(
         struct Mesh *mesh, const char *uvmap, float (*r_looptangents)[4], struct ReportList *reports);
+void BKE_mesh_mikktspace_run_parallel(
+        const struct SMikkTSpaceContext *pContext, const int totitem,
+        void (*func)(void *data, const int start, const int end), void *userdata);
 
 /**
  * References a contiguous loop-fan with normal offset vars.
@@ -422,6 +422,34 @@ void modifier_mdef_compact_influences(struct ModifierData *md);
 void        modifier_path_init(char *path, int path_maxlen, const char *name);
 const char *modifier_path_relbase(struct Object *ob);
 
+/* Copy of the modifier stack result after an expensive modifier,
+ * mesh_calc_modifiers() resumes from the deepest valid one. */
+typedef struct ModifierResultCache {
+	/* hash of the stack input and of the settings of all modifiers up to this one */
+	unsigned int key;
+	CustomDataMask append_mask;
+	struct DerivedMesh *dm;
+	/* optional, evaluated in parallel to 'dm' */
+	struct DerivedMesh *orcodm, *clothorcodm;
+	size_t mem_size;
+} ModifierResultCache;
+
+typedef struct ModifierResultCacheStats {
+	size_t mem_used, mem_budget;
+	unsigned int num_entries;
+	/* evaluations resuming from a cached result, and evaluations without any valid one */
+	unsigned int num_hits, num_misses;
+} ModifierResultCacheStats;
+
+bool modifier_result_cache_store(
+        struct ModifierData *md, unsigned int key, CustomDataMask append_mask,
+        struct DerivedMesh *dm, struct DerivedMesh *orcodm, struct DerivedMesh *clothorcodm);
+void modifier_result_cache_free(struct ModifierData *md);
+void modifier_result_cache_invalidate(struct ModifierData *md);
+void modifier_result_cache_stats_count(const bool hit);
+void modifier_result_cache_stats_get(ModifierResultCacheStats *r_stats);
+void modifier_result_cache_budget_set(size_t mem_budget);
+
 
 /* wrappers for modifier callbacks */
 
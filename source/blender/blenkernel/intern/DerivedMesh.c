@@ -50,6 +50,7 @@
 #include "BLI_utildefines.h"
 #include "BLI_linklist.h"
 #include "BLI_task.h"
+#include "BLI_hash_mm2a.h"
 
 #include "BKE_cdderivedmesh.h"
 #include "BKE_editmesh.h"
@@ -75,6 +76,8 @@ static DerivedMesh *navmesh_dm_createNavMeshForVisualization(DerivedMesh *dm);
 
 #include "BLI_sys_types.h" /* for intptr_t support */
 
+#include "PIL_time.h"
+
 #include "GPU_buffers.h"
 #include "GPU_glew.h"
 #include "GPU_shader.h"
@@ -856,6 +859,8 @@ void DM_to_meshkey(DerivedMesh *dm, Mesh *me, KeyBlock *kb)
 	for (a = 0; a < kb->totelem; a++, fp += 3, mvert++) {
 		copy_v3_v3(fp, mvert->co);
 	}
+
+	BKE_keyblock_delta_cache_invalidate(me->key, kb);
 }
 
 /**
@@ -1613,6 +1618,8 @@ static void shapekey_layers_to_keyblocks(DerivedMesh *dm, Mesh *me, int actshape
 	
 	if (!me->key)
 		return;
+
+	BKE_key_delta_cache_free(me->key);
 	
 	tot = CustomData_number_of_layers(&dm->vertData, CD_SHAPEKEY);
 	for (i = 0; i < tot; i++) {
@@ -1722,6 +1729,231 @@ static void dm_ensure_display_normals(DerivedMesh *dm)
 	}
 }
 
+/* -------------------------------------------------------------------- */
+
+/** \name Modifier Result Cache
+ *
+ * The stack result after expensive modifiers is stored (see #modifier_result_cache_store),
+ * so changing a modifier only re-evaluates the stack from the deepest valid result before it.
+ *
+ * Results are validated by a key hashing the stack input (mesh data, deformed coordinates,
+ * vertex group names, evaluation parameters) and the settings of all modifiers up to the cached one.
+ * The data masks the result was built with are added to the key of each result too,
+ * since they depend on the modifiers after it (see #modifier_result_cache_key_masks).
+ * Modifiers depending on time or on other datablocks end the cacheable part of the stack,
+ * the whole cache of the object is freed when its mesh is tagged for update.
+ *
+ * \{ */
+
+/* Time spent evaluating the stack since the previous cached result (or the stack input)
+ * for the current result to be worth caching, in seconds. */
+#define MODIFIER_RESULT_CACHE_MIN_TIME 0.005
+
+static void modifier_result_cache_id_link_cb(void *userData, Object *UNUSED(ob), ID **idpoin, int UNUSED(cb_flag))
+{
+	bool *r_has_links = userData;
+
+	if (*idpoin) {
+		*r_has_links = true;
+	}
+}
+
+/**
+ * Whether the result of \a md only depends on its input and settings.
+ */
+static bool modifier_result_is_cacheable(Object *ob, ModifierData *md)
+{
+	const ModifierTypeInfo *mti = modifierType_getInfo(md->type);
+	bool has_links = false;
+
+	if (mti->dependsOnTime && mti->dependsOnTime(md)) {
+		return false;
+	}
+
+	/* displacements are edited in place by sculpting */
+	if (md->type == eModifierType_Multires) {
+		return false;
+	}
+
+	if (mti->foreachIDLink) {
+		mti->foreachIDLink(md, ob, modifier_result_cache_id_link_cb, &has_links);
+	}
+	else if (mti->foreachObjectLink) {
+		mti->foreachObjectLink(md, ob, (ObjectWalkFunc)modifier_result_cache_id_link_cb, &has_links);
+	}
+
+	return !has_links;
+}
+
+static unsigned int modifier_result_cache_key_add(unsigned int key, ModifierData *md)
+{
+	const ModifierTypeInfo *mti = modifierType_getInfo(md->type);
+	BLI_HashMurmur2A mm2;
+
+	BLI_hash_mm2a_init(&mm2, key);
+	BLI_hash_mm2a_add_int(&mm2, md->type);
+	BLI_hash_mm2a_add_int(&mm2, md->mode);
+	/* all settings, runtime pointers stored in modifiers only cause extra misses */
+	BLI_hash_mm2a_add(&mm2, (const unsigned char *)(md + 1), (size_t)mti->structSize - sizeof(ModifierData));
+
+	return BLI_hash_mm2a_end(&mm2);
+}
+
+/**
+ * Key a result is stored with, adding the layers which are kept (\a curr) and those which the following
+ * modifiers need (ORCO for example), both change when enabling options of later modifiers.
+ */
+static unsigned int modifier_result_cache_key_masks(unsigned int key, CDMaskLink *curr, CustomDataMask dataMask)
+{
+	const CustomDataMask nextmask = curr->next ? curr->next->mask : dataMask;
+	BLI_HashMurmur2A mm2;
+
+	BLI_hash_mm2a_init(&mm2, key);
+	BLI_hash_mm2a_add(&mm2, (const unsigned char *)&curr->mask, sizeof(curr->mask));
+	BLI_hash_mm2a_add(&mm2, (const unsigned char *)&nextmask, sizeof(nextmask));
+
+	return BLI_hash_mm2a_end(&mm2);
+}
+
+static void customdata_hash_add(BLI_HashMurmur2A *mm2, const CustomData *data, const int totelem)
+{
+	int i;
+
+	BLI_hash_mm2a_add_int(mm2, totelem);
+
+	for (i = 0; i < data->totlayer; i++) {
+		const CustomDataLayer *layer = &data->layers[i];
+
+		BLI_hash_mm2a_add_int(mm2, layer->type);
+		BLI_hash_mm2a_add(mm2, (const unsigned char *)layer->name, strlen(layer->name));
+
+		if (layer->data == NULL) {
+			continue;
+		}
+
+		if (layer->type == CD_MDEFORMVERT) {
+			/* weights are stored outside of the layer */
+			const MDeformVert *dvert = layer->data;
+			int j;
+
+			for (j = 0; j < totelem; j++) {
+				BLI_hash_mm2a_add_int(mm2, dvert[j].totweight);
+				if (dvert[j].dw) {
+					BLI_hash_mm2a_add(
+					        mm2, (const unsigned char *)dvert[j].dw, sizeof(*dvert[j].dw) * (size_t)dvert[j].totweight);
+				}
+			}
+		}
+		else {
+			BLI_hash_mm2a_add(mm2, layer->data, (size_t)CustomData_sizeof(layer->type) * (size_t)totelem);
+		}
+	}
+}
+
+/**
+ * Key of the stack input, mesh data is hashed since not all operators tag the mesh when editing it.
+ */
+static unsigned int modifier_result_cache_input_key(
+        Scene *scene, Object *ob, Mesh *me, float (*deformedVerts)[3], const int numVerts,
+        CustomDataMask dataMask, const bool need_mapping)
+{
+	BLI_HashMurmur2A mm2;
+	bDeformGroup *dg;
+
+	BLI_hash_mm2a_init(&mm2, 0);
+	BLI_hash_mm2a_add(&mm2, (const unsigned char *)&me, sizeof(me));
+	BLI_hash_mm2a_add(&mm2, (const unsigned char *)&dataMask, sizeof(dataMask));
+	BLI_hash_mm2a_add_int(&mm2, need_mapping);
+	BLI_hash_mm2a_add(&mm2, (const unsigned char *)ob->obmat, sizeof(ob->obmat));
+	BLI_hash_mm2a_add_int(&mm2, (scene->r.mode & R_SIMPLIFY) ? scene->r.simplify_subsurf : -1);
+
+	if (deformedVerts) {
+		BLI_hash_mm2a_add(&mm2, (const unsigned char *)deformedVerts, sizeof(*deformedVerts) * (size_t)numVerts);
+	}
+
+	/* modifiers look vertex groups up by name, renaming or reordering them only tags the object */
+	for (dg = ob->defbase.first; dg; dg = dg->next) {
+		BLI_hash_mm2a_add(&mm2, (const unsigned char *)dg->name, strlen(dg->name) + 1);
+	}
+
+	customdata_hash_add(&mm2, &me->vdata, me->totvert);
+	customdata_hash_add(&mm2, &me->edata, me->totedge);
+	customdata_hash_add(&mm2, &me->fdata, me->totface);
+	customdata_hash_add(&mm2, &me->ldata, me->totloop);
+	customdata_hash_add(&mm2, &me->pdata, me->totpoly);
+
+	return BLI_hash_mm2a_end(&mm2);
+}
+
+/**
+ * Whether some result of the stack starting at \a md could be cached and used,
+ * a cacheable constructive modifier which is followed by other modifiers.
+ */
+static bool modifier_result_cache_is_used(Scene *scene, Object *ob, ModifierData *md, const int required_mode)
+{
+	for (; md && md->next; md = md->next) {
+		if (!modifier_isEnabled(scene, md, required_mode)) {
+			continue;
+		}
+		if (!modifier_result_is_cacheable(ob, md)) {
+			break;
+		}
+		if (modifierType_getInfo(md->type)->type != eModifierTypeType_OnlyDeform) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * Find the deepest valid cached result of the stack starting at \a md,
+ * freeing the results which aren't valid anymore.
+ *
+ * \param curr: Data masks of \a md and the following modifiers.
+ * \param key: Key of the stack input.
+ */
+static ModifierData *modifier_result_cache_find(
+        Scene *scene, Object *ob, ModifierData *md, CDMaskLink *curr, CustomDataMask dataMask,
+        const int required_mode, unsigned int key, unsigned int *r_key)
+{
+	ModifierData *md_found = NULL;
+
+	for (; md; md = md->next, curr = curr->next) {
+		if (modifier_isEnabled(scene, md, required_mode) && !modifier_result_is_cacheable(ob, md)) {
+			modifier_result_cache_invalidate(md);
+			break;
+		}
+
+		key = modifier_result_cache_key_add(key, md);
+
+		if (md->result_cache) {
+			if (md->result_cache->key == modifier_result_cache_key_masks(key, curr, dataMask)) {
+				md_found = md;
+				*r_key = key;
+			}
+			else {
+				modifier_result_cache_free(md);
+			}
+		}
+	}
+
+	return md_found;
+}
+
+static bool modifier_result_cache_has_errors(ModifierData *md_begin, ModifierData *md_end)
+{
+	ModifierData *md;
+
+	for (md = md_begin; md != md_end->next; md = md->next) {
+		if (md->error) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/** \} */
+
 /**
  * new value for useDeform -1  (hack for the gameengine):
  *
@@ -1774,6 +2006,13 @@ static void mesh_calc_modifiers(
 	ModifierApplyFlag app_flags = useRenderParams ? MOD_APPLY_RENDER : 0;
 	ModifierApplyFlag deform_app_flags = app_flags;
 
+	/* Only cache results of the viewport evaluation in object mode, see modifier_result_cache_store(). */
+	bool use_result_cache = (useCache && !useRenderParams && (index == -1) && (useDeform > 0) &&
+	                         !inputVertexCos && !build_shapekey_layers && (ob->mode == OB_MODE_OBJECT));
+	unsigned int result_cache_key = 0;
+	double result_cache_time = 0.0;
+	ModifierData *md_stack_begin;
+
 
 	if (useCache)
 		app_flags |= MOD_APPLY_USECACHE;
@@ -1883,11 +2122,64 @@ static void mesh_calc_modifiers(
 	orcodm = NULL;
 	clothorcodm = NULL;
 
+	if (use_result_cache) {
+		if (me->id.tag & LIB_TAG_ID_RECALC_ALL) {
+			modifier_result_cache_invalidate(ob->modifiers.first);
+		}
+
+		use_result_cache = modifier_result_cache_is_used(scene, ob, md, required_mode);
+	}
+
+	if (use_result_cache) {
+		const unsigned int input_key = modifier_result_cache_input_key(
+		        scene, ob, me, deformedVerts, numVerts, dataMask, need_mapping);
+		ModifierData *md_cached = modifier_result_cache_find(
+		        scene, ob, md, curr, dataMask, required_mode, input_key, &result_cache_key);
+
+		modifier_result_cache_stats_count(md_cached != NULL);
+
+		if (md_cached) {
+			/* resume from the cached result */
+			const ModifierResultCache *cache = md_cached->result_cache;
+
+			dm = CDDM_copy(cache->dm);
+			orcodm = cache->orcodm ? CDDM_copy(cache->orcodm) : NULL;
+			clothorcodm = cache->clothorcodm ? CDDM_copy(cache->clothorcodm) : NULL;
+			append_mask = cache->append_mask;
+
+			if (deformedVerts) {
+				MEM_freeN(deformedVerts);
+				deformedVerts = NULL;
+			}
+
+			for (; md != md_cached->next; md = md->next, curr = curr->next) {
+				md->scene = scene;
+			}
+		}
+		else {
+			result_cache_key = input_key;
+		}
+
+		result_cache_time = PIL_check_seconds_timer();
+	}
+
+	md_stack_begin = md;
+
 	for (; md; md = md->next, curr = curr->next) {
 		const ModifierTypeInfo *mti = modifierType_getInfo(md->type);
 
 		md->scene = scene;
 
+		if (use_result_cache) {
+			/* same as modifier_result_cache_find() */
+			if (modifier_isEnabled(scene, md, required_mode) && !modifier_result_is_cacheable(ob, md)) {
+				use_result_cache = false;
+			}
+			else {
+				result_cache_key = modifier_result_cache_key_add(result_cache_key, md);
+			}
+		}
+
 		if (!modifier_isEnabled(scene, md, required_mode)) {
 			continue;
 		}
@@ -2123,6 +2415,18 @@ static void mesh_calc_modifiers(
 				DM_update_weight_mcol(ob, dm, draw_flag, NULL, 0, NULL);
 				append_mask |= CD_MASK_PREVIEW_MLOOPCOL;
 			}
+
+			/* cache the result when it was expensive to get, except for the last modifier
+			 * (nothing to resume, the final DerivedMesh may not be a CDDM) */
+			if (use_result_cache && md->next && (deformedVerts == NULL) &&
+			    (PIL_check_seconds_timer() - result_cache_time >= MODIFIER_RESULT_CACHE_MIN_TIME) &&
+			    !modifier_result_cache_has_errors(md_stack_begin, md))
+			{
+				modifier_result_cache_store(
+				        md, modifier_result_cache_key_masks(result_cache_key, curr, dataMask),
+				        append_mask, dm, orcodm, clothorcodm);
+				result_cache_time = PIL_check_seconds_timer();
+			}
 		}
 
 		isPrevDeform = (mti->type == eModifierTypeType_OnlyDeform);
@@ -3274,6 +3578,7 @@ static void DM_calc_loop_tangents_thread(TaskPool * __restrict UNUSED(pool), voi
 		sInterface.m_getTexCoord = dm_ts_GetTextureCoordinate;
 		sInterface.m_getNormal = dm_ts_GetNormal;
 		sInterface.m_setTSpaceBasic = dm_ts_SetTSpace;
+		sInterface.m_runParallel = BKE_mesh_mikktspace_run_parallel;
 
 		/* 0 if failed */
 		genTangSpaceDefault(&sContext);
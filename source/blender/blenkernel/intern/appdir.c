@@ -380,6 +380,10 @@ const char *BKE_appdir_folder_id(const int folder_id, const char *subfolder)
 			if (get_path_user(path, "autosave", subfolder, "BLENDER_USER_DATAFILES", ver)) break;
 			return NULL;
 
+		case BLENDER_USER_CACHE:
+			if (get_path_user(path, "cache", subfolder, "BLENDER_USER_CACHE", ver)) break;
+			return NULL;
+
 		case BLENDER_USER_CONFIG:
 			if (get_path_user(path, "config", subfolder, "BLENDER_USER_CONFIG", ver)) break;
 			return NULL;
@@ -424,6 +428,9 @@ const char *BKE_appdir_folder_id_user_notest(const int folder_id, const char *su
 		case BLENDER_USER_AUTOSAVE:
 			get_path_user(path, "autosave", subfolder, "BLENDER_USER_AUTOSAVE", ver);
 			break;
+		case BLENDER_USER_CACHE:
+			get_path_user(path, "cache", subfolder, "BLENDER_USER_CACHE", ver);
+			break;
 		case BLENDER_USER_SCRIPTS:
 			get_path_user(path, "scripts", subfolder, "BLENDER_USER_SCRIPTS", ver);
 			break;
@@ -446,8 +453,11 @@ const char *BKE_appdir_folder_id_create(const int folder_id, const char *subfold
 	const char *path;
 
 	/* only for user folders */
-	if (!ELEM(folder_id, BLENDER_USER_DATAFILES, BLENDER_USER_CONFIG, BLENDER_USER_SCRIPTS, BLENDER_USER_AUTOSAVE))
+	if (!ELEM(folder_id, BLENDER_USER_DATAFILES, BLENDER_USER_CONFIG, BLENDER_USER_SCRIPTS,
+	          BLENDER_USER_AUTOSAVE, BLENDER_USER_CACHE))
+	{
 		return NULL;
+	}
 	
 	path = BKE_appdir_folder_id(folder_id, subfolder);
 	
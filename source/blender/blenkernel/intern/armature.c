@@ -41,6 +41,7 @@
 #include "BLI_listbase.h"
 #include "BLI_string.h"
 #include "BLI_ghash.h"
+#include "BLI_hash_mm2a.h"
 #include "BLI_task.h"
 #include "BLI_utildefines.h"
 
@@ -954,22 +955,455 @@ static void armature_bbone_defmats_cb(void *userdata, Link *iter, int index)
 	}
 }
 
-void armature_deform_verts(Object *armOb, Object *target, DerivedMesh *dm, float (*vertexCos)[3],
-                           float (*defMats)[3][3], int numVerts, int deformflag,
-                           float (*prevCos)[3], const char *defgrp_name)
+/* -------------------------------------------------------------------- */
+/** \name Armature Skin Table
+ *
+ * Compact table of the pose channels and weights deforming each vertex,
+ * so the threaded vertex loop doesn't need to map deform-vert groups to channels.
+ * Callers evaluating the same target repeatedly (the armature modifier) keep it around,
+ * it's validated by hashing the weights since they are edited in-place.
+ * \{ */
+
+/* vertices are hashed and deformed in blocks of this size */
+#define ARMATURE_DEFORM_BLOCK_SIZE 256
+/* below this amount of vertices threading isn't worth the overhead */
+#define ARMATURE_DEFORM_THREADED_MIN 1024
+
+typedef struct ArmatureSkinCache {
+	unsigned int key;
+	int numverts;
+
+	/* when using vertex groups, the channels of vertex 'i' are in 'index'/'weight' [offs[i], offs[i + 1]) */
+	int *offs;
+	int *index;
+	float *weight;
+
+	/* when using the overall armature group, NULL otherwise */
+	float *armature_weight;
+	float *prevco_weight;
+} ArmatureSkinCache;
+
+typedef struct ArmatureSkinParams {
+	const MDeformVert *dverts;
+	int dverts_tot;
+	const int *defnr_to_index;  /* pose channel index of each group, -1 for non-deforming ones */
+	int defbase_tot;
+	bool use_dverts;
+	int armature_def_nr;
+	bool invert_vgroup;
+	bool use_prevcos;
+} ArmatureSkinParams;
+
+BLI_INLINE const MDeformVert *armature_skin_dvert(const ArmatureSkinParams *params, const int i)
+{
+	return (params->dverts && i < params->dverts_tot) ? &params->dverts[i] : NULL;
+}
+
+BLI_INLINE void armature_deform_block_range(const int numverts, const int block, int *r_start, int *r_end)
+{
+	*r_start = block * ARMATURE_DEFORM_BLOCK_SIZE;
+	*r_end = min_ii(*r_start + ARMATURE_DEFORM_BLOCK_SIZE, numverts);
+}
+
+BLI_INLINE bool armature_skin_dw_is_used(const ArmatureSkinParams *params, const MDeformWeight *dw)
+{
+	return (dw->def_nr >= 0 && dw->def_nr < params->defbase_tot && params->defnr_to_index[dw->def_nr] != -1);
+}
+
+typedef struct ArmatureSkinBuildData {
+	const ArmatureSkinParams *params;
+	int numverts;
+	ArmatureSkinCache *skin;
+	unsigned int *block_keys;
+} ArmatureSkinBuildData;
+
+/* multiply-xor chain over the weights, each step is invertible so editing any single weight changes the key */
+BLI_INLINE unsigned int armature_skin_key_step(unsigned int key, const unsigned int value)
+{
+	return (key ^ value) * 0x9E3779B1u;
+}
+
+static void armature_skin_key_block_cb(void *userdata, const int block)
+{
+	const ArmatureSkinBuildData *data = userdata;
+	unsigned int key = (unsigned int)block;
+	int i, i_end;
+
+	armature_deform_block_range(data->numverts, block, &i, &i_end);
+	for (; i < i_end; i++) {
+		const MDeformVert *dvert = armature_skin_dvert(data->params, i);
+
+		if (dvert == NULL) {
+			key = armature_skin_key_step(key, (unsigned int)-1);
+		}
+		else {
+			const MDeformWeight *dw = dvert->dw;
+			unsigned int j;
+
+			key = armature_skin_key_step(key, (unsigned int)dvert->totweight);
+			for (j = dvert->totweight; j != 0; j--, dw++) {
+				unsigned int weight_bits;
+
+				memcpy(&weight_bits, &dw->weight, sizeof(weight_bits));
+				key = armature_skin_key_step(key, (unsigned int)dw->def_nr);
+				key = armature_skin_key_step(key, weight_bits);
+			}
+		}
+	}
+
+	data->block_keys[block] = key;
+}
+
+static unsigned int armature_skin_key(const ArmatureSkinParams *params, const int numverts)
+{
+	const int totblock = (numverts + ARMATURE_DEFORM_BLOCK_SIZE - 1) / ARMATURE_DEFORM_BLOCK_SIZE;
+	ArmatureSkinBuildData data = {.params = params, .numverts = numverts};
+	BLI_HashMurmur2A mm2;
+
+	data.block_keys = MEM_mallocN(sizeof(*data.block_keys) * (size_t)max_ii(totblock, 1), __func__);
+	BLI_task_parallel_range(
+	        0, totblock, &data, armature_skin_key_block_cb, numverts >= ARMATURE_DEFORM_THREADED_MIN);
+
+	BLI_hash_mm2a_init(&mm2, 0);
+	BLI_hash_mm2a_add_int(&mm2, numverts);
+	BLI_hash_mm2a_add_int(&mm2, params->use_dverts);
+	BLI_hash_mm2a_add_int(&mm2, params->armature_def_nr);
+	BLI_hash_mm2a_add_int(&mm2, params->invert_vgroup);
+	BLI_hash_mm2a_add_int(&mm2, params->use_prevcos);
+	BLI_hash_mm2a_add_int(&mm2, params->defbase_tot);
+
+	if (params->use_dverts) {
+		BLI_hash_mm2a_add(
+		        &mm2, (const unsigned char *)params->defnr_to_index,
+		        sizeof(*params->defnr_to_index) * (size_t)params->defbase_tot);
+	}
+
+	BLI_hash_mm2a_add(&mm2, (const unsigned char *)data.block_keys, sizeof(*data.block_keys) * (size_t)totblock);
+
+	MEM_freeN(data.block_keys);
+
+	return BLI_hash_mm2a_end(&mm2);
+}
+
+/* amount of used weights of each vertex, stored in 'offs[i + 1]' before accumulating */
+static void armature_skin_count_block_cb(void *userdata, const int block)
+{
+	const ArmatureSkinBuildData *data = userdata;
+	int *offs = data->skin->offs;
+	int i, i_end;
+
+	armature_deform_block_range(data->numverts, block, &i, &i_end);
+	for (; i < i_end; i++) {
+		const MDeformVert *dvert = armature_skin_dvert(data->params, i);
+		int tot = 0;
+
+		if (dvert) {
+			const MDeformWeight *dw = dvert->dw;
+			unsigned int j;
+
+			for (j = dvert->totweight; j != 0; j--, dw++) {
+				tot += armature_skin_dw_is_used(data->params, dw);
+			}
+		}
+
+		offs[i + 1] = tot;
+	}
+}
+
+static void armature_skin_fill_block_cb(void *userdata, const int block)
+{
+	const ArmatureSkinBuildData *data = userdata;
+	const ArmatureSkinParams *params = data->params;
+	ArmatureSkinCache *skin = data->skin;
+	int i, i_end;
+
+	armature_deform_block_range(data->numverts, block, &i, &i_end);
+	for (; i < i_end; i++) {
+		const MDeformVert *dvert = armature_skin_dvert(params, i);
+
+		if (skin->offs && dvert) {
+			const MDeformWeight *dw = dvert->dw;
+			int k = skin->offs[i];
+			unsigned int j;
+
+			/* keep the deform-vert order, so weights are accumulated in the same order as before */
+			for (j = dvert->totweight; j != 0; j--, dw++) {
+				if (armature_skin_dw_is_used(params, dw)) {
+					skin->index[k] = params->defnr_to_index[dw->def_nr];
+					skin->weight[k] = dw->weight;
+					k++;
+				}
+			}
+		}
+
+		if (skin->armature_weight) {
+			float armature_weight = 1.0f;
+			float prevco_weight = 1.0f;
+
+			if (dvert) {
+				armature_weight = defvert_find_weight(dvert, params->armature_def_nr);
+
+				if (params->invert_vgroup)
+					armature_weight = 1.0f - armature_weight;
+
+				/* hackish: the blending factor can be used for blending with prevCos too */
+				if (params->use_prevcos) {
+					prevco_weight = armature_weight;
+					armature_weight = 1.0f;
+				}
+			}
+
+			skin->armature_weight[i] = armature_weight;
+			skin->prevco_weight[i] = prevco_weight;
+		}
+	}
+}
+
+static ArmatureSkinCache *armature_skin_cache_build(const ArmatureSkinParams *params, const int numverts)
+{
+	const int totblock = (numverts + ARMATURE_DEFORM_BLOCK_SIZE - 1) / ARMATURE_DEFORM_BLOCK_SIZE;
+	const bool use_threading = numverts >= ARMATURE_DEFORM_THREADED_MIN;
+	ArmatureSkinCache *skin = MEM_callocN(sizeof(*skin), __func__);
+	ArmatureSkinBuildData data = {.params = params, .numverts = numverts, .skin = skin};
+	int i;
+
+	skin->numverts = numverts;
+
+	if (params->use_dverts) {
+		skin->offs = MEM_mallocN(sizeof(*skin->offs) * (size_t)(numverts + 1), __func__);
+		skin->offs[0] = 0;
+
+		BLI_task_parallel_range(0, totblock, &data, armature_skin_count_block_cb, use_threading);
+
+		for (i = 0; i < numverts; i++) {
+			skin->offs[i + 1] += skin->offs[i];
+		}
+
+		skin->index = MEM_mallocN(sizeof(*skin->index) * (size_t)max_ii(skin->offs[numverts], 1), __func__);
+		skin->weight = MEM_mallocN(sizeof(*skin->weight) * (size_t)max_ii(skin->offs[numverts], 1), __func__);
+	}
+
+	if (params->armature_def_nr != -1) {
+		skin->armature_weight = MEM_mallocN(sizeof(*skin->armature_weight) * (size_t)numverts, __func__);
+		skin->prevco_weight = MEM_mallocN(sizeof(*skin->prevco_weight) * (size_t)numverts, __func__);
+	}
+
+	BLI_task_parallel_range(0, totblock, &data, armature_skin_fill_block_cb, use_threading);
+
+	return skin;
+}
+
+void BKE_armature_skin_cache_free(ArmatureSkinCache *skin)
+{
+	if (skin == NULL) {
+		return;
+	}
+
+	MEM_SAFE_FREE(skin->offs);
+	MEM_SAFE_FREE(skin->index);
+	MEM_SAFE_FREE(skin->weight);
+	MEM_SAFE_FREE(skin->armature_weight);
+	MEM_SAFE_FREE(skin->prevco_weight);
+	MEM_freeN(skin);
+}
+
+/** \} */
+
+typedef struct ArmatureDeformData {
+	bPoseChannel **pchan_array;
+	bPoseChanDeform *pdef_info_array;
+	int totchan;
+	const ArmatureSkinCache *skin;
+
+	float (*vertexCos)[3];
+	float (*defMats)[3][3];
+	float (*prevCos)[3];
+	int numverts;
+
+	bool use_envelope;
+	bool use_quaternion;
+
+	float premat[4][4];
+	float postmat[4][4];
+} ArmatureDeformData;
+
+BLI_INLINE void armature_vert_deform(ArmatureDeformData *data, const int i)
+{
+	const ArmatureSkinCache *skin = data->skin;
+	float (*vertexCos)[3] = data->vertexCos;
+	float (*defMats)[3][3] = data->defMats;
+	float (*prevCos)[3] = data->prevCos;
+	const bool use_quaternion = data->use_quaternion;
+	bPoseChannel *pchan;
+	DualQuat sumdq, *dq = NULL;
+	float *co, dco[3];
+	float sumvec[3], summat[3][3];
+	float *vec = NULL, (*smat)[3] = NULL;
+	float contrib = 0.0f;
+	float armature_weight = 1.0f; /* default to 1 if no overall def group */
+	float prevco_weight = 1.0f;   /* weight for optional cached vertexcos */
+	int j, j_end;
+
+	if (use_quaternion) {
+		memset(&sumdq, 0, sizeof(DualQuat));
+		dq = &sumdq;
+	}
+	else {
+		sumvec[0] = sumvec[1] = sumvec[2] = 0.0f;
+		vec = sumvec;
+
+		if (defMats) {
+			zero_m3(summat);
+			smat = summat;
+		}
+	}
+
+	if (skin && skin->armature_weight) {
+		armature_weight = skin->armature_weight[i];
+		prevco_weight = skin->prevco_weight[i];
+	}
+
+	/* check if there's any  point in calculating for this vert */
+	if (armature_weight == 0.0f)
+		return;
+
+	/* get the coord we work on */
+	co = prevCos ? prevCos[i] : vertexCos[i];
+
+	/* Apply the object's matrix */
+	mul_m4_v3(data->premat, co);
+
+	if (skin && skin->offs) {
+		j = skin->offs[i];
+		j_end = skin->offs[i + 1];
+	}
+	else {
+		j = j_end = 0;
+	}
+
+	if (j != j_end) { /* use weight groups */
+		for (; j < j_end; j++) {
+			float weight = skin->weight[j];
+			pchan = data->pchan_array[skin->index[j]];
+
+			if (pchan->bone->flag & BONE_MULT_VG_ENV) {
+				Bone *bone = pchan->bone;
+				weight *= distfactor_to_bone(co, bone->arm_head, bone->arm_tail,
+				                             bone->rad_head, bone->rad_tail, bone->dist);
+			}
+
+			if (vec && (smat == NULL) && (pchan->bone->segments <= 1)) {
+				/* common linear blend case, same math as pchan_bone_deform() and mul_m4_v3() inlined */
+				if (weight != 0.0f) {
+					float (*mat)[4] = pchan->chan_mat;
+					float cop[3];
+
+					cop[0] = co[0] * mat[0][0] + co[1] * mat[1][0] + mat[2][0] * co[2] + mat[3][0];
+					cop[1] = co[0] * mat[0][1] + co[1] * mat[1][1] + mat[2][1] * co[2] + mat[3][1];
+					cop[2] = co[0] * mat[0][2] + co[1] * mat[1][2] + mat[2][2] * co[2] + mat[3][2];
+
+					vec[0] += (cop[0] - co[0]) * weight;
+					vec[1] += (cop[1] - co[1]) * weight;
+					vec[2] += (cop[2] - co[2]) * weight;
+
+					contrib += weight;
+				}
+			}
+			else {
+				pchan_bone_deform(
+				        pchan, &data->pdef_info_array[skin->index[j]], weight, vec, dq, smat, co, &contrib);
+			}
+		}
+	}
+	/* also when there are vertexgroups but not groups with bones
+	 * (like for softbody groups) */
+	else if (data->use_envelope) {
+		for (j = 0; j < data->totchan; j++) {
+			pchan = data->pchan_array[j];
+			if (!(pchan->bone->flag & BONE_NO_DEFORM))
+				contrib += dist_bone_deform(pchan, &data->pdef_info_array[j], vec, dq, smat, co);
+		}
+	}
+
+	/* actually should be EPSILON? weight values and contrib can be like 10e-39 small */
+	if (contrib > 0.0001f) {
+		if (use_quaternion) {
+			normalize_dq(dq, contrib);
+
+			if (armature_weight != 1.0f) {
+				copy_v3_v3(dco, co);
+				mul_v3m3_dq(dco, (defMats) ? summat : NULL, dq);
+				sub_v3_v3(dco, co);
+				mul_v3_fl(dco, armature_weight);
+				add_v3_v3(co, dco);
+			}
+			else
+				mul_v3m3_dq(co, (defMats) ? summat : NULL, dq);
+
+			smat = summat;
+		}
+		else {
+			mul_v3_fl(vec, armature_weight / contrib);
+			add_v3_v3v3(co, vec, co);
+		}
+
+		if (defMats) {
+			float pre[3][3], post[3][3], tmpmat[3][3];
+
+			copy_m3_m4(pre, data->premat);
+			copy_m3_m4(post, data->postmat);
+			copy_m3_m3(tmpmat, defMats[i]);
+
+			if (!use_quaternion) /* quaternion already is scale corrected */
+				mul_m3_fl(smat, armature_weight / contrib);
+
+			mul_m3_series(defMats[i], post, smat, pre, tmpmat);
+		}
+	}
+
+	/* always, check above code */
+	mul_m4_v3(data->postmat, co);
+
+	/* interpolate with previous modifier position using weight group */
+	if (prevCos) {
+		float mw = 1.0f - prevco_weight;
+		vertexCos[i][0] = prevco_weight * vertexCos[i][0] + mw * co[0];
+		vertexCos[i][1] = prevco_weight * vertexCos[i][1] + mw * co[1];
+		vertexCos[i][2] = prevco_weight * vertexCos[i][2] + mw * co[2];
+	}
+}
+
+static void armature_deform_block_cb(void *userdata, const int block)
+{
+	ArmatureDeformData *data = userdata;
+	int i, i_end;
+
+	armature_deform_block_range(data->numverts, block, &i, &i_end);
+	for (; i < i_end; i++) {
+		armature_vert_deform(data, i);
+	}
+}
+
+/**
+ * \param skin_cache: Optional, keeps the table of channels and weights of each vertex between calls,
+ * free with #BKE_armature_skin_cache_free.
+ */
+void armature_deform_verts_ex(Object *armOb, Object *target, DerivedMesh *dm, float (*vertexCos)[3],
+                              float (*defMats)[3][3], int numVerts, int deformflag,
+                              float (*prevCos)[3], const char *defgrp_name,
+                              ArmatureSkinCache **skin_cache)
 {
 	bPoseChanDeform *pdef_info_array;
 	bPoseChanDeform *pdef_info = NULL;
 	bArmature *arm = armOb->data;
-	bPoseChannel *pchan, **defnrToPC = NULL;
+	bPoseChannel *pchan, **pchan_array;
 	int *defnrToPCIndex = NULL;
 	MDeformVert *dverts = NULL;
 	bDeformGroup *dg;
 	DualQuat *dualquats = NULL;
-	float obinv[4][4], premat[4][4], postmat[4][4];
-	const bool use_envelope   = (deformflag & ARM_DEF_ENVELOPE) != 0;
+	ArmatureSkinCache *skin = NULL;
+	float obinv[4][4];
 	const bool use_quaternion = (deformflag & ARM_DEF_QUATERNION) != 0;
-	const bool invert_vgroup  = (deformflag & ARM_DEF_INVERT_VGROUP) != 0;
 	int defbase_tot = 0;       /* safety for vertexgroup index overflow */
 	int i, target_totvert = 0; /* safety for vertexgroup overflow */
 	bool use_dverts = false;
@@ -981,10 +1415,15 @@ void armature_deform_verts(Object *armOb, Object *target, DerivedMesh *dm, float
 		return;
 	}
 
+	ArmatureDeformData data = {
+	    .vertexCos = vertexCos, .defMats = defMats, .prevCos = prevCos,
+	    .use_envelope = (deformflag & ARM_DEF_ENVELOPE) != 0, .use_quaternion = use_quaternion,
+	};
+
 	invert_m4_m4(obinv, target->obmat);
-	copy_m4_m4(premat, target->obmat);
-	mul_m4_m4m4(postmat, obinv, armOb->obmat);
-	invert_m4_m4(premat, postmat);
+	copy_m4_m4(data.premat, target->obmat);
+	mul_m4_m4m4(data.postmat, obinv, armOb->obmat);
+	invert_m4_m4(data.premat, data.postmat);
 
 	/* bone defmats are already in the channels, chan_mat */
 
@@ -996,11 +1435,16 @@ void armature_deform_verts(Object *armOb, Object *target, DerivedMesh *dm, float
 	}
 
 	pdef_info_array = MEM_callocN(sizeof(bPoseChanDeform) * totchan, "bPoseChanDeform");
+	pchan_array = MEM_mallocN(sizeof(*pchan_array) * max_ii(totchan, 1), "pchan_array");
+
+	for (i = 0, pchan = armOb->pose->chanbase.first; pchan; i++, pchan = pchan->next) {
+		pchan_array[i] = pchan;
+	}
 
-	ArmatureBBoneDefmatsData data = {
+	ArmatureBBoneDefmatsData bbone_data = {
 	    .pdef_info_array = pdef_info_array, .dualquats = dualquats, .use_quaternion = use_quaternion
 	};
-	BLI_task_parallel_listbase(&armOb->pose->chanbase, &data, armature_bbone_defmats_cb, totchan > 512);
+	BLI_task_parallel_listbase(&armOb->pose->chanbase, &bbone_data, armature_bbone_defmats_cb, totchan > 512);
 
 	/* get the def_nr for the overall armature vertex group if present */
 	armature_def_nr = defgroup_name_index(target, defgrp_name);
@@ -1034,173 +1478,60 @@ void armature_deform_verts(Object *armOb, Object *target, DerivedMesh *dm, float
 			}
 
 			if (use_dverts) {
-				defnrToPC = MEM_callocN(sizeof(*defnrToPC) * defbase_tot, "defnrToBone");
-				defnrToPCIndex = MEM_callocN(sizeof(*defnrToPCIndex) * defbase_tot, "defnrToIndex");
+				defnrToPCIndex = MEM_mallocN(sizeof(*defnrToPCIndex) * max_ii(defbase_tot, 1), "defnrToIndex");
 				for (i = 0, dg = target->defbase.first; dg; i++, dg = dg->next) {
-					defnrToPC[i] = BKE_pose_channel_find_name(armOb->pose, dg->name);
+					pchan = BKE_pose_channel_find_name(armOb->pose, dg->name);
 					/* exclude non-deforming bones */
-					if (defnrToPC[i]) {
-						if (defnrToPC[i]->bone->flag & BONE_NO_DEFORM) {
-							defnrToPC[i] = NULL;
-						}
-						else {
-							defnrToPCIndex[i] = BLI_findindex(&armOb->pose->chanbase, defnrToPC[i]);
-						}
+					if (pchan && !(pchan->bone->flag & BONE_NO_DEFORM)) {
+						defnrToPCIndex[i] = BLI_findindex(&armOb->pose->chanbase, pchan);
+					}
+					else {
+						defnrToPCIndex[i] = -1;
 					}
 				}
 			}
 		}
 	}
 
-	for (i = 0; i < numVerts; i++) {
-		MDeformVert *dvert;
-		DualQuat sumdq, *dq = NULL;
-		float *co, dco[3];
-		float sumvec[3], summat[3][3];
-		float *vec = NULL, (*smat)[3] = NULL;
-		float contrib = 0.0f;
-		float armature_weight = 1.0f; /* default to 1 if no overall def group */
-		float prevco_weight = 1.0f;   /* weight for optional cached vertexcos */
-
-		if (use_quaternion) {
-			memset(&sumdq, 0, sizeof(DualQuat));
-			dq = &sumdq;
-		}
-		else {
-			sumvec[0] = sumvec[1] = sumvec[2] = 0.0f;
-			vec = sumvec;
-
-			if (defMats) {
-				zero_m3(summat);
-				smat = summat;
-			}
-		}
-
-		if (use_dverts || armature_def_nr != -1) {
-			if (dm)
-				dvert = dm->getVertData(dm, i, CD_MDEFORMVERT);
-			else if (dverts && i < target_totvert)
-				dvert = dverts + i;
-			else
-				dvert = NULL;
-		}
-		else
-			dvert = NULL;
-
-		if (armature_def_nr != -1 && dvert) {
-			armature_weight = defvert_find_weight(dvert, armature_def_nr);
+	if (use_dverts || armature_def_nr != -1) {
+		const ArmatureSkinParams params = {
+		    .dverts = dm ? dm->getVertDataArray(dm, CD_MDEFORMVERT) : dverts,
+		    .dverts_tot = dm ? numVerts : target_totvert,
+		    .defnr_to_index = defnrToPCIndex, .defbase_tot = defbase_tot,
+		    .use_dverts = use_dverts, .armature_def_nr = armature_def_nr,
+		    .invert_vgroup = (deformflag & ARM_DEF_INVERT_VGROUP) != 0, .use_prevcos = (prevCos != NULL),
+		};
 
-			if (invert_vgroup)
-				armature_weight = 1.0f - armature_weight;
+		if (skin_cache) {
+			const unsigned int key = armature_skin_key(&params, numVerts);
 
-			/* hackish: the blending factor can be used for blending with prevCos too */
-			if (prevCos) {
-				prevco_weight = armature_weight;
-				armature_weight = 1.0f;
+			skin = *skin_cache;
+			if (skin == NULL || skin->key != key || skin->numverts != numVerts) {
+				BKE_armature_skin_cache_free(skin);
+				skin = *skin_cache = armature_skin_cache_build(&params, numVerts);
+				skin->key = key;
 			}
 		}
-
-		/* check if there's any  point in calculating for this vert */
-		if (armature_weight == 0.0f)
-			continue;
-
-		/* get the coord we work on */
-		co = prevCos ? prevCos[i] : vertexCos[i];
-
-		/* Apply the object's matrix */
-		mul_m4_v3(premat, co);
-
-		if (use_dverts && dvert && dvert->totweight) { /* use weight groups ? */
-			MDeformWeight *dw = dvert->dw;
-			int deformed = 0;
-			unsigned int j;
-
-			for (j = dvert->totweight; j != 0; j--, dw++) {
-				const int index = dw->def_nr;
-				if (index >= 0 && index < defbase_tot && (pchan = defnrToPC[index])) {
-					float weight = dw->weight;
-					Bone *bone = pchan->bone;
-					pdef_info = pdef_info_array + defnrToPCIndex[index];
-
-					deformed = 1;
-
-					if (bone && bone->flag & BONE_MULT_VG_ENV) {
-						weight *= distfactor_to_bone(co, bone->arm_head, bone->arm_tail,
-						                             bone->rad_head, bone->rad_tail, bone->dist);
-					}
-					pchan_bone_deform(pchan, pdef_info, weight, vec, dq, smat, co, &contrib);
-				}
-			}
-			/* if there are vertexgroups but not groups with bones
-			 * (like for softbody groups) */
-			if (deformed == 0 && use_envelope) {
-				pdef_info = pdef_info_array;
-				for (pchan = armOb->pose->chanbase.first; pchan; pchan = pchan->next, pdef_info++) {
-					if (!(pchan->bone->flag & BONE_NO_DEFORM))
-						contrib += dist_bone_deform(pchan, pdef_info, vec, dq, smat, co);
-				}
-			}
-		}
-		else if (use_envelope) {
-			pdef_info = pdef_info_array;
-			for (pchan = armOb->pose->chanbase.first; pchan; pchan = pchan->next, pdef_info++) {
-				if (!(pchan->bone->flag & BONE_NO_DEFORM))
-					contrib += dist_bone_deform(pchan, pdef_info, vec, dq, smat, co);
-			}
+		else {
+			skin = armature_skin_cache_build(&params, numVerts);
 		}
+	}
 
-		/* actually should be EPSILON? weight values and contrib can be like 10e-39 small */
-		if (contrib > 0.0001f) {
-			if (use_quaternion) {
-				normalize_dq(dq, contrib);
-
-				if (armature_weight != 1.0f) {
-					copy_v3_v3(dco, co);
-					mul_v3m3_dq(dco, (defMats) ? summat : NULL, dq);
-					sub_v3_v3(dco, co);
-					mul_v3_fl(dco, armature_weight);
-					add_v3_v3(co, dco);
-				}
-				else
-					mul_v3m3_dq(co, (defMats) ? summat : NULL, dq);
-
-				smat = summat;
-			}
-			else {
-				mul_v3_fl(vec, armature_weight / contrib);
-				add_v3_v3v3(co, vec, co);
-			}
-
-			if (defMats) {
-				float pre[3][3], post[3][3], tmpmat[3][3];
-
-				copy_m3_m4(pre, premat);
-				copy_m3_m4(post, postmat);
-				copy_m3_m3(tmpmat, defMats[i]);
-
-				if (!use_quaternion) /* quaternion already is scale corrected */
-					mul_m3_fl(smat, armature_weight / contrib);
+	data.pchan_array = pchan_array;
+	data.pdef_info_array = pdef_info_array;
+	data.totchan = totchan;
+	data.skin = skin;
 
-				mul_m3_series(defMats[i], post, smat, pre, tmpmat);
-			}
-		}
+	data.numverts = numVerts;
 
-		/* always, check above code */
-		mul_m4_v3(postmat, co);
-
-		/* interpolate with previous modifier position using weight group */
-		if (prevCos) {
-			float mw = 1.0f - prevco_weight;
-			vertexCos[i][0] = prevco_weight * vertexCos[i][0] + mw * co[0];
-			vertexCos[i][1] = prevco_weight * vertexCos[i][1] + mw * co[1];
-			vertexCos[i][2] = prevco_weight * vertexCos[i][2] + mw * co[2];
-		}
-	}
+	BLI_task_parallel_range(
+	        0, (numVerts + ARMATURE_DEFORM_BLOCK_SIZE - 1) / ARMATURE_DEFORM_BLOCK_SIZE,
+	        &data, armature_deform_block_cb, numVerts >= ARMATURE_DEFORM_THREADED_MIN);
 
+	if (skin && skin_cache == NULL)
+		BKE_armature_skin_cache_free(skin);
 	if (dualquats)
 		MEM_freeN(dualquats);
-	if (defnrToPC)
-		MEM_freeN(defnrToPC);
 	if (defnrToPCIndex)
 		MEM_freeN(defnrToPCIndex);
 
@@ -1213,9 +1544,18 @@ void armature_deform_verts(Object *armOb, Object *target, DerivedMesh *dm, float
 			MEM_freeN(pdef_info->b_bone_dual_quats);
 	}
 
+	MEM_freeN(pchan_array);
 	MEM_freeN(pdef_info_array);
 }
 
+void armature_deform_verts(Object *armOb, Object *target, DerivedMesh *dm, float (*vertexCos)[3],
+                           float (*defMats)[3][3], int numVerts, int deformflag,
+                           float (*prevCos)[3], const char *defgrp_name)
+{
+	armature_deform_verts_ex(armOb, target, dm, vertexCos, defMats, numVerts, deformflag,
+	                         prevCos, defgrp_name, NULL);
+}
+
 /* ************ END Armature Deform ******************* */
 
 void get_objectspace_bone_matrix(struct Bone *bone, float M_accumulatedMatrix[4][4], int UNUSED(root),
@@ -25,18 +25,10 @@
  * DNA level diffing for undo.
  */
 
-#ifndef _WIN32
-#  include <unistd.h> // for read close
-#else
-#  include <io.h> // for open close read
-#endif
-
 #include <stdlib.h>
 #include <stdio.h>
 #include <stddef.h>
 #include <string.h>
-#include <fcntl.h>  /* for open */
-#include <errno.h>
 
 #include "MEM_guardedalloc.h"
 
@@ -334,8 +326,6 @@ const char *BKE_undo_get_name_last(void)
 bool BKE_undo_save_file(const char *filename)
 {
 	UndoElem *uel;
-	MemFileChunk *chunk;
-	int file, oflags;
 
 	if ((U.uiflag & USER_GLOBALUNDO) == 0) {
 		return false;
@@ -347,41 +337,26 @@ bool BKE_undo_save_file(const char *filename)
 		return false;
 	}
 
-	/* note: This is currently used for autosave and 'quit.blend', where _not_ following symlinks is OK,
-	 * however if this is ever executed explicitly by the user, we may want to allow writing to symlinks.
-	 */
-
-	oflags = O_BINARY | O_WRONLY | O_CREAT | O_TRUNC;
-#ifdef O_NOFOLLOW
-	/* use O_NOFOLLOW to avoid writing to a symlink - use 'O_EXCL' (CVE-2008-1103) */
-	oflags |= O_NOFOLLOW;
-#else
-	/* TODO(sergey): How to deal with symlinks on windows? */
-#  ifndef _MSC_VER
-#    warning "Symbolic links will be followed on undo save, possibly causing CVE-2008-1103"
-#  endif
-#endif
-	file = BLI_open(filename,  oflags, 0666);
-
-	if (file == -1) {
-		fprintf(stderr, "Unable to save '%s': %s\n",
-		        filename, errno ? strerror(errno) : "Unknown error opening file");
-		return false;
-	}
+	return BLO_memfile_write_file(&uel->memfile, filename);
+}
 
-	for (chunk = uel->memfile.chunks.first; chunk; chunk = chunk->next) {
-		if (write(file, chunk->buf, chunk->size) != chunk->size) {
-			break;
-		}
+/**
+ * Copies the undo buffer, so it can be saved while the undo stack changes (from another thread).
+ *
+ * \return success.
+ */
+bool BKE_undo_copy_memfile(MemFile *r_memfile)
+{
+	if ((U.uiflag & USER_GLOBALUNDO) == 0) {
+		return false;
 	}
 
-	close(file);
-
-	if (chunk) {
-		fprintf(stderr, "Unable to save '%s': %s\n",
-		        filename, errno ? strerror(errno) : "Unknown error writing file");
+	if (curundo == NULL) {
+		fprintf(stderr, "No undo buffer to save recovery file\n");
 		return false;
 	}
+
+	BLO_memfile_copy(&curundo->memfile, r_memfile);
 	return true;
 }
 
@@ -111,6 +111,10 @@ void DAG_init(void)
 void DAG_exit(void)
 {
 	BLI_spin_end(&threaded_update_lock);
+	/* Finish profiling requested from the command line. */
+	if (DEG_debug_profile_is_running()) {
+		DEG_debug_profile_end();
+	}
 	DEG_free_node_types();
 }
 
@@ -1717,6 +1721,18 @@ void DAG_relations_tag_update(Main *bmain)
 	}
 }
 
+/* tag relations of the given datablock for update */
+void DAG_id_tag_relations_update(Main *bmain, ID *id)
+{
+	if (DEG_depsgraph_use_legacy()) {
+		DAG_relations_tag_update(bmain);
+	}
+	else {
+		/* New dependency graph. */
+		DEG_id_tag_relations_update(bmain, id);
+	}
+}
+
 /* rebuild dependency graph only for a given scene */
 void DAG_scene_relations_rebuild(Main *bmain, Scene *sce)
 {
@@ -3588,6 +3604,10 @@ void DAG_init(void)
 
 void DAG_exit(void)
 {
+	/* Finish profiling requested from the command line. */
+	if (DEG_debug_profile_is_running()) {
+		DEG_debug_profile_end();
+	}
 	DEG_free_node_types();
 }
 
@@ -3611,6 +3631,12 @@ void DAG_relations_tag_update(Main *bmain)
 	DEG_relations_tag_update(bmain);
 }
 
+/* Tag relations of the given datablock for update. */
+void DAG_id_tag_relations_update(Main *bmain, ID *id)
+{
+	DEG_id_tag_relations_update(bmain, id);
+}
+
 /* Rebuild dependency graph only for a given scene. */
 void DAG_scene_relations_rebuild(Main *bmain, Scene *scene)
 {
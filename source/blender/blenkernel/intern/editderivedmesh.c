@@ -468,6 +468,7 @@ static void emDM_calc_loop_tangents_thread(TaskPool * __restrict UNUSED(pool), v
 		sInterface.m_getTexCoord = emdm_ts_GetTextureCoordinate;
 		sInterface.m_getNormal = emdm_ts_GetNormal;
 		sInterface.m_setTSpaceBasic = emdm_ts_SetTSpace;
+		sInterface.m_runParallel = BKE_mesh_mikktspace_run_parallel;
 		/* 0 if failed */
 		genTangSpaceDefault(&sContext);
 	}
@@ -38,6 +38,8 @@
 
 #include "BLI_blenlib.h"
 #include "BLI_math_vector.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
 #include "BLI_utildefines.h"
 
 #include "BLT_translation.h"
@@ -83,6 +85,8 @@ void BKE_key_free(Key *key)
 
 	BKE_animdata_free((ID *)key, false);
 
+	BKE_key_delta_cache_free(key);
+
 	while ((kb = BLI_pophead(&key->block))) {
 		if (kb->data)
 			MEM_freeN(kb->data);
@@ -94,6 +98,8 @@ void BKE_key_free_nolib(Key *key)
 {
 	KeyBlock *kb;
 
+	BKE_key_delta_cache_free(key);
+
 	while ((kb = BLI_pophead(&key->block))) {
 		if (kb->data)
 			MEM_freeN(kb->data);
@@ -164,6 +170,7 @@ Key *BKE_key_copy(Main *bmain, Key *key)
 	while (kbn) {
 		
 		if (kbn->data) kbn->data = MEM_dupallocN(kbn->data);
+		kbn->delta_cache = NULL;
 		if (kb == key->refkey) keyn->refkey = kbn;
 		
 		kbn = kbn->next;
@@ -191,6 +198,7 @@ Key *BKE_key_copy_nolib(Key *key)
 	while (kbn) {
 		
 		if (kbn->data) kbn->data = MEM_dupallocN(kbn->data);
+		kbn->delta_cache = NULL;
 		if (kb == key->refkey) keyn->refkey = kbn;
 		
 		kbn = kbn->next;
@@ -276,6 +284,50 @@ void key_curve_position_weights(float t, float data[4], int type)
 	}
 }
 
+/**
+ * Same as #key_curve_position_weights for an array of positions,
+ * the interpolation type is only checked once so the loops can be vectorized.
+ */
+void key_curve_position_weights_array(const float *t, float (*data)[4], const int tot, const int type)
+{
+	int a;
+
+	if (type == KEY_LINEAR) {
+		for (a = 0; a < tot; a++) {
+			data[a][0] =          0.0f;
+			data[a][1] = -t[a]  + 1.0f;
+			data[a][2] =  t[a];
+			data[a][3] =          0.0f;
+		}
+	}
+	else if (ELEM(type, KEY_CARDINAL, KEY_CATMULL_ROM)) {
+		const float fc = (type == KEY_CARDINAL) ? 0.71f : 0.5f;
+
+		for (a = 0; a < tot; a++) {
+			const float t1 = t[a];
+			const float t2 = t1 * t1;
+			const float t3 = t2 * t1;
+
+			data[a][0] = -fc          * t3  + 2.0f * fc          * t2 - fc * t1;
+			data[a][1] =  (2.0f - fc) * t3  + (fc - 3.0f)        * t2 + 1.0f;
+			data[a][2] =  (fc - 2.0f) * t3  + (3.0f - 2.0f * fc) * t2 + fc * t1;
+			data[a][3] =  fc          * t3  - fc * t2;
+		}
+	}
+	else if (type == KEY_BSPLINE) {
+		for (a = 0; a < tot; a++) {
+			const float t1 = t[a];
+			const float t2 = t1 * t1;
+			const float t3 = t2 * t1;
+
+			data[a][0] = -0.16666666f * t3  + 0.5f * t2   - 0.5f * t1   + 0.16666666f;
+			data[a][1] =  0.5f        * t3  - t2                        + 0.66666666f;
+			data[a][2] = -0.5f        * t3  + 0.5f * t2   + 0.5f * t1   + 0.16666666f;
+			data[a][3] =  0.16666666f * t3;
+		}
+	}
+}
+
 /* first derivative */
 void key_curve_tangent_weights(float t, float data[4], int type)
 {
@@ -708,6 +760,290 @@ static void cp_cu_key(Curve *cu, Key *key, KeyBlock *actkb, KeyBlock *kb, const
 	}
 }
 
+/* -------------------------------------------------------------------- */
+/** \name Blocked Relative Key Evaluation
+ *
+ * Fast path of #BKE_key_evaluate_relative for meshes and lattices.
+ * Vertices are blended in blocks, all active keys are added to a block before moving on
+ * so the output stays in the cache, blocks are evaluated in parallel.
+ * Keys which only move a few vertices use a sparse list of offsets (#KeyBlockDeltaCache).
+ *
+ * The order of operations per vertex is the same as the generic code,
+ * so results are identical.
+ * \{ */
+
+#define KEY_EVAL_BLOCK_SIZE 1024
+/* vertices * keys, below this threading isn't worth the overhead */
+#define KEY_EVAL_THREADED_MIN 10000
+/* keys moving less than (totelem / KEY_DELTA_SPARSE_DIV) vertices are evaluated sparse */
+#define KEY_DELTA_SPARSE_DIV 4
+
+/**
+ * Runtime offsets of a key to its relative key, only the vertices which moved are stored.
+ * Validated against the data pointers it was built from,
+ * in place modifications need #BKE_keyblock_delta_cache_invalidate.
+ */
+typedef struct KeyBlockDeltaCache {
+	const void *data, *ref_data;
+	int totelem;
+	/* -1 when too many vertices moved to store them sparse */
+	int totdelta;
+	int *index;
+	/* reference minus key coordinates (as used by #rel_flerp) */
+	float (*delta)[3];
+	/* first delta of each block, (totblock + 1) items */
+	int *block_offs;
+} KeyBlockDeltaCache;
+
+static ThreadMutex key_delta_cache_lock = BLI_MUTEX_INITIALIZER;
+
+static void key_delta_cache_free(KeyBlockDeltaCache *dc)
+{
+	MEM_SAFE_FREE(dc->index);
+	MEM_SAFE_FREE(dc->delta);
+	MEM_SAFE_FREE(dc->block_offs);
+	MEM_freeN(dc);
+}
+
+/**
+ * Free the delta cache of \a kb and of the keys relative to it.
+ */
+void BKE_keyblock_delta_cache_invalidate(Key *key, KeyBlock *kb)
+{
+	KeyBlock *kb_iter;
+
+	for (kb_iter = key->block.first; kb_iter; kb_iter = kb_iter->next) {
+		if (kb_iter->delta_cache &&
+		    ((kb_iter == kb) || (kb_iter->delta_cache->ref_data == kb->data)))
+		{
+			key_delta_cache_free(kb_iter->delta_cache);
+			kb_iter->delta_cache = NULL;
+		}
+	}
+}
+
+void BKE_key_delta_cache_free(Key *key)
+{
+	KeyBlock *kb;
+
+	for (kb = key->block.first; kb; kb = kb->next) {
+		if (kb->delta_cache) {
+			key_delta_cache_free(kb->delta_cache);
+			kb->delta_cache = NULL;
+		}
+	}
+}
+
+static KeyBlockDeltaCache *key_delta_cache_build(KeyBlock *kb, const float (*ref)[3])
+{
+	KeyBlockDeltaCache *dc = MEM_callocN(sizeof(*dc), __func__);
+	const float (*from)[3] = kb->data;
+	const int tot = kb->totelem;
+	const int totblock = (tot + KEY_EVAL_BLOCK_SIZE - 1) / KEY_EVAL_BLOCK_SIZE;
+	float delta[3];
+	int i, totdelta = 0;
+
+	dc->data = kb->data;
+	dc->ref_data = ref;
+	dc->totelem = tot;
+
+	/* only skip vertices which would add exactly nothing */
+	for (i = 0; i < tot; i++) {
+		sub_v3_v3v3(delta, ref[i], from[i]);
+		if (!is_zero_v3(delta)) {
+			totdelta++;
+		}
+	}
+
+	if (totdelta > tot / KEY_DELTA_SPARSE_DIV) {
+		dc->totdelta = -1;
+		return dc;
+	}
+
+	dc->totdelta = totdelta;
+	dc->block_offs = MEM_mallocN(sizeof(*dc->block_offs) * (totblock + 1), __func__);
+	if (totdelta != 0) {
+		dc->index = MEM_mallocN(sizeof(*dc->index) * totdelta, __func__);
+		dc->delta = MEM_mallocN(sizeof(*dc->delta) * totdelta, __func__);
+	}
+
+	for (i = 0, totdelta = 0; i < tot; i++) {
+		if ((i % KEY_EVAL_BLOCK_SIZE) == 0) {
+			dc->block_offs[i / KEY_EVAL_BLOCK_SIZE] = totdelta;
+		}
+		sub_v3_v3v3(delta, ref[i], from[i]);
+		if (!is_zero_v3(delta)) {
+			dc->index[totdelta] = i;
+			copy_v3_v3(dc->delta[totdelta], delta);
+			totdelta++;
+		}
+	}
+	dc->block_offs[totblock] = totdelta;
+
+	return dc;
+}
+
+/* call with key_delta_cache_lock held */
+static const KeyBlockDeltaCache *key_delta_cache_ensure(KeyBlock *kb, const float (*ref)[3])
+{
+	KeyBlockDeltaCache *dc = kb->delta_cache;
+
+	if (dc && ((dc->data != kb->data) || (dc->ref_data != (const void *)ref) || (dc->totelem != kb->totelem))) {
+		key_delta_cache_free(dc);
+		dc = NULL;
+	}
+
+	if (dc == NULL) {
+		dc = kb->delta_cache = key_delta_cache_build(kb, ref);
+	}
+
+	return dc;
+}
+
+typedef struct KeyEvalRelative {
+	float (*ref)[3], (*from)[3];
+	const KeyBlockDeltaCache *delta_cache;  /* when set, 'ref' and 'from' aren't used */
+	const float *weights;
+	float curval;
+} KeyEvalRelative;
+
+typedef struct KeyEvalRelativeData {
+	float (*out)[3];
+	const KeyEvalRelative *keys;
+	int totkey;
+	int tot;
+} KeyEvalRelativeData;
+
+static void key_evaluate_relative_block_cb(void *userdata, const int block)
+{
+	const KeyEvalRelativeData *data = userdata;
+	float (*out)[3] = data->out;
+	const int start = block * KEY_EVAL_BLOCK_SIZE;
+	const int end = min_ii(start + KEY_EVAL_BLOCK_SIZE, data->tot);
+	int k, i;
+
+	for (k = 0; k < data->totkey; k++) {
+		const KeyEvalRelative *ke = &data->keys[k];
+		const float curval = ke->curval;
+		const float *weights = ke->weights;
+
+		if (ke->delta_cache) {
+			const KeyBlockDeltaCache *dc = ke->delta_cache;
+			const int delta_end = dc->block_offs[block + 1];
+
+			for (i = dc->block_offs[block]; i < delta_end; i++) {
+				const int v = dc->index[i];
+				const float weight = weights ? (weights[v] * curval) : curval;
+
+				out[v][0] -= weight * dc->delta[i][0];
+				out[v][1] -= weight * dc->delta[i][1];
+				out[v][2] -= weight * dc->delta[i][2];
+			}
+		}
+		else if (weights) {
+			for (i = start; i < end; i++) {
+				rel_flerp(3, out[i], ke->ref[i], ke->from[i], weights[i] * curval);
+			}
+		}
+		else {
+			/* contiguous, vectorizes well */
+			rel_flerp((end - start) * 3, out[start], ke->ref[start], ke->from[start], curval);
+		}
+	}
+}
+
+static void key_evaluate_relative_blocked(
+        const int tot, float (*out)[3], Key *key, KeyBlock *actkb, float **per_keyblock_weights)
+{
+	KeyEvalRelativeData data;
+	KeyEvalRelative *keys;
+	KeyBlock **blocks, *kb;
+	char *actkb_data = NULL, *freeactkb = NULL;
+	/* lattice edit-mode frees and reallocates key data, only trust the data pointer for meshes */
+	const bool use_delta_cache = (GS(key->from->name) == ID_ME);
+	const int totblock = (tot + KEY_EVAL_BLOCK_SIZE - 1) / KEY_EVAL_BLOCK_SIZE;
+	int totblocks, keyblock_index, totkey = 0;
+
+	totblocks = BLI_listbase_count(&key->block);
+	blocks = MEM_mallocN(sizeof(*blocks) * totblocks, __func__);
+	keys = MEM_mallocN(sizeof(*keys) * totblocks, __func__);
+	for (kb = key->block.first, keyblock_index = 0; kb; kb = kb->next, keyblock_index++) {
+		blocks[keyblock_index] = kb;
+	}
+
+	if (actkb) {
+		/* edit-mode coordinates, get them once for all keys */
+		actkb_data = key_block_get_data(key, actkb, actkb, &freeactkb);
+	}
+
+	if (use_delta_cache) {
+		BLI_mutex_lock(&key_delta_cache_lock);
+	}
+
+	for (kb = key->block.first, keyblock_index = 0; kb; kb = kb->next, keyblock_index++) {
+		KeyEvalRelative *ke = &keys[totkey];
+		KeyBlock *refb;
+
+		/* only with value, and no difference allowed */
+		if ((kb == key->refkey) || (kb->flag & KEYBLOCK_MUTE) || (kb->curval == 0.0f) || (kb->totelem != tot)) {
+			continue;
+		}
+
+		/* reference now can be any block */
+		if (kb->relative < 0 || kb->relative >= totblocks) {
+			continue;
+		}
+		refb = blocks[kb->relative];
+
+		ke->from = (float (*)[3])((kb == actkb) ? actkb_data : kb->data);
+		ke->ref = (float (*)[3])((refb == actkb) ? actkb_data : refb->data);
+		ke->weights = per_keyblock_weights ? per_keyblock_weights[keyblock_index] : NULL;
+		ke->curval = kb->curval;
+		ke->delta_cache = NULL;
+
+		if (ke->from == NULL || ke->ref == NULL) {
+			continue;
+		}
+
+		if (use_delta_cache && (ke->from == kb->data) && (ke->ref == refb->data)) {
+			const KeyBlockDeltaCache *dc = key_delta_cache_ensure(kb, (const float (*)[3])ke->ref);
+
+			if (dc->totdelta == 0) {
+				/* same as its reference */
+				continue;
+			}
+			else if (dc->totdelta != -1) {
+				ke->delta_cache = dc;
+			}
+		}
+
+		totkey++;
+	}
+
+	if (use_delta_cache) {
+		BLI_mutex_unlock(&key_delta_cache_lock);
+	}
+
+	if (totkey != 0) {
+		data.out = out;
+		data.keys = keys;
+		data.totkey = totkey;
+		data.tot = tot;
+
+		BLI_task_parallel_range(
+		        0, totblock, &data, key_evaluate_relative_block_cb,
+		        (tot * totkey) >= KEY_EVAL_THREADED_MIN);
+	}
+
+	if (freeactkb) {
+		MEM_freeN(freeactkb);
+	}
+	MEM_freeN(keys);
+	MEM_freeN(blocks);
+}
+
+/** \} */
+
 void BKE_key_evaluate_relative(const int start, int end, const int tot, char *basispoin, Key *key, KeyBlock *actkb,
                                float **per_keyblock_weights, const int mode)
 {
@@ -737,6 +1073,11 @@ void BKE_key_evaluate_relative(const int start, int end, const int tot, char *ba
 	cp_key(start, end, tot, basispoin, key, actkb, key->refkey, NULL, mode);
 	
 	/* step 2: do it */
+
+	if (mode == KEY_MODE_DUMMY && start == 0 && end == tot && key->elemsize == (int)sizeof(float[3])) {
+		key_evaluate_relative_blocked(tot, (float (*)[3])basispoin, key, actkb, per_keyblock_weights);
+		return;
+	}
 	
 	for (kb = key->block.first, keyblock_index = 0; kb; kb = kb->next, keyblock_index++) {
 		if (kb != key->refkey) {
@@ -1121,7 +1462,13 @@ float **BKE_keyblock_get_per_block_weights(Object *ob, Key *key, WeightsArrayCac
 	     keyblock;
 	     keyblock = keyblock->next, keyblock_index++)
 	{
-		per_keyblock_weights[keyblock_index] = get_weights_array(ob, keyblock->vgroup, cache);
+		/* keys which don't contribute don't need their weights */
+		if ((keyblock->curval == 0.0f) || (keyblock->flag & KEYBLOCK_MUTE)) {
+			per_keyblock_weights[keyblock_index] = NULL;
+		}
+		else {
+			per_keyblock_weights[keyblock_index] = get_weights_array(ob, keyblock->vgroup, cache);
+		}
 	}
 
 	return per_keyblock_weights;
@@ -1611,6 +1958,10 @@ void BKE_keyblock_update_from_lattice(Lattice *lt, KeyBlock *kb)
 	for (a = 0; a < kb->totelem; a++, fp++, bp++) {
 		copy_v3_v3(*fp, bp->vec);
 	}
+
+	if (lt->key) {
+		BKE_keyblock_delta_cache_invalidate(lt->key, kb);
+	}
 }
 
 void BKE_keyblock_convert_from_lattice(Lattice *lt, KeyBlock *kb)
@@ -1750,6 +2101,10 @@ void BKE_keyblock_update_from_mesh(Mesh *me, KeyBlock *kb)
 	for (a = 0; a < tot; a++, fp++, mvert++) {
 		copy_v3_v3(*fp, mvert->co);
 	}
+
+	if (me->key) {
+		BKE_keyblock_delta_cache_invalidate(me->key, kb);
+	}
 }
 
 void BKE_keyblock_convert_from_mesh(Mesh *me, KeyBlock *kb)
@@ -1875,6 +2230,8 @@ void BKE_keyblock_update_from_vertcos(Object *ob, KeyBlock *kb, float (*vertCos)
 		for (a = 0; a < tot; a++, fp += 3, co++) {
 			copy_v3_v3(fp, *co);
 		}
+
+		BKE_keyblock_delta_cache_invalidate(BKE_key_from_object(ob), kb);
 	}
 	else if (ELEM(ob->type, OB_CURVE, OB_SURF)) {
 		Curve *cu = (Curve *)ob->data;
@@ -2001,6 +2358,8 @@ void BKE_keyblock_update_from_offset(Object *ob, KeyBlock *kb, float (*ofs)[3])
 		for (a = 0; a < kb->totelem; a++, fp += 3, ofs++) {
 			add_v3_v3(fp, *ofs);
 		}
+
+		BKE_keyblock_delta_cache_invalidate(BKE_key_from_object(ob), kb);
 	}
 	else if (ELEM(ob->type, OB_CURVE, OB_SURF)) {
 		Curve *cu = (Curve *)ob->data;
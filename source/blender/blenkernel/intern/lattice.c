@@ -40,6 +40,7 @@
 #include "BLI_listbase.h"
 #include "BLI_bitmap.h"
 #include "BLI_math.h"
+#include "BLI_task.h"
 
 #include "DNA_mesh_types.h"
 #include "DNA_meshdata_types.h"
@@ -332,10 +333,25 @@ void BKE_lattice_make_local(Main *bmain, Lattice *lt, const bool lib_local)
 	BKE_id_make_local_generic(bmain, &lt->id, true, lib_local);
 }
 
+/* everything the cell of a vertex depends on, compared to validate #LatticeDeformCache */
+typedef struct LatticeDeformCellParams {
+	float latmat[4][4];
+	float fuvw[3], duvw[3];
+	int pnts[3];
+	int type[3];
+} LatticeDeformCellParams;
+
 typedef struct LatticeDeformData {
 	Object *object;
 	float *latticedata;
 	float latmat[4][4];
+
+	/* resolved once instead of per vertex */
+	Lattice *lt;
+	MDeformVert *dvert;
+	int defgrp_index;
+
+	LatticeDeformCellParams params;
 } LatticeDeformData;
 
 LatticeDeformData *init_latt_deform(Object *oblatt, Object *ob)
@@ -393,115 +409,147 @@ LatticeDeformData *init_latt_deform(Object *oblatt, Object *ob)
 		}
 	}
 
-	lattice_deform_data = MEM_mallocN(sizeof(LatticeDeformData), "Lattice Deform Data");
+	lattice_deform_data = MEM_callocN(sizeof(LatticeDeformData), "Lattice Deform Data");
 	lattice_deform_data->latticedata = latticedata;
 	lattice_deform_data->object = oblatt;
 	copy_m4_m4(lattice_deform_data->latmat, latmat);
 
+	lattice_deform_data->lt = lt;
+	lattice_deform_data->dvert = BKE_lattice_deform_verts_get(oblatt);
+	lattice_deform_data->defgrp_index =
+	        (lt->vgroup[0] && lattice_deform_data->dvert) ? defgroup_name_index(oblatt, lt->vgroup) : -1;
+
+	copy_m4_m4(lattice_deform_data->params.latmat, latmat);
+	copy_v3_fl3(lattice_deform_data->params.fuvw, lt->fu, lt->fv, lt->fw);
+	copy_v3_fl3(lattice_deform_data->params.duvw, lt->du, lt->dv, lt->dw);
+	lattice_deform_data->params.pnts[0] = lt->pntsu;
+	lattice_deform_data->params.pnts[1] = lt->pntsv;
+	lattice_deform_data->params.pnts[2] = lt->pntsw;
+	lattice_deform_data->params.type[0] = lt->typeu;
+	lattice_deform_data->params.type[1] = lt->typev;
+	lattice_deform_data->params.type[2] = lt->typew;
+
 	return lattice_deform_data;
 }
 
-void calc_latt_deform(LatticeDeformData *lattice_deform_data, float co[3], float weight)
+/* -------------------------------------------------------------------- */
+/** \name Lattice Deform Cells
+ *
+ * Deforming a point is split in two steps, finding its lattice cell and curve weights
+ * (which only depend on the undeformed point and the lattice resolution),
+ * then summing the 4x4x4 lattice point offsets around it.
+ * The first step works on arrays of points so it can be vectorized and cached.
+ * \{ */
+
+/* points are deformed in blocks of this size, also the granularity of the cell cache */
+#define LATTICE_DEFORM_BLOCK_SIZE 256
+/* below this amount of points threading isn't worth the overhead */
+#define LATTICE_DEFORM_THREADED_MIN 1024
+
+/* cells of a block of points, one array per axis */
+typedef struct LatticeDeformCells {
+	int *index[3];
+	float (*weights[3])[4];
+} LatticeDeformCells;
+
+/**
+ * Cell cache of #lattice_deform_verts_ex, owned by the caller (the lattice modifier).
+ * Blocks are only recomputed when their points or the lattice parameters change.
+ */
+typedef struct LatticeDeformCache {
+	LatticeDeformCellParams params;
+	int numverts;
+	float (*co)[3];
+	int *index[3];
+	float (*weights[3])[4];
+} LatticeDeformCache;
+
+static void latt_deform_cells_calc(
+        const LatticeDeformCellParams *params, const float (*co)[3], const int tot, const LatticeDeformCells *cells)
 {
-	Object *ob = lattice_deform_data->object;
-	Lattice *lt = ob->data;
-	float u, v, w, tu[4], tv[4], tw[4];
-	float vec[3];
-	int idx_w, idx_v, idx_u;
-	int ui, vi, wi, uu, vv, ww;
+	float t[LATTICE_DEFORM_BLOCK_SIZE];
+	int axis, a;
 
-	/* vgroup influence */
-	int defgrp_index = -1;
-	float co_prev[3], weight_blend = 0.0f;
-	MDeformVert *dvert = BKE_lattice_deform_verts_get(ob);
+	BLI_assert(tot <= LATTICE_DEFORM_BLOCK_SIZE);
 
+	for (axis = 0; axis < 3; axis++) {
+		int *index = cells->index[axis];
+		float (*weights)[4] = cells->weights[axis];
 
-	if (lt->editlatt) lt = lt->editlatt->latt;
-	if (lattice_deform_data->latticedata == NULL) return;
+		if (params->pnts[axis] > 1) {
+			const float (*mat)[4] = params->latmat;
 
-	if (lt->vgroup[0] && dvert) {
-		defgrp_index = defgroup_name_index(ob, lt->vgroup);
-		copy_v3_v3(co_prev, co);
-	}
+			/* co is in local coords, treat with latmat, matching #mul_v3_m4v3 */
+			for (a = 0; a < tot; a++) {
+				const float vec = co[a][0] * mat[0][axis] + co[a][1] * mat[1][axis] + mat[2][axis] * co[a][2] +
+				                  mat[3][axis];
+				const float f = (vec - params->fuvw[axis]) / params->duvw[axis];
 
-	/* co is in local coords, treat with latmat */
-	mul_v3_m4v3(vec, lattice_deform_data->latmat, co);
-
-	/* u v w coords */
+				index[a] = (int)floor(f);
+				t[a] = f - index[a];
+			}
 
-	if (lt->pntsu > 1) {
-		u = (vec[0] - lt->fu) / lt->du;
-		ui = (int)floor(u);
-		u -= ui;
-		key_curve_position_weights(u, tu, lt->typeu);
-	}
-	else {
-		tu[0] = tu[2] = tu[3] = 0.0; tu[1] = 1.0;
-		ui = 0;
+			key_curve_position_weights_array(t, weights, tot, params->type[axis]);
+		}
+		else {
+			for (a = 0; a < tot; a++) {
+				index[a] = 0;
+				weights[a][0] = weights[a][2] = weights[a][3] = 0.0f;
+				weights[a][1] = 1.0f;
+			}
+		}
 	}
+}
 
-	if (lt->pntsv > 1) {
-		v = (vec[1] - lt->fv) / lt->dv;
-		vi = (int)floor(v);
-		v -= vi;
-		key_curve_position_weights(v, tv, lt->typev);
-	}
-	else {
-		tv[0] = tv[2] = tv[3] = 0.0; tv[1] = 1.0;
-		vi = 0;
-	}
+BLI_INLINE int latt_deform_index_clamp(const int i, const int tot)
+{
+	return (i > 0) ? ((i < tot) ? i : tot - 1) : 0;
+}
 
-	if (lt->pntsw > 1) {
-		w = (vec[2] - lt->fw) / lt->dw;
-		wi = (int)floor(w);
-		w -= wi;
-		key_curve_position_weights(w, tw, lt->typew);
+static void latt_deform_cell_apply(
+        const LatticeDeformData *lattice_deform_data, const int index[3],
+        const float tu[4], const float tv[4], const float tw[4],
+        float co[3], const float weight)
+{
+	const Lattice *lt = lattice_deform_data->lt;
+	const float *latticedata = lattice_deform_data->latticedata;
+	const MDeformVert *dvert = lattice_deform_data->dvert;
+	const int defgrp_index = lattice_deform_data->defgrp_index;
+	int idx_u[4], idx_v[4], idx_w[4];
+	float co_prev[3], weight_blend = 0.0f;
+	float u, v, w;
+	int uu, vv, ww;
+
+	if (defgrp_index != -1) {
+		copy_v3_v3(co_prev, co);
 	}
-	else {
-		tw[0] = tw[2] = tw[3] = 0.0; tw[1] = 1.0;
-		wi = 0;
+
+	for (ww = 0; ww < 4; ww++) {
+		idx_u[ww] = latt_deform_index_clamp(index[0] + ww - 1, lt->pntsu);
+		idx_v[ww] = latt_deform_index_clamp(index[1] + ww - 1, lt->pntsv) * lt->pntsu;
+		idx_w[ww] = latt_deform_index_clamp(index[2] + ww - 1, lt->pntsw) * lt->pntsu * lt->pntsv;
 	}
 
-	for (ww = wi - 1; ww <= wi + 2; ww++) {
-		w = tw[ww - wi + 1];
+	for (ww = 0; ww < 4; ww++) {
+		w = tw[ww];
 
 		if (w != 0.0f) {
-			if (ww > 0) {
-				if (ww < lt->pntsw) idx_w = ww * lt->pntsu * lt->pntsv;
-				else                idx_w = (lt->pntsw - 1) * lt->pntsu * lt->pntsv;
-			}
-			else {
-				idx_w = 0;
-			}
-
-			for (vv = vi - 1; vv <= vi + 2; vv++) {
-				v = w * tv[vv - vi + 1];
+			for (vv = 0; vv < 4; vv++) {
+				v = w * tv[vv];
 
 				if (v != 0.0f) {
-					if (vv > 0) {
-						if (vv < lt->pntsv) idx_v = idx_w + vv * lt->pntsu;
-						else                idx_v = idx_w + (lt->pntsv - 1) * lt->pntsu;
-					}
-					else {
-						idx_v = idx_w;
-					}
+					const int idx_v_w = idx_w[ww] + idx_v[vv];
 
-					for (uu = ui - 1; uu <= ui + 2; uu++) {
-						u = weight * v * tu[uu - ui + 1];
+					for (uu = 0; uu < 4; uu++) {
+						u = weight * v * tu[uu];
 
 						if (u != 0.0f) {
-							if (uu > 0) {
-								if (uu < lt->pntsu) idx_u = idx_v + uu;
-								else                idx_u = idx_v + (lt->pntsu - 1);
-							}
-							else {
-								idx_u = idx_v;
-							}
+							const int idx = idx_v_w + idx_u[uu];
 
-							madd_v3_v3fl(co, &lattice_deform_data->latticedata[idx_u * 3], u);
+							madd_v3_v3fl(co, &latticedata[idx * 3], u);
 
 							if (defgrp_index != -1)
-								weight_blend += (u * defvert_find_weight(dvert + idx_u, defgrp_index));
+								weight_blend += (u * defvert_find_weight(dvert + idx, defgrp_index));
 						}
 					}
 				}
@@ -511,9 +559,64 @@ void calc_latt_deform(LatticeDeformData *lattice_deform_data, float co[3], float
 
 	if (defgrp_index != -1)
 		interp_v3_v3v3(co, co_prev, co, weight_blend);
+}
+
+void calc_latt_deform(LatticeDeformData *lattice_deform_data, float co[3], float weight)
+{
+	int index[3];
+	float tu[4], tv[4], tw[4];
+	const LatticeDeformCells cells = {{&index[0], &index[1], &index[2]}, {&tu, &tv, &tw}};
+
+	if (lattice_deform_data->latticedata == NULL) return;
+
+	latt_deform_cells_calc(&lattice_deform_data->params, (const float (*)[3])co, 1, &cells);
+	latt_deform_cell_apply(lattice_deform_data, index, tu, tv, tw, co, weight);
+}
+
+static void latt_deform_cache_ensure(
+        LatticeDeformCache **r_cache, const LatticeDeformCellParams *params, const int numverts, bool *r_is_valid)
+{
+	LatticeDeformCache *cache = *r_cache;
+	int axis;
+
+	if (cache && (cache->numverts == numverts) && (memcmp(&cache->params, params, sizeof(*params)) == 0)) {
+		*r_is_valid = true;
+		return;
+	}
+
+	if (cache == NULL || cache->numverts != numverts) {
+		BKE_lattice_deform_cache_free(cache);
+		cache = *r_cache = MEM_callocN(sizeof(*cache), __func__);
+		cache->numverts = numverts;
+		cache->co = MEM_mallocN(sizeof(*cache->co) * numverts, __func__);
+		for (axis = 0; axis < 3; axis++) {
+			cache->index[axis] = MEM_mallocN(sizeof(*cache->index[axis]) * numverts, __func__);
+			cache->weights[axis] = MEM_mallocN(sizeof(*cache->weights[axis]) * numverts, __func__);
+		}
+	}
+
+	cache->params = *params;
+	*r_is_valid = false;
+}
 
+void BKE_lattice_deform_cache_free(LatticeDeformCache *cache)
+{
+	int axis;
+
+	if (cache == NULL) {
+		return;
+	}
+
+	for (axis = 0; axis < 3; axis++) {
+		MEM_freeN(cache->index[axis]);
+		MEM_freeN(cache->weights[axis]);
+	}
+	MEM_freeN(cache->co);
+	MEM_freeN(cache);
 }
 
+/** \} */
+
 void end_latt_deform(LatticeDeformData *lattice_deform_data)
 {
 	if (lattice_deform_data->latticedata)
@@ -849,11 +952,78 @@ void curve_deform_vector(Scene *scene, Object *cuOb, Object *target,
 
 }
 
-void lattice_deform_verts(Object *laOb, Object *target, DerivedMesh *dm,
-                          float (*vertexCos)[3], int numVerts, const char *vgroup, float fac)
+typedef struct LatticeDeformUserdata {
+	const LatticeDeformData *lattice_deform_data;
+	float (*vertexCos)[3];
+	int numverts;
+	const MDeformVert *dvert;
+	int defgrp_index;
+	float fac;
+
+	LatticeDeformCache *cache;
+	bool cache_is_valid;
+} LatticeDeformUserdata;
+
+static void lattice_deform_block_cb(void *userdata, const int block)
+{
+	const LatticeDeformUserdata *data = userdata;
+	float (*vertexCos)[3] = data->vertexCos;
+	LatticeDeformCache *cache = data->cache;
+	const int start = block * LATTICE_DEFORM_BLOCK_SIZE;
+	const int tot = min_ii(LATTICE_DEFORM_BLOCK_SIZE, data->numverts - start);
+	LatticeDeformCells cells;
+	int index_buf[3][LATTICE_DEFORM_BLOCK_SIZE];
+	float weights_buf[3][LATTICE_DEFORM_BLOCK_SIZE][4];
+	int axis, a;
+
+	if (cache) {
+		for (axis = 0; axis < 3; axis++) {
+			cells.index[axis] = cache->index[axis] + start;
+			cells.weights[axis] = cache->weights[axis] + start;
+		}
+
+		if (!data->cache_is_valid || memcmp(cache->co[start], vertexCos[start], sizeof(*vertexCos) * tot) != 0) {
+			memcpy(cache->co[start], vertexCos[start], sizeof(*vertexCos) * tot);
+			latt_deform_cells_calc(&data->lattice_deform_data->params, (const float (*)[3])&vertexCos[start], tot, &cells);
+		}
+	}
+	else {
+		for (axis = 0; axis < 3; axis++) {
+			cells.index[axis] = index_buf[axis];
+			cells.weights[axis] = weights_buf[axis];
+		}
+		latt_deform_cells_calc(&data->lattice_deform_data->params, (const float (*)[3])&vertexCos[start], tot, &cells);
+	}
+
+	for (a = 0; a < tot; a++) {
+		const int index[3] = {cells.index[0][a], cells.index[1][a], cells.index[2][a]};
+		float weight = data->fac;
+
+		if (data->dvert) {
+			weight = defvert_find_weight(&data->dvert[start + a], data->defgrp_index);
+			if (weight <= 0.0f) {
+				continue;
+			}
+			weight *= data->fac;
+		}
+
+		latt_deform_cell_apply(
+		        data->lattice_deform_data, index,
+		        cells.weights[0][a], cells.weights[1][a], cells.weights[2][a],
+		        vertexCos[start + a], weight);
+	}
+}
+
+/**
+ * \param cache: Optional, keeps the lattice cells of the points between calls,
+ * free with #BKE_lattice_deform_cache_free.
+ */
+void lattice_deform_verts_ex(Object *laOb, Object *target, DerivedMesh *dm,
+                             float (*vertexCos)[3], int numVerts, const char *vgroup, float fac,
+                             LatticeDeformCache **cache)
 {
 	LatticeDeformData *lattice_deform_data;
-	int a;
+	LatticeDeformUserdata data = {NULL};
 	bool use_vgroups;
 
 	if (laOb->type != OB_LATTICE)
@@ -878,33 +1048,49 @@ void lattice_deform_verts(Object *laOb, Object *target, DerivedMesh *dm,
 	else {
 		use_vgroups = false;
 	}
-	
+
+	data.lattice_deform_data = lattice_deform_data;
+	data.vertexCos = vertexCos;
+	data.numverts = numVerts;
+	data.fac = fac;
+
 	if (vgroup && vgroup[0] && use_vgroups) {
 		Mesh *me = target->data;
 		const int defgrp_index = defgroup_name_index(target, vgroup);
-		float weight;
 
-		if (defgrp_index >= 0 && (me->dvert || dm)) {
-			MDeformVert *dvert = me->dvert;
-			
-			for (a = 0; a < numVerts; a++, dvert++) {
-				if (dm) dvert = dm->getVertData(dm, a, CD_MDEFORMVERT);
-
-				weight = defvert_find_weight(dvert, defgrp_index);
+		if (defgrp_index >= 0) {
+			data.dvert = dm ? dm->getVertDataArray(dm, CD_MDEFORMVERT) : me->dvert;
+			data.defgrp_index = defgrp_index;
+		}
 
-				if (weight > 0.0f)
-					calc_latt_deform(lattice_deform_data, vertexCos[a], weight * fac);
-			}
+		if (data.dvert == NULL) {
+			/* nothing to deform, a NULL dvert would deform every vertex at full strength */
+			numVerts = 0;
 		}
 	}
-	else {
-		for (a = 0; a < numVerts; a++) {
-			calc_latt_deform(lattice_deform_data, vertexCos[a], fac);
+
+	if (lattice_deform_data->latticedata && numVerts > 0) {
+		const int totblock = (numVerts + LATTICE_DEFORM_BLOCK_SIZE - 1) / LATTICE_DEFORM_BLOCK_SIZE;
+
+		if (cache) {
+			latt_deform_cache_ensure(cache, &lattice_deform_data->params, numVerts, &data.cache_is_valid);
+			data.cache = *cache;
 		}
+
+		BLI_task_parallel_range(
+		        0, totblock, &data, lattice_deform_block_cb,
+		        numVerts >= LATTICE_DEFORM_THREADED_MIN);
 	}
+
 	end_latt_deform(lattice_deform_data);
 }
 
+void lattice_deform_verts(Object *laOb, Object *target, DerivedMesh *dm,
+                          float (*vertexCos)[3], int numVerts, const char *vgroup, float fac)
+{
+	lattice_deform_verts_ex(laOb, target, dm, vertexCos, numVerts, vgroup, fac, NULL);
+}
+
 bool object_deform_mball(Object *ob, ListBase *dispbase)
 {
 	if (ob->parent && ob->parent->type == OB_LATTICE && ob->partype == PARSKEL) {
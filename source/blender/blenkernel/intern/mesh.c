@@ -1813,6 +1813,7 @@ void BKE_mesh_transform(Mesh *me, float mat[4][4], bool do_keys)
 				mul_m4_v3(mat, fp);
 			}
 		}
+		BKE_key_delta_cache_free(me->key);
 	}
 
 	/* don't update normals, caller can do this explicitly.
@@ -1844,6 +1845,7 @@ void BKE_mesh_translate(Mesh *me, const float offset[3], const bool do_keys)
 				add_v3_v3(fp, offset);
 			}
 		}
+		BKE_key_delta_cache_free(me->key);
 	}
 }
 
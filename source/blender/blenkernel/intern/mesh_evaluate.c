@@ -1687,6 +1687,40 @@ static void set_tspace(const SMikkTSpaceContext *pContext, const float fv_tangen
 	p_res[3] = face_sign;
 }
 
+/* Mikktspace's parallel range callback. */
+#define MIKKTSPACE_PARALLEL_CHUNK_SIZE 1024
+
+typedef struct MikktspaceParallelData {
+	void (*func)(void *data, const int start, const int end);
+	void *data;
+	int totitem;
+} MikktspaceParallelData;
+
+static void mikktspace_parallel_range_cb(void *userdata, const int chunk)
+{
+	MikktspaceParallelData *data = userdata;
+	const int start = chunk * MIKKTSPACE_PARALLEL_CHUNK_SIZE;
+	const int end = min_ii(start + MIKKTSPACE_PARALLEL_CHUNK_SIZE, data->totitem);
+
+	data->func(data->data, start, end);
+}
+
+/**
+ * Implementation of Mikktspace's m_runParallel callback, spreading the ranges over the task scheduler.
+ * Safe to use from within a task, and for any mesh whose other callbacks only read shared data.
+ */
+void BKE_mesh_mikktspace_run_parallel(
+        const struct SMikkTSpaceContext *UNUSED(pContext), const int totitem,
+        void (*func)(void *data, const int start, const int end), void *userdata)
+{
+	MikktspaceParallelData data = {func, userdata, totitem};
+	const int totchunk = (totitem + MIKKTSPACE_PARALLEL_CHUNK_SIZE - 1) / MIKKTSPACE_PARALLEL_CHUNK_SIZE;
+
+	BLI_task_parallel_range(0, totchunk, &data, mikktspace_parallel_range_cb, totchunk > 1);
+}
+
+#undef MIKKTSPACE_PARALLEL_CHUNK_SIZE
+
 /**
  * Compute simplified tangent space normals, i.e. tangent vector + sign of bi-tangent one, which combined with
  * split normals can be used to recreate the full tangent space.
@@ -1730,6 +1764,7 @@ void BKE_mesh_loop_tangents_ex(
 	s_interface.m_getTexCoord = get_texture_coordinate;
 	s_interface.m_getNormal = get_normal;
 	s_interface.m_setTSpaceBasic = set_tspace;
+	s_interface.m_runParallel = BKE_mesh_mikktspace_run_parallel;
 
 	/* 0 if failed */
 	if (genTangSpaceDefault(&s_context) == false) {
@@ -46,6 +46,7 @@
 #include "MEM_guardedalloc.h"
 
 #include "DNA_armature_types.h"
+#include "DNA_meshdata_types.h"
 #include "DNA_object_types.h"
 
 #include "BLI_utildefines.h"
@@ -59,6 +60,7 @@
 #include "BKE_appdir.h"
 #include "BKE_key.h"
 #include "BKE_multires.h"
+#include "BKE_cdderivedmesh.h"
 #include "BKE_DerivedMesh.h"
 
 /* may move these, only for modifier_path_relbase */
@@ -68,6 +70,8 @@
 
 #include "MOD_modifiertypes.h"
 
+#include "atomic_ops.h"
+
 static ModifierTypeInfo *modifier_types[NUM_MODIFIER_TYPES] = {NULL};
 static VirtualModifierData virtualModifierCommonData;
 
@@ -139,6 +143,7 @@ void modifier_free(ModifierData *md)
 
 	if (mti->freeData) mti->freeData(md);
 	if (md->error) MEM_freeN(md->error);
+	modifier_result_cache_free(md);
 
 	MEM_freeN(md);
 }
@@ -728,6 +733,160 @@ void modifier_path_init(char *path, int path_maxlen, const char *name)
 }
 
 
+/* -------------------------------------------------------------------- */
+/** \name Modifier Result Cache
+ *
+ * Stores copies of the stack result after expensive modifiers, validated by
+ * mesh_calc_modifiers() which computes the keys. The memory used by all caches
+ * is limited by a global budget, results which don't fit are not stored.
+ * \{ */
+
+#define MODIFIER_RESULT_CACHE_BUDGET_DEFAULT (256 * 1024 * 1024)
+
+static struct {
+	size_t mem_used, mem_budget;
+	unsigned int num_entries;
+	unsigned int num_hits, num_misses;
+} modifier_result_cache_stats = {0, MODIFIER_RESULT_CACHE_BUDGET_DEFAULT, 0, 0, 0};
+
+static size_t customdata_mem_size(const CustomData *data, const int totelem)
+{
+	size_t mem_size = 0;
+	int i;
+
+	for (i = 0; i < data->totlayer; i++) {
+		mem_size += (size_t)CustomData_sizeof(data->layers[i].type) * (size_t)totelem;
+	}
+	return mem_size;
+}
+
+static size_t dm_mem_size(DerivedMesh *dm)
+{
+	if (dm == NULL) {
+		return 0;
+	}
+	return (customdata_mem_size(&dm->vertData, dm->numVertData) +
+	        customdata_mem_size(&dm->edgeData, dm->numEdgeData) +
+	        customdata_mem_size(&dm->faceData, dm->numTessFaceData) +
+	        customdata_mem_size(&dm->loopData, dm->numLoopData) +
+	        customdata_mem_size(&dm->polyData, dm->numPolyData));
+}
+
+/**
+ * Store copies of the stack result after \a md, replacing any previous result.
+ *
+ * \note Results are stored as CDDM copies, #CDDM_copy creates the ORIGINDEX layers
+ * which subsurf only builds on demand, so they are kept. Temporary layers (such as
+ * poly normals) are not copied, the following modifiers compute them again when needed.
+ *
+ * \return false when the result doesn't fit in the memory budget.
+ */
+bool modifier_result_cache_store(
+        ModifierData *md, unsigned int key, CustomDataMask append_mask,
+        DerivedMesh *dm, DerivedMesh *orcodm, DerivedMesh *clothorcodm)
+{
+	ModifierResultCache *cache;
+	/* lower bound, avoids copying results which can't fit anyway */
+	const size_t mem_size_min =
+	        sizeof(MVert) * (size_t)dm->getNumVerts(dm) + sizeof(MEdge) * (size_t)dm->getNumEdges(dm) +
+	        sizeof(MLoop) * (size_t)dm->getNumLoops(dm) + sizeof(MPoly) * (size_t)dm->getNumPolys(dm);
+	size_t mem_size;
+
+	modifier_result_cache_free(md);
+
+	if (mem_size_min + modifier_result_cache_stats.mem_used > modifier_result_cache_stats.mem_budget) {
+		return false;
+	}
+
+	cache = MEM_callocN(sizeof(*cache), __func__);
+	cache->key = key;
+	cache->append_mask = append_mask;
+	cache->dm = CDDM_copy(dm);
+	cache->orcodm = orcodm ? CDDM_copy(orcodm) : NULL;
+	cache->clothorcodm = clothorcodm ? CDDM_copy(clothorcodm) : NULL;
+	md->result_cache = cache;
+
+	mem_size = dm_mem_size(cache->dm) + dm_mem_size(cache->orcodm) + dm_mem_size(cache->clothorcodm);
+
+	if (atomic_add_and_fetch_z(&modifier_result_cache_stats.mem_used, mem_size) >
+	    modifier_result_cache_stats.mem_budget)
+	{
+		atomic_sub_and_fetch_z(&modifier_result_cache_stats.mem_used, mem_size);
+		modifier_result_cache_free(md);
+		return false;
+	}
+
+	cache->mem_size = mem_size;
+	atomic_add_and_fetch_u(&modifier_result_cache_stats.num_entries, 1);
+
+	return true;
+}
+
+void modifier_result_cache_free(ModifierData *md)
+{
+	ModifierResultCache *cache = md->result_cache;
+
+	if (cache == NULL) {
+		return;
+	}
+
+	cache->dm->release(cache->dm);
+	if (cache->orcodm) {
+		cache->orcodm->release(cache->orcodm);
+	}
+	if (cache->clothorcodm) {
+		cache->clothorcodm->release(cache->clothorcodm);
+	}
+
+	/* zero while the entry is being stored */
+	if (cache->mem_size) {
+		atomic_sub_and_fetch_z(&modifier_result_cache_stats.mem_used, cache->mem_size);
+		atomic_sub_and_fetch_u(&modifier_result_cache_stats.num_entries, 1);
+	}
+
+	MEM_freeN(cache);
+	md->result_cache = NULL;
+}
+
+/**
+ * Free the cached results depending on \a md, to be called when its settings change.
+ */
+void modifier_result_cache_invalidate(ModifierData *md)
+{
+	for (; md; md = md->next) {
+		modifier_result_cache_free(md);
+	}
+}
+
+void modifier_result_cache_stats_count(const bool hit)
+{
+	if (hit) {
+		atomic_add_and_fetch_u(&modifier_result_cache_stats.num_hits, 1);
+	}
+	else {
+		atomic_add_and_fetch_u(&modifier_result_cache_stats.num_misses, 1);
+	}
+}
+
+void modifier_result_cache_stats_get(ModifierResultCacheStats *r_stats)
+{
+	r_stats->mem_used = modifier_result_cache_stats.mem_used;
+	r_stats->mem_budget = modifier_result_cache_stats.mem_budget;
+	r_stats->num_entries = modifier_result_cache_stats.num_entries;
+	r_stats->num_hits = modifier_result_cache_stats.num_hits;
+	r_stats->num_misses = modifier_result_cache_stats.num_misses;
+}
+
+/**
+ * Existing results are kept when lowering the budget, it only limits new ones.
+ */
+void modifier_result_cache_budget_set(size_t mem_budget)
+{
+	modifier_result_cache_stats.mem_budget = mem_budget;
+}
+
+/** \} */
+
 /* wrapper around ModifierTypeInfo.applyModifier that ensures valid normals */
 
 struct DerivedMesh *modwrap_applyModifier(
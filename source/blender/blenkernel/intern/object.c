@@ -3076,6 +3076,8 @@ bool BKE_object_shapekey_remove(Main *bmain, Object *ob, KeyBlock *kb)
 		}
 	}
 
+	BKE_keyblock_delta_cache_invalidate(key, kb);
+
 	BLI_remlink(&key->block, kb);
 	key->totkey--;
 	if (key->refkey == kb) {
@@ -2005,6 +2005,50 @@ void BKE_scene_update_for_newframe_ex(EvaluationContext *eval_ctx, Main *bmain,
 #endif
 }
 
+/* Frame update which only brings the given IDs up to date, for exporters and
+ * bakers which need evaluated state of a few datablocks on many frames.
+ *
+ * Frame change handlers are not run, the rest of the scene is updated by the
+ * next regular update.
+ */
+void BKE_scene_update_ids_for_newframe(EvaluationContext *eval_ctx, Main *bmain, Scene *sce, unsigned int lay,
+                                       ID **ids, int num_ids)
+{
+	float ctime = BKE_scene_frame_get(sce);
+	Scene *sce_iter;
+
+#ifdef WITH_LEGACY_DEPSGRAPH
+	if (DEG_depsgraph_use_legacy()) {
+		BKE_scene_update_for_newframe_ex(eval_ctx, bmain, sce, lay, false);
+		return;
+	}
+#endif
+
+	BKE_image_update_frame(bmain, sce->r.cfra);
+
+	for (sce_iter = sce; sce_iter; sce_iter = sce_iter->set)
+		DAG_scene_relations_update(bmain, sce_iter);
+
+	BKE_mask_evaluate_all_masks(bmain, ctime, true);
+
+	BKE_cachefile_update_frame(bmain, sce, ctime, (((double)sce->r.frs_sec) / (double)sce->r.frs_sec_base));
+
+#ifdef POSE_ANIMATION_WORKAROUND
+	scene_armature_depsgraph_workaround(bmain);
+#endif
+
+	BKE_main_id_tag_idcode(bmain, ID_MA, LIB_TAG_DOIT, false);
+	BKE_main_id_tag_idcode(bmain, ID_LA, LIB_TAG_DOIT, false);
+
+	DEG_evaluate_ids_on_framechange(eval_ctx, bmain, sce->depsgraph, ctime, lay, ids, num_ids);
+
+	/* Inform editors about possible changes. */
+	DAG_ids_check_recalc(bmain, sce, true);
+
+	/* clear recalc flags, postponed IDs keep them for the next update */
+	DEG_ids_clear_recalc_evaluated(bmain, sce->depsgraph);
+}
+
 /* return default layer, also used to patch old files */
 SceneRenderLayer *BKE_scene_add_render_layer(Scene *sce, const char *name)
 {
@@ -142,6 +142,10 @@ float BLI_bvhtree_get_epsilon(const BVHTree *tree);
 int BLI_bvhtree_find_nearest(
         BVHTree *tree, const float co[3], BVHTreeNearest *nearest,
         BVHTree_NearestPointCallback callback, void *userdata);
+/* threaded version for arrays of points, the callback must be thread-safe */
+void BLI_bvhtree_find_nearest_batch(
+        BVHTree *tree, const float (*co)[3], BVHTreeNearest *nearest, const int co_num,
+        BVHTree_NearestPointCallback callback, void *userdata);
 
 int BLI_bvhtree_find_nearest_to_ray_angle(
         BVHTree *tree, const float co[3], const float dir[3],
@@ -162,6 +166,12 @@ int BLI_bvhtree_ray_cast_ex(
 int BLI_bvhtree_ray_cast(
         BVHTree *tree, const float co[3], const float dir[3], float radius, BVHTreeRayHit *hit,
         BVHTree_RayCastCallback callback, void *userdata);
+/* threaded version for arrays of rays, the callback must be thread-safe */
+void BLI_bvhtree_ray_cast_batch(
+        BVHTree *tree, const float (*co)[3], const float (*dir)[3], float radius,
+        BVHTreeRayHit *hits, const int rays_num,
+        BVHTree_RayCastCallback callback, void *userdata,
+        int flag);
 
 void BLI_bvhtree_ray_cast_all_ex(
         BVHTree *tree, const float co[3], const float dir[3], float radius, float hit_dist,
@@ -37,8 +37,9 @@ extern "C" {
 
 /* Task Scheduler
  * 
- * Central scheduler that holds running threads ready to execute tasks. A single
- * queue holds the task from all pools.
+ * Central scheduler that holds running threads ready to execute tasks. Each
+ * worker thread has its own queue holding tasks from all pools, threads which
+ * run out of work steal tasks from the queues of the other threads.
  *
  * Init/exit must be called before/after any task pools are created/freed, and
  * must be called from the main threads. All other scheduler and pool functions
@@ -51,6 +52,7 @@ enum {
 	TASK_SCHEDULER_SINGLE_THREAD = 1
 };
 
+TaskScheduler *BLI_task_scheduler_create_ex(int num_threads, const bool use_thread_affinity);
 TaskScheduler *BLI_task_scheduler_create(int num_threads);
 void BLI_task_scheduler_free(TaskScheduler *scheduler);
 
@@ -75,6 +77,7 @@ typedef enum TaskPriority {
 	TASK_PRIORITY_HIGH
 } TaskPriority;
 
+typedef struct Task Task;
 typedef struct TaskPool TaskPool;
 typedef void (*TaskRunFunction)(TaskPool *__restrict pool, void *taskdata, int threadid);
 typedef void (*TaskFreeFunction)(TaskPool *__restrict pool, void *taskdata, int threadid);
@@ -91,6 +94,13 @@ void BLI_task_pool_push(TaskPool *pool, TaskRunFunction run,
 void BLI_task_pool_push_from_thread(TaskPool *pool, TaskRunFunction run,
         void *taskdata, bool free_taskdata, TaskPriority priority, int thread_id);
 
+/* tasks depending on other tasks, scheduled once those are done */
+Task *BLI_task_pool_create_task(
+        TaskPool *pool, TaskRunFunction run, void *taskdata,
+        bool free_taskdata, TaskFreeFunction freedata, TaskPriority priority);
+void BLI_task_add_dependency(Task *task, Task *dependency);
+void BLI_task_submit(Task *task);
+
 /* work and wait until all tasks are done */
 void BLI_task_pool_work_and_wait(TaskPool *pool);
 /* cancel all tasks, keep worker threads running */
@@ -72,6 +72,16 @@
 #  define KDOPBVH_THREAD_LEAF_THRESHOLD 1024
 #endif
 
+/* Tree levels with less branches than this are built one branch after the other,
+ * refitting the (large) leaf ranges of each branch in parallel instead. */
+#define KDOPBVH_THREAD_LEVEL_BRANCHES_MIN 8
+
+/* Number of leafs refit by one task. */
+#define KDOPBVH_REFIT_BLOCK_SIZE 1024
+
+/* Number of rays traversing the tree together in batched ray-casts. */
+#define KDOPBVH_RAY_PACKET_SIZE 8
+
 
 /* -------------------------------------------------------------------- */
 
@@ -511,18 +521,12 @@ static void create_kdop_hull(BVHTree *tree, BVHNode *node, const float *co, int
 	}
 }
 
-/**
- * \note depends on the fact that the BVH's for each face is already build
- */
-static void refit_kdop_hull(BVHTree *tree, BVHNode *node, int start, int end)
+static void refit_kdop_hull_range(const BVHTree *tree, float *bv, int start, int end)
 {
 	float newmin, newmax;
-	float *bv = node->bv;
 	int j;
 	axis_t axis_iter;
 
-	node_minmax_init(tree, node);
-
 	for (j = start; j < end; j++) {
 		/* for all Axes. */
 		for (axis_iter = tree->start_axis; axis_iter < tree->stop_axis; axis_iter++) {
@@ -535,7 +539,63 @@ static void refit_kdop_hull(BVHTree *tree, BVHNode *node, int start, int end)
 				bv[(2 * axis_iter) + 1] = newmax;
 		}
 	}
+}
+
+/**
+ * \note depends on the fact that the BVH's for each face is already build
+ */
+static void refit_kdop_hull(BVHTree *tree, BVHNode *node, int start, int end)
+{
+	node_minmax_init(tree, node);
+	refit_kdop_hull_range(tree, node->bv, start, end);
+}
+
+typedef struct BVHRefitData {
+	const BVHTree *tree;
+	BVHNode *node;
+	int start, end;
+} BVHRefitData;
+
+static void refit_kdop_hull_task_cb(void *userdata, void *userdata_chunk, const int block, const int UNUSED(thread_id))
+{
+	const BVHRefitData *data = userdata;
+	const int start = data->start + block * KDOPBVH_REFIT_BLOCK_SIZE;
+	const int end = min_ii(start + KDOPBVH_REFIT_BLOCK_SIZE, data->end);
+
+	refit_kdop_hull_range(data->tree, userdata_chunk, start, end);
+}
+
+static void refit_kdop_hull_finalize(void *userdata, void *userdata_chunk)
+{
+	const BVHRefitData *data = userdata;
+	const float *bv_chunk = userdata_chunk;
+	float *bv = data->node->bv;
+	axis_t axis_iter;
+
+	for (axis_iter = data->tree->start_axis; axis_iter < data->tree->stop_axis; axis_iter++) {
+		bv[(2 * axis_iter)]     = min_ff(bv[(2 * axis_iter)],     bv_chunk[(2 * axis_iter)]);
+		bv[(2 * axis_iter) + 1] = max_ff(bv[(2 * axis_iter) + 1], bv_chunk[(2 * axis_iter) + 1]);
+	}
+}
+
+/**
+ * A version of #refit_kdop_hull splitting the leafs range over threads,
+ * used for the top levels of the tree which have less branches than threads.
+ */
+static void refit_kdop_hull_threaded(BVHTree *tree, BVHNode *node, int start, int end)
+{
+	BVHRefitData data = {.tree = tree, .node = node, .start = start, .end = end};
+	const int num_blocks = (end - start + KDOPBVH_REFIT_BLOCK_SIZE - 1) / KDOPBVH_REFIT_BLOCK_SIZE;
+	float bv_chunk[13 * 2];
+
+	node_minmax_init(tree, node);
+	memcpy(&bv_chunk[2 * tree->start_axis], &node->bv[2 * tree->start_axis],
+	       sizeof(float) * 2 * (size_t)(tree->stop_axis - tree->start_axis));
 
+	BLI_task_parallel_range_finalize(
+	        0, num_blocks, &data, bv_chunk, sizeof(bv_chunk),
+	        refit_kdop_hull_task_cb, refit_kdop_hull_finalize,
+	        num_blocks > 1, false);
 }
 
 /**
@@ -800,6 +860,9 @@ typedef struct BVHDivNodesData {
 	int depth;
 	int i;
 	int first_of_next_level;
+
+	/* Whether branches of this level refit their leafs in parallel. */
+	bool use_threading_refit;
 } BVHDivNodesData;
 
 static void non_recursive_bvh_div_nodes_task_cb(void *userdata, const int j)
@@ -817,7 +880,12 @@ static void non_recursive_bvh_div_nodes_task_cb(void *userdata, const int j)
 
 	/* This calculates the bounding box of this branch
 	 * and chooses the largest axis as the axis to divide leafs */
-	refit_kdop_hull(data->tree, parent, parent_leafs_begin, parent_leafs_end);
+	if (data->use_threading_refit) {
+		refit_kdop_hull_threaded(data->tree, parent, parent_leafs_begin, parent_leafs_end);
+	}
+	else {
+		refit_kdop_hull(data->tree, parent, parent_leafs_begin, parent_leafs_end);
+	}
 	split_axis = get_largest_axis(parent->bv);
 
 	/* Save split axis (this can be used on raytracing to speedup the query time) */
@@ -912,7 +980,7 @@ static void non_recursive_bvh_div_nodes(BVHTree *tree, BVHNode *branches_array,
 	BVHDivNodesData cb_data = {
 		.tree = tree, .branches_array = branches_array, .leafs_array = leafs_array,
 		.tree_type = tree_type, .tree_offset = tree_offset, .data = &data,
-		.first_of_next_level = 0, .depth = 0, .i = 0,
+		.first_of_next_level = 0, .depth = 0, .i = 0, .use_threading_refit = false,
 	};
 
 	/* Loop tree levels (log N) loops */
@@ -920,14 +988,18 @@ static void non_recursive_bvh_div_nodes(BVHTree *tree, BVHNode *branches_array,
 		const int first_of_next_level = i * tree_type + tree_offset;
 		const int end_j = min_ii(first_of_next_level, num_branches + 1);  /* index of last branch on this level */
 
+		const bool use_threading = num_leafs > KDOPBVH_THREAD_LEAF_THRESHOLD;
+
 		/* Loop all branches on this level */
 		cb_data.first_of_next_level = first_of_next_level;
 		cb_data.i = i;
 		cb_data.depth = depth;
+		/* Top levels don't have enough branches to keep all threads busy. */
+		cb_data.use_threading_refit = use_threading && (end_j - i < KDOPBVH_THREAD_LEVEL_BRANCHES_MIN);
 
 		BLI_task_parallel_range(
 		            i, end_j, &cb_data, non_recursive_bvh_div_nodes_task_cb,
-		            num_leafs > KDOPBVH_THREAD_LEAF_THRESHOLD);
+		            use_threading && !cb_data.use_threading_refit);
 	}
 }
 
@@ -1571,6 +1643,43 @@ int BLI_bvhtree_find_nearest(
 	return data.nearest.index;
 }
 
+
+typedef struct BVHNearestBatchData {
+	BVHTree *tree;
+	const float (*co)[3];
+	BVHTreeNearest *nearest;
+	BVHTree_NearestPointCallback callback;
+	void *userdata;
+} BVHNearestBatchData;
+
+static void bvhtree_find_nearest_batch_task_cb(
+        void *userdata, void *UNUSED(userdata_chunk), const int i, const int UNUSED(thread_id))
+{
+	const BVHNearestBatchData *batch = userdata;
+
+	BLI_bvhtree_find_nearest(batch->tree, batch->co[i], &batch->nearest[i], batch->callback, batch->userdata);
+}
+
+/**
+ * Find the nearest element of an array of points,
+ * the equivalent of calling #BLI_bvhtree_find_nearest for each of them.
+ *
+ * \param nearest: Array of \a co_num results, used as input too (maximum \a dist_sq).
+ * \note The \a callback is called from multiple threads.
+ */
+void BLI_bvhtree_find_nearest_batch(
+        BVHTree *tree, const float (*co)[3], BVHTreeNearest *nearest, const int co_num,
+        BVHTree_NearestPointCallback callback, void *userdata)
+{
+	BVHNearestBatchData batch = {
+		.tree = tree, .co = co, .nearest = nearest, .callback = callback, .userdata = userdata,
+	};
+
+	BLI_task_parallel_range_ex(
+	        0, co_num, &batch, NULL, 0, bvhtree_find_nearest_batch_task_cb,
+	        co_num > KDOPBVH_THREAD_LEAF_THRESHOLD, true);
+}
+
 /** \} */
 
 
@@ -1898,6 +2007,210 @@ void BLI_bvhtree_ray_cast_all(
 }
 
 
+/* -------------------------------------------------------------------- */
+
+/** \name BLI_bvhtree_ray_cast_batch
+ *
+ * Rays are grouped in packets of #KDOPBVH_RAY_PACKET_SIZE which traverse the tree together,
+ * the node tests of all rays in a packet are done in a single branch-free loop over
+ * structure-of-arrays data, so the compiler can vectorize it.
+ * Packets are distributed over threads.
+ *
+ * \{ */
+
+typedef struct BVHRayCastPacket {
+	BVHRayCastData data[KDOPBVH_RAY_PACKET_SIZE];
+
+	/* Copies of the per ray data used by the node tests, in lane order. */
+	float origin[3][KDOPBVH_RAY_PACKET_SIZE];
+	float idot_axis[3][KDOPBVH_RAY_PACKET_SIZE];
+	/* Index (0 or 1) of the near bound along each axis. */
+	int near_index[3][KDOPBVH_RAY_PACKET_SIZE];
+	float hit_dist[KDOPBVH_RAY_PACKET_SIZE];
+} BVHRayCastPacket;
+
+/**
+ * Same test as #fast_ray_nearest_hit for all rays of the packet.
+ *
+ * \return the mask of rays in \a mask hitting the node closer than their current hit.
+ */
+static unsigned int ray_packet_nearest_hit(
+        const BVHRayCastPacket *packet, const BVHNode *node, const unsigned int mask,
+        float r_dist[KDOPBVH_RAY_PACKET_SIZE])
+{
+	const float *bv = node->bv;
+	unsigned int hit_mask = 0;
+	int l;
+
+	for (l = 0; l < KDOPBVH_RAY_PACKET_SIZE; l++) {
+		const int ix = packet->near_index[0][l];
+		const int iy = packet->near_index[1][l];
+		const int iz = packet->near_index[2][l];
+		const float t1x = (bv[ix]     - packet->origin[0][l]) * packet->idot_axis[0][l];
+		const float t2x = (bv[1 - ix] - packet->origin[0][l]) * packet->idot_axis[0][l];
+		const float t1y = (bv[2 + iy] - packet->origin[1][l]) * packet->idot_axis[1][l];
+		const float t2y = (bv[3 - iy] - packet->origin[1][l]) * packet->idot_axis[1][l];
+		const float t1z = (bv[4 + iz] - packet->origin[2][l]) * packet->idot_axis[2][l];
+		const float t2z = (bv[5 - iz] - packet->origin[2][l]) * packet->idot_axis[2][l];
+		const float dist = max_fff(t1x, t1y, t1z);
+		const float hit_dist = packet->hit_dist[l];
+
+		const bool miss =
+		        (t1x > t2y) | (t2x < t1y) | (t1x > t2z) | (t2x < t1z) | (t1y > t2z) | (t2y < t1z) |
+		        (t2x < 0.0f) | (t2y < 0.0f) | (t2z < 0.0f) |
+		        (t1x > hit_dist) | (t1y > hit_dist) | (t1z > hit_dist) |
+		        (dist >= hit_dist);
+
+		r_dist[l] = dist;
+		hit_mask |= (unsigned int)!miss << l;
+	}
+
+	return hit_mask & mask;
+}
+
+static void dfs_raycast_packet(BVHRayCastPacket *packet, BVHNode *node, unsigned int mask)
+{
+	float dist[KDOPBVH_RAY_PACKET_SIZE];
+	int i, l;
+
+	mask = ray_packet_nearest_hit(packet, node, mask, dist);
+	if (mask == 0) {
+		return;
+	}
+
+	if (node->totnode == 0) {
+		for (l = 0; l < KDOPBVH_RAY_PACKET_SIZE; l++) {
+			if (mask & (1u << l)) {
+				BVHRayCastData *data = &packet->data[l];
+				if (data->callback) {
+					data->callback(data->userdata, node->index, &data->ray, &data->hit);
+				}
+				else {
+					data->hit.index = node->index;
+					data->hit.dist  = dist[l];
+					madd_v3_v3v3fl(data->hit.co, data->ray.origin, data->ray.direction, dist[l]);
+				}
+				packet->hit_dist[l] = data->hit.dist;
+			}
+		}
+	}
+	else {
+		/* pick loop direction from the first active ray, rays of a packet are expected to be coherent */
+		const BVHRayCastData *data = packet->data;
+		for (l = 0; (mask & (1u << l)) == 0; l++) {
+			data++;
+		}
+
+		if (data->ray_dot_axis[node->main_axis] > 0.0f) {
+			for (i = 0; i != node->totnode; i++) {
+				dfs_raycast_packet(packet, node->children[i], mask);
+			}
+		}
+		else {
+			for (i = node->totnode - 1; i >= 0; i--) {
+				dfs_raycast_packet(packet, node->children[i], mask);
+			}
+		}
+	}
+}
+
+typedef struct BVHRayCastBatchData {
+	BVHTree *tree;
+	const float (*co)[3];
+	const float (*dir)[3];
+	float radius;
+	BVHTreeRayHit *hits;
+	int rays_num;
+	BVHTree_RayCastCallback callback;
+	void *userdata;
+	int flag;
+} BVHRayCastBatchData;
+
+static void bvhtree_ray_cast_batch_task_cb(
+        void *userdata, void *UNUSED(userdata_chunk), const int packet_index, const int UNUSED(thread_id))
+{
+	const BVHRayCastBatchData *batch = userdata;
+	BVHNode *root = batch->tree->nodes[batch->tree->totleaf];
+	const int start = packet_index * KDOPBVH_RAY_PACKET_SIZE;
+	const int rays_num = min_ii(KDOPBVH_RAY_PACKET_SIZE, batch->rays_num - start);
+	BVHRayCastPacket packet;
+	int l, i;
+
+	for (l = 0; l < rays_num; l++) {
+		BVHRayCastData *data = &packet.data[l];
+
+		BLI_ASSERT_UNIT_V3(batch->dir[start + l]);
+
+		data->tree = batch->tree;
+		data->callback = batch->callback;
+		data->userdata = batch->userdata;
+
+		copy_v3_v3(data->ray.origin,    batch->co[start + l]);
+		copy_v3_v3(data->ray.direction, batch->dir[start + l]);
+		data->ray.radius = batch->radius;
+
+		bvhtree_ray_cast_data_precalc(data, batch->flag);
+
+		memcpy(&data->hit, &batch->hits[start + l], sizeof(data->hit));
+	}
+
+	if (root) {
+		if (batch->radius == 0.0f) {
+			for (l = 0; l < KDOPBVH_RAY_PACKET_SIZE; l++) {
+				/* unused lanes of the last packet repeat the first ray, they are masked out */
+				const BVHRayCastData *data = &packet.data[(l < rays_num) ? l : 0];
+				for (i = 0; i < 3; i++) {
+					packet.origin[i][l] = data->ray.origin[i];
+					packet.idot_axis[i][l] = data->idot_axis[i];
+					packet.near_index[i][l] = data->index[2 * i] - 2 * i;
+				}
+				packet.hit_dist[l] = data->hit.dist;
+			}
+
+			dfs_raycast_packet(&packet, root, (1u << rays_num) - 1);
+		}
+		else {
+			/* XXX: packets don't support ray.radius, see #dfs_raycast */
+			for (l = 0; l < rays_num; l++) {
+				dfs_raycast(&packet.data[l], root);
+			}
+		}
+	}
+
+	for (l = 0; l < rays_num; l++) {
+		memcpy(&batch->hits[start + l], &packet.data[l].hit, sizeof(packet.data[l].hit));
+	}
+}
+
+/**
+ * Cast an array of rays, the equivalent of calling #BLI_bvhtree_ray_cast_ex for each of them.
+ *
+ * \param hits: Array of \a rays_num hits, used as input (max distance, usually #BVH_RAYCAST_DIST_MAX
+ * with an index of -1) and for the results.
+ * \note The \a callback is called from multiple threads.
+ * Rays next to each other in the arrays should be coherent (close origins and directions)
+ * for the packets to traverse the tree efficiently.
+ */
+void BLI_bvhtree_ray_cast_batch(
+        BVHTree *tree, const float (*co)[3], const float (*dir)[3], float radius,
+        BVHTreeRayHit *hits, const int rays_num,
+        BVHTree_RayCastCallback callback, void *userdata,
+        int flag)
+{
+	BVHRayCastBatchData batch = {
+		.tree = tree, .co = co, .dir = dir, .radius = radius, .hits = hits, .rays_num = rays_num,
+		.callback = callback, .userdata = userdata, .flag = flag,
+	};
+	const int packets_num = (rays_num + KDOPBVH_RAY_PACKET_SIZE - 1) / KDOPBVH_RAY_PACKET_SIZE;
+
+	BLI_task_parallel_range_ex(
+	        0, packets_num, &batch, NULL, 0, bvhtree_ray_cast_batch_task_cb,
+	        rays_num > KDOPBVH_THREAD_LEAF_THRESHOLD, true);
+}
+
+/** \} */
+
+
 /* -------------------------------------------------------------------- */
 
 /** \name BLI_bvhtree_find_nearest_to_ray functions
@@ -0,0 +1,953 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/blenlib/intern/flathash.c
+ *  \ingroup bli
+ *
+ * A general (pointer -> pointer) open addressing hash table,
+ * with the same API as #GHash (see BLI_ghash.c).
+ *
+ * Keys and values are stored inline in flat arrays, so unlike #GHash there is
+ * no allocation per entry and no pointer chasing through bucket chains.
+ *
+ * Each slot has one control byte:
+ * - ``FLATHASH_CTRL_EMPTY`` the slot was never used, terminates a probe sequence.
+ * - ``FLATHASH_CTRL_DELETED`` the slot was removed, probing continues past it.
+ * - Otherwise the slot is used, the byte holds 7 bits of the key hash (the 'tag').
+ *
+ * Lookups compare the tag against a whole group of control bytes at once (using SSE2 when available),
+ * so the compare callback is only called for slots which are very likely to match.
+ * Groups are probed starting at the hash, moving by a triangular number of groups.
+ *
+ * The control bytes of the first group are mirrored after the last slot,
+ * so a group starting at any slot can be read without wrapping around.
+ *
+ * \note Unlike #GHash, inserting (or removing while iterating) moves entries in memory,
+ * pointers returned by lookup functions are only valid until the next insertion.
+ */
+
+#include <string.h>
+#include <stdlib.h>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_sys_types.h"  /* for intptr_t support */
+#include "BLI_utildefines.h"
+
+#include "BLI_flathash.h"
+#include "BLI_strict_flags.h"
+
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+#ifdef _MSC_VER
+#  include <intrin.h>
+#endif
+
+#define FLATHASH_GROUP_SIZE 16
+
+#define FLATHASH_CTRL_EMPTY   ((unsigned char)0x80)
+#define FLATHASH_CTRL_DELETED ((unsigned char)0xfe)
+
+#define FLATHASH_SLOT_NONE ((unsigned int)-1)
+
+/**
+ * Max load, open addressing needs free slots to end probe sequences,
+ * group probing keeps those short even with high load.
+ */
+#define FLATHASH_LIMIT_GROW(_nslots) (((_nslots) * 7) / 8)
+
+enum {
+	/* Whether the FlatHash is actually used as FlatSet (no value storage). */
+	FLATHASH_FLAG_IS_FLATSET = (1 << 16),
+};
+
+struct FlatHash {
+	GHashHashFP hashfp;
+	GHashCmpFP cmpfp;
+
+	/* All arrays are in a single allocation (starting with keys). */
+	void **keys;
+	void **vals;  /* NULL for FlatSet. */
+	unsigned char *ctrl;  /* nslots + FLATHASH_GROUP_SIZE. */
+
+	unsigned int nslots;  /* Always a power of two. */
+	unsigned int limit_grow;
+
+	unsigned int nentries;
+	unsigned int ndeleted;
+	unsigned int flag;
+};
+
+/* -------------------------------------------------------------------- */
+/** \name Internal Utility API
+ * \{ */
+
+BLI_INLINE bool flathash_ctrl_is_used(const unsigned char ctrl)
+{
+	return (ctrl & 0x80) == 0;
+}
+
+/**
+ * Both the slot index (low bits) and the tag (high bits) come from the hash,
+ * but #GHash callbacks don't always spread keys over all bits (pointers, plain integers),
+ * so mix them (murmur3 finalizer).
+ */
+BLI_INLINE unsigned int flathash_keyhash(FlatHash *fh, const void *key)
+{
+	unsigned int hash = fh->hashfp(key);
+
+	hash ^= hash >> 16;
+	hash *= 0x85ebca6bu;
+	hash ^= hash >> 13;
+	hash *= 0xc2b2ae35u;
+	hash ^= hash >> 16;
+
+	return hash;
+}
+
+BLI_INLINE unsigned char flathash_tag(const unsigned int hash)
+{
+	return (unsigned char)(hash >> 25);
+}
+
+/**
+ * \return a bit-mask of the bytes in the group starting at \a group which are equal to \a ctrl.
+ */
+BLI_INLINE unsigned int flathash_group_match(const unsigned char *group, const unsigned char ctrl)
+{
+#ifdef __SSE2__
+	const __m128i group_v = _mm_loadu_si128((const __m128i *)group);
+	return (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(group_v, _mm_set1_epi8((char)ctrl)));
+#else
+	unsigned int mask = 0, i;
+	for (i = 0; i < FLATHASH_GROUP_SIZE; i++) {
+		mask |= (unsigned int)(group[i] == ctrl) << i;
+	}
+	return mask;
+#endif
+}
+
+/**
+ * \return a bit-mask of the empty or deleted slots in the group starting at \a group.
+ */
+BLI_INLINE unsigned int flathash_group_match_free(const unsigned char *group)
+{
+#ifdef __SSE2__
+	return (unsigned int)_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)group));
+#else
+	unsigned int mask = 0, i;
+	for (i = 0; i < FLATHASH_GROUP_SIZE; i++) {
+		mask |= (unsigned int)(group[i] >> 7) << i;
+	}
+	return mask;
+#endif
+}
+
+/* index of the lowest bit set, \a mask must not be zero */
+BLI_INLINE unsigned int flathash_mask_first(const unsigned int mask)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return (unsigned int)index;
+#else
+	return (unsigned int)__builtin_ctz(mask);
+#endif
+}
+
+BLI_INLINE void flathash_ctrl_set(FlatHash *fh, const unsigned int slot, const unsigned char ctrl)
+{
+	fh->ctrl[slot] = ctrl;
+	if (slot < FLATHASH_GROUP_SIZE) {
+		fh->ctrl[fh->nslots + slot] = ctrl;
+	}
+}
+
+/**
+ * Smallest number of slots holding \a nentries without growing.
+ */
+static unsigned int flathash_nslots_calc(const unsigned int nentries)
+{
+	unsigned int nslots = FLATHASH_GROUP_SIZE;
+
+	while (FLATHASH_LIMIT_GROW(nslots) < nentries) {
+		nslots <<= 1;
+	}
+	return nslots;
+}
+
+static void flathash_slots_alloc(FlatHash *fh, const unsigned int nslots)
+{
+	const size_t nptrs = (fh->flag & FLATHASH_FLAG_IS_FLATSET) ? 1 : 2;
+	char *mem = MEM_mallocN((sizeof(void *) * nptrs + 1) * nslots + FLATHASH_GROUP_SIZE, "FlatHash slots");
+
+	fh->keys = (void **)mem;
+	fh->vals = (nptrs == 2) ? fh->keys + nslots : NULL;
+	fh->ctrl = (unsigned char *)(fh->keys + nptrs * nslots);
+	memset(fh->ctrl, FLATHASH_CTRL_EMPTY, nslots + FLATHASH_GROUP_SIZE);
+
+	fh->nslots = nslots;
+	fh->limit_grow = FLATHASH_LIMIT_GROW(nslots);
+	fh->ndeleted = 0;
+}
+
+/**
+ * Get the slot of \a key, or #FLATHASH_SLOT_NONE.
+ */
+BLI_INLINE unsigned int flathash_lookup_slot_ex(FlatHash *fh, const void *key, const unsigned int hash)
+{
+	const unsigned int slot_mask = fh->nslots - 1;
+	const unsigned char tag = flathash_tag(hash);
+	unsigned int pos = hash & slot_mask;
+	unsigned int step = 0;
+
+	while (true) {
+		const unsigned char *group = &fh->ctrl[pos];
+		unsigned int match = flathash_group_match(group, tag);
+
+		while (match) {
+			const unsigned int slot = (pos + flathash_mask_first(match)) & slot_mask;
+			if (fh->cmpfp(key, fh->keys[slot]) == false) {
+				return slot;
+			}
+			match &= match - 1;
+		}
+
+		/* there are always empty slots, so this terminates */
+		if (flathash_group_match(group, FLATHASH_CTRL_EMPTY)) {
+			return FLATHASH_SLOT_NONE;
+		}
+
+		step += FLATHASH_GROUP_SIZE;
+		pos = (pos + step) & slot_mask;
+	}
+}
+
+BLI_INLINE unsigned int flathash_lookup_slot(FlatHash *fh, const void *key)
+{
+	return flathash_lookup_slot_ex(fh, key, flathash_keyhash(fh, key));
+}
+
+/**
+ * Get the first empty or deleted slot in the probe sequence of \a hash.
+ */
+BLI_INLINE unsigned int flathash_free_slot(FlatHash *fh, const unsigned int hash)
+{
+	const unsigned int slot_mask = fh->nslots - 1;
+	unsigned int pos = hash & slot_mask;
+	unsigned int step = 0;
+
+	while (true) {
+		const unsigned int match = flathash_group_match_free(&fh->ctrl[pos]);
+
+		if (match) {
+			return (pos + flathash_mask_first(match)) & slot_mask;
+		}
+
+		step += FLATHASH_GROUP_SIZE;
+		pos = (pos + step) & slot_mask;
+	}
+}
+
+/**
+ * Re-insert all entries into \a nslots slots, also drops deleted slots.
+ */
+static void flathash_resize(FlatHash *fh, const unsigned int nslots)
+{
+	void **keys_old = fh->keys;
+	void **vals_old = fh->vals;
+	const unsigned char *ctrl_old = fh->ctrl;
+	const unsigned int nslots_old = fh->nslots;
+	unsigned int i;
+
+	flathash_slots_alloc(fh, nslots);
+
+	for (i = 0; i < nslots_old; i++) {
+		if (flathash_ctrl_is_used(ctrl_old[i])) {
+			const unsigned int hash = flathash_keyhash(fh, keys_old[i]);
+			const unsigned int slot = flathash_free_slot(fh, hash);
+
+			flathash_ctrl_set(fh, slot, flathash_tag(hash));
+			fh->keys[slot] = keys_old[i];
+			if (vals_old) {
+				fh->vals[slot] = vals_old[i];
+			}
+		}
+	}
+
+	MEM_freeN(keys_old);
+}
+
+/**
+ * Take a free slot for a new entry of \a hash, the caller must assign the key (and value).
+ */
+static unsigned int flathash_insert_slot(FlatHash *fh, const unsigned int hash)
+{
+	unsigned int slot = flathash_free_slot(fh, hash);
+
+	if (fh->ctrl[slot] == FLATHASH_CTRL_DELETED) {
+		fh->ndeleted--;
+	}
+	else if (fh->nentries + fh->ndeleted >= fh->limit_grow) {
+		/* Grow, or only drop the deleted slots when there are many of them.
+		 * Keep some room so removing and adding entries doesn't re-hash on every insertion. */
+		const unsigned int nslots = flathash_nslots_calc(fh->nentries + 1 + fh->nentries / 4);
+		flathash_resize(fh, MAX2(nslots, fh->nslots));
+		slot = flathash_free_slot(fh, hash);
+	}
+
+	flathash_ctrl_set(fh, slot, flathash_tag(hash));
+	fh->nentries++;
+
+	return slot;
+}
+
+BLI_INLINE void flathash_remove_slot(FlatHash *fh, const unsigned int slot)
+{
+	flathash_ctrl_set(fh, slot, FLATHASH_CTRL_DELETED);
+	fh->nentries--;
+	fh->ndeleted++;
+}
+
+static FlatHash *flathash_new(GHashHashFP hashfp, GHashCmpFP cmpfp, const char *info,
+                              const unsigned int nentries_reserve, const unsigned int flag)
+{
+	FlatHash *fh = MEM_mallocN(sizeof(*fh), info);
+
+	fh->hashfp = hashfp;
+	fh->cmpfp = cmpfp;
+	fh->nentries = 0;
+	fh->flag = flag;
+
+	flathash_slots_alloc(fh, flathash_nslots_calc(nentries_reserve));
+
+	return fh;
+}
+
+BLI_INLINE void flathash_insert(FlatHash *fh, void *key, void *val)
+{
+	const unsigned int slot = flathash_insert_slot(fh, flathash_keyhash(fh, key));
+
+	fh->keys[slot] = key;
+	if (fh->vals) {
+		fh->vals[slot] = val;
+	}
+}
+
+/**
+ * Insert or replace, \return true if a new key has been added.
+ */
+BLI_INLINE bool flathash_insert_safe(
+        FlatHash *fh, void *key, void *val, GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp)
+{
+	const unsigned int hash = flathash_keyhash(fh, key);
+	unsigned int slot = flathash_lookup_slot_ex(fh, key, hash);
+
+	if (slot != FLATHASH_SLOT_NONE) {
+		if (keyfreefp) keyfreefp(fh->keys[slot]);
+		if (valfreefp) valfreefp(fh->vals[slot]);
+		fh->keys[slot] = key;
+		if (fh->vals) {
+			fh->vals[slot] = val;
+		}
+		return false;
+	}
+
+	slot = flathash_insert_slot(fh, hash);
+	fh->keys[slot] = key;
+	if (fh->vals) {
+		fh->vals[slot] = val;
+	}
+	return true;
+}
+
+/**
+ * Ensure \a key has a slot, see #BLI_flathash_ensure_p.
+ */
+BLI_INLINE bool flathash_ensure_slot(FlatHash *fh, const void *key, unsigned int *r_slot)
+{
+	const unsigned int hash = flathash_keyhash(fh, key);
+	unsigned int slot = flathash_lookup_slot_ex(fh, key, hash);
+	const bool haskey = (slot != FLATHASH_SLOT_NONE);
+
+	if (!haskey) {
+		slot = flathash_insert_slot(fh, hash);
+		fh->keys[slot] = (void *)key;
+	}
+
+	*r_slot = slot;
+	return haskey;
+}
+
+static void flathash_free_cb(FlatHash *fh, GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp)
+{
+	unsigned int i;
+
+	BLI_assert(keyfreefp || valfreefp);
+	BLI_assert(!valfreefp || fh->vals);
+
+	for (i = 0; i < fh->nslots; i++) {
+		if (flathash_ctrl_is_used(fh->ctrl[i])) {
+			if (keyfreefp) keyfreefp(fh->keys[i]);
+			if (valfreefp) valfreefp(fh->vals[i]);
+		}
+	}
+}
+
+static FlatHash *flathash_copy(FlatHash *fh, GHashKeyCopyFP keycopyfp, GHashValCopyFP valcopyfp)
+{
+	FlatHash *fh_new = MEM_mallocN(sizeof(*fh_new), __func__);
+	const size_t nptrs = fh->vals ? 2 : 1;
+
+	*fh_new = *fh;
+
+	/* same layout, so the slots can be copied as a whole */
+	flathash_slots_alloc(fh_new, fh->nslots);
+	memcpy(fh_new->keys, fh->keys, (sizeof(void *) * nptrs + 1) * fh->nslots + FLATHASH_GROUP_SIZE);
+	fh_new->ndeleted = fh->ndeleted;
+
+	if (keycopyfp || valcopyfp) {
+		unsigned int i;
+
+		for (i = 0; i < fh_new->nslots; i++) {
+			if (flathash_ctrl_is_used(fh_new->ctrl[i])) {
+				if (keycopyfp) fh_new->keys[i] = keycopyfp(fh->keys[i]);
+				if (valcopyfp) fh_new->vals[i] = valcopyfp(fh->vals[i]);
+			}
+		}
+	}
+
+	return fh_new;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Public API
+ * \{ */
+
+/**
+ * Creates a new, empty FlatHash.
+ *
+ * \param hashfp  Hash callback.
+ * \param cmpfp  Comparison callback.
+ * \param info  Identifier string for the FlatHash.
+ * \param nentries_reserve  Optionally reserve the number of members that the hash will hold.
+ * \return  An empty FlatHash.
+ */
+FlatHash *BLI_flathash_new_ex(GHashHashFP hashfp, GHashCmpFP cmpfp, const char *info,
+                              const unsigned int nentries_reserve)
+{
+	return flathash_new(hashfp, cmpfp, info, nentries_reserve, 0);
+}
+
+/**
+ * Wraps #BLI_flathash_new_ex with zero entries reserved.
+ */
+FlatHash *BLI_flathash_new(GHashHashFP hashfp, GHashCmpFP cmpfp, const char *info)
+{
+	return BLI_flathash_new_ex(hashfp, cmpfp, info, 0);
+}
+
+/**
+ * Copy given FlatHash. Keys and values are also copied if relevant callback is provided,
+ * else pointers remain the same.
+ */
+FlatHash *BLI_flathash_copy(FlatHash *fh, GHashKeyCopyFP keycopyfp, GHashValCopyFP valcopyfp)
+{
+	return flathash_copy(fh, keycopyfp, valcopyfp);
+}
+
+/**
+ * Reserve given amount of entries (resize \a fh accordingly if needed).
+ */
+void BLI_flathash_reserve(FlatHash *fh, const unsigned int nentries_reserve)
+{
+	const unsigned int nslots = flathash_nslots_calc(nentries_reserve);
+
+	if (nslots > fh->nslots) {
+		flathash_resize(fh, nslots);
+	}
+}
+
+/**
+ * \return size of the FlatHash.
+ */
+unsigned int BLI_flathash_size(FlatHash *fh)
+{
+	return fh->nentries;
+}
+
+/**
+ * Insert a key/value pair into the \a fh.
+ *
+ * \note Duplicates are not checked,
+ * the caller is expected to ensure elements are unique unless
+ * FLATHASH_FLAG_ALLOW_DUPES flag is set.
+ */
+void BLI_flathash_insert(FlatHash *fh, void *key, void *val)
+{
+	BLI_assert((fh->flag & FLATHASH_FLAG_ALLOW_DUPES) || (BLI_flathash_haskey(fh, key) == 0));
+	flathash_insert(fh, key, val);
+}
+
+/**
+ * Inserts a new value to a key that may already be in the hash.
+ *
+ * \returns true if a new key has been added.
+ */
+bool BLI_flathash_reinsert(FlatHash *fh, void *key, void *val, GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp)
+{
+	return flathash_insert_safe(fh, key, val, keyfreefp, valfreefp);
+}
+
+/**
+ * Lookup the value of \a key in \a fh.
+ *
+ * \returns the value for \a key or NULL.
+ */
+void *BLI_flathash_lookup(FlatHash *fh, const void *key)
+{
+	const unsigned int slot = flathash_lookup_slot(fh, key);
+	BLI_assert(!(fh->flag & FLATHASH_FLAG_IS_FLATSET));
+	return (slot != FLATHASH_SLOT_NONE) ? fh->vals[slot] : NULL;
+}
+
+/**
+ * A version of #BLI_flathash_lookup which accepts a fallback argument.
+ */
+void *BLI_flathash_lookup_default(FlatHash *fh, const void *key, void *val_default)
+{
+	const unsigned int slot = flathash_lookup_slot(fh, key);
+	BLI_assert(!(fh->flag & FLATHASH_FLAG_IS_FLATSET));
+	return (slot != FLATHASH_SLOT_NONE) ? fh->vals[slot] : val_default;
+}
+
+/**
+ * Lookup a pointer to the value of \a key in \a fh.
+ *
+ * \returns the pointer to value for \a key or NULL.
+ *
+ * \note The pointer is only valid until the next insertion.
+ */
+void **BLI_flathash_lookup_p(FlatHash *fh, const void *key)
+{
+	const unsigned int slot = flathash_lookup_slot(fh, key);
+	BLI_assert(!(fh->flag & FLATHASH_FLAG_IS_FLATSET));
+	return (slot != FLATHASH_SLOT_NONE) ? &fh->vals[slot] : NULL;
+}
+
+/**
+ * Ensure \a key is exists in \a fh, see #BLI_ghash_ensure_p.
+ *
+ * \returns true when the value didn't need to be added.
+ * (when false, the caller _must_ initialize the value).
+ */
+bool BLI_flathash_ensure_p(FlatHash *fh, void *key, void ***r_val)
+{
+	unsigned int slot;
+	const bool haskey = flathash_ensure_slot(fh, key, &slot);
+
+	BLI_assert(!(fh->flag & FLATHASH_FLAG_IS_FLATSET));
+	*r_val = &fh->vals[slot];
+	return haskey;
+}
+
+/**
+ * A version of #BLI_flathash_ensure_p which also returns a pointer to the key.
+ *
+ * \warning Caller _must_ write to \a r_key when returning false.
+ */
+bool BLI_flathash_ensure_p_ex(FlatHash *fh, const void *key, void ***r_key, void ***r_val)
+{
+	unsigned int slot;
+	const bool haskey = flathash_ensure_slot(fh, key, &slot);
+
+	BLI_assert(!(fh->flag & FLATHASH_FLAG_IS_FLATSET));
+	*r_key = &fh->keys[slot];
+	*r_val = &fh->vals[slot];
+	return haskey;
+}
+
+/**
+ * Remove \a key from \a fh, or return false if the key wasn't found.
+ */
+bool BLI_flathash_remove(FlatHash *fh, const void *key, GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp)
+{
+	const unsigned int slot = flathash_lookup_slot(fh, key);
+
+	if (slot == FLATHASH_SLOT_NONE) {
+		return false;
+	}
+
+	if (keyfreefp) keyfreefp(fh->keys[slot]);
+	if (valfreefp) valfreefp(fh->vals[slot]);
+	flathash_remove_slot(fh, slot);
+	return true;
+}
+
+/**
+ * Remove \a key from \a fh, returning the value or NULL if the key wasn't found.
+ */
+void *BLI_flathash_popkey(FlatHash *fh, const void *key, GHashKeyFreeFP keyfreefp)
+{
+	const unsigned int slot = flathash_lookup_slot(fh, key);
+	void *val;
+
+	BLI_assert(!(fh->flag & FLATHASH_FLAG_IS_FLATSET));
+
+	if (slot == FLATHASH_SLOT_NONE) {
+		return NULL;
+	}
+
+	val = fh->vals[slot];
+	if (keyfreefp) keyfreefp(fh->keys[slot]);
+	flathash_remove_slot(fh, slot);
+	return val;
+}
+
+/**
+ * \return true if the \a key is in \a fh.
+ */
+bool BLI_flathash_haskey(FlatHash *fh, const void *key)
+{
+	return (flathash_lookup_slot(fh, key) != FLATHASH_SLOT_NONE);
+}
+
+/**
+ * Remove a random entry from \a fh, returning true if a key/value pair could be removed, false otherwise.
+ *
+ * \param r_key: The removed key.
+ * \param r_val: The removed value.
+ * \param state: Used for efficient removal.
+ * \return true if there was something to pop, false if the hash was already empty.
+ */
+bool BLI_flathash_pop(FlatHash *fh, FlatHashIterState *state, void **r_key, void **r_val)
+{
+	unsigned int slot;
+
+	for (slot = state->curr_slot; slot < fh->nslots; slot++) {
+		if (flathash_ctrl_is_used(fh->ctrl[slot])) {
+			*r_key = fh->keys[slot];
+			*r_val = fh->vals ? fh->vals[slot] : NULL;
+			flathash_remove_slot(fh, slot);
+			state->curr_slot = slot + 1;
+			return true;
+		}
+	}
+
+	state->curr_slot = slot;
+	*r_key = NULL;
+	*r_val = NULL;
+	return false;
+}
+
+/**
+ * Reset \a fh clearing all entries.
+ *
+ * \param keyfreefp  Optional callback to free the key.
+ * \param valfreefp  Optional callback to free the value.
+ * \param nentries_reserve  Optionally reserve the number of members that the hash will hold.
+ */
+void BLI_flathash_clear_ex(FlatHash *fh, GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp,
+                           const unsigned int nentries_reserve)
+{
+	const unsigned int nslots = flathash_nslots_calc(nentries_reserve);
+
+	if (keyfreefp || valfreefp)
+		flathash_free_cb(fh, keyfreefp, valfreefp);
+
+	if (nslots == fh->nslots) {
+		memset(fh->ctrl, FLATHASH_CTRL_EMPTY, fh->nslots + FLATHASH_GROUP_SIZE);
+		fh->ndeleted = 0;
+	}
+	else {
+		MEM_freeN(fh->keys);
+		flathash_slots_alloc(fh, nslots);
+	}
+	fh->nentries = 0;
+}
+
+/**
+ * Wraps #BLI_flathash_clear_ex with zero entries reserved.
+ */
+void BLI_flathash_clear(FlatHash *fh, GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp)
+{
+	BLI_flathash_clear_ex(fh, keyfreefp, valfreefp, 0);
+}
+
+/**
+ * Frees the FlatHash and its members.
+ *
+ * \param fh  The FlatHash to free.
+ * \param keyfreefp  Optional callback to free the key.
+ * \param valfreefp  Optional callback to free the value.
+ */
+void BLI_flathash_free(FlatHash *fh, GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp)
+{
+	if (keyfreefp || valfreefp)
+		flathash_free_cb(fh, keyfreefp, valfreefp);
+
+	MEM_freeN(fh->keys);
+	MEM_freeN(fh);
+}
+
+/**
+ * Sets a FlatHash flag.
+ */
+void BLI_flathash_flag_set(FlatHash *fh, unsigned int flag)
+{
+	fh->flag |= flag;
+}
+
+/**
+ * Clear a FlatHash flag.
+ */
+void BLI_flathash_flag_clear(FlatHash *fh, unsigned int flag)
+{
+	fh->flag &= ~flag;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Iterator API
+ * \{ */
+
+BLI_INLINE unsigned int flathash_next_used_slot(const FlatHashIterator *fhi, unsigned int slot)
+{
+	while (slot < fhi->nslots && !flathash_ctrl_is_used(fhi->ctrl[slot])) {
+		slot++;
+	}
+	return slot;
+}
+
+/**
+ * Init an already allocated FlatHashIterator. The hash table must not be mutated during the iteration.
+ *
+ * \param fhi  The FlatHashIterator to initialize.
+ * \param fh  The FlatHash to iterate over.
+ */
+void BLI_flathashIterator_init(FlatHashIterator *fhi, FlatHash *fh)
+{
+	fhi->keys = fh->keys;
+	fhi->vals = fh->vals;
+	fhi->ctrl = fh->ctrl;
+	fhi->nslots = fh->nslots;
+	fhi->slot = flathash_next_used_slot(fhi, 0);
+}
+
+/**
+ * Steps the iterator to the next index.
+ *
+ * \param fhi  The iterator.
+ */
+void BLI_flathashIterator_step(FlatHashIterator *fhi)
+{
+	BLI_assert(fhi->slot < fhi->nslots);
+	fhi->slot = flathash_next_used_slot(fhi, fhi->slot + 1);
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Convenience FlatHash Creation Functions
+ * \{ */
+
+FlatHash *BLI_flathash_ptr_new_ex(const char *info, const unsigned int nentries_reserve)
+{
+	return BLI_flathash_new_ex(BLI_ghashutil_ptrhash, BLI_ghashutil_ptrcmp, info, nentries_reserve);
+}
+FlatHash *BLI_flathash_ptr_new(const char *info)
+{
+	return BLI_flathash_ptr_new_ex(info, 0);
+}
+
+FlatHash *BLI_flathash_str_new_ex(const char *info, const unsigned int nentries_reserve)
+{
+	return BLI_flathash_new_ex(BLI_ghashutil_strhash_p, BLI_ghashutil_strcmp, info, nentries_reserve);
+}
+FlatHash *BLI_flathash_str_new(const char *info)
+{
+	return BLI_flathash_str_new_ex(info, 0);
+}
+
+FlatHash *BLI_flathash_int_new_ex(const char *info, const unsigned int nentries_reserve)
+{
+	return BLI_flathash_new_ex(BLI_ghashutil_inthash_p, BLI_ghashutil_intcmp, info, nentries_reserve);
+}
+FlatHash *BLI_flathash_int_new(const char *info)
+{
+	return BLI_flathash_int_new_ex(info, 0);
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name FlatSet Public API
+ *
+ * Use ghash API to give 'set' functionality
+ * \{ */
+
+FlatSet *BLI_flatset_new_ex(GSetHashFP hashfp, GSetCmpFP cmpfp, const char *info,
+                            const unsigned int nentries_reserve)
+{
+	return (FlatSet *)flathash_new(hashfp, cmpfp, info, nentries_reserve, FLATHASH_FLAG_IS_FLATSET);
+}
+
+FlatSet *BLI_flatset_new(GSetHashFP hashfp, GSetCmpFP cmpfp, const char *info)
+{
+	return BLI_flatset_new_ex(hashfp, cmpfp, info, 0);
+}
+
+/**
+ * Copy given FlatSet. Keys are also copied if callback is provided, else pointers remain the same.
+ */
+FlatSet *BLI_flatset_copy(FlatSet *fs, GSetKeyCopyFP keycopyfp)
+{
+	return (FlatSet *)flathash_copy((FlatHash *)fs, keycopyfp, NULL);
+}
+
+unsigned int BLI_flatset_size(FlatSet *fs)
+{
+	return ((FlatHash *)fs)->nentries;
+}
+
+/**
+ * Adds the key to the set (no checks for unique keys!).
+ * Matching #BLI_flathash_insert
+ */
+void BLI_flatset_insert(FlatSet *fs, void *key)
+{
+	BLI_assert((((FlatHash *)fs)->flag & FLATHASH_FLAG_ALLOW_DUPES) || (BLI_flatset_haskey(fs, key) == 0));
+	flathash_insert((FlatHash *)fs, key, NULL);
+}
+
+/**
+ * A version of BLI_flatset_insert which checks first if the key is in the set.
+ * \returns true if a new key has been added.
+ */
+bool BLI_flatset_add(FlatSet *fs, void *key)
+{
+	unsigned int slot;
+	return !flathash_ensure_slot((FlatHash *)fs, key, &slot);
+}
+
+/**
+ * Set counterpart to #BLI_flathash_ensure_p_ex.
+ * similar to BLI_flatset_add, except it returns the key pointer.
+ *
+ * \warning Caller _must_ write to \a r_key when returning false.
+ */
+bool BLI_flatset_ensure_p_ex(FlatSet *fs, const void *key, void ***r_key)
+{
+	unsigned int slot;
+	const bool haskey = flathash_ensure_slot((FlatHash *)fs, key, &slot);
+
+	*r_key = &((FlatHash *)fs)->keys[slot];
+	return haskey;
+}
+
+/**
+ * Adds the key to the set (duplicates are managed).
+ * Matching #BLI_flathash_reinsert
+ *
+ * \returns true if a new key has been added.
+ */
+bool BLI_flatset_reinsert(FlatSet *fs, void *key, GSetKeyFreeFP keyfreefp)
+{
+	return flathash_insert_safe((FlatHash *)fs, key, NULL, keyfreefp, NULL);
+}
+
+bool BLI_flatset_remove(FlatSet *fs, const void *key, GSetKeyFreeFP keyfreefp)
+{
+	return BLI_flathash_remove((FlatHash *)fs, key, keyfreefp, NULL);
+}
+
+bool BLI_flatset_haskey(FlatSet *fs, const void *key)
+{
+	return (flathash_lookup_slot((FlatHash *)fs, key) != FLATHASH_SLOT_NONE);
+}
+
+/**
+ * Remove a random entry from \a fs, returning true if a key could be removed, false otherwise.
+ *
+ * \param r_key: The removed key.
+ * \param state: Used for efficient removal.
+ * \return true if there was something to pop, false if the set was already empty.
+ */
+bool BLI_flatset_pop(FlatSet *fs, FlatSetIterState *state, void **r_key)
+{
+	void *val;
+	return BLI_flathash_pop((FlatHash *)fs, state, r_key, &val);
+}
+
+void BLI_flatset_clear_ex(FlatSet *fs, GSetKeyFreeFP keyfreefp,
+                          const unsigned int nentries_reserve)
+{
+	BLI_flathash_clear_ex((FlatHash *)fs, keyfreefp, NULL, nentries_reserve);
+}
+
+void BLI_flatset_clear(FlatSet *fs, GSetKeyFreeFP keyfreefp)
+{
+	BLI_flathash_clear((FlatHash *)fs, keyfreefp, NULL);
+}
+
+void BLI_flatset_free(FlatSet *fs, GSetKeyFreeFP keyfreefp)
+{
+	BLI_flathash_free((FlatHash *)fs, keyfreefp, NULL);
+}
+
+void BLI_flatset_flag_set(FlatSet *fs, unsigned int flag)
+{
+	((FlatHash *)fs)->flag |= flag;
+}
+
+void BLI_flatset_flag_clear(FlatSet *fs, unsigned int flag)
+{
+	((FlatHash *)fs)->flag &= ~flag;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Convenience FlatSet Creation Functions
+ * \{ */
+
+FlatSet *BLI_flatset_ptr_new_ex(const char *info, const unsigned int nentries_reserve)
+{
+	return BLI_flatset_new_ex(BLI_ghashutil_ptrhash, BLI_ghashutil_ptrcmp, info, nentries_reserve);
+}
+FlatSet *BLI_flatset_ptr_new(const char *info)
+{
+	return BLI_flatset_ptr_new_ex(info, 0);
+}
+
+FlatSet *BLI_flatset_str_new_ex(const char *info, const unsigned int nentries_reserve)
+{
+	return BLI_flatset_new_ex(BLI_ghashutil_strhash_p, BLI_ghashutil_strcmp, info, nentries_reserve);
+}
+FlatSet *BLI_flatset_str_new(const char *info)
+{
+	return BLI_flatset_str_new_ex(info, 0);
+}
+
+/** \} */
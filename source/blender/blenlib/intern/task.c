@@ -24,12 +24,21 @@
  * A generic task system which can be used for any task based subsystem.
  */
 
+#ifdef __linux__
+/* for pthread_setaffinity_np() */
+#  ifndef _GNU_SOURCE
+#    define _GNU_SOURCE
+#  endif
+#  include <sched.h>
+#endif
+
 #include <stdlib.h>
 
 #include "MEM_guardedalloc.h"
 
 #include "DNA_listBase.h"
 
+#include "BLI_linklist.h"
 #include "BLI_listbase.h"
 #include "BLI_math.h"
 #include "BLI_task.h"
@@ -56,6 +65,13 @@ typedef struct Task {
 	bool free_taskdata;
 	TaskFreeFunction freedata;
 	TaskPool *pool;
+
+	/* Only used by tasks created with BLI_task_pool_create_task(). */
+	TaskPriority priority;
+	/* Number of dependencies which are not done yet, plus one as long as the task is not submitted. */
+	unsigned int num_pending;
+	/* Tasks depending on this one (Task pointers). */
+	LinkNode *successors;
 } Task;
 
 /* This is a per-thread storage of pre-allocated tasks.
@@ -107,6 +123,8 @@ struct TaskPool {
 
 	volatile size_t num;
 	volatile size_t done;
+	/* Incremented whenever a task of the pool is queued, protected by num_mutex. */
+	unsigned int num_queued;
 	size_t num_threads;
 	size_t currently_running_tasks;
 	ThreadMutex num_mutex;
@@ -139,16 +157,41 @@ struct TaskPool {
 #endif
 };
 
+/* Queue of a worker thread.
+ *
+ * The thread takes its own tasks from the head, other threads running out of work steal
+ * from the tail. Each queue has its own lock, so threads only contend when stealing from
+ * the same queue.
+ *
+ * High priority tasks all go to one extra queue which every thread checks first, pushed to
+ * and taken from its head, so the task pushed last is picked up first.
+ */
+typedef struct TaskQueue {
+	ListBase tasks;
+	/* Read without lock, to skip empty queues quickly. */
+	volatile int num_tasks;
+	SpinLock lock;
+} TaskQueue;
+
 struct TaskScheduler {
 	pthread_t *threads;
 	struct TaskThread *task_threads;
 	TaskMemPool *task_mempool;
 	int num_threads;
 	bool background_thread_only;
+	bool use_thread_affinity;
+
+	/* One queue per worker thread, thread id N uses queues[N - 1],
+	 * queues[num_threads] holds the high priority tasks. */
+	TaskQueue *queues;
+	/* Tasks pushed from other threads are distributed over all queues. */
+	unsigned int queue_next;
 
-	ListBase queue;
-	ThreadMutex queue_mutex;
-	ThreadCondition queue_cond;
+	/* Idle worker threads sleep until new tasks are pushed. */
+	ThreadMutex sleep_mutex;
+	ThreadCondition sleep_cond;
+	unsigned int push_epoch;
+	unsigned int num_sleeping;
 
 	volatile bool do_exit;
 };
@@ -251,66 +294,253 @@ static void task_pool_num_increase(TaskPool *pool)
 	BLI_mutex_lock(&pool->num_mutex);
 
 	pool->num++;
-	BLI_condition_notify_all(&pool->num_cond);
 
 	BLI_mutex_unlock(&pool->num_mutex);
 }
 
-static bool task_scheduler_thread_wait_pop(TaskScheduler *scheduler, Task **task)
+/* Whether a worker thread may run the task, reserves a running slot of the pool when it does. */
+static bool task_scheduler_task_can_run(TaskScheduler *scheduler, Task *task)
 {
-	bool found_task = false;
-	BLI_mutex_lock(&scheduler->queue_mutex);
-
-	while (!scheduler->queue.first && !scheduler->do_exit)
-		BLI_condition_wait(&scheduler->queue_cond, &scheduler->queue_mutex);
-
-	do {
-		Task *current_task;
-
-		/* Assuming we can only have a void queue in 'exit' case here seems logical (we should only be here after
-		 * our worker thread has been woken up from a condition_wait(), which only happens after a new task was
-		 * added to the queue), but it is wrong.
-		 * Waiting on condition may wake up the thread even if condition is not signaled (spurious wake-ups), and some
-		 * race condition may also empty the queue **after** condition has been signaled, but **before** awoken thread
-		 * reaches this point...
-		 * See http://stackoverflow.com/questions/8594591
-		 *
-		 * So we only abort here if do_exit is set.
-		 */
-		if (scheduler->do_exit) {
-			BLI_mutex_unlock(&scheduler->queue_mutex);
-			return false;
+	TaskPool *pool = task->pool;
+
+	if (scheduler->background_thread_only && !pool->run_in_background) {
+		return false;
+	}
+
+	if (atomic_add_and_fetch_z(&pool->currently_running_tasks, 1) <= pool->num_threads ||
+	    pool->num_threads == 0)
+	{
+		return true;
+	}
+
+	atomic_sub_and_fetch_z(&pool->currently_running_tasks, 1);
+	return false;
+}
+
+/**
+ * Take a task from \a queue.
+ *
+ * \param from_head: Take the most recently pushed task (own queue), otherwise the oldest one (stealing).
+ * \param pool: Only take tasks of this pool, used by #BLI_task_pool_work_and_wait.
+ */
+static Task *task_queue_pop(
+        TaskScheduler *scheduler, TaskQueue *queue, const bool from_head, TaskPool *pool)
+{
+	Task *task;
+
+	if (queue->num_tasks == 0) {
+		return NULL;
+	}
+
+	BLI_spin_lock(&queue->lock);
+
+	for (task = from_head ? queue->tasks.first : queue->tasks.last;
+	     task != NULL;
+	     task = from_head ? task->next : task->prev)
+	{
+		if (pool ? (task->pool == pool) : task_scheduler_task_can_run(scheduler, task)) {
+			BLI_remlink(&queue->tasks, task);
+			queue->num_tasks--;
+			break;
 		}
+	}
 
-		for (current_task = scheduler->queue.first;
-		     current_task != NULL;
-		     current_task = current_task->next)
-		{
-			TaskPool *pool = current_task->pool;
+	BLI_spin_unlock(&queue->lock);
 
-			if (scheduler->background_thread_only && !pool->run_in_background) {
-				continue;
-			}
+	return task;
+}
 
-			if (atomic_add_and_fetch_z(&pool->currently_running_tasks, 1) <= pool->num_threads ||
-			    pool->num_threads == 0)
-			{
-				*task = current_task;
-				found_task = true;
-				BLI_remlink(&scheduler->queue, *task);
-				break;
+static Task *task_scheduler_pop(TaskScheduler *scheduler, const int thread_id)
+{
+	const int num_queues = scheduler->num_threads;
+	Task *task;
+	int i;
+
+	/* high priority tasks first, then own tasks */
+	task = task_queue_pop(scheduler, &scheduler->queues[num_queues], true, NULL);
+	if (task == NULL) {
+		task = task_queue_pop(scheduler, &scheduler->queues[thread_id - 1], true, NULL);
+	}
+
+	/* steal from the other threads, starting with the next one so not all threads try the same queue */
+	for (i = 1; (task == NULL) && (i < num_queues); i++) {
+		task = task_queue_pop(scheduler, &scheduler->queues[(thread_id - 1 + i) % num_queues], false, NULL);
+	}
+
+	return task;
+}
+
+static Task *task_scheduler_pop_pool(TaskScheduler *scheduler, TaskPool *pool)
+{
+	Task *task = NULL;
+	int i;
+
+	/* find task from this pool. if we get a task from another pool,
+	 * we can get into deadlock */
+	task = task_queue_pop(scheduler, &scheduler->queues[scheduler->num_threads], true, pool);
+	for (i = 0; (task == NULL) && (i < scheduler->num_threads); i++) {
+		task = task_queue_pop(scheduler, &scheduler->queues[i], true, pool);
+	}
+
+	return task;
+}
+
+/**
+ * Puts the task in a queue, the pool must already count it.
+ *
+ * \param thread_id: Worker thread pushing the task, which keeps it in its own queue.
+ * Tasks from other threads (0 or -1) are distributed over the queues.
+ * High priority tasks always go to the shared high priority queue.
+ */
+static void task_scheduler_push(TaskScheduler *scheduler, Task *task, TaskPriority priority, const int thread_id)
+{
+	TaskPool *pool = task->pool;
+	TaskQueue *queue;
+
+	if (priority == TASK_PRIORITY_HIGH) {
+		queue = &scheduler->queues[scheduler->num_threads];
+	}
+	else if (thread_id > 0) {
+		queue = &scheduler->queues[thread_id - 1];
+	}
+	else {
+		const unsigned int queue_index = atomic_fetch_and_add_u(&scheduler->queue_next, 1);
+		queue = &scheduler->queues[queue_index % (unsigned int)scheduler->num_threads];
+	}
+
+	/* Hold the pool mutex until the waiters are notified, the task can't be done before that
+	 * (which would let the pool be freed). It's taken before the queue lock, never under it. */
+	BLI_mutex_lock(&pool->num_mutex);
+
+	/* add task to queue */
+	BLI_spin_lock(&queue->lock);
+
+	if (priority == TASK_PRIORITY_HIGH)
+		BLI_addhead(&queue->tasks, task);
+	else
+		BLI_addtail(&queue->tasks, task);
+	queue->num_tasks++;
+
+	BLI_spin_unlock(&queue->lock);
+
+	/* wake up threads waiting in BLI_task_pool_work_and_wait() */
+	pool->num_queued++;
+	BLI_condition_notify_all(&pool->num_cond);
+
+	BLI_mutex_unlock(&pool->num_mutex);
+
+	/* wake up a sleeping thread */
+	atomic_add_and_fetch_u(&scheduler->push_epoch, 1);
+	if (atomic_add_and_fetch_u(&scheduler->num_sleeping, 0) != 0) {
+		BLI_mutex_lock(&scheduler->sleep_mutex);
+		BLI_condition_notify_one(&scheduler->sleep_cond);
+		BLI_mutex_unlock(&scheduler->sleep_mutex);
+	}
+}
+
+/* Wait until a task is pushed after \a push_epoch was read (so no new task can be missed). */
+static void task_scheduler_sleep(TaskScheduler *scheduler, const unsigned int push_epoch)
+{
+	BLI_mutex_lock(&scheduler->sleep_mutex);
+
+	atomic_add_and_fetch_u(&scheduler->num_sleeping, 1);
+	while (atomic_add_and_fetch_u(&scheduler->push_epoch, 0) == push_epoch && !scheduler->do_exit) {
+		BLI_condition_wait(&scheduler->sleep_cond, &scheduler->sleep_mutex);
+	}
+	atomic_sub_and_fetch_u(&scheduler->num_sleeping, 1);
+
+	BLI_mutex_unlock(&scheduler->sleep_mutex);
+}
+
+static void task_discard(Task *task, const int thread_id);
+
+/**
+ * Dependencies of the successors of a task are done,
+ * schedule the ones which don't wait for other tasks anymore.
+ */
+static void task_successors_release(LinkNode *successors, const bool discard, const int thread_id)
+{
+	while (successors) {
+		LinkNode *successors_next = successors->next;
+		Task *task = successors->link;
+
+		MEM_freeN(successors);
+
+		if (atomic_sub_and_fetch_u(&task->num_pending, 1) == 0) {
+			if (discard) {
+				task_discard(task, thread_id);
 			}
 			else {
-				atomic_sub_and_fetch_z(&pool->currently_running_tasks, 1);
+				task_scheduler_push(task->pool->scheduler, task, task->priority, thread_id);
 			}
 		}
-		if (!found_task)
-			BLI_condition_wait(&scheduler->queue_cond, &scheduler->queue_mutex);
-	} while (!found_task);
 
-	BLI_mutex_unlock(&scheduler->queue_mutex);
+		successors = successors_next;
+	}
+}
+
+/* Free a task which didn't run (canceled pool), together with the tasks depending on it. */
+static void task_discard(Task *task, const int thread_id)
+{
+	TaskPool *pool = task->pool;
+	LinkNode *successors = task->successors;
+
+	task_data_free(task, thread_id);
+	MEM_freeN(task);
+
+	task_successors_release(successors, true, thread_id);
+
+	/* notify pool task was done */
+	task_pool_num_decrease(pool, 1);
+}
+
+static void task_run_and_free(TaskPool *pool, Task *task, const int thread_id)
+{
+	LinkNode *successors;
+
+	/* run task */
+	task->run(pool, task->taskdata, thread_id);
 
-	return true;
+	successors = task->successors;
+
+	/* delete task */
+	task_free(pool, task, thread_id);
+
+	/* schedule tasks waiting for this one, from this thread since they likely use its results */
+	task_successors_release(successors, pool->do_cancel, thread_id);
+
+	/* notify pool task was done */
+	task_pool_num_decrease(pool, 1);
+}
+
+static void task_scheduler_thread_affinity_set(TaskThread *thread)
+{
+#ifdef __linux__
+	/* pin worker N to the N-th CPU this process may use, leaving the first one to the main thread */
+	cpu_set_t cpuset_process, cpuset;
+	int cpu, cpu_index = 0;
+
+	if (sched_getaffinity(0, sizeof(cpuset_process), &cpuset_process) != 0) {
+		return;
+	}
+
+	const int num_cpus = CPU_COUNT(&cpuset_process);
+	const int cpu_target = thread->id % num_cpus;
+
+	for (cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+		if (CPU_ISSET(cpu, &cpuset_process)) {
+			if (cpu_index++ == cpu_target) {
+				CPU_ZERO(&cpuset);
+				CPU_SET(cpu, &cpuset);
+				pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset);
+				break;
+			}
+		}
+	}
+#else
+	/* not supported */
+	UNUSED_VARS(thread);
+#endif
 }
 
 static void *task_scheduler_thread_run(void *thread_p)
@@ -318,36 +548,42 @@ static void *task_scheduler_thread_run(void *thread_p)
 	TaskThread *thread = (TaskThread *) thread_p;
 	TaskScheduler *scheduler = thread->scheduler;
 	int thread_id = thread->id;
-	Task *task;
-
-	/* keep popping off tasks */
-	while (task_scheduler_thread_wait_pop(scheduler, &task)) {
-		TaskPool *pool = task->pool;
 
-		/* run task */
-		task->run(pool, task->taskdata, thread_id);
+	if (scheduler->use_thread_affinity) {
+		task_scheduler_thread_affinity_set(thread);
+	}
 
-		/* delete task */
-		task_free(pool, task, thread_id);
+	/* keep popping off tasks */
+	while (!scheduler->do_exit) {
+		const unsigned int push_epoch = atomic_add_and_fetch_u(&scheduler->push_epoch, 0);
+		Task *task = task_scheduler_pop(scheduler, thread_id);
 
-		/* notify pool task was done */
-		task_pool_num_decrease(pool, 1);
+		if (task) {
+			task_run_and_free(task->pool, task, thread_id);
+		}
+		else {
+			task_scheduler_sleep(scheduler, push_epoch);
+		}
 	}
 
 	return NULL;
 }
 
-TaskScheduler *BLI_task_scheduler_create(int num_threads)
+/**
+ * \param use_thread_affinity: Pin each worker thread to its own CPU (only supported on Linux currently),
+ * this avoids the OS moving threads around, at the cost of sharing CPUs badly with other processes.
+ */
+TaskScheduler *BLI_task_scheduler_create_ex(int num_threads, const bool use_thread_affinity)
 {
 	TaskScheduler *scheduler = MEM_callocN(sizeof(TaskScheduler), "TaskScheduler");
 
 	/* multiple places can use this task scheduler, sharing the same
 	 * threads, so we keep track of the number of users. */
 	scheduler->do_exit = false;
+	scheduler->use_thread_affinity = use_thread_affinity;
 
-	BLI_listbase_clear(&scheduler->queue);
-	BLI_mutex_init(&scheduler->queue_mutex);
-	BLI_condition_init(&scheduler->queue_cond);
+	BLI_mutex_init(&scheduler->sleep_mutex);
+	BLI_condition_init(&scheduler->sleep_cond);
 
 	if (num_threads == 0) {
 		/* automatic number of threads will be main thread + num cores */
@@ -371,6 +607,15 @@ TaskScheduler *BLI_task_scheduler_create(int num_threads)
 		scheduler->threads = MEM_callocN(sizeof(pthread_t) * num_threads, "TaskScheduler threads");
 		scheduler->task_threads = MEM_callocN(sizeof(TaskThread) * num_threads, "TaskScheduler task threads");
 
+		/* queues must exist before the threads start */
+		scheduler->queues = MEM_callocN(sizeof(*scheduler->queues) * (num_threads + 1), "TaskScheduler queues");
+		for (i = 0; i <= num_threads; i++) {
+			BLI_spin_init(&scheduler->queues[i].lock);
+		}
+
+		scheduler->task_mempool = MEM_callocN(sizeof(*scheduler->task_mempool) * (num_threads + 1),
+		                                      "TaskScheduler task_mempool");
+
 		for (i = 0; i < num_threads; i++) {
 			TaskThread *thread = &scheduler->task_threads[i];
 			thread->scheduler = scheduler;
@@ -380,23 +625,25 @@ TaskScheduler *BLI_task_scheduler_create(int num_threads)
 				fprintf(stderr, "TaskScheduler failed to launch thread %d/%d\n", i, num_threads);
 			}
 		}
-
-		scheduler->task_mempool = MEM_callocN(sizeof(*scheduler->task_mempool) * (num_threads + 1),
-		                                      "TaskScheduler task_mempool");
 	}
 
 	return scheduler;
 }
 
+TaskScheduler *BLI_task_scheduler_create(int num_threads)
+{
+	return BLI_task_scheduler_create_ex(num_threads, false);
+}
+
 void BLI_task_scheduler_free(TaskScheduler *scheduler)
 {
 	Task *task;
 
 	/* stop all waiting threads */
-	BLI_mutex_lock(&scheduler->queue_mutex);
+	BLI_mutex_lock(&scheduler->sleep_mutex);
 	scheduler->do_exit = true;
-	BLI_condition_notify_all(&scheduler->queue_cond);
-	BLI_mutex_unlock(&scheduler->queue_mutex);
+	BLI_condition_notify_all(&scheduler->sleep_cond);
+	BLI_mutex_unlock(&scheduler->sleep_mutex);
 
 	/* delete threads */
 	if (scheduler->threads) {
@@ -426,14 +673,23 @@ void BLI_task_scheduler_free(TaskScheduler *scheduler)
 	}
 
 	/* delete leftover tasks */
-	for (task = scheduler->queue.first; task; task = task->next) {
-		task_data_free(task, 0);
+	if (scheduler->queues) {
+		for (int i = 0; i <= scheduler->num_threads; i++) {
+			TaskQueue *queue = &scheduler->queues[i];
+
+			for (task = queue->tasks.first; task; task = task->next) {
+				task_data_free(task, 0);
+				BLI_linklist_free(task->successors, NULL);
+			}
+			BLI_freelistN(&queue->tasks);
+			BLI_spin_end(&queue->lock);
+		}
+		MEM_freeN(scheduler->queues);
 	}
-	BLI_freelistN(&scheduler->queue);
 
 	/* delete mutex/condition */
-	BLI_mutex_end(&scheduler->queue_mutex);
-	BLI_condition_end(&scheduler->queue_cond);
+	BLI_mutex_end(&scheduler->sleep_mutex);
+	BLI_condition_end(&scheduler->sleep_cond);
 
 	MEM_freeN(scheduler);
 }
@@ -443,45 +699,36 @@ int BLI_task_scheduler_num_threads(TaskScheduler *scheduler)
 	return scheduler->num_threads + 1;
 }
 
-static void task_scheduler_push(TaskScheduler *scheduler, Task *task, TaskPriority priority)
-{
-	task_pool_num_increase(task->pool);
-
-	/* add task to queue */
-	BLI_mutex_lock(&scheduler->queue_mutex);
-
-	if (priority == TASK_PRIORITY_HIGH)
-		BLI_addhead(&scheduler->queue, task);
-	else
-		BLI_addtail(&scheduler->queue, task);
-
-	BLI_condition_notify_one(&scheduler->queue_cond);
-	BLI_mutex_unlock(&scheduler->queue_mutex);
-}
-
 static void task_scheduler_clear(TaskScheduler *scheduler, TaskPool *pool)
 {
+	ListBase tasks = {NULL, NULL};
 	Task *task, *nexttask;
-	size_t done = 0;
+	int i;
 
-	BLI_mutex_lock(&scheduler->queue_mutex);
+	/* take all tasks from this pool from the queues */
+	for (i = 0; i <= scheduler->num_threads; i++) {
+		TaskQueue *queue = &scheduler->queues[i];
 
-	/* free all tasks from this pool from the queue */
-	for (task = scheduler->queue.first; task; task = nexttask) {
-		nexttask = task->next;
+		BLI_spin_lock(&queue->lock);
 
-		if (task->pool == pool) {
-			task_data_free(task, 0);
-			BLI_freelinkN(&scheduler->queue, task);
+		for (task = queue->tasks.first; task; task = nexttask) {
+			nexttask = task->next;
 
-			done++;
+			if (task->pool == pool) {
+				BLI_remlink(&queue->tasks, task);
+				BLI_addtail(&tasks, task);
+				queue->num_tasks--;
+			}
 		}
-	}
 
-	BLI_mutex_unlock(&scheduler->queue_mutex);
+		BLI_spin_unlock(&queue->lock);
+	}
 
-	/* notify done */
-	task_pool_num_decrease(pool, done);
+	/* free them, notify done */
+	for (task = tasks.first; task; task = nexttask) {
+		nexttask = task->next;
+		task_discard(task, 0);
+	}
 }
 
 /* Task Pool */
@@ -505,6 +752,7 @@ static TaskPool *task_pool_create_ex(TaskScheduler *scheduler, void *userdata, c
 	pool->scheduler = scheduler;
 	pool->num = 0;
 	pool->done = 0;
+	pool->num_queued = 0;
 	pool->num_threads = 0;
 	pool->currently_running_tasks = 0;
 	pool->do_cancel = false;
@@ -599,7 +847,7 @@ void BLI_task_pool_free(TaskPool *pool)
 	BLI_end_threaded_malloc();
 }
 
-static void task_pool_push(
+static Task *task_create(
         TaskPool *pool, TaskRunFunction run, void *taskdata,
         bool free_taskdata, TaskFreeFunction freedata, TaskPriority priority,
         int thread_id)
@@ -611,8 +859,23 @@ static void task_pool_push(
 	task->free_taskdata = free_taskdata;
 	task->freedata = freedata;
 	task->pool = pool;
+	task->priority = priority;
+	task->num_pending = 0;
+	task->successors = NULL;
+
+	return task;
+}
+
+static void task_pool_push(
+        TaskPool *pool, TaskRunFunction run, void *taskdata,
+        bool free_taskdata, TaskFreeFunction freedata, TaskPriority priority,
+        int thread_id)
+{
+	Task *task = task_create(pool, run, taskdata, free_taskdata, freedata, priority, thread_id);
+
+	task_pool_num_increase(pool);
 
-	task_scheduler_push(pool->scheduler, task, priority);
+	task_scheduler_push(pool->scheduler, task, priority, thread_id);
 }
 
 void BLI_task_pool_push_ex(
@@ -634,6 +897,52 @@ void BLI_task_pool_push_from_thread(TaskPool *pool, TaskRunFunction run,
 	task_pool_push(pool, run, taskdata, free_taskdata, NULL, priority, thread_id);
 }
 
+/**
+ * Create a task which is only scheduled once it is submitted with #BLI_task_submit
+ * and all tasks it depends on (see #BLI_task_add_dependency) are done.
+ *
+ * The task counts as part of the pool from now on,
+ * so it must be submitted before waiting for the pool.
+ */
+Task *BLI_task_pool_create_task(
+        TaskPool *pool, TaskRunFunction run, void *taskdata,
+        bool free_taskdata, TaskFreeFunction freedata, TaskPriority priority)
+{
+	Task *task = task_create(pool, run, taskdata, free_taskdata, freedata, priority, -1);
+
+	/* held until the task is submitted */
+	task->num_pending = 1;
+
+	task_pool_num_increase(pool);
+
+	return task;
+}
+
+/**
+ * Make \a task wait for \a dependency to be done.
+ *
+ * \note Must be called before \a dependency is submitted, both tasks must be of the same pool.
+ */
+void BLI_task_add_dependency(Task *task, Task *dependency)
+{
+	BLI_assert(task->pool == dependency->pool);
+	BLI_assert(dependency->num_pending != 0);
+
+	atomic_add_and_fetch_u(&task->num_pending, 1);
+	BLI_linklist_prepend(&dependency->successors, task);
+}
+
+/**
+ * Hand a task from #BLI_task_pool_create_task over to the scheduler,
+ * it runs as soon as all its dependencies are done. The task must not be accessed afterwards.
+ */
+void BLI_task_submit(Task *task)
+{
+	if (atomic_sub_and_fetch_u(&task->num_pending, 1) == 0) {
+		task_scheduler_push(task->pool->scheduler, task, task->priority, -1);
+	}
+}
+
 void BLI_task_pool_work_and_wait(TaskPool *pool)
 {
 	TaskScheduler *scheduler = pool->scheduler;
@@ -641,49 +950,29 @@ void BLI_task_pool_work_and_wait(TaskPool *pool)
 	BLI_mutex_lock(&pool->num_mutex);
 
 	while (pool->num != 0) {
-		Task *task, *work_task = NULL;
-		bool found_task = false;
+		const unsigned int num_queued = pool->num_queued;
+		Task *task = NULL;
 
 		BLI_mutex_unlock(&pool->num_mutex);
 
-		BLI_mutex_lock(&scheduler->queue_mutex);
-
-		/* find task from this pool. if we get a task from another pool,
-		 * we can get into deadlock */
-
 		if (pool->num_threads == 0 ||
 		    pool->currently_running_tasks < pool->num_threads)
 		{
-			for (task = scheduler->queue.first; task; task = task->next) {
-				if (task->pool == pool) {
-					work_task = task;
-					found_task = true;
-					BLI_remlink(&scheduler->queue, task);
-					break;
-				}
-			}
+			task = task_scheduler_pop_pool(scheduler, pool);
 		}
 
-		BLI_mutex_unlock(&scheduler->queue_mutex);
-
 		/* if found task, do it, otherwise wait until other tasks are done */
-		if (found_task) {
-			/* run task */
+		if (task) {
 			atomic_add_and_fetch_z(&pool->currently_running_tasks, 1);
-			work_task->run(pool, work_task->taskdata, 0);
-
-			/* delete task */
-			task_free(pool, task, 0);
-
-			/* notify pool task was done */
-			task_pool_num_decrease(pool, 1);
+			task_run_and_free(pool, task, 0);
 		}
 
 		BLI_mutex_lock(&pool->num_mutex);
 		if (pool->num == 0)
 			break;
 
-		if (!found_task)
+		/* only wait when no task was queued meanwhile */
+		if (!task && pool->num_queued == num_queued)
 			BLI_condition_wait(&pool->num_cond, &pool->num_mutex);
 	}
 
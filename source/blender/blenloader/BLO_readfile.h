@@ -41,6 +41,7 @@ struct bScreen;
 struct LinkNode;
 struct Main;
 struct MemFile;
+struct PreviewImage;
 struct ReportList;
 struct Scene;
 struct UserDef;
@@ -50,6 +51,7 @@ struct BHead;
 struct FileData;
 
 typedef struct BlendHandle BlendHandle;
+typedef struct BlendIndex BlendIndex;
 
 typedef enum BlenFileType {
 	BLENFILETYPE_BLEND = 1,
@@ -88,11 +90,21 @@ struct LinkNode *BLO_blendhandle_get_linkable_groups(BlendHandle *bh);
 
 void BLO_blendhandle_close(BlendHandle *bh);
 
+BlendIndex *BLO_blendindex_from_file(const char *filepath, struct ReportList *reports);
+
+struct LinkNode *BLO_blendindex_get_datablock_names(const BlendIndex *index, int ofblocktype, int *tot_names);
+struct LinkNode *BLO_blendindex_get_previews(const BlendIndex *index, int ofblocktype, int *tot_prev);
+const struct PreviewImage *BLO_blendindex_get_preview(const BlendIndex *index, int ofblocktype, const char *name);
+struct LinkNode *BLO_blendindex_get_linkable_groups(const BlendIndex *index);
+
+void BLO_blendindex_free(BlendIndex *index);
+
 /***/
 
 #define BLO_GROUP_MAX 32
 
 bool BLO_has_bfile_extension(const char *str);
+bool BLO_has_chunked_header(const char *filepath);
 bool BLO_library_path_explode(const char *path, char *r_dir, char **r_group, char **r_name);
 
 struct Main *BLO_library_link_begin(struct Main *mainvar, BlendHandle **bh, const char *filepath);
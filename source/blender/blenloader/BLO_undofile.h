@@ -38,6 +38,8 @@ typedef struct {
 	
 	char *buf;
 	unsigned int ident, size;
+	/* hash of the content, to find identical chunks of the previous step */
+	unsigned int hash;
 	
 } MemFileChunk;
 
@@ -52,6 +54,8 @@ extern void memfile_chunk_add(MemFile *compare, MemFile *current, const char *bu
 /* exports */
 extern void BLO_memfile_free(MemFile *memfile);
 extern void BLO_memfile_merge(MemFile *first, MemFile *second);
+extern void BLO_memfile_copy(const MemFile *memfile, MemFile *r_memfile);
+extern bool BLO_memfile_write_file(MemFile *memfile, const char *filename);
 
 #endif
 
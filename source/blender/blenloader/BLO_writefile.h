@@ -43,6 +43,8 @@ extern bool BLO_write_file(
         struct ReportList *reports, const struct BlendThumbnail *thumb);
 extern bool BLO_write_file_mem(
         struct Main *mainvar, struct MemFile *compare, struct MemFile *current, int write_flags);
+extern bool BLO_write_file_snapshot(
+        struct Main *mainvar, struct MemFile *r_memfile, int write_flags);
 
 #endif
 
@@ -0,0 +1,676 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2016 Blender Foundation.
+ * All rights reserved.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/blenloader/intern/blendindex.c
+ *  \ingroup blenloader
+ *
+ * Persistent index of the datablocks (names and previews) of a .blend file.
+ *
+ * Listing the content of a .blend file requires opening and scanning the whole file,
+ * which gets slow with big libraries, especially over network file-systems.
+ * The index is stored in the user cache directory, keyed on the file path,
+ * and reused as long as the modification time and size of the file are unchanged.
+ *
+ * Using an index refreshes the modification time of its cache file, the cache is pruned
+ * from indices not used for a while (or the least recently used ones when it gets too big)
+ * the first time an index is written in a session.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_utildefines.h"
+#include "BLI_fileops.h"
+#include "BLI_fileops_types.h"
+#include "BLI_hash_md5.h"
+#include "BLI_linklist.h"
+#include "BLI_path_util.h"
+#include "BLI_string.h"
+#include "BLI_threads.h"
+
+#ifdef WIN32
+#  include "BLI_winstuff.h"
+#endif
+
+#include "DNA_ID.h"
+#include "DNA_sdna_types.h"
+
+#include "BKE_appdir.h"
+#include "BKE_global.h"  /* for ENDIAN_ORDER */
+#include "BKE_icons.h"
+#include "BKE_idcode.h"
+#include "BKE_main.h"
+
+#include "BLO_readfile.h"
+#include "BLO_blend_defs.h"
+
+#include "readfile.h"
+
+#define BLENDINDEX_DIR "blendindex"
+#define BLENDINDEX_EXT ".bidx"
+#define BLENDINDEX_MAGIC "BLENIDX"
+#define BLENDINDEX_VERSION 1
+
+/* Sanity limit for preview sizes read from the cache. */
+#define BLENDINDEX_PREVIEW_MAX_SIZE 4096
+
+/* Indices not used for that long are removed from the cache (in seconds). */
+#define BLENDINDEX_PRUNE_AGE (30 * 24 * 60 * 60)
+/* Least recently used indices are removed above that total size of the cache (in bytes). */
+#define BLENDINDEX_PRUNE_SIZE ((int64_t)256 * 1024 * 1024)
+/* Temporary files of #blendindex_write older than that were left by a crash (in seconds). */
+#define BLENDINDEX_PRUNE_TMP_AGE (60 * 60)
+
+typedef struct BlendIndexEntry {
+	short idcode;
+	char name[MAX_ID_NAME - 2];
+	/* Only set for ID types which have previews, may be empty. */
+	PreviewImage *preview;
+} BlendIndexEntry;
+
+struct BlendIndex {
+	/* In file order. */
+	BlendIndexEntry *entries;
+	int tot_entries;
+};
+
+/* On-disk layout, native endianness (the cache is only read back on the same machine). */
+typedef struct BlendIndexFileHeader {
+	char magic[8];
+	int version;
+	int endian;
+	int64_t mtime;
+	uint64_t size;
+	int path_len;
+	int tot_entries;
+} BlendIndexFileHeader;
+
+typedef struct BlendIndexFileEntry {
+	short idcode;
+	char has_preview;
+	char pad;
+	char name[MAX_ID_NAME - 2];
+} BlendIndexFileEntry;
+
+typedef struct BlendIndexFilePreview {
+	unsigned int w, h;
+	short flag;
+	short has_rect;
+} BlendIndexFilePreview;
+
+/* -------------------------------------------------------------------- */
+/** \name Cache File
+ * \{ */
+
+static ThreadMutex blendindex_dir_mutex = BLI_MUTEX_INITIALIZER;
+static char blendindex_dir[FILE_MAX] = "";
+static bool blendindex_dir_init = false;
+static bool blendindex_dir_pruned = false;
+
+static bool blendindex_cache_dir(char r_dir[FILE_MAX])
+{
+	/* BKE_appdir uses a static buffer, only resolve it once. */
+	BLI_mutex_lock(&blendindex_dir_mutex);
+	if (!blendindex_dir_init) {
+		const char *path = BKE_appdir_folder_id_create(BLENDER_USER_CACHE, BLENDINDEX_DIR);
+		if (path) {
+			BLI_strncpy(blendindex_dir, path, sizeof(blendindex_dir));
+		}
+		blendindex_dir_init = true;
+	}
+	BLI_strncpy(r_dir, blendindex_dir, FILE_MAX);
+	BLI_mutex_unlock(&blendindex_dir_mutex);
+
+	return (r_dir[0] != '\0');
+}
+
+static bool blendindex_cache_filepath(const char *filepath, char r_cachepath[FILE_MAX])
+{
+	char dir[FILE_MAX], digest[16], digest_hex[33], filename[FILE_MAXFILE];
+
+	if (!blendindex_cache_dir(dir)) {
+		return false;
+	}
+
+	BLI_hash_md5_buffer(filepath, strlen(filepath), digest);
+	BLI_hash_md5_to_hexdigest(digest, digest_hex);
+	BLI_snprintf(filename, sizeof(filename), "%s" BLENDINDEX_EXT, digest_hex);
+	BLI_join_dirfile(r_cachepath, FILE_MAX, dir, filename);
+
+	return true;
+}
+
+static int blendindex_cache_file_cmp(const void *a, const void *b)
+{
+	const struct direntry *file_a = *(const struct direntry **)a;
+	const struct direntry *file_b = *(const struct direntry **)b;
+
+	if (file_a->s.st_mtime < file_b->s.st_mtime) return -1;
+	if (file_a->s.st_mtime > file_b->s.st_mtime) return 1;
+	return 0;
+}
+
+/* Temporary files are named "<hash>.bidx.<address>@", see #blendindex_write. */
+static bool blendindex_cache_file_is_tmp(const char *filename)
+{
+	return BLI_str_endswith(filename, "@") && (strstr(filename, BLENDINDEX_EXT ".") != NULL);
+}
+
+/**
+ * Remove the indices which were not used for #BLENDINDEX_PRUNE_AGE, and then the least
+ * recently used ones until the cache is below #BLENDINDEX_PRUNE_SIZE.
+ * Temporary files left behind by interrupted writes are removed as well.
+ */
+static void blendindex_cache_prune(const char *dir)
+{
+	struct direntry *files, **cache_files;
+	const time_t now = time(NULL);
+	const unsigned int tot_files = BLI_filelist_dir_contents(dir, &files);
+	unsigned int i, tot_cache_files = 0;
+	int64_t cache_size = 0;
+
+	cache_files = MEM_mallocN(sizeof(*cache_files) * MAX2(tot_files, 1), __func__);
+
+	for (i = 0; i < tot_files; i++) {
+		if (!S_ISREG(files[i].s.st_mode)) {
+			continue;
+		}
+		if (BLI_testextensie(files[i].relname, BLENDINDEX_EXT)) {
+			cache_files[tot_cache_files++] = &files[i];
+			cache_size += (int64_t)files[i].s.st_size;
+		}
+		else if (blendindex_cache_file_is_tmp(files[i].relname) &&
+		         (now - files[i].s.st_mtime > BLENDINDEX_PRUNE_TMP_AGE))
+		{
+			/* Recent ones may still be written by another instance. */
+			char path[FILE_MAX];
+
+			BLI_join_dirfile(path, sizeof(path), dir, files[i].relname);
+			BLI_delete(path, false, false);
+		}
+	}
+
+	qsort(cache_files, tot_cache_files, sizeof(*cache_files), blendindex_cache_file_cmp);
+
+	for (i = 0; i < tot_cache_files; i++) {
+		const struct direntry *file = cache_files[i];
+
+		if ((now - file->s.st_mtime > BLENDINDEX_PRUNE_AGE) || (cache_size > BLENDINDEX_PRUNE_SIZE)) {
+			char path[FILE_MAX];
+
+			/* Note: direntry.path lacks the separator when dir has no trailing one. */
+			BLI_join_dirfile(path, sizeof(path), dir, file->relname);
+			if (BLI_delete(path, false, false) == 0) {
+				cache_size -= (int64_t)file->s.st_size;
+			}
+		}
+		else {
+			/* Sorted by age, all remaining ones are kept. */
+			break;
+		}
+	}
+
+	MEM_freeN(cache_files);
+	BLI_filelist_free(files, tot_files);
+}
+
+/* Pruning scans the whole cache, only do it once per session. */
+static void blendindex_cache_prune_once(void)
+{
+	char dir[FILE_MAX];
+	bool do_prune;
+
+	BLI_mutex_lock(&blendindex_dir_mutex);
+	do_prune = !blendindex_dir_pruned;
+	blendindex_dir_pruned = true;
+	BLI_mutex_unlock(&blendindex_dir_mutex);
+
+	if (do_prune && blendindex_cache_dir(dir)) {
+		blendindex_cache_prune(dir);
+	}
+}
+
+static void blendindex_file_header_init(
+        BlendIndexFileHeader *header, const char *filepath, const BLI_stat_t *st, const int tot_entries)
+{
+	memset(header, 0, sizeof(*header));
+	BLI_strncpy(header->magic, BLENDINDEX_MAGIC, sizeof(header->magic));
+	header->version = BLENDINDEX_VERSION;
+	header->endian = ENDIAN_ORDER;
+	header->mtime = (int64_t)st->st_mtime;
+	header->size = (uint64_t)st->st_size;
+	header->path_len = (int)strlen(filepath) + 1;
+	header->tot_entries = tot_entries;
+}
+
+static bool blendindex_read_preview(FILE *file, PreviewImage *prv)
+{
+	int i;
+
+	for (i = 0; i < NUM_ICON_SIZES; i++) {
+		BlendIndexFilePreview fprv;
+
+		if (fread(&fprv, sizeof(fprv), 1, file) != 1) {
+			return false;
+		}
+
+		prv->w[i] = fprv.w;
+		prv->h[i] = fprv.h;
+		prv->flag[i] = fprv.flag;
+
+		if (fprv.has_rect) {
+			size_t len;
+
+			if (fprv.w == 0 || fprv.h == 0 ||
+			    fprv.w > BLENDINDEX_PREVIEW_MAX_SIZE || fprv.h > BLENDINDEX_PREVIEW_MAX_SIZE)
+			{
+				return false;
+			}
+
+			len = (size_t)fprv.w * (size_t)fprv.h * sizeof(unsigned int);
+			prv->rect[i] = MEM_mallocN(len, __func__);
+			if (fread(prv->rect[i], len, 1, file) != 1) {
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+static void blendindex_write_preview(FILE *file, const PreviewImage *prv)
+{
+	int i;
+
+	for (i = 0; i < NUM_ICON_SIZES; i++) {
+		BlendIndexFilePreview fprv = {0};
+
+		fprv.w = prv->w[i];
+		fprv.h = prv->h[i];
+		fprv.flag = prv->flag[i];
+		fprv.has_rect = (prv->rect[i] && prv->w[i] && prv->h[i]);
+
+		fwrite(&fprv, sizeof(fprv), 1, file);
+		if (fprv.has_rect) {
+			fwrite(prv->rect[i], sizeof(unsigned int), (size_t)fprv.w * (size_t)fprv.h, file);
+		}
+	}
+}
+
+/**
+ * \return The index when \a cachepath holds an up to date index of \a filepath, else NULL.
+ */
+static BlendIndex *blendindex_read(const char *cachepath, const char *filepath, const BLI_stat_t *st)
+{
+	BlendIndexFileHeader header, header_ref;
+	BlendIndex *index;
+	char path[FILE_MAX];
+	FILE *file;
+	bool ok = true;
+	int i;
+
+	file = BLI_fopen(cachepath, "rb");
+	if (file == NULL) {
+		return NULL;
+	}
+
+	blendindex_file_header_init(&header_ref, filepath, st, 0);
+
+	if ((fread(&header, sizeof(header), 1, file) != 1) ||
+	    !STREQLEN(header.magic, header_ref.magic, sizeof(header.magic)) ||
+	    (header.version != header_ref.version) ||
+	    (header.endian != header_ref.endian) ||
+	    (header.mtime != header_ref.mtime) ||
+	    (header.size != header_ref.size) ||
+	    (header.path_len != header_ref.path_len) ||
+	    ((size_t)header.path_len > sizeof(path)) ||
+	    (header.tot_entries < 0) ||
+	    ((uint64_t)header.tot_entries > header.size / sizeof(BHead)) ||
+	    (fread(path, (size_t)header.path_len, 1, file) != 1) ||
+	    !STREQLEN(path, filepath, (size_t)header.path_len))
+	{
+		fclose(file);
+		return NULL;
+	}
+
+	index = MEM_callocN(sizeof(*index), __func__);
+	index->entries = MEM_callocN(sizeof(*index->entries) * (size_t)MAX2(header.tot_entries, 1), __func__);
+
+	for (i = 0; i < header.tot_entries && ok; i++) {
+		BlendIndexEntry *entry = &index->entries[i];
+		BlendIndexFileEntry fentry;
+
+		if (fread(&fentry, sizeof(fentry), 1, file) != 1) {
+			ok = false;
+			break;
+		}
+
+		entry->idcode = fentry.idcode;
+		BLI_strncpy(entry->name, fentry.name, sizeof(entry->name));
+		index->tot_entries++;
+
+		if (fentry.has_preview) {
+			entry->preview = MEM_callocN(sizeof(PreviewImage), "newpreview");
+			ok = blendindex_read_preview(file, entry->preview);
+		}
+	}
+
+	fclose(file);
+
+	if (!ok) {
+		BLO_blendindex_free(index);
+		return NULL;
+	}
+
+	/* Keeps the index from being pruned. */
+	BLI_file_touch(cachepath);
+
+	return index;
+}
+
+static void blendindex_write(const char *cachepath, const char *filepath, const BLI_stat_t *st, const BlendIndex *index)
+{
+	BlendIndexFileHeader header;
+	char tmppath[FILE_MAX];
+	FILE *file;
+	bool ok;
+	int i;
+
+	/* Write to a temporary file first, the cache may be read from other threads or instances. */
+	BLI_snprintf(tmppath, sizeof(tmppath), "%s.%p@", cachepath, (const void *)index);
+
+	file = BLI_fopen(tmppath, "wb");
+	if (file == NULL) {
+		return;
+	}
+
+	blendindex_file_header_init(&header, filepath, st, index->tot_entries);
+	fwrite(&header, sizeof(header), 1, file);
+	fwrite(filepath, (size_t)header.path_len, 1, file);
+
+	for (i = 0; i < index->tot_entries; i++) {
+		const BlendIndexEntry *entry = &index->entries[i];
+		BlendIndexFileEntry fentry = {0};
+
+		fentry.idcode = entry->idcode;
+		fentry.has_preview = (entry->preview != NULL);
+		BLI_strncpy(fentry.name, entry->name, sizeof(fentry.name));
+
+		fwrite(&fentry, sizeof(fentry), 1, file);
+		if (entry->preview) {
+			blendindex_write_preview(file, entry->preview);
+		}
+	}
+
+	ok = (ferror(file) == 0);
+	ok &= (fclose(file) == 0);
+
+	if (!ok || BLI_rename(tmppath, cachepath) != 0) {
+		BLI_delete(tmppath, false, false);
+	}
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Index Creation
+ * \{ */
+
+static int blendindex_count_idcode(const BlendIndex *index, const int idcode)
+{
+	int i, tot = 0;
+
+	for (i = 0; i < index->tot_entries; i++) {
+		if (index->entries[i].idcode == idcode) {
+			tot++;
+		}
+	}
+
+	return tot;
+}
+
+static BlendIndex *blendindex_from_handle(BlendHandle *bh)
+{
+	FileData *fd = (FileData *)bh;
+	BlendIndex *index = MEM_callocN(sizeof(*index), __func__);
+	BHead *bhead;
+	int tot = 0, idcode_iter = 0;
+	short idcode;
+
+	for (bhead = blo_firstbhead(fd); bhead; bhead = blo_nextbhead(fd, bhead)) {
+		if (bhead->code == ENDB) {
+			break;
+		}
+		else if (BKE_idcode_is_valid(bhead->code)) {
+			tot++;
+		}
+	}
+
+	index->entries = MEM_callocN(sizeof(*index->entries) * (size_t)MAX2(tot, 1), __func__);
+
+	for (bhead = blo_firstbhead(fd); bhead && index->tot_entries < tot; bhead = blo_nextbhead(fd, bhead)) {
+		if (BKE_idcode_is_valid(bhead->code)) {
+			BlendIndexEntry *entry = &index->entries[index->tot_entries++];
+
+			entry->idcode = (short)bhead->code;
+			BLI_strncpy(entry->name, bhead_id_name(fd, bhead) + 2, sizeof(entry->name));
+		}
+	}
+
+	/* Previews are gathered per type, the list is in reverse order of the IDs. */
+	while ((idcode = BKE_idcode_iter_step(&idcode_iter))) {
+		const int tot_idcode = blendindex_count_idcode(index, idcode);
+		LinkNode *previews, *ln;
+		int tot_prev, i;
+
+		if (tot_idcode == 0) {
+			continue;
+		}
+
+		previews = BLO_blendhandle_get_previews(bh, idcode, &tot_prev);
+
+		if (previews && (tot_prev == tot_idcode)) {
+			for (i = index->tot_entries - 1, ln = previews; i >= 0; i--) {
+				if (index->entries[i].idcode == idcode) {
+					index->entries[i].preview = ln->link;
+					ln->link = NULL;
+					ln = ln->next;
+				}
+			}
+		}
+
+		BLI_linklist_free(previews, BKE_previewimg_freefunc);
+	}
+
+	return index;
+}
+
+/**
+ * Get the index of the datablocks of a file, from the cache when up to date,
+ * otherwise by scanning the file (the cache is then updated).
+ *
+ * \param filepath The file path to index.
+ * \param reports Report errors in opening the file (can be NULL).
+ * \return The index on success, or NULL on failure.
+ */
+BlendIndex *BLO_blendindex_from_file(const char *filepath, ReportList *reports)
+{
+	BlendIndex *index = NULL;
+	BlendHandle *bh;
+	BLI_stat_t st;
+	char cachepath[FILE_MAX];
+	bool use_cache;
+
+	use_cache = (BLI_stat(filepath, &st) == 0) && blendindex_cache_filepath(filepath, cachepath);
+
+	if (use_cache) {
+		index = blendindex_read(cachepath, filepath, &st);
+		if (index) {
+			return index;
+		}
+	}
+
+	bh = BLO_blendhandle_from_file(filepath, reports);
+	if (bh == NULL) {
+		return NULL;
+	}
+
+	index = blendindex_from_handle(bh);
+	BLO_blendhandle_close(bh);
+
+	if (use_cache) {
+		blendindex_write(cachepath, filepath, &st, index);
+		blendindex_cache_prune_once();
+	}
+
+	return index;
+}
+
+void BLO_blendindex_free(BlendIndex *index)
+{
+	int i;
+
+	for (i = 0; i < index->tot_entries; i++) {
+		BKE_previewimg_freefunc(index->entries[i].preview);
+	}
+
+	MEM_freeN(index->entries);
+	MEM_freeN(index);
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Index Access
+ *
+ * Same results as the matching BLO_blendhandle_ functions.
+ * \{ */
+
+/**
+ * Gets the names of all the datablocks of a certain type in the indexed file.
+ *
+ * \param index The index to access.
+ * \param ofblocktype The type of names to get.
+ * \param tot_names The length of the returned list.
+ * \return A BLI_linklist of strings. The string links should be freed with malloc.
+ */
+LinkNode *BLO_blendindex_get_datablock_names(const BlendIndex *index, int ofblocktype, int *tot_names)
+{
+	LinkNode *names = NULL;
+	int i, tot = 0;
+
+	for (i = 0; i < index->tot_entries; i++) {
+		if (index->entries[i].idcode == ofblocktype) {
+			BLI_linklist_prepend(&names, strdup(index->entries[i].name));
+			tot++;
+		}
+	}
+
+	*tot_names = tot;
+	return names;
+}
+
+/**
+ * Gets the previews of all the datablocks of a certain type in the indexed file.
+ *
+ * \param index The index to access.
+ * \param ofblocktype The type of names to get.
+ * \param tot_prev The length of the returned list.
+ * \return A BLI_linklist of PreviewImage. The PreviewImage links should be freed with #BKE_previewimg_freefunc.
+ */
+LinkNode *BLO_blendindex_get_previews(const BlendIndex *index, int ofblocktype, int *tot_prev)
+{
+	LinkNode *previews = NULL;
+	int i, tot = 0;
+
+	for (i = 0; i < index->tot_entries; i++) {
+		const BlendIndexEntry *entry = &index->entries[i];
+
+		if (entry->idcode == ofblocktype && entry->preview) {
+			BLI_linklist_prepend(&previews, BKE_previewimg_copy(entry->preview));
+			tot++;
+		}
+	}
+
+	*tot_prev = tot;
+	return previews;
+}
+
+/**
+ * Gets the preview of a single datablock of the indexed file.
+ *
+ * \param index The index to access.
+ * \param ofblocktype The type of the datablock.
+ * \param name The name of the datablock (without the ID code).
+ * \return The preview owned by the index, or NULL if the datablock has none.
+ */
+const PreviewImage *BLO_blendindex_get_preview(const BlendIndex *index, int ofblocktype, const char *name)
+{
+	int i;
+
+	for (i = 0; i < index->tot_entries; i++) {
+		const BlendIndexEntry *entry = &index->entries[i];
+
+		if (entry->idcode == ofblocktype && STREQ(entry->name, name)) {
+			return entry->preview;
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * Gets the names of all the linkable datablock types available in the indexed file.
+ *
+ * \param index The index to access.
+ * \return A BLI_linklist of strings. The string links should be freed with malloc.
+ */
+LinkNode *BLO_blendindex_get_linkable_groups(const BlendIndex *index)
+{
+	LinkNode *names = NULL;
+	bool gathered[INDEX_ID_NULL] = {false};
+	int i;
+
+	for (i = 0; i < index->tot_entries; i++) {
+		const short idcode = index->entries[i].idcode;
+
+		if (BKE_idcode_is_linkable(idcode)) {
+			const int idcode_index = BKE_idcode_to_index(idcode);
+
+			if (!gathered[idcode_index]) {
+				gathered[idcode_index] = true;
+				BLI_linklist_prepend(&names, strdup(BKE_idcode_to_name(idcode)));
+			}
+		}
+	}
+
+	return names;
+}
+
+/** \} */
@@ -0,0 +1,678 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2016 Blender Foundation.
+ * All rights reserved.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/blenloader/intern/chunkfile.c
+ *  \ingroup blenloader
+ *
+ * Chunked compressed container for .blend files.
+ *
+ * File data is split into chunks of a fixed uncompressed size which are compressed
+ * independently of each other, so they can be (de)compressed in parallel and any
+ * offset of the file can be read without decompressing the data in front of it.
+ *
+ * Layout (all values are little endian):
+ * - #ChunkFileHeader: magic, version and uncompressed size of chunks.
+ * - Compressed chunks, stored one after another.
+ * - Table of #ChunkFileEntry, one per chunk.
+ * - #ChunkFileFooter: location of the table and magic.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <fcntl.h>
+
+#ifdef WIN32
+#  include <io.h>
+#  include "BLI_winstuff.h"
+#else
+#  include <unistd.h>
+#endif
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_utildefines.h"
+#include "BLI_endian_switch.h"
+#include "BLI_fileops.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
+
+#include "BKE_global.h"  /* ENDIAN_ORDER */
+
+#ifdef WITH_LZO
+#  ifdef WITH_SYSTEM_LZO
+#    include <lzo/lzo1x.h>
+#  else
+#    include "minilzo.h"
+#  endif
+#endif
+
+#ifdef WITH_LZMA
+#  include "LzmaLib.h"
+#endif
+
+#include "chunkfile.h"
+
+#ifdef WIN32
+#  define chunkfile_lseek _lseeki64
+#else
+#  define chunkfile_lseek lseek
+#endif
+
+#define CHUNKFILE_MAGIC "BLENCHNK"
+#define CHUNKFILE_MAGIC_LEN 8
+#define CHUNKFILE_VERSION 1
+
+/* Uncompressed size of every chunk but the last one. */
+#define CHUNKFILE_CHUNK_SIZE (1 << 20)
+
+typedef struct ChunkFileHeader {
+	char magic[CHUNKFILE_MAGIC_LEN];
+	int version;
+	int chunk_size;
+} ChunkFileHeader;
+
+typedef struct ChunkFileEntry {
+	uint64_t offset;  /* in the file */
+	unsigned int size_compressed;
+	unsigned int size;
+	int codec;  /* eChunkFileCodec */
+	int pad;
+} ChunkFileEntry;
+
+typedef struct ChunkFileFooter {
+	uint64_t table_offset;
+	int tot_chunk;
+	int pad;
+	char magic[CHUNKFILE_MAGIC_LEN];
+} ChunkFileFooter;
+
+/* Number of chunks handled at once, each of them on its own thread. */
+static int chunkfile_batch_size(void)
+{
+	return MAX2(2, BLI_system_thread_count() * 2);
+}
+
+static size_t chunkfile_compressed_size_max(const size_t size)
+{
+	/* LZMA does not provide a bound, make sure incompressible data fits, it's stored as-is anyway. */
+	return size + size / 8 + 128 + 16;
+}
+
+static bool chunkfile_codec_supported(eChunkFileCodec codec)
+{
+	switch (codec) {
+		case CHUNKFILE_CODEC_NONE:
+			return true;
+#ifdef WITH_LZO
+		case CHUNKFILE_CODEC_LZO:
+			return true;
+#endif
+#ifdef WITH_LZMA
+		case CHUNKFILE_CODEC_LZMA:
+			return true;
+#endif
+		default:
+			return false;
+	}
+}
+
+static void chunkfile_header_switch_endian(ChunkFileHeader *header)
+{
+	if (ENDIAN_ORDER == B_ENDIAN) {
+		BLI_endian_switch_int32(&header->version);
+		BLI_endian_switch_int32(&header->chunk_size);
+	}
+}
+
+static void chunkfile_entry_switch_endian(ChunkFileEntry *entry)
+{
+	if (ENDIAN_ORDER == B_ENDIAN) {
+		BLI_endian_switch_uint64(&entry->offset);
+		BLI_endian_switch_uint32(&entry->size_compressed);
+		BLI_endian_switch_uint32(&entry->size);
+		BLI_endian_switch_int32(&entry->codec);
+	}
+}
+
+static void chunkfile_footer_switch_endian(ChunkFileFooter *footer)
+{
+	if (ENDIAN_ORDER == B_ENDIAN) {
+		BLI_endian_switch_uint64(&footer->table_offset);
+		BLI_endian_switch_int32(&footer->tot_chunk);
+	}
+}
+
+/* -------------------------------------------------------------------- */
+/** \name Writing
+ * \{ */
+
+typedef struct ChunkFileBuffer {
+	char *data;
+	char *data_compressed;
+	size_t size;
+	size_t size_compressed;
+	eChunkFileCodec codec;
+} ChunkFileBuffer;
+
+struct ChunkFileWriter {
+	int file;
+	eChunkFileCodec codec;
+	bool error;
+
+	/* Chunks filled in order, compressed in parallel once all of them are full. */
+	ChunkFileBuffer *chunks;
+	int tot_chunk_batch;
+	int tot_chunk_filled;
+
+	uint64_t offset;
+	ChunkFileEntry *table;
+	int tot_table, table_size;
+};
+
+static void chunkfile_compress_func(void *userdata, const int index)
+{
+	ChunkFileWriter *writer = userdata;
+	ChunkFileBuffer *chunk = &writer->chunks[index];
+	const size_t size_max = chunkfile_compressed_size_max(CHUNKFILE_CHUNK_SIZE);
+
+	chunk->codec = CHUNKFILE_CODEC_NONE;
+	chunk->size_compressed = 0;
+
+	switch (writer->codec) {
+#ifdef WITH_LZO
+		case CHUNKFILE_CODEC_LZO:
+		{
+			void *wrkmem = MEM_mallocN(LZO1X_MEM_COMPRESS, "chunkfile lzo wrkmem");
+			lzo_uint out_len = (lzo_uint)size_max;
+			if (lzo1x_1_compress((unsigned char *)chunk->data, (lzo_uint)chunk->size,
+			                     (unsigned char *)chunk->data_compressed, &out_len, wrkmem) == LZO_E_OK)
+			{
+				chunk->codec = CHUNKFILE_CODEC_LZO;
+				chunk->size_compressed = (size_t)out_len;
+			}
+			MEM_freeN(wrkmem);
+			break;
+		}
+#endif
+#ifdef WITH_LZMA
+		case CHUNKFILE_CODEC_LZMA:
+		{
+			/* Properties are stored in front of the compressed data. */
+			unsigned char *props = (unsigned char *)chunk->data_compressed;
+			size_t props_len = LZMA_PROPS_SIZE;
+			size_t out_len = size_max - LZMA_PROPS_SIZE;
+			if (LzmaCompress(props + LZMA_PROPS_SIZE, &out_len, (unsigned char *)chunk->data, chunk->size,
+			                 props, &props_len, 5, 1 << 24, 3, 0, 2, 32, 1) == SZ_OK &&
+			    props_len == LZMA_PROPS_SIZE)
+			{
+				chunk->codec = CHUNKFILE_CODEC_LZMA;
+				chunk->size_compressed = out_len + LZMA_PROPS_SIZE;
+			}
+			break;
+		}
+#endif
+		default:
+			break;
+	}
+
+	/* Store incompressible data as-is. */
+	if (chunk->codec != CHUNKFILE_CODEC_NONE && chunk->size_compressed >= chunk->size) {
+		chunk->codec = CHUNKFILE_CODEC_NONE;
+	}
+	if (chunk->codec == CHUNKFILE_CODEC_NONE) {
+		chunk->size_compressed = chunk->size;
+	}
+}
+
+static bool chunkfile_write_data(ChunkFileWriter *writer, const void *data, size_t size)
+{
+	if (write(writer->file, data, size) != (ssize_t)size) {
+		writer->error = true;
+		return false;
+	}
+	writer->offset += size;
+	return true;
+}
+
+/* Compress all filled chunks and write them in order. */
+static void chunkfile_writer_flush(ChunkFileWriter *writer)
+{
+	int i;
+
+	if (writer->tot_chunk_filled == 0 || writer->error) {
+		return;
+	}
+
+	BLI_task_parallel_range(0, writer->tot_chunk_filled, writer, chunkfile_compress_func,
+	                        writer->tot_chunk_filled > 1);
+
+	for (i = 0; i < writer->tot_chunk_filled; i++) {
+		ChunkFileBuffer *chunk = &writer->chunks[i];
+		ChunkFileEntry *entry;
+
+		if (UNLIKELY(writer->tot_table == writer->table_size)) {
+			writer->table_size *= 2;
+			writer->table = MEM_reallocN(writer->table, sizeof(*writer->table) * writer->table_size);
+		}
+		entry = &writer->table[writer->tot_table++];
+		entry->offset = writer->offset;
+		entry->size_compressed = (unsigned int)chunk->size_compressed;
+		entry->size = (unsigned int)chunk->size;
+		entry->codec = chunk->codec;
+		entry->pad = 0;
+
+		if (!chunkfile_write_data(writer,
+		                          (chunk->codec == CHUNKFILE_CODEC_NONE) ? chunk->data : chunk->data_compressed,
+		                          chunk->size_compressed))
+		{
+			break;
+		}
+		chunk->size = 0;
+	}
+
+	writer->tot_chunk_filled = 0;
+}
+
+ChunkFileWriter *blo_chunkfile_writer_open(const char *filepath, eChunkFileCodec codec)
+{
+	ChunkFileWriter *writer;
+	ChunkFileHeader header;
+	int file, i;
+
+	file = BLI_open(filepath, O_BINARY + O_WRONLY + O_CREAT + O_TRUNC, 0666);
+	if (file == -1) {
+		return NULL;
+	}
+
+	/* Fall back to whatever compression this build supports. */
+	if (!chunkfile_codec_supported(codec)) {
+		codec = chunkfile_codec_supported(CHUNKFILE_CODEC_LZO) ? CHUNKFILE_CODEC_LZO :
+		        chunkfile_codec_supported(CHUNKFILE_CODEC_LZMA) ? CHUNKFILE_CODEC_LZMA :
+		        CHUNKFILE_CODEC_NONE;
+	}
+
+	writer = MEM_callocN(sizeof(*writer), "ChunkFileWriter");
+	writer->file = file;
+	writer->codec = codec;
+
+	writer->tot_chunk_batch = chunkfile_batch_size();
+	writer->chunks = MEM_callocN(sizeof(*writer->chunks) * writer->tot_chunk_batch, "ChunkFileWriter.chunks");
+	for (i = 0; i < writer->tot_chunk_batch; i++) {
+		writer->chunks[i].data = MEM_mallocN(CHUNKFILE_CHUNK_SIZE, "ChunkFileBuffer.data");
+		writer->chunks[i].data_compressed = MEM_mallocN(chunkfile_compressed_size_max(CHUNKFILE_CHUNK_SIZE),
+		                                                "ChunkFileBuffer.data_compressed");
+	}
+
+	writer->table_size = 1024;
+	writer->table = MEM_mallocN(sizeof(*writer->table) * writer->table_size, "ChunkFileWriter.table");
+
+	memcpy(header.magic, CHUNKFILE_MAGIC, CHUNKFILE_MAGIC_LEN);
+	header.version = CHUNKFILE_VERSION;
+	header.chunk_size = CHUNKFILE_CHUNK_SIZE;
+	chunkfile_header_switch_endian(&header);
+	chunkfile_write_data(writer, &header, sizeof(header));
+
+	return writer;
+}
+
+bool blo_chunkfile_writer_write(ChunkFileWriter *writer, const char *data, size_t data_len)
+{
+	while (data_len != 0 && !writer->error) {
+		ChunkFileBuffer *chunk = &writer->chunks[writer->tot_chunk_filled];
+		const size_t len = MIN2(data_len, CHUNKFILE_CHUNK_SIZE - chunk->size);
+
+		memcpy(chunk->data + chunk->size, data, len);
+		chunk->size += len;
+		data += len;
+		data_len -= len;
+
+		if (chunk->size == CHUNKFILE_CHUNK_SIZE) {
+			writer->tot_chunk_filled++;
+			if (writer->tot_chunk_filled == writer->tot_chunk_batch) {
+				chunkfile_writer_flush(writer);
+			}
+		}
+	}
+
+	return !writer->error;
+}
+
+bool blo_chunkfile_writer_close(ChunkFileWriter *writer)
+{
+	ChunkFileFooter footer;
+	bool ok;
+	int i;
+
+	/* Last chunk is only partially filled. */
+	if (writer->tot_chunk_filled < writer->tot_chunk_batch &&
+	    writer->chunks[writer->tot_chunk_filled].size != 0)
+	{
+		writer->tot_chunk_filled++;
+	}
+	chunkfile_writer_flush(writer);
+
+	footer.table_offset = writer->offset;
+	footer.tot_chunk = writer->tot_table;
+	footer.pad = 0;
+	memcpy(footer.magic, CHUNKFILE_MAGIC, CHUNKFILE_MAGIC_LEN);
+
+	for (i = 0; i < writer->tot_table; i++) {
+		chunkfile_entry_switch_endian(&writer->table[i]);
+	}
+	chunkfile_footer_switch_endian(&footer);
+
+	if (!writer->error) {
+		chunkfile_write_data(writer, writer->table, sizeof(*writer->table) * writer->tot_table);
+	}
+	if (!writer->error) {
+		chunkfile_write_data(writer, &footer, sizeof(footer));
+	}
+
+	ok = (close(writer->file) != -1) && !writer->error;
+
+	for (i = 0; i < writer->tot_chunk_batch; i++) {
+		MEM_freeN(writer->chunks[i].data);
+		MEM_freeN(writer->chunks[i].data_compressed);
+	}
+	MEM_freeN(writer->chunks);
+	MEM_freeN(writer->table);
+	MEM_freeN(writer);
+
+	return ok;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Reading
+ * \{ */
+
+struct ChunkFileReader {
+	int file;
+	int chunk_size;
+
+	ChunkFileEntry *table;
+	int tot_chunk;
+	size_t size;
+
+	/* Current position for sequential reads. */
+	size_t offset;
+
+	/* Chunks decompressed together, starting at window_first. */
+	char **window;
+	int window_first, window_len, window_size;
+	char *data_compressed;
+	size_t data_compressed_size;
+	bool error;
+};
+
+static bool chunkfile_read_data(int file, uint64_t offset, void *data, size_t size)
+{
+	if (chunkfile_lseek(file, offset, SEEK_SET) == -1) {
+		return false;
+	}
+	return (read(file, data, size) == (ssize_t)size);
+}
+
+bool blo_chunkfile_is_chunked(const char *filepath)
+{
+	char magic[CHUNKFILE_MAGIC_LEN];
+	bool is_chunked = false;
+	int file = BLI_open(filepath, O_BINARY | O_RDONLY, 0);
+
+	if (file != -1) {
+		is_chunked = (read(file, magic, sizeof(magic)) == sizeof(magic)) &&
+		             (memcmp(magic, CHUNKFILE_MAGIC, CHUNKFILE_MAGIC_LEN) == 0);
+		close(file);
+	}
+
+	return is_chunked;
+}
+
+static bool chunkfile_reader_read_table(ChunkFileReader *reader)
+{
+	ChunkFileHeader header;
+	ChunkFileFooter footer;
+	int64_t file_size;
+	uint64_t offset = sizeof(header);
+	int i;
+
+	if (!chunkfile_read_data(reader->file, 0, &header, sizeof(header))) {
+		return false;
+	}
+	chunkfile_header_switch_endian(&header);
+	if (memcmp(header.magic, CHUNKFILE_MAGIC, CHUNKFILE_MAGIC_LEN) != 0 ||
+	    header.version != CHUNKFILE_VERSION ||
+	    header.chunk_size <= 0)
+	{
+		return false;
+	}
+	reader->chunk_size = header.chunk_size;
+
+	file_size = (int64_t)chunkfile_lseek(reader->file, 0, SEEK_END);
+	if (file_size < (int64_t)(sizeof(header) + sizeof(footer)) ||
+	    !chunkfile_read_data(reader->file, (uint64_t)file_size - sizeof(footer), &footer, sizeof(footer)))
+	{
+		return false;
+	}
+	chunkfile_footer_switch_endian(&footer);
+	if (memcmp(footer.magic, CHUNKFILE_MAGIC, CHUNKFILE_MAGIC_LEN) != 0 ||
+	    footer.tot_chunk < 0 ||
+	    footer.table_offset + sizeof(ChunkFileEntry) * (uint64_t)footer.tot_chunk + sizeof(footer) !=
+	    (uint64_t)file_size)
+	{
+		return false;
+	}
+
+	reader->tot_chunk = footer.tot_chunk;
+	reader->table = MEM_mallocN(sizeof(*reader->table) * MAX2(reader->tot_chunk, 1), "ChunkFileReader.table");
+	if (!chunkfile_read_data(reader->file, footer.table_offset,
+	                         reader->table, sizeof(*reader->table) * reader->tot_chunk))
+	{
+		return false;
+	}
+
+	/* Chunks are stored one after another, all but the last one are full. */
+	for (i = 0; i < reader->tot_chunk; i++) {
+		ChunkFileEntry *entry = &reader->table[i];
+		chunkfile_entry_switch_endian(entry);
+		if (entry->offset != offset ||
+		    !chunkfile_codec_supported(entry->codec) ||
+		    entry->size > (unsigned int)reader->chunk_size ||
+		    (i != reader->tot_chunk - 1 && entry->size != (unsigned int)reader->chunk_size) ||
+		    (entry->codec == CHUNKFILE_CODEC_NONE && entry->size_compressed != entry->size))
+		{
+			return false;
+		}
+		offset += entry->size_compressed;
+		reader->size += entry->size;
+	}
+
+	return (offset == footer.table_offset);
+}
+
+ChunkFileReader *blo_chunkfile_reader_open(const char *filepath)
+{
+	ChunkFileReader *reader;
+	int file = BLI_open(filepath, O_BINARY | O_RDONLY, 0);
+
+	if (file == -1) {
+		return NULL;
+	}
+
+	reader = MEM_callocN(sizeof(*reader), "ChunkFileReader");
+	reader->file = file;
+
+	if (!chunkfile_reader_read_table(reader)) {
+		blo_chunkfile_reader_close(reader);
+		return NULL;
+	}
+
+	reader->window_size = chunkfile_batch_size();
+	reader->window = MEM_callocN(sizeof(*reader->window) * reader->window_size, "ChunkFileReader.window");
+
+	return reader;
+}
+
+size_t blo_chunkfile_reader_size(const ChunkFileReader *reader)
+{
+	return reader->size;
+}
+
+static void chunkfile_decompress_func(void *userdata, const int index)
+{
+	ChunkFileReader *reader = userdata;
+	const ChunkFileEntry *entry = &reader->table[reader->window_first + index];
+	const char *in = reader->data_compressed + (entry->offset - reader->table[reader->window_first].offset);
+	char *out = reader->window[index];
+	bool ok = false;
+
+	switch (entry->codec) {
+		case CHUNKFILE_CODEC_NONE:
+			memcpy(out, in, entry->size);
+			ok = true;
+			break;
+#ifdef WITH_LZO
+		case CHUNKFILE_CODEC_LZO:
+		{
+			lzo_uint out_len = entry->size;
+			ok = (lzo1x_decompress_safe((const unsigned char *)in, entry->size_compressed,
+			                            (unsigned char *)out, &out_len, NULL) == LZO_E_OK) &&
+			     (out_len == entry->size);
+			break;
+		}
+#endif
+#ifdef WITH_LZMA
+		case CHUNKFILE_CODEC_LZMA:
+		{
+			size_t out_len = entry->size;
+			size_t in_len = entry->size_compressed - LZMA_PROPS_SIZE;
+			ok = (entry->size_compressed > LZMA_PROPS_SIZE) &&
+			     (LzmaUncompress((unsigned char *)out, &out_len,
+			                     (const unsigned char *)in + LZMA_PROPS_SIZE, &in_len,
+			                     (const unsigned char *)in, LZMA_PROPS_SIZE) == SZ_OK) &&
+			     (out_len == entry->size);
+			break;
+		}
+#endif
+		default:
+			break;
+	}
+
+	if (!ok) {
+		reader->error = true;
+	}
+}
+
+/* Decompress chunks starting at the given one, in parallel. */
+static bool chunkfile_reader_window_load(ChunkFileReader *reader, int first)
+{
+	const ChunkFileEntry *entry_first = &reader->table[first], *entry_last;
+	size_t size_compressed;
+	int i;
+
+	reader->window_first = first;
+	reader->window_len = MIN2(reader->window_size, reader->tot_chunk - first);
+	entry_last = &reader->table[first + reader->window_len - 1];
+
+	size_compressed = (size_t)(entry_last->offset + entry_last->size_compressed - entry_first->offset);
+	if (size_compressed > reader->data_compressed_size) {
+		MEM_SAFE_FREE(reader->data_compressed);
+		reader->data_compressed = MEM_mallocN(size_compressed, "ChunkFileReader.data_compressed");
+		reader->data_compressed_size = size_compressed;
+	}
+	for (i = 0; i < reader->window_len; i++) {
+		if (reader->window[i] == NULL) {
+			reader->window[i] = MEM_mallocN(reader->chunk_size, "ChunkFileReader.window");
+		}
+	}
+
+	if (!chunkfile_read_data(reader->file, entry_first->offset, reader->data_compressed, size_compressed)) {
+		reader->error = true;
+	}
+	else {
+		BLI_task_parallel_range(0, reader->window_len, reader, chunkfile_decompress_func,
+		                        reader->window_len > 1);
+	}
+
+	if (reader->error) {
+		reader->window_len = 0;
+		return false;
+	}
+	return true;
+}
+
+/**
+ * Read from the current position, decompressing chunks as needed.
+ * \return the number of bytes read, less than requested at the end of the file or on error.
+ */
+size_t blo_chunkfile_reader_read(ChunkFileReader *reader, void *buffer, size_t size)
+{
+	size_t done = 0;
+
+	while (done < size && reader->offset < reader->size && !reader->error) {
+		const int index = (int)(reader->offset / (size_t)reader->chunk_size);
+		const size_t chunk_offset = reader->offset - (size_t)index * (size_t)reader->chunk_size;
+		size_t len;
+
+		if (index < reader->window_first || index >= reader->window_first + reader->window_len) {
+			if (!chunkfile_reader_window_load(reader, index)) {
+				break;
+			}
+		}
+
+		len = MIN2(size - done, reader->table[index].size - chunk_offset);
+		memcpy((char *)buffer + done, reader->window[index - reader->window_first] + chunk_offset, len);
+		done += len;
+		reader->offset += len;
+	}
+
+	return done;
+}
+
+/* Move the position of sequential reads, only chunks at that position get decompressed. */
+void blo_chunkfile_reader_seek(ChunkFileReader *reader, size_t offset)
+{
+	reader->offset = MIN2(offset, reader->size);
+}
+
+void blo_chunkfile_reader_close(ChunkFileReader *reader)
+{
+	int i;
+
+	if (reader->window) {
+		for (i = 0; i < reader->window_size; i++) {
+			MEM_SAFE_FREE(reader->window[i]);
+		}
+		MEM_freeN(reader->window);
+	}
+	MEM_SAFE_FREE(reader->data_compressed);
+	MEM_SAFE_FREE(reader->table);
+	close(reader->file);
+	MEM_freeN(reader);
+}
+
+/** \} */
@@ -0,0 +1,57 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2016 Blender Foundation.
+ * All rights reserved.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/blenloader/intern/chunkfile.h
+ *  \ingroup blenloader
+ *  \brief Chunked compressed container for .blend files.
+ */
+
+#ifndef __CHUNKFILE_H__
+#define __CHUNKFILE_H__
+
+/* Compression of a single chunk. */
+typedef enum eChunkFileCodec {
+	CHUNKFILE_CODEC_NONE = 0,
+	CHUNKFILE_CODEC_LZO  = 1,
+	CHUNKFILE_CODEC_LZMA = 2,
+} eChunkFileCodec;
+
+typedef struct ChunkFileWriter ChunkFileWriter;
+typedef struct ChunkFileReader ChunkFileReader;
+
+/* writing */
+ChunkFileWriter *blo_chunkfile_writer_open(const char *filepath, eChunkFileCodec codec);
+bool blo_chunkfile_writer_write(ChunkFileWriter *writer, const char *data, size_t data_len);
+bool blo_chunkfile_writer_close(ChunkFileWriter *writer);
+
+/* reading */
+bool blo_chunkfile_is_chunked(const char *filepath);
+ChunkFileReader *blo_chunkfile_reader_open(const char *filepath);
+size_t blo_chunkfile_reader_size(const ChunkFileReader *reader);
+size_t blo_chunkfile_reader_read(ChunkFileReader *reader, void *buffer, size_t size);
+void blo_chunkfile_reader_seek(ChunkFileReader *reader, size_t offset);
+void blo_chunkfile_reader_close(ChunkFileReader *reader);
+
+#endif  /* __CHUNKFILE_H__ */
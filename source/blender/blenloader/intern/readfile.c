@@ -45,10 +45,12 @@
 #include "BLI_utildefines.h"
 #ifndef WIN32
 #  include <unistd.h> // for read close
+#  include <sys/mman.h> // for mmap
 #else
 #  include <io.h> // for open close read
 #  include "winsock2.h"
 #  include "BLI_winstuff.h"
+#  include "mmap_win.h"
 #endif
 
 /* allow readfile to use deprecated functionality */
@@ -108,6 +110,7 @@
 #include "BLI_blenlib.h"
 #include "BLI_math.h"
 #include "BLI_threads.h"
+#include "BLI_task.h"
 #include "BLI_mempool.h"
 
 #include "BLT_translation.h"
@@ -157,6 +160,7 @@
 
 #include "RE_engine.h"
 
+#include "chunkfile.h"
 #include "readfile.h"
 
 
@@ -218,6 +222,14 @@
 /* Use GHash for restoring pointers by name */
 #define USE_GHASH_RESTORE_POINTER
 
+/* Direct link big self-contained datablocks (meshes, shape keys) in a task pool,
+ * while the main thread continues reading the rest of the file */
+#define USE_PARALLEL_DIRECT_LINK
+
+/* Map uncompressed library files into memory and only keep an index of their DATA blocks,
+ * so linking from big libraries only loads the blocks which are actually used */
+#define USE_BHEAD_MMAP
+
 /***/
 
 typedef struct OldNew {
@@ -231,8 +243,17 @@ typedef struct OldNewMap {
 	int nentries, entriessize;
 	bool sorted;
 	int lasthit;
+	/* Open addressing hash of entry indices, built on first full search, see oldnewmap_index_ensure().
+	 * The allocation is kept when the map is cleared, only the first index_mask + 1 slots are used. */
+	int *index;
+	unsigned int index_mask;
+	unsigned int index_alloc;
+	bool use_index;
 } OldNewMap;
 
+/* Only build the index for maps bigger than this, smaller ones are fine with a linear search. */
+#define OLDNEWMAP_INDEX_MIN_ENTRIES 64
+
 
 /* local prototypes */
 static void *read_struct(FileData *fd, BHead *bh, const char *blockname);
@@ -293,11 +314,84 @@ static int verg_oldnewmap(const void *v1, const void *v2)
 }
 
 
+BLI_INLINE unsigned int oldnewmap_hash(const void *addr)
+{
+	/* Low bits are mostly zero because of alignment, mix higher ones in. */
+	uintptr_t key = (uintptr_t)addr;
+	key ^= (key >> 4) ^ (key >> 17) ^ (key >> 31);
+	return (unsigned int)key * 2654435761u;
+}
+
+/* Add entry to the index, replacing older entry with the same address,
+ * so the index points to the last inserted one as a backwards full search would. */
+static void oldnewmap_index_insert(OldNewMap *onm, int i)
+{
+	const void *addr = onm->entries[i].old;
+	unsigned int slot = oldnewmap_hash(addr) & onm->index_mask;
+
+	while (onm->index[slot] != -1) {
+		if (onm->entries[onm->index[slot]].old == addr) {
+			break;
+		}
+		slot = (slot + 1) & onm->index_mask;
+	}
+	onm->index[slot] = i;
+}
+
+static void oldnewmap_index_free(OldNewMap *onm)
+{
+	MEM_SAFE_FREE(onm->index);
+	onm->index_mask = 0;
+	onm->index_alloc = 0;
+	onm->use_index = false;
+}
+
+/* (Re)build the index, it is sized for the used entries so it is at most a quarter full,
+ * inserting rebuilds it once it gets half full. */
+static void oldnewmap_index_ensure(OldNewMap *onm)
+{
+	unsigned int index_size = 1;
+	int i;
+
+	while (index_size < (unsigned int)onm->nentries * 4) {
+		index_size <<= 1;
+	}
+
+	if (index_size > onm->index_alloc) {
+		MEM_SAFE_FREE(onm->index);
+		onm->index = MEM_mallocN(sizeof(*onm->index) * index_size, "OldNewMap.index");
+		onm->index_alloc = index_size;
+	}
+	onm->index_mask = index_size - 1;
+	onm->use_index = true;
+	memset(onm->index, -1, sizeof(*onm->index) * index_size);
+
+	for (i = 0; i < onm->nentries; i++) {
+		oldnewmap_index_insert(onm, i);
+	}
+}
+
+static int oldnewmap_index_lookup(const OldNewMap *onm, const void *addr)
+{
+	unsigned int slot = oldnewmap_hash(addr) & onm->index_mask;
+	int i;
+
+	while ((i = onm->index[slot]) != -1) {
+		if (onm->entries[i].old == addr) {
+			return i;
+		}
+		slot = (slot + 1) & onm->index_mask;
+	}
+	return -1;
+}
+
 static void oldnewmap_sort(FileData *fd) 
 {
 	BLI_assert(fd->libmap->sorted == false);
 	qsort(fd->libmap->entries, fd->libmap->nentries, sizeof(OldNew), verg_oldnewmap);
 	fd->libmap->sorted = 1;
+	/* Sorted maps use binary search. */
+	oldnewmap_index_free(fd->libmap);
 }
 
 /* nr is zero for data, and ID code for libdata */
@@ -316,6 +410,15 @@ static void oldnewmap_insert(OldNewMap *onm, const void *oldaddr, void *newaddr,
 	entry->old = oldaddr;
 	entry->newp = newaddr;
 	entry->nr = nr;
+
+	if (onm->use_index) {
+		if (UNLIKELY((unsigned int)onm->nentries * 2 > onm->index_mask + 1)) {
+			oldnewmap_index_ensure(onm);
+		}
+		else {
+			oldnewmap_index_insert(onm, onm->nentries - 1);
+		}
+	}
 }
 
 void blo_do_versions_oldnewmap_insert(OldNewMap *onm, const void *oldaddr, void *newaddr, int nr)
@@ -329,18 +432,24 @@ void blo_do_versions_oldnewmap_insert(OldNewMap *onm, const void *oldaddr, void
  * \param lasthit: Use as a reference position to avoid a full search
  * from either end of the array, giving more efficient lookups.
  *
- * \note This would seem an ideal case for hash or btree lookups.
- * However the data is written in-order, using the \a lasthit will normally avoid calling this function.
- * Creating a btree/hash structure adds overhead for the common-case to optimize the corner-case
- * (since most entries will never be retrieved).
- * So just keep full lookups as a fall-back.
+ * \note The data is written in-order, using the \a lasthit will normally avoid calling this function.
+ * Out of order lookups are common for library data and versioned files though, so bigger maps
+ * build a hash index on their first full lookup. This keeps the common-case free of overhead,
+ * since most maps never get here.
  */
-static int oldnewmap_lookup_entry_full(const OldNewMap *onm, const void *addr, int lasthit)
+static int oldnewmap_lookup_entry_full(OldNewMap *onm, const void *addr, int lasthit)
 {
 	const int nentries = onm->nentries;
 	const OldNew *entries = onm->entries;
 	int i;
 
+	if (!onm->use_index && nentries > OLDNEWMAP_INDEX_MIN_ENTRIES) {
+		oldnewmap_index_ensure(onm);
+	}
+	if (onm->use_index) {
+		return oldnewmap_index_lookup(onm, addr);
+	}
+
 	/* search relative to lasthit where possible */
 	if (lasthit >= 0 && lasthit < nentries) {
 
@@ -454,10 +563,13 @@ static void oldnewmap_clear(OldNewMap *onm)
 {
 	onm->nentries = 0;
 	onm->lasthit = 0;
+	/* keep the index allocation, the map is cleared for every ID */
+	onm->use_index = false;
 }
 
 static void oldnewmap_free(OldNewMap *onm) 
 {
+	oldnewmap_index_free(onm);
 	MEM_freeN(onm->entries);
 	MEM_freeN(onm);
 }
@@ -780,10 +892,30 @@ static BHeadN *get_bhead(FileData *fd)
 			/* bhead now contains the (converted) bhead structure. Now read
 			 * the associated data and put everything in a BHeadN (creative naming !)
 			 */
+#ifdef USE_BHEAD_MMAP
+			/* Only index DATA blocks of mapped files, their data is used straight from the mapping
+			 * and the pages are only loaded when a block is actually read.
+			 * Endian switching is done in place, so those files are read as usual. */
+			if (!fd->eof && fd->mmap_data && bhead.code == DATA && !(fd->flags & FD_FLAGS_SWITCH_ENDIAN)) {
+				if ((size_t)bhead.len <= fd->mmap_size - fd->mmap_seek) {
+					new_bhead = MEM_mallocN(sizeof(BHeadN), "new_bhead");
+					new_bhead->next = new_bhead->prev = NULL;
+					new_bhead->data = fd->mmap_data + fd->mmap_seek;
+					new_bhead->bhead = bhead;
+
+					fd->mmap_seek += (size_t)bhead.len;
+				}
+				else {
+					fd->eof = 1;
+				}
+			}
+			else
+#endif
 			if (!fd->eof) {
 				new_bhead = MEM_mallocN(sizeof(BHeadN) + bhead.len, "new_bhead");
 				if (new_bhead) {
 					new_bhead->next = new_bhead->prev = NULL;
+					new_bhead->data = new_bhead + 1;
 					new_bhead->bhead = bhead;
 					
 					readsize = fd->read(fd, new_bhead + 1, bhead.len);
@@ -865,10 +997,17 @@ BHead *blo_nextbhead(FileData *fd, BHead *thisblock)
 	return(bhead);
 }
 
+/* Data of the block, use instead of (bhead + 1) since blocks of mapped files are not stored inline. */
+const void *bhead_data(const BHead *bhead)
+{
+	const BHeadN *bheadn = (const BHeadN *)POINTER_OFFSET(bhead, -offsetof(BHeadN, bhead));
+	return bheadn->data;
+}
+
 /* Warning! Caller's responsability to ensure given bhead **is** and ID one! */
 const char *bhead_id_name(const FileData *fd, const BHead *bhead)
 {
-	return (const char *)POINTER_OFFSET(bhead, sizeof(*bhead) + fd->id_name_offs);
+	return (const char *)POINTER_OFFSET(bhead_data(bhead), fd->id_name_offs);
 }
 
 static void decode_blender_header(FileData *fd)
@@ -925,6 +1064,7 @@ static bool read_file_dna(FileData *fd, const char **r_error_message)
 			fd->filesdna = DNA_sdna_from_data(&bhead[1], bhead->len, do_endian_swap, true, r_error_message);
 			if (fd->filesdna) {
 				fd->compflags = DNA_struct_get_compareflags(fd->filesdna, fd->memsdna);
+				fd->reconstruct_info = DNA_reconstruct_info_create(fd->filesdna, fd->memsdna, fd->compflags);
 				/* used to retrieve ID names from (bhead+1) */
 				fd->id_name_offs = DNA_elem_offset(fd->filesdna, "ID", "char", "name[]");
 
@@ -1006,6 +1146,15 @@ static int fd_read_gzip_from_file(FileData *filedata, void *buffer, unsigned int
 	return (readsize);
 }
 
+static int fd_read_from_chunkfile(FileData *filedata, void *buffer, unsigned int size)
+{
+	int readsize = (int)blo_chunkfile_reader_read(filedata->chunkfile, buffer, size);
+	
+	filedata->seek += readsize;
+	
+	return readsize;
+}
+
 static int fd_read_from_memory(FileData *filedata, void *buffer, unsigned int size)
 {
 	/* don't read more bytes then there are available in the buffer */
@@ -1017,6 +1166,19 @@ static int fd_read_from_memory(FileData *filedata, void *buffer, unsigned int si
 	return (readsize);
 }
 
+#ifdef USE_BHEAD_MMAP
+static int fd_read_from_mmap(FileData *filedata, void *buffer, unsigned int size)
+{
+	/* don't read more bytes then there are available in the mapping */
+	const size_t readsize = MIN2((size_t)size, filedata->mmap_size - filedata->mmap_seek);
+
+	memcpy(buffer, filedata->mmap_data + filedata->mmap_seek, readsize);
+	filedata->mmap_seek += readsize;
+
+	return (int)readsize;
+}
+#endif
+
 static int fd_read_from_memfile(FileData *filedata, void *buffer, unsigned int size)
 {
 	static unsigned int seek = (1<<30);	/* the current position */
@@ -1115,11 +1277,95 @@ static FileData *blo_decode_and_check(FileData *fd, ReportList *reports)
 	return fd;
 }
 
+#ifdef USE_BHEAD_MMAP
+/**
+ * Map an uncompressed .blend file into memory,
+ * returns NULL for compressed files or when mapping fails, they are to be read as usual then.
+ */
+static FileData *blo_openblenderfile_mmap(const char *filepath)
+{
+	FileData *fd = NULL;
+	char header[7];
+	size_t size;
+	void *mem;
+	int file;
+
+	file = BLI_open(filepath, O_BINARY | O_RDONLY, 0);
+	if (file == -1) {
+		return NULL;
+	}
+
+	size = BLI_file_descriptor_size(file);
+	if ((size != (size_t)-1) && (size > SIZEOFBLENDERHEADER) &&
+	    (read(file, header, sizeof(header)) == sizeof(header)) &&
+	    STREQLEN(header, "BLENDER", sizeof(header)))
+	{
+		mem = mmap(NULL, size, PROT_READ, MAP_SHARED, file, 0);
+		if (mem != MAP_FAILED) {
+			fd = filedata_new();
+			fd->mmap_data = mem;
+			fd->mmap_size = size;
+			fd->read = fd_read_from_mmap;
+		}
+	}
+
+	/* the mapping stays valid */
+	close(file);
+
+	return fd;
+}
+#endif
+
 /* cannot be called with relative paths anymore! */
 /* on each new library added, it now checks for the current FileData and expands relativeness */
 FileData *blo_openblenderfile(const char *filepath, ReportList *reports)
+{
+	return blo_openblenderfile_ex(filepath, false, reports);
+}
+
+/**
+ * \param use_mmap: Map uncompressed files instead of reading them in memory,
+ * only the blocks which are actually used are then loaded from disk. Meant for libraries,
+ * the file has to stay unchanged until the returned #FileData is freed.
+ */
+FileData *blo_openblenderfile_ex(const char *filepath, const bool use_mmap, ReportList *reports)
 {
 	gzFile gzfile;
+
+#ifdef USE_BHEAD_MMAP
+	if (use_mmap) {
+		FileData *fd = blo_openblenderfile_mmap(filepath);
+		if (fd) {
+			/* needed for library_append and read_libraries */
+			BLI_strncpy(fd->relabase, filepath, sizeof(fd->relabase));
+
+			return blo_decode_and_check(fd, reports);
+		}
+	}
+#else
+	UNUSED_VARS(use_mmap);
+#endif
+
+	if (blo_chunkfile_is_chunked(filepath)) {
+		ChunkFileReader *chunkfile = blo_chunkfile_reader_open(filepath);
+		FileData *fd;
+
+		if (chunkfile == NULL) {
+			BKE_reportf(reports, RPT_WARNING, "Unable to open '%s': %s",
+			            filepath, TIP_("invalid or unsupported compressed file"));
+			return NULL;
+		}
+
+		fd = filedata_new();
+		fd->chunkfile = chunkfile;
+		fd->read = fd_read_from_chunkfile;
+
+		/* needed for library_append and read_libraries */
+		BLI_strncpy(fd->relabase, filepath, sizeof(fd->relabase));
+
+		return blo_decode_and_check(fd, reports);
+	}
+
 	errno = 0;
 	gzfile = BLI_gzopen(filepath, "rb");
 	
@@ -1146,15 +1392,30 @@ FileData *blo_openblenderfile(const char *filepath, ReportList *reports)
  */
 static FileData *blo_openblenderfile_minimal(const char *filepath)
 {
-	gzFile gzfile;
-	errno = 0;
-	gzfile = BLI_gzopen(filepath, "rb");
+	FileData *fd = NULL;
 
-	if (gzfile != (gzFile)Z_NULL) {
-		FileData *fd = filedata_new();
-		fd->gzfiledes = gzfile;
-		fd->read = fd_read_gzip_from_file;
+	if (blo_chunkfile_is_chunked(filepath)) {
+		ChunkFileReader *chunkfile = blo_chunkfile_reader_open(filepath);
 
+		if (chunkfile != NULL) {
+			fd = filedata_new();
+			fd->chunkfile = chunkfile;
+			fd->read = fd_read_from_chunkfile;
+		}
+	}
+	else {
+		gzFile gzfile;
+		errno = 0;
+		gzfile = BLI_gzopen(filepath, "rb");
+
+		if (gzfile != (gzFile)Z_NULL) {
+			fd = filedata_new();
+			fd->gzfiledes = gzfile;
+			fd->read = fd_read_gzip_from_file;
+		}
+	}
+
+	if (fd) {
 		decode_blender_header(fd);
 
 		if (fd->flags & FD_FLAGS_FILE_OK) {
@@ -1265,6 +1526,16 @@ void blo_freefiledata(FileData *fd)
 			gzclose(fd->gzfiledes);
 		}
 		
+		if (fd->chunkfile != NULL) {
+			blo_chunkfile_reader_close(fd->chunkfile);
+		}
+
+#ifdef USE_BHEAD_MMAP
+		if (fd->mmap_data != NULL) {
+			munmap((void *)fd->mmap_data, fd->mmap_size);
+		}
+#endif
+		
 		if (fd->strm.next_in) {
 			if (inflateEnd(&fd->strm) != Z_OK) {
 				printf("close gzip stream error\n");
@@ -1281,6 +1552,8 @@ void blo_freefiledata(FileData *fd)
 
 		if (fd->filesdna)
 			DNA_sdna_free(fd->filesdna);
+		if (fd->reconstruct_info)
+			DNA_reconstruct_info_free(fd->reconstruct_info);
 		if (fd->compflags)
 			MEM_freeN((void *)fd->compflags);
 		
@@ -1325,6 +1598,15 @@ bool BLO_has_bfile_extension(const char *str)
 	return BLI_testextensie_array(str, ext_test);
 }
 
+/**
+ * Check if the file is written in the chunked compressed container (see chunkfile.c),
+ * such files don't start with the regular "BLENDER" header.
+ */
+bool BLO_has_chunked_header(const char *filepath)
+{
+	return blo_chunkfile_is_chunked(filepath);
+}
+
 /**
  * Try to explode given path into its 'library components' (i.e. a .blend file, id type/group, and datablock itself).
  *
@@ -1856,7 +2138,7 @@ static void switch_endian_structs(const struct SDNA *filesdna, BHead *bhead)
 	int blocksize, nblocks;
 	char *data;
 	
-	data = (char *)(bhead+1);
+	data = (char *)bhead_data(bhead);
 	blocksize = filesdna->typelens[ filesdna->structs[bhead->SDNAnr][0] ];
 	
 	nblocks = bhead->nr;
@@ -1878,12 +2160,12 @@ static void *read_struct(FileData *fd, BHead *bh, const char *blockname)
 		
 		if (fd->compflags[bh->SDNAnr] != SDNA_CMP_REMOVED) {
 			if (fd->compflags[bh->SDNAnr] == SDNA_CMP_NOT_EQUAL) {
-				temp = DNA_struct_reconstruct(fd->memsdna, fd->filesdna, fd->compflags, bh->SDNAnr, bh->nr, (bh+1));
+				temp = DNA_struct_reconstruct(fd->reconstruct_info, bh->SDNAnr, bh->nr, bhead_data(bh));
 			}
 			else {
 				/* SDNA_CMP_EQUAL */
 				temp = MEM_mallocN(bh->len, blockname);
-				memcpy(temp, (bh+1), bh->len);
+				memcpy(temp, bhead_data(bh), bh->len);
 			}
 		}
 	}
@@ -3493,6 +3775,38 @@ static void switch_endian_keyblock(Key *key, KeyBlock *kb)
 	}
 }
 
+/* expand a key saved sparse (see write_keys), the reference key is always saved dense */
+static void direct_link_keyblock_sparse(Key *key, KeyBlock *kb)
+{
+	const KeyBlock *refkb = key->refkey;
+	const int *index = kb->data_sparse;
+	const float (*co)[3] = (const float (*)[3])(index + kb->totsparse);
+	const size_t data_sparse_len = (sizeof(int) + sizeof(float[3])) * (size_t)kb->totsparse;
+	float (*data)[3];
+	int i;
+
+	if (refkb && (refkb != kb) && refkb->data && (kb->data == NULL) &&
+	    (key->elemsize == (int)sizeof(float[3])) &&
+	    (MEM_allocN_len(kb->data_sparse) >= data_sparse_len))
+	{
+		kb->totelem = refkb->totelem;
+		kb->data = data = MEM_dupallocN(refkb->data);
+
+		for (i = 0; i < kb->totsparse; i++) {
+			if (index[i] >= 0 && index[i] < kb->totelem) {
+				copy_v3_v3(data[index[i]], co[i]);
+			}
+		}
+	}
+	else {
+		printf("Error reading shape key '%s', sparse data can't be expanded\n", kb->name);
+	}
+
+	MEM_freeN(kb->data_sparse);
+	kb->data_sparse = NULL;
+	kb->totsparse = 0;
+}
+
 static void direct_link_key(FileData *fd, Key *key)
 {
 	KeyBlock *kb;
@@ -3506,9 +3820,23 @@ static void direct_link_key(FileData *fd, Key *key)
 	
 	for (kb = key->block.first; kb; kb = kb->next) {
 		kb->data = newdataadr(fd, kb->data);
+		kb->data_sparse = newdataadr(fd, kb->data_sparse);
+		kb->delta_cache = NULL;
 		
-		if (fd->flags & FD_FLAGS_SWITCH_ENDIAN)
+		if (fd->flags & FD_FLAGS_SWITCH_ENDIAN) {
 			switch_endian_keyblock(key, kb);
+			if (kb->data_sparse) {
+				/* indices and coordinates, all 4 byte values */
+				BLI_endian_switch_int32_array(kb->data_sparse, kb->totsparse * 4);
+			}
+		}
+	}
+
+	/* after the loop, the reference key may come later in the list */
+	for (kb = key->block.first; kb; kb = kb->next) {
+		if (kb->data_sparse) {
+			direct_link_keyblock_sparse(key, kb);
+		}
 	}
 }
 
@@ -5025,6 +5353,7 @@ static void direct_link_modifiers(FileData *fd, ListBase *lb)
 	for (md=lb->first; md; md=md->next) {
 		md->error = NULL;
 		md->scene = NULL;
+		md->result_cache = NULL;
 		
 		/* if modifiers disappear, or for upward compatibility */
 		if (NULL == modifierType_getInfo(md->type))
@@ -5039,6 +5368,12 @@ static void direct_link_modifiers(FileData *fd, ListBase *lb)
 			ArmatureModifierData *amd = (ArmatureModifierData *)md;
 			
 			amd->prevCos = NULL;
+			amd->skin_cache = NULL;
+		}
+		else if (md->type == eModifierType_Lattice) {
+			LatticeModifierData *lmd = (LatticeModifierData *)md;
+
+			lmd->cache = NULL;
 		}
 		else if (md->type == eModifierType_Cloth) {
 			ClothModifierData *clmd = (ClothModifierData *)md;
@@ -8002,6 +8337,100 @@ static BHead *read_data_into_oldnewmap(FileData *fd, BHead *bhead, const char *a
 	return bhead;
 }
 
+#ifdef USE_PARALLEL_DIRECT_LINK
+
+/* Minimal size of direct data for a datablock to be linked in a task. */
+#define DIRECT_LINK_TASK_MIN_SIZE (256 * 1024)
+
+typedef struct DirectLinkTask {
+	/* Copy of the main FileData with its own datamap, so lookups done by the
+	 * task do not interfere with the ones done by the main thread. */
+	FileData fd;
+	ID *id;
+	BHead *bhead;  /* first data block */
+	int tot_bhead;
+	const char *allocname;
+} DirectLinkTask;
+
+/* Direct linking of these datablocks only uses own datamap and
+ * file-wide read-only settings, so it can be done from a thread. */
+static bool direct_link_is_threadsafe(const short idcode)
+{
+	return ELEM(idcode, ID_ME, ID_KE);
+}
+
+static void direct_link_task_run(TaskPool * __restrict UNUSED(pool), void *taskdata, int UNUSED(threadid))
+{
+	DirectLinkTask *task = taskdata;
+	FileData *fd = &task->fd;
+	ID *id = task->id;
+	BHead *bhead = task->bhead;
+	int i;
+
+	/* All the blocks are already loaded by the main thread, so no actual file reading happens here. */
+	for (i = 0; i < task->tot_bhead; i++, bhead = blo_nextbhead(fd, bhead)) {
+		void *data = read_struct(fd, bhead, task->allocname);
+		if (data) {
+			oldnewmap_insert(fd->datamap, bhead->old, data, 0);
+		}
+	}
+
+	direct_link_id(fd, id);
+
+	switch (GS(id->name)) {
+		case ID_ME:
+			direct_link_mesh(fd, (Mesh *)id);
+			break;
+		case ID_KE:
+			direct_link_key(fd, (Key *)id);
+			break;
+		default:
+			BLI_assert(0);
+			break;
+	}
+
+	oldnewmap_free_unused(fd->datamap);
+	oldnewmap_free(fd->datamap);
+}
+
+/* Push direct linking of the ID to the task pool when it's worth it,
+ * returns the block following ID's data, NULL when the ID is to be linked in place. */
+static BHead *read_libblock_direct_link_deferred(FileData *fd, ID *id, BHead *bhead, const char *allocname)
+{
+	DirectLinkTask *task;
+	BHead *bhead_data = blo_nextbhead(fd, bhead), *bhead_end;
+	size_t data_len = 0;
+	int tot_bhead = 0;
+
+	if (!direct_link_is_threadsafe(GS(id->name))) {
+		return NULL;
+	}
+
+	for (bhead_end = bhead_data; bhead_end && bhead_end->code == DATA; bhead_end = blo_nextbhead(fd, bhead_end)) {
+		data_len += (size_t)bhead_end->len;
+		tot_bhead++;
+	}
+
+	if (data_len < DIRECT_LINK_TASK_MIN_SIZE || bhead_end == NULL) {
+		return NULL;
+	}
+
+	task = MEM_mallocN(sizeof(*task), "DirectLinkTask");
+	task->fd = *fd;
+	task->fd.datamap = oldnewmap_new();
+	task->fd.direct_link_pool = NULL;
+	task->id = id;
+	task->bhead = bhead_data;
+	task->tot_bhead = tot_bhead;
+	task->allocname = allocname;
+
+	BLI_task_pool_push(fd->direct_link_pool, direct_link_task_run, task, true, TASK_PRIORITY_LOW);
+
+	return bhead_end;
+}
+
+#endif  /* USE_PARALLEL_DIRECT_LINK */
+
 static BHead *read_libblock(FileData *fd, Main *main, BHead *bhead, const short tag, ID **r_id)
 {
 	/* this routine reads a libblock and its direct data. Use link functions to connect it all
@@ -8118,6 +8547,15 @@ static BHead *read_libblock(FileData *fd, Main *main, BHead *bhead, const short
 
 	/* need a name for the mallocN, just for debugging and sane prints on leaks */
 	allocname = dataname(GS(id->name));
+
+#ifdef USE_PARALLEL_DIRECT_LINK
+	if (fd->direct_link_pool) {
+		BHead *bhead_next = read_libblock_direct_link_deferred(fd, id, bhead, allocname);
+		if (bhead_next) {
+			return bhead_next;
+		}
+	}
+#endif
 	
 	/* read all data into fd->datamap */
 	bhead = read_data_into_oldnewmap(fd, bhead, allocname);
@@ -8537,6 +8975,15 @@ BlendFileData *blo_read_file_internal(FileData *fd, const char *filepath)
 		}
 	}
 
+#ifdef USE_PARALLEL_DIRECT_LINK
+	{
+		TaskScheduler *task_scheduler = BLI_task_scheduler_get();
+		if (task_scheduler && BLI_task_scheduler_num_threads(task_scheduler) > 1) {
+			fd->direct_link_pool = BLI_task_pool_create(task_scheduler, fd);
+		}
+	}
+#endif
+
 	while (bhead) {
 		switch (bhead->code) {
 		case DATA:
@@ -8569,6 +9016,14 @@ BlendFileData *blo_read_file_internal(FileData *fd, const char *filepath)
 			bhead = read_libblock(fd, bfd->main, bhead, LIB_TAG_LOCAL, NULL);
 		}
 	}
+
+#ifdef USE_PARALLEL_DIRECT_LINK
+	if (fd->direct_link_pool) {
+		BLI_task_pool_work_and_wait(fd->direct_link_pool);
+		BLI_task_pool_free(fd->direct_link_pool);
+		fd->direct_link_pool = NULL;
+	}
+#endif
 	
 	/* do before read_libraries, but skip undo case */
 	if (fd->memfile == NULL) {
@@ -10293,7 +10748,7 @@ static void read_libraries(FileData *basefd, ListBase *mainlist)
 						        mainptr->curlib->filepath,
 						        mainptr->curlib->name,
 						        library_parent_filepath(mainptr->curlib));
-						fd = blo_openblenderfile(mainptr->curlib->filepath, basefd->reports);
+						fd = blo_openblenderfile_ex(mainptr->curlib->filepath, true, basefd->reports);
 					}
 					/* allow typing in a new lib path */
 					if (G.debug_value == -666) {
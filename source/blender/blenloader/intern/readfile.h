@@ -61,6 +61,12 @@ typedef struct FileData {
 	// variables needed for reading from file
 	int filedes;
 	gzFile gzfiledes;
+	struct ChunkFileReader *chunkfile;
+
+	// variables needed for reading from a mapped file, see: USE_BHEAD_MMAP
+	const char *mmap_data;
+	size_t mmap_size;
+	size_t mmap_seek;
 
 	// now only in use for library appending
 	char relabase[FILE_MAX];
@@ -76,6 +82,7 @@ typedef struct FileData {
 	struct SDNA *filesdna;
 	const struct SDNA *memsdna;
 	const char *compflags;  /* array of eSDNA_StructCompare */
+	struct DNA_ReconstructInfo *reconstruct_info;  /* conversion of NOT_EQUAL structs */
 	
 	int fileversion;
 	int id_name_offs;       /* used to retrieve ID names from (bhead+1) */
@@ -98,6 +105,9 @@ typedef struct FileData {
 	ListBase *mainlist;
 	ListBase *old_mainlist;  /* Used for undo. */
 
+	/* see: USE_PARALLEL_DIRECT_LINK */
+	struct TaskPool *direct_link_pool;
+
 	/* ick ick, used to return
 	 * data through streamglue.
 	 */
@@ -107,6 +117,9 @@ typedef struct FileData {
 
 typedef struct BHeadN {
 	struct BHeadN *next, *prev;
+	/* Data of the block, stored directly after the BHead,
+	 * or inside the mapped file for DATA blocks (see: USE_BHEAD_MMAP). */
+	const void *data;
 	struct BHead bhead;
 } BHeadN;
 
@@ -130,6 +143,7 @@ void blo_split_main(ListBase *mainlist, struct Main *main);
 BlendFileData *blo_read_file_internal(FileData *fd, const char *filepath);
 
 FileData *blo_openblenderfile(const char *filepath, struct ReportList *reports);
+FileData *blo_openblenderfile_ex(const char *filepath, const bool use_mmap, struct ReportList *reports);
 FileData *blo_openblendermemory(const void *buffer, int buffersize, struct ReportList *reports);
 FileData *blo_openblendermemfile(struct MemFile *memfile, struct ReportList *reports);
 
@@ -150,6 +164,7 @@ BHead *blo_firstbhead(FileData *fd);
 BHead *blo_nextbhead(FileData *fd, BHead *thisblock);
 BHead *blo_prevbhead(FileData *fd, BHead *thisblock);
 
+const void *bhead_data(const BHead *bhead);
 const char *bhead_id_name(const FileData *fd, const BHead *bhead);
 
 /* do versions stuff */
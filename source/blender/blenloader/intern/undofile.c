@@ -34,12 +34,22 @@
 #include <string.h>
 #include <stdio.h>
 #include <math.h>
+#include <fcntl.h>
+#include <errno.h>
+
+#ifndef WIN32
+#  include <unistd.h>
+#else
+#  include <io.h>
+#endif
 
 #include "MEM_guardedalloc.h"
 
 #include "DNA_listBase.h"
 
 #include "BLI_blenlib.h"
+#include "BLI_ghash.h"
+#include "BLI_hash_mm2a.h"
 
 #include "BLO_undofile.h"
 
@@ -63,47 +73,93 @@ void BLO_memfile_free(MemFile *memfile)
 void BLO_memfile_merge(MemFile *first, MemFile *second)
 {
 	MemFileChunk *fc, *sc;
-	
-	fc = first->chunks.first;
-	sc = second->chunks.first;
-	while (fc || sc) {
-		if (fc && sc) {
-			if (sc->ident) {
+	GHash *buf_to_chunk;
+
+	/* chunks of 'second' can share any buffer of 'first', not only the one at the same position
+	 * (see memfile_chunk_add), so find the owners by buffer */
+	buf_to_chunk = BLI_ghash_ptr_new_ex(__func__, BLI_listbase_count(&first->chunks));
+	for (fc = first->chunks.first; fc; fc = fc->next) {
+		if (fc->ident == 0) {
+			BLI_ghash_insert(buf_to_chunk, fc->buf, fc);
+		}
+	}
+
+	for (sc = second->chunks.first; sc; sc = sc->next) {
+		if (sc->ident) {
+			/* pop, so only one chunk takes ownership of a buffer shared several times */
+			fc = BLI_ghash_popkey(buf_to_chunk, sc->buf, NULL);
+			if (fc) {
 				sc->ident = 0;
 				fc->ident = 1;
 			}
 		}
-		if (fc) fc = fc->next;
-		if (sc) sc = sc->next;
 	}
-	
+
+	BLI_ghash_free(buf_to_chunk, NULL, NULL);
+
 	BLO_memfile_free(first);
 }
 
+static unsigned int memfile_chunk_hash(const void *key)
+{
+	const MemFileChunk *chunk = key;
+	return chunk->hash;
+}
+
+static bool memfile_chunk_cmp(const void *a, const void *b)
+{
+	const MemFileChunk *chunk_a = a;
+	const MemFileChunk *chunk_b = b;
+	return !((chunk_a->size == chunk_b->size) && (memcmp(chunk_a->buf, chunk_b->buf, chunk_a->size) == 0));
+}
+
+static GHash *memfile_chunk_hash_new(MemFile *memfile)
+{
+	GHash *chunk_hash = BLI_ghash_new_ex(
+	        memfile_chunk_hash, memfile_chunk_cmp, __func__, BLI_listbase_count(&memfile->chunks));
+	MemFileChunk *chunk;
+
+	for (chunk = memfile->chunks.first; chunk; chunk = chunk->next) {
+		void **val_p;
+		if (!BLI_ghash_ensure_p(chunk_hash, chunk, &val_p)) {
+			*val_p = chunk;
+		}
+	}
+
+	return chunk_hash;
+}
+
 void memfile_chunk_add(MemFile *compare, MemFile *current, const char *buf, unsigned int size)
 {
 	static MemFileChunk *compchunk = NULL;
+	static GHash *compchunk_hash = NULL;
 	MemFileChunk *curchunk;
-	
+
 	/* this function inits when compare != NULL or when current == NULL  */
-	if (compare) {
-		compchunk = compare->chunks.first;
-		return;
-	}
-	if (current == NULL) {
+	if (compare || current == NULL) {
+		if (compchunk_hash) {
+			BLI_ghash_free(compchunk_hash, NULL, NULL);
+			compchunk_hash = NULL;
+		}
 		compchunk = NULL;
+
+		if (compare) {
+			compchunk = compare->chunks.first;
+			compchunk_hash = memfile_chunk_hash_new(compare);
+		}
 		return;
 	}
-	
+
 	curchunk = MEM_mallocN(sizeof(MemFileChunk), "MemFileChunk");
 	curchunk->size = size;
 	curchunk->buf = NULL;
 	curchunk->ident = 0;
+	curchunk->hash = BLI_hash_mm2((const unsigned char *)buf, size, 0);
 	BLI_addtail(&current->chunks, curchunk);
-	
-	/* we compare compchunk with buf */
+
+	/* we compare compchunk with buf, most chunks match in order */
 	if (compchunk) {
-		if (compchunk->size == curchunk->size) {
+		if ((compchunk->hash == curchunk->hash) && (compchunk->size == curchunk->size)) {
 			if (memcmp(compchunk->buf, buf, size) == 0) {
 				curchunk->buf = compchunk->buf;
 				curchunk->ident = 1;
@@ -111,7 +167,20 @@ void memfile_chunk_add(MemFile *compare, MemFile *current, const char *buf, unsi
 		}
 		compchunk = compchunk->next;
 	}
-	
+
+	/* look for the same data anywhere in the compare memfile,
+	 * so data being added or removed doesn't prevent sharing the chunks that follow */
+	if ((curchunk->buf == NULL) && compchunk_hash) {
+		MemFileChunk *match = BLI_ghash_lookup(compchunk_hash, &(const MemFileChunk){
+		        .buf = (char *)buf, .size = size, .hash = curchunk->hash});
+		if (match) {
+			curchunk->buf = match->buf;
+			curchunk->ident = 1;
+			/* continue comparing in order from there */
+			compchunk = match->next;
+		}
+	}
+
 	/* not equal... */
 	if (curchunk->buf == NULL) {
 		curchunk->buf = MEM_mallocN(size, "Chunk buffer");
@@ -120,3 +189,89 @@ void memfile_chunk_add(MemFile *compare, MemFile *current, const char *buf, unsi
 	}
 }
 
+/**
+ * Copy the content of \a memfile, so it stays valid while \a memfile is changed or freed
+ * (the chunks of an undo step are shared with other steps).
+ * Chunks are merged into large blocks, to avoid many small allocations.
+ */
+void BLO_memfile_copy(const MemFile *memfile, MemFile *r_memfile)
+{
+	const unsigned int block_size_max = 1 << 26;  /* 64mb */
+	MemFileChunk *chunk, *block = NULL;
+
+	BLI_listbase_clear(&r_memfile->chunks);
+	r_memfile->size = 0;
+
+	for (chunk = memfile->chunks.first; chunk; chunk = chunk->next) {
+		if (block == NULL || (block->size + chunk->size) > block_size_max) {
+			const MemFileChunk *chunk_iter;
+			unsigned int block_size = 0;
+
+			/* size of the chunks fitting in this block (at least one) */
+			for (chunk_iter = chunk; chunk_iter; chunk_iter = chunk_iter->next) {
+				if (block_size && (block_size + chunk_iter->size) > block_size_max) {
+					break;
+				}
+				block_size += chunk_iter->size;
+			}
+
+			block = MEM_callocN(sizeof(MemFileChunk), "MemFileChunk");
+			block->buf = MEM_mallocN(block_size, "Chunk buffer");
+			BLI_addtail(&r_memfile->chunks, block);
+		}
+
+		memcpy(block->buf + block->size, chunk->buf, chunk->size);
+		block->size += chunk->size;
+		r_memfile->size += chunk->size;
+	}
+}
+
+/**
+ * Saves .blend using a memfile (undo step or #BLO_write_file_snapshot).
+ *
+ * \note Thread safe, as long as the memfile isn't changed meanwhile.
+ *
+ * \return success.
+ */
+bool BLO_memfile_write_file(MemFile *memfile, const char *filename)
+{
+	MemFileChunk *chunk;
+	int file, oflags;
+
+	/* note: This is currently used for autosave and 'quit.blend', where _not_ following symlinks is OK,
+	 * however if this is ever executed explicitly by the user, we may want to allow writing to symlinks.
+	 */
+
+	oflags = O_BINARY | O_WRONLY | O_CREAT | O_TRUNC;
+#ifdef O_NOFOLLOW
+	/* use O_NOFOLLOW to avoid writing to a symlink - use 'O_EXCL' (CVE-2008-1103) */
+	oflags |= O_NOFOLLOW;
+#else
+	/* TODO(sergey): How to deal with symlinks on windows? */
+#  ifndef _MSC_VER
+#    warning "Symbolic links will be followed on undo save, possibly causing CVE-2008-1103"
+#  endif
+#endif
+	file = BLI_open(filename,  oflags, 0666);
+
+	if (file == -1) {
+		fprintf(stderr, "Unable to save '%s': %s\n",
+		        filename, errno ? strerror(errno) : "Unknown error opening file");
+		return false;
+	}
+
+	for (chunk = memfile->chunks.first; chunk; chunk = chunk->next) {
+		if (write(file, chunk->buf, chunk->size) != chunk->size) {
+			break;
+		}
+	}
+
+	close(file);
+
+	if (chunk) {
+		fprintf(stderr, "Unable to save '%s': %s\n",
+		        filename, errno ? strerror(errno) : "Unknown error writing file");
+		return false;
+	}
+	return true;
+}
@@ -183,6 +183,7 @@
 #include "BLO_undofile.h"
 #include "BLO_blend_defs.h"
 
+#include "chunkfile.h"
 #include "readfile.h"
 
 /* for SDNA_TYPE_FROM_STRUCT() macro */
@@ -203,6 +204,8 @@
 typedef enum {
 	WW_WRAP_NONE = 1,
 	WW_WRAP_ZLIB,
+	WW_WRAP_CHUNKED,
+	WW_WRAP_MEMFILE,
 } eWriteWrapType;
 
 typedef struct WriteWrap WriteWrap;
@@ -216,6 +219,8 @@ struct WriteWrap {
 	union {
 		int file_handle;
 		gzFile gz_handle;
+		ChunkFileWriter *chunk_handle;
+		MemFile *memfile;
 	} _user_data;
 };
 
@@ -275,6 +280,57 @@ static size_t ww_write_zlib(WriteWrap *ww, const char *buf, size_t buf_len)
 }
 #undef FILE_HANDLE
 
+/* chunked, see chunkfile.c */
+#define FILE_HANDLE(ww) \
+	(ww)->_user_data.chunk_handle
+
+static bool ww_open_chunked(WriteWrap *ww, const char *filepath)
+{
+	ChunkFileWriter *file;
+
+	file = blo_chunkfile_writer_open(filepath, CHUNKFILE_CODEC_LZO);
+
+	if (file != NULL) {
+		FILE_HANDLE(ww) = file;
+		return true;
+	}
+	else {
+		return false;
+	}
+}
+static bool ww_close_chunked(WriteWrap *ww)
+{
+	return blo_chunkfile_writer_close(FILE_HANDLE(ww));
+}
+static size_t ww_write_chunked(WriteWrap *ww, const char *buf, size_t buf_len)
+{
+	return blo_chunkfile_writer_write(FILE_HANDLE(ww), buf, buf_len) ? buf_len : 0;
+}
+#undef FILE_HANDLE
+
+/* memfile, keeps the file content in memory (see BLO_write_file_snapshot) */
+#define FILE_HANDLE(ww) \
+	(ww)->_user_data.memfile
+
+static bool ww_close_memfile(WriteWrap *UNUSED(ww))
+{
+	return true;
+}
+static size_t ww_write_memfile(WriteWrap *ww, const char *buf, size_t buf_len)
+{
+	MemFile *memfile = FILE_HANDLE(ww);
+	MemFileChunk *chunk = MEM_callocN(sizeof(MemFileChunk), "MemFileChunk");
+
+	chunk->buf = MEM_mallocN(buf_len, "Chunk buffer");
+	chunk->size = (unsigned int)buf_len;
+	memcpy(chunk->buf, buf, buf_len);
+	BLI_addtail(&memfile->chunks, chunk);
+	memfile->size += chunk->size;
+
+	return buf_len;
+}
+#undef FILE_HANDLE
+
 /* --- end compression types --- */
 
 static void ww_handle_init(eWriteWrapType ww_type, WriteWrap *r_ww)
@@ -289,6 +345,20 @@ static void ww_handle_init(eWriteWrapType ww_type, WriteWrap *r_ww)
 			r_ww->write = ww_write_zlib;
 			break;
 		}
+		case WW_WRAP_CHUNKED:
+		{
+			r_ww->open  = ww_open_chunked;
+			r_ww->close = ww_close_chunked;
+			r_ww->write = ww_write_chunked;
+			break;
+		}
+		case WW_WRAP_MEMFILE:
+		{
+			/* no open, the memfile is set by the caller */
+			r_ww->close = ww_close_memfile;
+			r_ww->write = ww_write_memfile;
+			break;
+		}
 		default:
 		{
 			r_ww->open  = ww_open_none;
@@ -320,6 +390,8 @@ typedef struct {
 #ifdef USE_BMESH_SAVE_AS_COMPAT
 	bool use_mesh_compat; /* option to save with older mesh format */
 #endif
+
+	bool use_keys_sparse; /* option to save mesh shape keys sparse, see G_FILE_KEYS_SPARSE */
 } WriteData;
 
 static WriteData *writedata_new(WriteWrap *ww)
@@ -460,6 +532,11 @@ static bool endwrite(WriteData *wd)
 		wd->count = 0;
 	}
 
+	if (wd->current) {
+		/* free comparing data */
+		memfile_chunk_add(NULL, NULL, NULL, 0);
+	}
+
 	const bool err = wd->error;
 	writedata_free(wd);
 
@@ -530,11 +607,12 @@ static void writestruct_id(
 	writestruct_at_address_id(wd, filecode, structname, nr, adr, adr);
 }
 
-static void writedata(WriteData *wd, int filecode, int len, const void *adr)  /* do not use for structs */
+/* do not use for structs */
+static void writedata_at_address(WriteData *wd, int filecode, int len, const void *adr, const void *data)
 {
 	BHead bh;
 
-	if (adr == NULL || len == 0) {
+	if (adr == NULL || data == NULL || len == 0) {
 		return;
 	}
 
@@ -549,7 +627,12 @@ static void writedata(WriteData *wd, int filecode, int len, const void *adr)  /*
 	bh.len    = len;
 
 	mywrite(wd, &bh, sizeof(BHead));
-	mywrite(wd, adr, len);
+	mywrite(wd, data, len);
+}
+
+static void writedata(WriteData *wd, int filecode, int len, const void *adr)  /* do not use for structs */
+{
+	writedata_at_address(wd, filecode, len, adr, adr);
 }
 
 /* use this to force writing of lists in same order as reading (using link_list) */
@@ -1933,6 +2016,80 @@ static void write_vfonts(WriteData *wd, ListBase *idbase)
 }
 
 
+/* mesh keys moving less than (totelem / KEYBLOCK_SPARSE_DIV) vertices are saved sparse */
+#define KEYBLOCK_SPARSE_DIV 2
+
+/**
+ * Count the coordinates of \a kb which differ from the reference key,
+ * returns -1 when the key can't or shouldn't be saved sparse
+ * (keys equal to their reference are saved dense, sparse keys always have data).
+ * The comparison is bitwise so reading the key back gives exactly the same data.
+ */
+static int write_keyblock_sparse_count(const Key *key, const KeyBlock *kb)
+{
+	const KeyBlock *refkb = key->refkey;
+	const float (*co)[3], (*refco)[3];
+	int a, totsparse = 0;
+
+	if ((key->from == NULL) || (GS(key->from->name) != ID_ME) || (key->elemsize != (int)sizeof(float[3])) ||
+	    (refkb == NULL) || (refkb == kb) || (refkb->data == NULL) || (kb->data == NULL) ||
+	    (kb->totelem == 0) || (kb->totelem != refkb->totelem))
+	{
+		return -1;
+	}
+
+	co = kb->data;
+	refco = refkb->data;
+	for (a = 0; a < kb->totelem; a++) {
+		if (memcmp(co[a], refco[a], sizeof(float[3])) != 0) {
+			if (++totsparse > kb->totelem / KEYBLOCK_SPARSE_DIV) {
+				return -1;
+			}
+		}
+	}
+
+	return totsparse ? totsparse : -1;
+}
+
+/**
+ * Save a key as the indices and coordinates of the vertices which differ from the reference key,
+ * the reference key itself is always saved dense.
+ * Only used with #G_FILE_KEYS_SPARSE, older versions read these as empty keys.
+ */
+static void write_keyblock_sparse(WriteData *wd, const Key *key, const KeyBlock *kb, const int totsparse)
+{
+	KeyBlock kb_flat = *kb;
+	const float (*co)[3] = kb->data;
+	const float (*refco)[3] = key->refkey->data;
+	float (*co_sparse)[3];
+	size_t data_sparse_len;
+	int *index;
+	int a, i;
+
+	kb_flat.data = NULL;
+	kb_flat.totelem = 0;
+	kb_flat.totsparse = totsparse;
+	/* the dense data address is unique, reuse it to identify the sparse data */
+	kb_flat.data_sparse = kb->data;
+	writestruct_at_address(wd, DATA, KeyBlock, 1, kb, &kb_flat);
+
+	data_sparse_len = (sizeof(int) + sizeof(float[3])) * (size_t)totsparse;
+	index = MEM_mallocN(data_sparse_len, __func__);
+	co_sparse = (float (*)[3])(index + totsparse);
+
+	for (a = 0, i = 0; a < kb->totelem; a++) {
+		if (memcmp(co[a], refco[a], sizeof(float[3])) != 0) {
+			index[i] = a;
+			memcpy(co_sparse[i], co[a], sizeof(float[3]));
+			i++;
+		}
+	}
+	BLI_assert(i == totsparse);
+
+	writedata_at_address(wd, DATA, (int)data_sparse_len, kb->data, index);
+	MEM_freeN(index);
+}
+
 static void write_keys(WriteData *wd, ListBase *idbase)
 {
 	Key *key;
@@ -1952,9 +2109,16 @@ static void write_keys(WriteData *wd, ListBase *idbase)
 			/* direct data */
 			kb = key->block.first;
 			while (kb) {
-				writestruct(wd, DATA, KeyBlock, 1, kb);
-				if (kb->data) {
-					writedata(wd, DATA, kb->totelem * key->elemsize, kb->data);
+				const int totsparse = wd->use_keys_sparse ? write_keyblock_sparse_count(key, kb) : -1;
+
+				if (totsparse != -1) {
+					write_keyblock_sparse(wd, key, kb, totsparse);
+				}
+				else {
+					writestruct(wd, DATA, KeyBlock, 1, kb);
+					if (kb->data) {
+						writedata(wd, DATA, kb->totelem * key->elemsize, kb->data);
+					}
 				}
 				kb = kb->next;
 			}
@@ -4045,6 +4209,9 @@ static bool write_file_handle(
 	wd->use_mesh_compat = (write_flags & G_FILE_MESH_COMPAT) != 0;
 #endif
 
+	/* undo keeps keys dense, unchanged data is shared between steps anyway */
+	wd->use_keys_sparse = (write_flags & G_FILE_KEYS_SPARSE) && (current == NULL);
+
 #ifdef USE_NODE_COMPAT_CUSTOMNODES
 	/* don't write compatibility data on undo */
 	if (!current) {
@@ -4197,7 +4364,7 @@ bool BLO_write_file(
 	BLI_snprintf(tempname, sizeof(tempname), "%s@", filepath);
 
 	if (write_flags & G_FILE_COMPRESS) {
-		ww_type = WW_WRAP_ZLIB;
+		ww_type = (write_flags & G_FILE_COMPRESS_CHUNKED) ? WW_WRAP_CHUNKED : WW_WRAP_ZLIB;
 	}
 	else {
 		ww_type = WW_WRAP_NONE;
@@ -4291,3 +4458,32 @@ bool BLO_write_file_mem(Main *mainvar, MemFile *compare, MemFile *current, int w
 
 	return (err == 0);
 }
+
+/**
+ * Write the same content as #BLO_write_file into \a r_memfile, without touching the disk,
+ * so the (slow) writing of the file can be done later, from another thread.
+ * See #BLO_memfile_write_file.
+ *
+ * \note Unlike #BLO_write_file_mem this isn't an undo step, chunks are never shared.
+ * Paths are not remapped and no thumbnail is written.
+ *
+ * \return Success.
+ */
+bool BLO_write_file_snapshot(Main *mainvar, MemFile *r_memfile, int write_flags)
+{
+	WriteWrap ww;
+
+	ww_handle_init(WW_WRAP_MEMFILE, &ww);
+	ww._user_data.memfile = r_memfile;
+
+	const bool err = write_file_handle(mainvar, &ww, NULL, NULL, write_flags, NULL);
+
+	ww.close(&ww);
+
+	if (err) {
+		BLO_memfile_free(r_memfile);
+		return false;
+	}
+
+	return true;
+}
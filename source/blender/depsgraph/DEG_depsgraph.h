@@ -61,6 +61,7 @@ typedef struct Depsgraph Depsgraph;
 /* ------------------------------------------------ */
 
 struct EvaluationContext;
+struct ID;
 struct Main;
 
 struct PointerRNA;
@@ -129,6 +130,11 @@ void DEG_id_type_tag(struct Main *bmain, short idtype);
 
 void DEG_ids_clear_recalc(struct Main *bmain);
 
+/* Clear recalc tags of IDs which are up to date after a partial evaluation,
+ * IDs which still have operations tagged in the graph keep them.
+ */
+void DEG_ids_clear_recalc_evaluated(struct Main *bmain, Depsgraph *graph);
+
 /* Update Flushing ------------------------------- */
 
 /* Flush updates for all IDs */
@@ -170,6 +176,23 @@ void DEG_evaluate_on_framechange(struct EvaluationContext *eval_ctx,
                                  float ctime,
                                  const unsigned int layer);
 
+/* Frame changed recalculation of the given IDs only.
+ *
+ * Only operations the IDs depend on are evaluated, the rest of the graph
+ * stays tagged and is brought up to date by the next update.
+ *
+ * < context_type: context to perform evaluation for
+ * < ctime: (frame) new frame to evaluate values on
+ * < ids: IDs to get evaluated state of
+ */
+void DEG_evaluate_ids_on_framechange(struct EvaluationContext *eval_ctx,
+                                     struct Main *bmain,
+                                     Depsgraph *graph,
+                                     float ctime,
+                                     const unsigned int layer,
+                                     struct ID **ids,
+                                     int num_ids);
+
 /* Data changed recalculation entry point.
  * < context_type: context to perform evaluation for
  * < layers: visible layers bitmask to update the graph for
@@ -82,6 +82,21 @@ void DEG_stats_simple(const struct Depsgraph *graph,
                       size_t *r_operations,
                       size_t *r_relations);
 
+/* ------------------------------------------------ */
+
+/* Start recording timing of every evaluated operation, when trace_filepath is
+ * given the recorded events are written there in Chrome's trace event format
+ * once profiling ends.
+ */
+void DEG_debug_profile_begin(const char *trace_filepath);
+
+/* Stop recording, write the trace and print a summary of the operations on the
+ * critical path of the evaluations. Returns false if the trace failed to write.
+ */
+bool DEG_debug_profile_end(void);
+
+bool DEG_debug_profile_is_running(void);
+
 /* ************************************************ */
 /* Diagram-Based Graph Debugging */
 
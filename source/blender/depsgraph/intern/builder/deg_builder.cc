@@ -98,8 +98,12 @@ void deg_graph_build_finalize(Depsgraph *graph)
 		}
 	}
 	GHASH_FOREACH_END();
-	/* STEP 2: Flush visibility layers from children to parent. */
+	/* STEP 2: Flush visibility layers from children to parent, the order in
+	 * which nodes are visited is stored for calculating evaluation priorities.
+	 */
 	std::stack<OperationDepsNode *> stack;
+	graph->priority_order.clear();
+	graph->priority_order.reserve(graph->operations.size());
 	foreach (OperationDepsNode *node, graph->operations) {
 		IDDepsNode *id_node = node->owner->owner;
 		node->done = 0;
@@ -121,6 +125,7 @@ void deg_graph_build_finalize(Depsgraph *graph)
 	while (!stack.empty()) {
 		OperationDepsNode *node = stack.top();
 		stack.pop();
+		graph->priority_order.push_back(node);
 		/* Flush layers to parents. */
 		foreach (DepsRelation *rel, node->inlinks) {
 			if (rel->from->type == DEPSNODE_TYPE_OPERATION) {
@@ -54,45 +54,38 @@ struct StackEntry {
 	DepsRelation *via_relation;
 };
 
-void deg_graph_detect_cycles(Depsgraph *graph)
-{
-	enum {
-		/* Not is not visited at all during traversal. */
-		NODE_NOT_VISITED = 0,
-		/* Node has been visited during traversal and not in current stack. */
-		NODE_VISITED = 1,
-		/* Node has been visited during traversal and is in current stack. */
-		NODE_IN_STACK = 2,
-	};
+enum {
+	/* Not is not visited at all during traversal. */
+	NODE_NOT_VISITED = 0,
+	/* Node has been visited during traversal and not in current stack. */
+	NODE_VISITED = 1,
+	/* Node has been visited during traversal and is in current stack. */
+	NODE_IN_STACK = 2,
+};
 
-	std::stack<StackEntry> traversal_stack;
-	foreach (OperationDepsNode *node, graph->operations) {
-		bool has_inlinks = false;
-		foreach (DepsRelation *rel, node->inlinks) {
-			if (rel->from->type == DEPSNODE_TYPE_OPERATION) {
-				has_inlinks = true;
-			}
-		}
-		if (has_inlinks == false) {
-			StackEntry entry;
-			entry.node = node;
-			entry.from = NULL;
-			entry.via_relation = NULL;
-			traversal_stack.push(entry);
-			node->tag = NODE_IN_STACK;
-		}
-		else {
-			node->tag = NODE_NOT_VISITED;
-		}
-		node->done = 0;
-	}
+static void deg_graph_cycles_push(std::stack<StackEntry> *traversal_stack,
+                                  OperationDepsNode *node)
+{
+	StackEntry entry;
+	entry.node = node;
+	entry.from = NULL;
+	entry.via_relation = NULL;
+	traversal_stack->push(entry);
+	node->tag = NODE_IN_STACK;
+}
 
-	while (!traversal_stack.empty()) {
-		StackEntry& entry = traversal_stack.top();
+static void deg_graph_cycles_traverse(std::stack<StackEntry> *traversal_stack)
+{
+	while (!traversal_stack->empty()) {
+		StackEntry& entry = traversal_stack->top();
 		OperationDepsNode *node = entry.node;
 		bool all_child_traversed = true;
 		for (int i = node->done; i < node->outlinks.size(); ++i) {
 			DepsRelation *rel = node->outlinks[i];
+			if (rel->flag & DEPSREL_FLAG_CYCLIC) {
+				/* Cycle was already solved by an earlier traversal. */
+				continue;
+			}
 			if (rel->to->type == DEPSNODE_TYPE_OPERATION) {
 				OperationDepsNode *to = (OperationDepsNode *)rel->to;
 				if (to->tag == NODE_IN_STACK) {
@@ -119,7 +112,7 @@ void deg_graph_detect_cycles(Depsgraph *graph)
 					new_entry.node = to;
 					new_entry.from = &entry;
 					new_entry.via_relation = rel;
-					traversal_stack.push(new_entry);
+					traversal_stack->push(new_entry);
 					to->tag = NODE_IN_STACK;
 					all_child_traversed = false;
 					node->done = i;
@@ -129,7 +122,48 @@ void deg_graph_detect_cycles(Depsgraph *graph)
 		}
 		if (all_child_traversed) {
 			node->tag = NODE_VISITED;
-			traversal_stack.pop();
+			traversal_stack->pop();
+		}
+	}
+}
+
+void deg_graph_detect_cycles(Depsgraph *graph)
+{
+	std::stack<StackEntry> traversal_stack;
+	foreach (OperationDepsNode *node, graph->operations) {
+		bool has_inlinks = false;
+		foreach (DepsRelation *rel, node->inlinks) {
+			if (rel->from->type == DEPSNODE_TYPE_OPERATION) {
+				has_inlinks = true;
+			}
+		}
+		if (has_inlinks == false) {
+			deg_graph_cycles_push(&traversal_stack, node);
+		}
+		else {
+			node->tag = NODE_NOT_VISITED;
+		}
+		node->done = 0;
+	}
+	deg_graph_cycles_traverse(&traversal_stack);
+}
+
+void deg_graph_detect_cycles(Depsgraph *graph,
+                             const vector<OperationDepsNode *> &nodes)
+{
+	/* Any new cycle goes through one of the rebuilt relations, and those are
+	 * all connected to the given nodes. So it's enough to only traverse the
+	 * part of the graph which is reachable from them.
+	 */
+	foreach (OperationDepsNode *node, graph->operations) {
+		node->tag = NODE_NOT_VISITED;
+		node->done = 0;
+	}
+	std::stack<StackEntry> traversal_stack;
+	foreach (OperationDepsNode *node, nodes) {
+		if (node->tag == NODE_NOT_VISITED) {
+			deg_graph_cycles_push(&traversal_stack, node);
+			deg_graph_cycles_traverse(&traversal_stack);
 		}
 	}
 }
@@ -30,11 +30,18 @@
 
 #pragma once
 
+#include "intern/depsgraph_types.h"
+
 namespace DEG {
 
 struct Depsgraph;
+struct OperationDepsNode;
 
 /* Detect and solve dependency cycles. */
 void deg_graph_detect_cycles(Depsgraph *graph);
 
+/* Detect and solve dependency cycles reachable from the given nodes only. */
+void deg_graph_detect_cycles(Depsgraph *graph,
+                             const vector<OperationDepsNode *> &nodes);
+
 }  // namespace DEG
@@ -0,0 +1,404 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2016 Blender Foundation.
+ * All rights reserved.
+ *
+ * Original Author: Sergey Sharybin
+ * Contributor(s): None Yet
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/depsgraph/intern/builder/deg_builder_incremental.cc
+ *  \ingroup depsgraph
+ *
+ * Incremental update of the dependency graph relations.
+ *
+ * Relations of an object are created by the builder of that object and are
+ * pointing to the nodes of the object itself or to the nodes of its data.
+ * This makes it possible to rebuild relations of a single object without
+ * touching the rest of the graph:
+ *
+ * - Nodes of tagged objects and their data are removed together with all
+ *   relations to and from them, and are built again.
+ * - Objects which had relations to the removed nodes have their incoming
+ *   relations removed and rebuilt.
+ *
+ * Cases where relations are added to the object from outside of its builder
+ * (proxies, dupli-groups, rigid body, metaballs, scene level drivers and so
+ * on) are not handled, full graph rebuild is used for them.
+ */
+
+#include "intern/builder/deg_builder_incremental.h"
+
+#include "MEM_guardedalloc.h"
+
+extern "C" {
+#include "BLI_utildefines.h"
+#include "BLI_ghash.h"
+
+#include "DNA_key_types.h"
+#include "DNA_node_types.h"
+#include "DNA_object_types.h"
+#include "DNA_scene_types.h"
+
+#include "BKE_global.h"
+#include "BKE_key.h"
+#include "BKE_library.h"
+#include "BKE_main.h"
+#include "BKE_node.h"
+} /* extern "C" */
+
+#include "intern/builder/deg_builder.h"
+#include "intern/builder/deg_builder_cycle.h"
+#include "intern/builder/deg_builder_nodes.h"
+#include "intern/builder/deg_builder_relations.h"
+#include "intern/builder/deg_builder_transitive.h"
+
+#include "intern/nodes/deg_node.h"
+#include "intern/nodes/deg_node_component.h"
+#include "intern/nodes/deg_node_operation.h"
+
+#include "intern/depsgraph.h"
+
+#include "util/deg_util_foreach.h"
+
+namespace DEG {
+
+namespace {
+
+/* Relations to those objects are added from outside of their own builder,
+ * so they can not be rebuilt in isolation.
+ */
+bool object_needs_full_rebuild(const Object *ob)
+{
+	return (ob->proxy != NULL ||
+	        ob->proxy_from != NULL ||
+	        ob->dup_group != NULL ||
+	        ob->rigidbody_object != NULL ||
+	        ob->rigidbody_constraint != NULL ||
+	        ob->type == OB_MBALL);
+}
+
+/* Data which is built as a part of the object. */
+void add_object_data_ids(Object *ob, GSet *ids)
+{
+	if (ob->data == NULL) {
+		return;
+	}
+	BLI_gset_add(ids, ob->data);
+	Key *key = BKE_key_from_object(ob);
+	if (key != NULL) {
+		BLI_gset_add(ids, &key->id);
+	}
+}
+
+/* Object which is connected with removed node via given one is to have its
+ * relations rebuilt.
+ */
+bool add_relation_neighbour(DepsNode *node,
+                            GSet *removed_ids,
+                            GSet *rebuild_objects)
+{
+	if (node->type == DEPSNODE_TYPE_TIMESOURCE) {
+		/* Time source relations are created by the object builders. */
+		return true;
+	}
+	if (node->type != DEPSNODE_TYPE_OPERATION) {
+		return false;
+	}
+	ID *id = ((OperationDepsNode *)node)->owner->owner->id;
+	if (BLI_gset_haskey(removed_ids, id)) {
+		return true;
+	}
+	if (GS(id->name) != ID_OB || object_needs_full_rebuild((Object *)id)) {
+		return false;
+	}
+	BLI_gset_add(rebuild_objects, id);
+	return true;
+}
+
+bool collect_ids(Depsgraph *graph,
+                 Scene *scene,
+                 GSet *removed_ids,
+                 GSet *rebuild_objects)
+{
+	GSET_FOREACH_BEGIN(ID *, id, graph->id_relations_tags)
+	{
+		if (graph->find_id_node(id) == NULL) {
+			/* Nothing is depending on the ID, which means it is not used by
+			 * the scene at all.
+			 */
+			continue;
+		}
+		if (GS(id->name) != ID_OB || object_needs_full_rebuild((Object *)id)) {
+			return false;
+		}
+		BLI_gset_add(removed_ids, id);
+		BLI_gset_add(rebuild_objects, id);
+	}
+	GSET_FOREACH_END();
+
+	/* Data is removed and rebuilt together with the object. */
+	GSET_FOREACH_BEGIN(Object *, ob, rebuild_objects)
+	{
+		add_object_data_ids(ob, removed_ids);
+	}
+	GSET_FOREACH_END();
+
+	/* Objects which are connected to the removed nodes will lose some of
+	 * their relations.
+	 */
+	GSET_FOREACH_BEGIN(ID *, id, removed_ids)
+	{
+		IDDepsNode *id_node = graph->find_id_node(id);
+		if (id_node == NULL) {
+			continue;
+		}
+		GHASH_FOREACH_BEGIN(ComponentDepsNode *, comp_node, id_node->components)
+		{
+			GHASH_FOREACH_BEGIN(OperationDepsNode *, op_node, comp_node->operations_map)
+			{
+				foreach (DepsRelation *rel, op_node->inlinks) {
+					if (!add_relation_neighbour(rel->from, removed_ids, rebuild_objects)) {
+						return false;
+					}
+				}
+				foreach (DepsRelation *rel, op_node->outlinks) {
+					if (!add_relation_neighbour(rel->to, removed_ids, rebuild_objects)) {
+						return false;
+					}
+				}
+			}
+			GHASH_FOREACH_END();
+		}
+		GHASH_FOREACH_END();
+	}
+	GSET_FOREACH_END();
+
+	/* Relations are only built for objects from the scene bases, objects
+	 * which are only referenced by other ones get their relations from the
+	 * builders of those, which we can't easily track down.
+	 */
+	GSet *scene_objects = BLI_gset_ptr_new(__func__);
+	LINKLIST_FOREACH (Base *, base, &scene->base) {
+		if (BLI_gset_haskey(rebuild_objects, base->object)) {
+			BLI_gset_add(scene_objects, base->object);
+		}
+	}
+	const bool all_in_scene = (BLI_gset_size(scene_objects) ==
+	                           BLI_gset_size(rebuild_objects));
+	BLI_gset_free(scene_objects, NULL);
+	return all_in_scene;
+}
+
+void remove_relations(DepsNode::Relations *relations)
+{
+	while (!relations->empty()) {
+		DepsRelation *rel = relations->back();
+		rel->unlink();
+		OBJECT_GUARDED_DELETE(rel, DepsRelation);
+	}
+}
+
+void remove_id_nodes(Depsgraph *graph, GSet *removed_ids)
+{
+	/* Exclude operations from the graph-wide list. */
+	int num_operations = 0;
+	foreach (OperationDepsNode *op_node, graph->operations) {
+		if (!BLI_gset_haskey(removed_ids, op_node->owner->owner->id)) {
+			graph->operations[num_operations++] = op_node;
+		}
+	}
+	graph->operations.resize(num_operations);
+
+	GSET_FOREACH_BEGIN(ID *, id, removed_ids)
+	{
+		IDDepsNode *id_node = graph->find_id_node(id);
+		if (id_node == NULL) {
+			continue;
+		}
+		GHASH_FOREACH_BEGIN(ComponentDepsNode *, comp_node, id_node->components)
+		{
+			GHASH_FOREACH_BEGIN(OperationDepsNode *, op_node, comp_node->operations_map)
+			{
+				remove_relations(&op_node->inlinks);
+				remove_relations(&op_node->outlinks);
+				BLI_gset_remove(graph->entry_tags, op_node, NULL);
+			}
+			GHASH_FOREACH_END();
+		}
+		GHASH_FOREACH_END();
+		graph->remove_id_node(id);
+	}
+	GSET_FOREACH_END();
+}
+
+void remove_id_node_inlinks(IDDepsNode *id_node)
+{
+	GHASH_FOREACH_BEGIN(ComponentDepsNode *, comp_node, id_node->components)
+	{
+		GHASH_FOREACH_BEGIN(OperationDepsNode *, op_node, comp_node->operations_map)
+		{
+			remove_relations(&op_node->inlinks);
+		}
+		GHASH_FOREACH_END();
+	}
+	GHASH_FOREACH_END();
+}
+
+void clear_id_tags(Main *bmain)
+{
+	BKE_main_id_tag_all(bmain, LIB_TAG_DOIT, false);
+	/* XXX nested node trees are not included in tag-clearing above,
+	 * so we need to do this manually.
+	 */
+	FOREACH_NODETREE(bmain, nodetree, id) {
+		if (id != (ID *)nodetree)
+			nodetree->id.tag &= ~LIB_TAG_DOIT;
+	} FOREACH_NODETREE_END
+}
+
+}  // namespace
+
+bool deg_graph_build_incremental(Depsgraph *graph, Main *bmain, Scene *scene)
+{
+	/* Objects from the set scene and scene-level rigid body are not tracked
+	 * per object.
+	 */
+	if (scene->set != NULL || scene->rigidbody_world != NULL) {
+		return false;
+	}
+
+	/* 1) Find out which part of the graph is affected. */
+	GSet *removed_ids = BLI_gset_ptr_new(__func__);
+	GSet *rebuild_objects = BLI_gset_ptr_new(__func__);
+	if (!collect_ids(graph, scene, removed_ids, rebuild_objects)) {
+		BLI_gset_free(removed_ids, NULL);
+		BLI_gset_free(rebuild_objects, NULL);
+		return false;
+	}
+
+	/* IDs which relations are to be rebuilt: objects and their data. */
+	GSet *rebuild_ids = BLI_gset_ptr_new(__func__);
+	GSET_FOREACH_BEGIN(Object *, ob, rebuild_objects)
+	{
+		BLI_gset_add(rebuild_ids, ob);
+		add_object_data_ids(ob, rebuild_ids);
+	}
+	GSET_FOREACH_END();
+
+	/* 2) Remove nodes of tagged objects and incoming relations of the other
+	 *    affected objects.
+	 */
+	remove_id_nodes(graph, removed_ids);
+	GSET_FOREACH_BEGIN(ID *, id, rebuild_ids)
+	{
+		IDDepsNode *id_node = graph->find_id_node(id);
+		if (id_node != NULL) {
+			remove_id_node_inlinks(id_node);
+		}
+	}
+	GSET_FOREACH_END();
+
+	/* 3) Build nodes for the removed objects.
+	 *
+	 * LIB_TAG_DOIT is set for all IDs which are still in the graph, so the
+	 * builder only creates nodes for removed and newly referenced IDs.
+	 */
+	clear_id_tags(bmain);
+	vector<ID *> kept_ids;
+	kept_ids.reserve(BLI_ghash_size(graph->id_hash));
+	GHASH_FOREACH_BEGIN(IDDepsNode *, id_node, graph->id_hash)
+	{
+		id_node->id->tag |= LIB_TAG_DOIT;
+		kept_ids.push_back(id_node->id);
+	}
+	GHASH_FOREACH_END();
+
+	DepsgraphNodeBuilder node_builder(bmain, graph);
+	LINKLIST_FOREACH (Base *, base, &scene->base) {
+		Object *ob = base->object;
+		if (BLI_gset_haskey(removed_ids, ob)) {
+			node_builder.build_object(scene, base, ob);
+		}
+	}
+
+	/* 4) Build relations of the affected objects.
+	 *
+	 * Newly referenced IDs don't have any relations yet, so they are built
+	 * as well.
+	 */
+	clear_id_tags(bmain);
+	foreach (ID *id, kept_ids) {
+		if (!BLI_gset_haskey(rebuild_ids, id)) {
+			id->tag |= LIB_TAG_DOIT;
+		}
+	}
+
+	DepsgraphRelationBuilder relation_builder(graph);
+	LINKLIST_FOREACH (Base *, base, &scene->base) {
+		Object *ob = base->object;
+		if (BLI_gset_haskey(rebuild_objects, ob)) {
+			relation_builder.build_object(bmain, scene, ob);
+		}
+	}
+
+	/* Collect operations which relations were rebuilt, and sync custom data
+	 * masks the same way DepsgraphRelationBuilder::build_scene() does.
+	 */
+	vector<OperationDepsNode *> rebuilt_operations;
+	GSET_FOREACH_BEGIN(ID *, id, rebuild_ids)
+	{
+		IDDepsNode *id_node = graph->find_id_node(id);
+		if (id_node == NULL) {
+			continue;
+		}
+		GHASH_FOREACH_BEGIN(ComponentDepsNode *, comp_node, id_node->components)
+		{
+			GHASH_FOREACH_BEGIN(OperationDepsNode *, op_node, comp_node->operations_map)
+			{
+				rebuilt_operations.push_back(op_node);
+				if (GS(id->name) == ID_OB) {
+					Object *object = (Object *)id;
+					object->customdata_mask |= op_node->customdata_mask;
+				}
+			}
+			GHASH_FOREACH_END();
+		}
+		GHASH_FOREACH_END();
+	}
+	GSET_FOREACH_END();
+
+	/* 5) Detect and solve cycles and simplify the graph only around the
+	 *    rebuilt relations, then flush visibility layers same as the full
+	 *    build does.
+	 */
+	deg_graph_detect_cycles(graph, rebuilt_operations);
+	if (G.debug_value == 799) {
+		deg_graph_transitive_reduction(graph, rebuilt_operations);
+	}
+	deg_graph_build_finalize(graph);
+
+	BLI_gset_free(removed_ids, NULL);
+	BLI_gset_free(rebuild_objects, NULL);
+	BLI_gset_free(rebuild_ids, NULL);
+	return true;
+}
+
+}  // namespace DEG
@@ -64,14 +64,16 @@ enum {
 	OP_REACHABLE = 2,
 };
 
-static void deg_graph_tag_paths_recursive(DepsNode *node)
+static void deg_graph_tag_paths_recursive(DepsNode *node,
+                                          vector<DepsNode *> *tagged_nodes)
 {
 	if (node->done & OP_VISITED) {
 		return;
 	}
 	node->done |= OP_VISITED;
+	tagged_nodes->push_back(node);
 	foreach (DepsRelation *rel, node->inlinks) {
-		deg_graph_tag_paths_recursive(rel->from);
+		deg_graph_tag_paths_recursive(rel->from, tagged_nodes);
 		/* Do this only in inlinks loop, so the target node does not get
 		 * flagged.
 		 */
@@ -79,43 +81,64 @@ static void deg_graph_tag_paths_recursive(DepsNode *node)
 	}
 }
 
-void deg_graph_transitive_reduction(Depsgraph *graph)
+static void deg_graph_transitive_reduction_target(
+        OperationDepsNode *target,
+        vector<DepsNode *> *tagged_nodes)
 {
-	foreach (OperationDepsNode *target, graph->operations) {
-		/* Clear tags. */
-		foreach (OperationDepsNode *node, graph->operations) {
-			node->done = 0;
-		}
+	/* mark nodes from which we can reach the target
+	 * start with children, so the target node and direct children are not
+	 * flagged.
+	 */
+	target->done |= OP_VISITED;
+	tagged_nodes->push_back(target);
+	foreach (DepsRelation *rel, target->inlinks) {
+		deg_graph_tag_paths_recursive(rel->from, tagged_nodes);
+	}
 
-		/* mark nodes from which we can reach the target
-		 * start with children, so the target node and direct children are not
-		 * flagged.
-		 */
-		target->done |= OP_VISITED;
-		foreach (DepsRelation *rel, target->inlinks) {
-			deg_graph_tag_paths_recursive(rel->from);
+	/* Remove redundant paths to the target. */
+	for (int i = 0; i < target->inlinks.size(); ) {
+		DepsRelation *rel = target->inlinks[i];
+		if (rel->from->type == DEPSNODE_TYPE_TIMESOURCE) {
+			/* HACK: time source nodes don't get "done" flag set/cleared. */
+			/* TODO: there will be other types in future, so iterators above
+			 * need modifying.
+			 */
+			++i;
 		}
-
-		/* Remove redundant paths to the target. */
-		for (DepsNode::Relations::const_iterator it_rel = target->inlinks.begin();
-		     it_rel != target->inlinks.end();
-		     )
-		{
-			DepsRelation *rel = *it_rel;
-			/* Increment in advance, so we can safely remove the relation. */
-			++it_rel;
-
-			if (rel->from->type == DEPSNODE_TYPE_TIMESOURCE) {
-				/* HACK: time source nodes don't get "done" flag set/cleared. */
-				/* TODO: there will be other types in future, so iterators above
-				 * need modifying.
-				 */
-			}
-			else if (rel->from->done & OP_REACHABLE) {
-				OBJECT_GUARDED_DELETE(rel, DepsRelation);
-			}
+		else if (rel->from->done & OP_REACHABLE) {
+			/* Unlinking removes relation from inlinks, so no need to
+			 * increment the index.
+			 */
+			rel->unlink();
+			OBJECT_GUARDED_DELETE(rel, DepsRelation);
+		}
+		else {
+			++i;
 		}
 	}
+
+	/* Clear tags, only touching nodes which were visited. */
+	foreach (DepsNode *node, *tagged_nodes) {
+		node->done = 0;
+	}
+	tagged_nodes->clear();
+}
+
+void deg_graph_transitive_reduction(Depsgraph *graph)
+{
+	deg_graph_transitive_reduction(graph, graph->operations);
+}
+
+void deg_graph_transitive_reduction(Depsgraph *graph,
+                                    const vector<OperationDepsNode *> &targets)
+{
+	vector<DepsNode *> tagged_nodes;
+	foreach (OperationDepsNode *node, graph->operations) {
+		node->done = 0;
+	}
+	foreach (OperationDepsNode *target, targets) {
+		deg_graph_transitive_reduction_target(target, &tagged_nodes);
+	}
 }
 
 }  // namespace DEG
@@ -30,11 +30,18 @@
 
 #pragma once
 
+#include "intern/depsgraph_types.h"
+
 namespace DEG {
 
 struct Depsgraph;
+struct OperationDepsNode;
 
 /* Performs a transitive reduction to remove redundant relations. */
 void deg_graph_transitive_reduction(Depsgraph *graph);
 
+/* Remove redundant relations leading to the given nodes only. */
+void deg_graph_transitive_reduction(Depsgraph *graph,
+                                    const vector<OperationDepsNode *> &targets);
+
 }  // namespace DEG
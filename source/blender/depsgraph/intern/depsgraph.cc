@@ -77,6 +77,7 @@ Depsgraph::Depsgraph()
 	id_hash = BLI_ghash_ptr_new("Depsgraph id hash");
 	subgraphs = BLI_gset_ptr_new("Depsgraph subgraphs");
 	entry_tags = BLI_gset_ptr_new("Depsgraph entry_tags");
+	id_relations_tags = BLI_gset_ptr_new("Depsgraph id_relations_tags");
 }
 
 Depsgraph::~Depsgraph()
@@ -87,6 +88,7 @@ Depsgraph::~Depsgraph()
 	BLI_ghash_free(id_hash, NULL, NULL);
 	BLI_gset_free(subgraphs, NULL);
 	BLI_gset_free(entry_tags, NULL);
+	BLI_gset_free(id_relations_tags, NULL);
 	if (this->root_node != NULL) {
 		OBJECT_GUARDED_DELETE(this->root_node, RootDepsNode);
 	}
@@ -454,6 +456,30 @@ DepsRelation::~DepsRelation()
 	BLI_assert(this->from && this->to);
 }
 
+static void remove_relation_from_links(DepsNode::Relations *links,
+                                       DepsRelation *rel)
+{
+	/* Relations are usually removed in the reverse order of creation, so
+	 * start lookup from the end.
+	 */
+	for (DepsNode::Relations::reverse_iterator it = links->rbegin();
+	     it != links->rend();
+	     ++it)
+	{
+		if (*it == rel) {
+			links->erase((++it).base());
+			return;
+		}
+	}
+	BLI_assert(!"Relation is not linked to the node");
+}
+
+void DepsRelation::unlink()
+{
+	remove_relation_from_links(&from->outlinks, this);
+	remove_relation_from_links(&to->inlinks, this);
+}
+
 /* Low level tagging -------------------------------------- */
 
 /* Tag a specific node as needing updates. */
@@ -473,6 +499,7 @@ void Depsgraph::clear_all_nodes()
 {
 	clear_id_nodes();
 	clear_subgraph_nodes();
+	priority_order.clear();
 	BLI_ghash_clear(id_hash, NULL, NULL);
 	if (this->root_node) {
 		OBJECT_GUARDED_DELETE(this->root_node, RootDepsNode);
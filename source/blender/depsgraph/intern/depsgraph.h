@@ -88,6 +88,9 @@ struct DepsRelation {
 	             const char *description);
 
 	~DepsRelation();
+
+	/* Remove relation from the nodes it connects. */
+	void unlink();
 };
 
 /* ********* */
@@ -156,6 +159,11 @@ struct Depsgraph {
 	/* Indicates whether relations needs to be updated. */
 	bool need_update;
 
+	/* IDs which relations are to be updated. Used to rebuild only affected
+	 * part of the graph when need_update is not set.
+	 */
+	GSet *id_relations_tags;
+
 	/* Quick-Access Temp Data ............. */
 
 	/* Nodes which have been tagged as "directly modified". */
@@ -167,6 +175,12 @@ struct Depsgraph {
 	/* All operation nodes, sorted in order of single-thread traversal order. */
 	OperationNodes operations;
 
+	/* Operation nodes with the ones depending on them first (reverse
+	 * topological order), set when building the graph so evaluation
+	 * priorities are calculated in a single pass.
+	 */
+	OperationNodes priority_order;
+
 	/* Spin lock for threading-critical operations.
 	 * Mainly used by graph evaluation.
 	 */
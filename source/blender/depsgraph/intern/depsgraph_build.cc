@@ -61,6 +61,7 @@ extern "C" {
 
 #include "builder/deg_builder.h"
 #include "builder/deg_builder_cycle.h"
+#include "builder/deg_builder_incremental.h"
 #include "builder/deg_builder_nodes.h"
 #include "builder/deg_builder_relations.h"
 #include "builder/deg_builder_transitive.h"
@@ -276,6 +277,32 @@ void DEG_relations_tag_update(Main *bmain)
 	}
 }
 
+/* Tag relations of the given ID for update. */
+void DEG_id_tag_relations_update(Main *bmain, ID *id)
+{
+	for (Scene *scene = (Scene *)bmain->scene.first;
+	     scene != NULL;
+	     scene = (Scene *)scene->id.next)
+	{
+		if (scene->depsgraph == NULL) {
+			continue;
+		}
+		DEG::Depsgraph *deg_graph =
+		        reinterpret_cast<DEG::Depsgraph *>(scene->depsgraph);
+		if (deg_graph->need_update) {
+			/* Full rebuild is scheduled already. */
+			continue;
+		}
+		if (GS(id->name) == ID_OB) {
+			BLI_gset_add(deg_graph->id_relations_tags, id);
+		}
+		else {
+			/* Only object level relations can be updated incrementally. */
+			deg_graph->need_update = true;
+		}
+	}
+}
+
 /* Create new graph if didn't exist yet,
  * or update relations if graph was tagged for update.
  */
@@ -290,14 +317,27 @@ void DEG_scene_relations_update(Main *bmain, Scene *scene)
 
 	DEG::Depsgraph *graph = reinterpret_cast<DEG::Depsgraph *>(scene->depsgraph);
 	if (!graph->need_update) {
-		/* Graph is up to date, nothing to do. */
-		return;
+		if (BLI_gset_size(graph->id_relations_tags) == 0) {
+			/* Graph is up to date, nothing to do. */
+			return;
+		}
+		/* Only relations of some objects changed, try to only rebuild the
+		 * affected part of the graph.
+		 */
+		const bool updated = DEG::deg_graph_build_incremental(graph,
+		                                                      bmain,
+		                                                      scene);
+		BLI_gset_clear(graph->id_relations_tags, NULL);
+		if (updated) {
+			return;
+		}
 	}
 
 	/* Clear all previous nodes and operations. */
 	graph->clear_all_nodes();
 	graph->operations.clear();
 	BLI_gset_clear(graph->entry_tags, NULL);
+	BLI_gset_clear(graph->id_relations_tags, NULL);
 
 	/* Build new nodes and relations. */
 	DEG_graph_build_from_scene(reinterpret_cast< ::Depsgraph * >(graph),
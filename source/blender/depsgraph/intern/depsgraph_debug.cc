@@ -65,6 +65,21 @@ DepsgraphStatsID *DEG_stats_id(ID *id)
 	return DEG::DepsgraphDebug::get_id_stats(id, false);
 }
 
+void DEG_debug_profile_begin(const char *trace_filepath)
+{
+	DEG::DepsgraphDebug::profile_begin(trace_filepath);
+}
+
+bool DEG_debug_profile_end(void)
+{
+	return DEG::DepsgraphDebug::profile_end();
+}
+
+bool DEG_debug_profile_is_running(void)
+{
+	return DEG::DepsgraphDebug::profile_is_running();
+}
+
 bool DEG_debug_compare(const struct Depsgraph *graph1,
                        const struct Depsgraph *graph2)
 {
@@ -154,6 +154,25 @@ void DEG_evaluate_on_framechange(EvaluationContext *eval_ctx,
 	DEG::deg_evaluate_on_refresh(eval_ctx, deg_graph, layers);
 }
 
+/* Frame-change evaluation of the given IDs only. */
+void DEG_evaluate_ids_on_framechange(EvaluationContext *eval_ctx,
+                                     Main *bmain,
+                                     Depsgraph *graph,
+                                     float ctime,
+                                     const unsigned int layers,
+                                     ID **ids,
+                                     int num_ids)
+{
+	DEG::Depsgraph *deg_graph = reinterpret_cast<DEG::Depsgraph *>(graph);
+	/* Update time on primary timesource. */
+	DEG::TimeSourceDepsNode *tsrc = deg_graph->find_time_source();
+	tsrc->cfra = ctime;
+	tsrc->tag_update(deg_graph);
+	DEG::deg_graph_flush_updates(bmain, deg_graph);
+	/* Perform recalculation updates of the requested part of the graph. */
+	DEG::deg_evaluate_ids_on_refresh(eval_ctx, deg_graph, layers, ids, num_ids);
+}
+
 bool DEG_needs_eval(Depsgraph *graph)
 {
 	DEG::Depsgraph *deg_graph = reinterpret_cast<DEG::Depsgraph *>(graph);
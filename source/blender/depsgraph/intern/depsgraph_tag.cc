@@ -42,6 +42,7 @@ extern "C" {
 #include "DNA_screen_types.h"
 #include "DNA_windowmanager_types.h"
 
+#include "BLI_ghash.h"
 #include "BLI_task.h"
 
 #include "BKE_idcode.h"
@@ -415,3 +416,57 @@ void DEG_ids_clear_recalc(Main *bmain)
 
 	memset(bmain->id_tag_update, 0, sizeof(bmain->id_tag_update));
 }
+
+void DEG_ids_clear_recalc_evaluated(Main *bmain, Depsgraph *graph)
+{
+	DEG::Depsgraph *deg_graph = reinterpret_cast<DEG::Depsgraph *>(graph);
+	ListBase *lbarray[MAX_LIBARRAY];
+	bNodeTree *ntree;
+	int a;
+
+	/* IDs with operations postponed by partial evaluation are still to be
+	 * updated, they and their ID type keep the recalc tags.
+	 */
+	GSet *postponed_ids = BLI_gset_ptr_new("Depsgraph postponed IDs");
+	GSET_FOREACH_BEGIN(DEG::OperationDepsNode *, node, deg_graph->entry_tags)
+	{
+		BLI_gset_add(postponed_ids, node->owner->owner->id);
+	}
+	GSET_FOREACH_END();
+
+	/* Loop over all ID types. */
+	a  = set_listbasepointers(bmain, lbarray);
+	while (a--) {
+		ListBase *lb = lbarray[a];
+		ID *id = (ID *)lb->first;
+
+		if (id == NULL) {
+			continue;
+		}
+		const int index = BKE_idcode_to_index(GS(id->name));
+		if (!bmain->id_tag_update[index]) {
+			continue;
+		}
+		bool has_postponed = false;
+		for (; id; id = (ID *)id->next) {
+			ntree = ntreeFromID(id);
+			if (BLI_gset_haskey(postponed_ids, id) ||
+			    (ntree != NULL && BLI_gset_haskey(postponed_ids, ntree)))
+			{
+				has_postponed = true;
+				continue;
+			}
+			id->tag &= ~(LIB_TAG_ID_RECALC | LIB_TAG_ID_RECALC_DATA);
+
+			/* Some ID's contain semi-datablock nodetree */
+			if (ntree != NULL) {
+				ntree->id.tag &= ~(LIB_TAG_ID_RECALC | LIB_TAG_ID_RECALC_DATA);
+			}
+		}
+		if (!has_postponed) {
+			bmain->id_tag_update[index] = 0;
+		}
+	}
+
+	BLI_gset_free(postponed_ids, NULL);
+}
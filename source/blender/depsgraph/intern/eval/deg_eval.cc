@@ -32,10 +32,13 @@
 
 #include "intern/eval/deg_eval.h"
 
+#include <algorithm>
+
 #include "PIL_time.h"
 
 extern "C" {
 #include "BLI_utildefines.h"
+#include "BLI_math_base.h"
 #include "BLI_task.h"
 #include "BLI_ghash.h"
 
@@ -55,31 +58,59 @@ extern "C" {
 #include "intern/depsgraph.h"
 #include "util/deg_util_foreach.h"
 
-/* Unfinished and unused, and takes quite some pre-processing time. */
-#undef USE_EVAL_PRIORITY
-
 /* Use integrated debugger to keep track how much each of the nodes was
  * evaluating.
  */
 #undef USE_DEBUGGER
 
+/* Cost assumed for operations which were not evaluated yet, in seconds. */
+#define DEG_EVAL_DEFAULT_COST 1e-4f
+
+/* Operations cheaper than this are evaluated on the thread which made them
+ * ready instead of being pushed to the task pool, in seconds.
+ */
+#define DEG_EVAL_INLINE_COST 2e-5f
+
+/* Maximum number of cheap operations waiting to be evaluated inline. */
+#define DEG_EVAL_INLINE_MAX 32
+
 namespace DEG {
 
 /* ********************** */
 /* Evaluation Entrypoints */
 
+struct DepsgraphEvalState {
+	EvaluationContext *eval_ctx;
+	Depsgraph *graph;
+	unsigned int layers;
+	/* Timings of this evaluation, NULL when not profiling. */
+	DepsgraphProfileEval *profile;
+};
+
+/* Operations which became ready on the current thread and which are to be
+ * evaluated there without going through the task pool.
+ */
+struct DepsgraphEvalInline {
+	/* Most expensive ready operation, continued with once the cheap ones
+	 * are done.
+	 */
+	OperationDepsNode *continuation;
+	OperationDepsNode *cheap[DEG_EVAL_INLINE_MAX];
+	int num_cheap;
+};
+
 /* Forward declarations. */
 static void schedule_children(TaskPool *pool,
                               Depsgraph *graph,
                               OperationDepsNode *node,
                               const unsigned int layers,
-                              const int thread_id);
+                              const int thread_id,
+                              DepsgraphEvalInline *inline_nodes);
 
-struct DepsgraphEvalState {
-	EvaluationContext *eval_ctx;
-	Depsgraph *graph;
-	unsigned int layers;
-};
+BLI_INLINE float node_eval_cost(const OperationDepsNode *node)
+{
+	return (node->eval_cost < 0.0f) ? DEG_EVAL_DEFAULT_COST : node->eval_cost;
+}
 
 static void deg_task_run_func(TaskPool *pool,
                               void *taskdata,
@@ -88,13 +119,16 @@ static void deg_task_run_func(TaskPool *pool,
 	DepsgraphEvalState *state =
 	        reinterpret_cast<DepsgraphEvalState *>(BLI_task_pool_userdata(pool));
 	OperationDepsNode *node = reinterpret_cast<OperationDepsNode *>(taskdata);
+	DepsgraphEvalInline inline_nodes;
+	inline_nodes.continuation = NULL;
+	inline_nodes.num_cheap = 0;
 
 	BLI_assert(!node->is_noop() && "NOOP nodes should not actually be scheduled");
 
 	/* Should only be the case for NOOPs, which never get to this point. */
 	BLI_assert(node->evaluate);
 
-	while (true) {
+	while (node != NULL) {
 		/* Get context. */
 		/* TODO: Who initialises this? "Init" operations aren't able to
 		 * initialise it!!!
@@ -109,8 +143,8 @@ static void deg_task_run_func(TaskPool *pool,
 		 */
 		if (node->evaluate) {
 			/* Take note of current time. */
-#ifdef USE_DEBUGGER
 			double start_time = PIL_check_seconds_timer();
+#ifdef USE_DEBUGGER
 			DepsgraphDebug::task_started(state->graph, node);
 #endif
 
@@ -118,79 +152,41 @@ static void deg_task_run_func(TaskPool *pool,
 			node->evaluate(state->eval_ctx);
 
 			/* Note how long this took. */
-#ifdef USE_DEBUGGER
 			double end_time = PIL_check_seconds_timer();
+#ifdef USE_DEBUGGER
 			DepsgraphDebug::task_completed(state->graph,
 			                               node,
 			                               end_time - start_time);
 #endif
+			if (state->profile) {
+				DepsgraphDebug::profile_task_completed(state->profile,
+				                                       node,
+				                                       thread_id,
+				                                       start_time,
+				                                       end_time);
+			}
+
+			/* Only this thread evaluates the node, so the running average
+			 * can be updated without locking.
+			 */
+			const float cost = (float)(end_time - start_time);
+			node->eval_cost = (node->eval_cost < 0.0f)
+			                  ? cost
+			                  : 0.7f * node->eval_cost + 0.3f * cost;
 		}
 
-		/* If there's only one outgoing link we try to immediately switch to
-		 * that node evaluation, without leaving the thread.
-		 *
-		 * It's only doable if the child don't have extra relations or all they
-		 * are satisfied.
-		 *
-		 * TODO(sergey): Checks here can be de-duplicated with the ones from
-		 * schedule_node(), however, how to do it nicely?
+		/* Children which became ready are either pushed to the pool or, when
+		 * they're cheap or the most expensive one, kept for evaluation in this
+		 * thread so we don't leave the thread until the graph branches.
 		 */
-		if (node->outlinks.size() == 1) {
-			DepsRelation *rel = node->outlinks[0];
-			OperationDepsNode *child = (OperationDepsNode *)rel->to;
-			BLI_assert(child->type == DEPSNODE_TYPE_OPERATION);
-			if (!child->scheduled) {
-				unsigned int id_layers = child->owner->owner->layers;
-				if (!((child->flag & DEPSOP_FLAG_NEEDS_UPDATE) != 0 &&
-				      (id_layers & state->layers) != 0))
-				{
-					/* Node does not need an update, so can;t continue with the
-					 * chain and need to switch to another one by leaving the
-					 * thread.
-					 */
-					break;
-				}
-				if ((rel->flag & DEPSREL_FLAG_CYCLIC) == 0) {
-					BLI_assert(child->num_links_pending > 0);
-					atomic_sub_and_fetch_uint32(&child->num_links_pending, 1);
-				}
-				if (child->num_links_pending == 0) {
-					bool is_scheduled = atomic_fetch_and_or_uint8(
-					        (uint8_t *)&child->scheduled, (uint8_t)true);
-					if (!is_scheduled) {
-						/* Node was not scheduled, switch to it! */
-						node = child;
-					}
-					else {
-						/* Someone else scheduled the node, leaving us
-						 * unemployed in this thread, we're leaving.
-						 */
-						break;
-					}
-				}
-				else {
-					/* There are other dependencies on the child, can't do
-					 * anything in the current thread.
-					 */
-					break;
-				}
-			}
-			else {
-				/* Happens when having cyclic dependencies.
-				 *
-				 * Nothing to do here, single child was already scheduled, we
-				 * can leave the thread now.
-				 */
-				break;
-			}
+		schedule_children(pool, state->graph, node, state->layers, thread_id, &inline_nodes);
+
+		if (inline_nodes.num_cheap != 0) {
+			node = inline_nodes.cheap[--inline_nodes.num_cheap];
 		}
 		else {
-			/* TODO(sergey): It's possible to use one of the outgoing relations
-			 * as a chain which we'll try to keep alive, but it's a bit more
-			 * involved change.
-			 */
-			schedule_children(pool, state->graph, node, state->layers, thread_id);
-			break;
+			node = inline_nodes.continuation;
+			inline_nodes.continuation = NULL;
 		}
 	}
 }
@@ -245,40 +241,50 @@ static void calculate_pending_parents(Depsgraph *graph, unsigned int layers)
 	                        do_threads);
 }
 
-#ifdef USE_EVAL_PRIORITY
-static void calculate_eval_priority(OperationDepsNode *node)
+/* Priority is the estimated time of the most expensive chain of operations
+ * starting at the node, so the critical path gets evaluated first.
+ *
+ * Nodes are visited in the order stored when building the graph, in which the
+ * nodes depending on an operation always come before it.
+ */
+static void calculate_eval_priority(Depsgraph *graph,
+                                    const unsigned int layers)
 {
-	if (node->done) {
-		return;
-	}
-	node->done = 1;
-
-	if (node->flag & DEPSOP_FLAG_NEEDS_UPDATE) {
-		/* XXX standard cost of a node, could be estimated somewhat later on */
-		const float cost = 1.0f;
-		/* NOOP nodes have no cost */
-		node->eval_priority = node->is_noop() ? cost : 0.0f;
-
-		foreach (DepsRelation *rel, node->outlinks) {
-			OperationDepsNode *to = (OperationDepsNode *)rel->to;
-			BLI_assert(to->type == DEPSNODE_TYPE_OPERATION);
-			calculate_eval_priority(to);
-			node->eval_priority += to->eval_priority;
+	BLI_assert(graph->priority_order.size() == graph->operations.size());
+
+	foreach (OperationDepsNode *node, graph->priority_order) {
+		if ((node->flag & DEPSOP_FLAG_NEEDS_UPDATE) != 0 &&
+		    (node->owner->owner->layers & layers) != 0)
+		{
+			float max_child_priority = 0.0f;
+			foreach (DepsRelation *rel, node->outlinks) {
+				OperationDepsNode *to = (OperationDepsNode *)rel->to;
+				BLI_assert(to->type == DEPSNODE_TYPE_OPERATION);
+				if ((rel->flag & DEPSREL_FLAG_CYCLIC) != 0) {
+					continue;
+				}
+				max_child_priority = max_ff(max_child_priority, to->eval_priority);
+			}
+			/* NOOP nodes have no cost */
+			node->eval_priority = max_child_priority +
+			                      (node->is_noop() ? 0.0f : node_eval_cost(node));
+		}
+		else {
+			node->eval_priority = 0.0f;
 		}
-	}
-	else {
-		node->eval_priority = 0.0f;
 	}
 }
-#endif
 
 /* Schedule a node if it needs evaluation.
  *   dec_parents: Decrement pending parents count, true when child nodes are
  *                scheduled after a task has been completed.
+ *   inline_nodes: Operations to be evaluated in the current thread, NULL when
+ *                 not called from a task.
  */
 static void schedule_node(TaskPool *pool, Depsgraph *graph, unsigned int layers,
                           OperationDepsNode *node, bool dec_parents,
-                          const int thread_id)
+                          const int thread_id,
+                          DepsgraphEvalInline *inline_nodes)
 {
 	unsigned int id_layers = node->owner->owner->layers;
 
@@ -296,28 +302,70 @@ static void schedule_node(TaskPool *pool, Depsgraph *graph, unsigned int layers,
 			if (!is_scheduled) {
 				if (node->is_noop()) {
 					/* skip NOOP node, schedule children right away */
-					schedule_children(pool, graph, node, layers, thread_id);
+					schedule_children(pool, graph, node, layers, thread_id, inline_nodes);
+					return;
+				}
+				if (inline_nodes != NULL) {
+					/* Merge cheap operations into the current task. */
+					if (node_eval_cost(node) < DEG_EVAL_INLINE_COST &&
+					    inline_nodes->num_cheap < DEG_EVAL_INLINE_MAX)
+					{
+						inline_nodes->cheap[inline_nodes->num_cheap++] = node;
+						return;
+					}
+					/* Keep the most expensive chain in this thread, others
+					 * go to the pool.
+					 */
+					if (inline_nodes->continuation == NULL) {
+						inline_nodes->continuation = node;
+						return;
+					}
+					if (node->eval_priority > inline_nodes->continuation->eval_priority) {
+						std::swap(node, inline_nodes->continuation);
+					}
 				}
-				else {
-					/* children are scheduled once this task is completed */
-					BLI_task_pool_push_from_thread(pool,
-					                               deg_task_run_func,
-					                               node,
-					                               false,
-					                               TASK_PRIORITY_HIGH,
-					                               thread_id);
+				/* children are scheduled once this task is completed */
+				DepsgraphEvalState *state =
+				        (DepsgraphEvalState *)BLI_task_pool_userdata(pool);
+				if (state->profile) {
+					DepsgraphDebug::profile_task_ready(state->profile, node);
 				}
+				BLI_task_pool_push_from_thread(pool,
+				                               deg_task_run_func,
+				                               node,
+				                               false,
+				                               TASK_PRIORITY_HIGH,
+				                               thread_id);
 			}
 		}
 	}
 }
 
+static bool eval_priority_less(const OperationDepsNode *a,
+                               const OperationDepsNode *b)
+{
+	return a->eval_priority < b->eval_priority;
+}
+
 static void schedule_graph(TaskPool *pool,
                            Depsgraph *graph,
                            const unsigned int layers)
 {
+	/* High priority tasks are put in front of the queue, so push the most
+	 * expensive chains last to have them picked up first.
+	 */
+	vector<OperationDepsNode *> ready_nodes;
 	foreach (OperationDepsNode *node, graph->operations) {
-		schedule_node(pool, graph, layers, node, false, 0);
+		if ((node->flag & DEPSOP_FLAG_NEEDS_UPDATE) != 0 &&
+		    (node->owner->owner->layers & layers) != 0 &&
+		    node->num_links_pending == 0)
+		{
+			ready_nodes.push_back(node);
+		}
+	}
+	std::stable_sort(ready_nodes.begin(), ready_nodes.end(), eval_priority_less);
+	foreach (OperationDepsNode *node, ready_nodes) {
+		schedule_node(pool, graph, layers, node, false, 0, NULL);
 	}
 }
 
@@ -325,7 +373,8 @@ static void schedule_children(TaskPool *pool,
                               Depsgraph *graph,
                               OperationDepsNode *node,
                               const unsigned int layers,
-                              const int thread_id)
+                              const int thread_id,
+                              DepsgraphEvalInline *inline_nodes)
 {
 	foreach (DepsRelation *rel, node->outlinks) {
 		OperationDepsNode *child = (OperationDepsNode *)rel->to;
@@ -339,29 +388,18 @@ static void schedule_children(TaskPool *pool,
 		              layers,
 		              child,
 		              (rel->flag & DEPSREL_FLAG_CYCLIC) == 0,
-		              thread_id);
+		              thread_id,
+		              inline_nodes);
 	}
 }
 
-/**
- * Evaluate all nodes tagged for updating,
- * \warning This is usually done as part of main loop, but may also be
- * called from frame-change update.
- *
- * \note Time sources should be all valid!
+/* Schedule and evaluate all operations tagged for update, tags are left
+ * for the caller to clear.
  */
-void deg_evaluate_on_refresh(EvaluationContext *eval_ctx,
-                             Depsgraph *graph,
-                             const unsigned int layers)
+static void deg_evaluate_tagged(EvaluationContext *eval_ctx,
+                                Depsgraph *graph,
+                                const unsigned int layers)
 {
-	/* Generate base evaluation context, upon which all the others are derived. */
-	// TODO: this needs both main and scene access...
-
-	/* Nothing to update, early out. */
-	if (BLI_gset_size(graph->entry_tags) == 0) {
-		return;
-	}
-
 	/* Set time for the current graph evaluation context. */
 	TimeSourceDepsNode *time_src = graph->find_time_source();
 	eval_ctx->ctime = time_src->cfra;
@@ -371,6 +409,7 @@ void deg_evaluate_on_refresh(EvaluationContext *eval_ctx,
 	state.eval_ctx = eval_ctx;
 	state.graph = graph;
 	state.layers = layers;
+	state.profile = NULL;
 
 	TaskScheduler *task_scheduler = BLI_task_scheduler_get();
 	TaskPool *task_pool = BLI_task_pool_create(task_scheduler, &state);
@@ -381,29 +420,135 @@ void deg_evaluate_on_refresh(EvaluationContext *eval_ctx,
 
 	calculate_pending_parents(graph, layers);
 
-	/* Clear tags. */
-	foreach (OperationDepsNode *node, graph->operations) {
-		node->done = 0;
-	}
-
 	/* Calculate priority for operation nodes. */
-#ifdef USE_EVAL_PRIORITY
-	foreach (OperationDepsNode *node, graph->operations) {
-		calculate_eval_priority(node);
-	}
-#endif
+	calculate_eval_priority(graph, layers);
 
 	DepsgraphDebug::eval_begin(eval_ctx);
+	state.profile = DepsgraphDebug::profile_eval_begin(graph);
 
 	schedule_graph(task_pool, graph, layers);
 
 	BLI_task_pool_work_and_wait(task_pool);
 	BLI_task_pool_free(task_pool);
 
+	if (state.profile) {
+		DepsgraphDebug::profile_eval_end(graph, state.profile);
+	}
 	DepsgraphDebug::eval_end(eval_ctx);
+}
+
+/**
+ * Evaluate all nodes tagged for updating,
+ * \warning This is usually done as part of main loop, but may also be
+ * called from frame-change update.
+ *
+ * \note Time sources should be all valid!
+ */
+void deg_evaluate_on_refresh(EvaluationContext *eval_ctx,
+                             Depsgraph *graph,
+                             const unsigned int layers)
+{
+	/* Generate base evaluation context, upon which all the others are derived. */
+	// TODO: this needs both main and scene access...
+
+	/* Nothing to update, early out. */
+	if (BLI_gset_size(graph->entry_tags) == 0) {
+		return;
+	}
+
+	deg_evaluate_tagged(eval_ctx, graph, layers);
 
 	/* Clear any uncleared tags - just in case. */
 	deg_graph_clear_tags(graph);
 }
 
+/* Mark operations which are to be evaluated in order to get the given IDs
+ * up to date, using the scheduled flag.
+ *
+ * Only tagged operations are followed: tags are flushed to all descendants,
+ * so untagged operations can't depend on anything which is to be evaluated.
+ */
+static void mark_ids_dependencies(Depsgraph *graph, ID **ids, int num_ids)
+{
+	vector<OperationDepsNode *> stack;
+	foreach (OperationDepsNode *node, graph->operations) {
+		node->scheduled = false;
+	}
+	for (int i = 0; i < num_ids; ++i) {
+		IDDepsNode *id_node = graph->find_id_node(ids[i]);
+		if (id_node == NULL) {
+			continue;
+		}
+		GHASH_FOREACH_BEGIN(ComponentDepsNode *, comp_node, id_node->components)
+		{
+			foreach (OperationDepsNode *node, comp_node->operations) {
+				if ((node->flag & DEPSOP_FLAG_NEEDS_UPDATE) != 0 &&
+				    node->scheduled == false)
+				{
+					node->scheduled = true;
+					stack.push_back(node);
+				}
+			}
+		}
+		GHASH_FOREACH_END();
+	}
+	while (!stack.empty()) {
+		OperationDepsNode *node = stack.back();
+		stack.pop_back();
+		foreach (DepsRelation *rel, node->inlinks) {
+			if (rel->from->type != DEPSNODE_TYPE_OPERATION) {
+				continue;
+			}
+			OperationDepsNode *from = (OperationDepsNode *)rel->from;
+			if ((from->flag & DEPSOP_FLAG_NEEDS_UPDATE) != 0 &&
+			    from->scheduled == false)
+			{
+				from->scheduled = true;
+				stack.push_back(from);
+			}
+		}
+	}
+}
+
+/**
+ * Evaluate only those of the nodes tagged for updating which are needed to
+ * get the given IDs up to date.
+ *
+ * Other nodes stay tagged and are used as entry points for the next update,
+ * so the rest of the scene catches up on the next refresh.
+ */
+void deg_evaluate_ids_on_refresh(EvaluationContext *eval_ctx,
+                                 Depsgraph *graph,
+                                 const unsigned int layers,
+                                 ID **ids,
+                                 int num_ids)
+{
+	/* Nothing to update, early out. */
+	if (BLI_gset_size(graph->entry_tags) == 0) {
+		return;
+	}
+
+	mark_ids_dependencies(graph, ids, num_ids);
+
+	/* Hide operations which are not needed from the scheduler. */
+	vector<OperationDepsNode *> postponed_nodes;
+	foreach (OperationDepsNode *node, graph->operations) {
+		if ((node->flag & DEPSOP_FLAG_NEEDS_UPDATE) != 0 &&
+		    node->scheduled == false &&
+		    (node->owner->owner->layers & layers) != 0)
+		{
+			node->flag &= ~DEPSOP_FLAG_NEEDS_UPDATE;
+			postponed_nodes.push_back(node);
+		}
+	}
+
+	deg_evaluate_tagged(eval_ctx, graph, layers);
+	deg_graph_clear_tags(graph);
+
+	foreach (OperationDepsNode *node, postponed_nodes) {
+		node->flag |= DEPSOP_FLAG_NEEDS_UPDATE;
+		BLI_gset_insert(graph->entry_tags, node);
+	}
+}
+
 }  // namespace DEG
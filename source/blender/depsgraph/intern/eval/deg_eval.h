@@ -33,6 +33,7 @@
 #pragma once
 
 struct EvaluationContext;
+struct ID;
 
 namespace DEG {
 
@@ -49,4 +50,14 @@ void deg_evaluate_on_refresh(EvaluationContext *eval_ctx,
                              Depsgraph *graph,
                              const unsigned int layers);
 
+/**
+ * Evaluate nodes tagged for updating which are needed to get the given IDs
+ * up to date, the rest of tagged nodes is kept for the next refresh.
+ */
+void deg_evaluate_ids_on_refresh(EvaluationContext *eval_ctx,
+                                 Depsgraph *graph,
+                                 const unsigned int layers,
+                                 ID **ids,
+                                 int num_ids);
+
 }  // namespace DEG
@@ -33,10 +33,16 @@
 #include "intern/eval/deg_eval_debug.h"
 
 #include <cstring>  /* required for STREQ later on. */
+#include <algorithm>
+#include <map>
+
+#include "PIL_time.h"
 
 extern "C" {
+#include "BLI_fileops.h"
 #include "BLI_listbase.h"
 #include "BLI_ghash.h"
+#include "BLI_threads.h"
 
 #include "DEG_depsgraph_debug.h"
 
@@ -48,10 +54,12 @@ extern "C" {
 #include "intern/nodes/deg_node_component.h"
 #include "intern/nodes/deg_node_operation.h"
 #include "intern/depsgraph_intern.h"
+#include "util/deg_util_foreach.h"
 
 namespace DEG {
 
 DepsgraphStats *DepsgraphDebug::stats = NULL;
+DepsgraphProfile *DepsgraphDebug::profile = NULL;
 
 static string get_component_name(eDepsNode_Type type, const char *name = "")
 {
@@ -155,6 +163,398 @@ void DepsgraphDebug::task_completed(Depsgraph *graph,
 	}
 }
 
+/* ******** */
+/* Profiler */
+
+/* Timing of a single operation evaluation. */
+struct DepsgraphProfileEntry {
+	/* Only valid until the end of the evaluation the entry belongs to. */
+	const OperationDepsNode *node;
+	string name;
+	string category;
+	/* Time at which the operation was pushed to the task pool, same as
+	 * start_time for operations evaluated straight after their parent.
+	 */
+	double ready_time;
+	double start_time;
+	double end_time;
+	int thread_id;
+	/* Entry of the same evaluation which finished last among the ones
+	 * this operation depends on, -1 if none.
+	 */
+	int critical_parent;
+};
+
+/* Accumulated time of an operation on the critical paths. */
+struct DepsgraphProfileCriticalStat {
+	DepsgraphProfileCriticalStat() : count(0), duration(0.0), wait(0.0) {}
+	int count;
+	double duration;
+	double wait;
+};
+
+/* Operations timed by a single evaluation. Every evaluation records into its
+ * own data, so concurrent evaluations of different depsgraphs only meet when
+ * the results are merged into the profile.
+ */
+struct DepsgraphProfileEval {
+	SpinLock lock;
+	double begin_time;
+	vector<DepsgraphProfileEntry> entries;
+	/* <OperationDepsNode : entry index + 1> */
+	GHash *node_entries;
+};
+
+struct DepsgraphProfile {
+	typedef std::map<string, DepsgraphProfileCriticalStat> CriticalStats;
+
+	string trace_filepath;
+	double begin_time;
+	/* Evaluations which are still recording, the profile can't end before
+	 * they merged their entries.
+	 */
+	int num_running_evals;
+
+	vector<DepsgraphProfileEntry> entries;
+	/* Begin and end time of every evaluation. */
+	vector<std::pair<double, double> > evaluations;
+
+	CriticalStats critical_stats;
+	double critical_time;
+};
+
+/* Guards DepsgraphDebug::profile and everything in it. */
+static ThreadMutex profile_lock = BLI_MUTEX_INITIALIZER;
+
+static bool profile_finish(DepsgraphProfile *profile);
+
+bool DepsgraphDebug::profile_is_running()
+{
+	BLI_mutex_lock(&profile_lock);
+	const bool is_running = (profile != NULL);
+	BLI_mutex_unlock(&profile_lock);
+	return is_running;
+}
+
+void DepsgraphDebug::profile_begin(const char *trace_filepath)
+{
+	BLI_mutex_lock(&profile_lock);
+	DepsgraphProfile *prev_profile = profile;
+	if (prev_profile != NULL && prev_profile->num_running_evals != 0) {
+		BLI_mutex_unlock(&profile_lock);
+		printf("Depsgraph profile can't restart while an evaluation is running\n");
+		return;
+	}
+	profile = new DepsgraphProfile();
+	if (trace_filepath) {
+		profile->trace_filepath = trace_filepath;
+	}
+	profile->begin_time = PIL_check_seconds_timer();
+	profile->num_running_evals = 0;
+	profile->critical_time = 0.0;
+	BLI_mutex_unlock(&profile_lock);
+
+	if (prev_profile != NULL) {
+		profile_finish(prev_profile);
+	}
+}
+
+DepsgraphProfileEval *DepsgraphDebug::profile_eval_begin(Depsgraph *UNUSED(graph))
+{
+	BLI_mutex_lock(&profile_lock);
+	if (profile == NULL) {
+		BLI_mutex_unlock(&profile_lock);
+		return NULL;
+	}
+	profile->num_running_evals++;
+	BLI_mutex_unlock(&profile_lock);
+
+	DepsgraphProfileEval *eval = new DepsgraphProfileEval();
+	BLI_spin_init(&eval->lock);
+	eval->begin_time = PIL_check_seconds_timer();
+	eval->node_entries = BLI_ghash_ptr_new("Depsgraph Profile Entries");
+	return eval;
+}
+
+static int profile_entry_index(DepsgraphProfileEval *eval,
+                               const OperationDepsNode *node,
+                               bool create)
+{
+	void **entry_p;
+	if (create) {
+		if (!BLI_ghash_ensure_p(eval->node_entries, (void *)node, &entry_p)) {
+			DepsgraphProfileEntry entry;
+			entry.node = node;
+			entry.ready_time = entry.start_time = entry.end_time = 0.0;
+			entry.thread_id = 0;
+			entry.critical_parent = -1;
+			eval->entries.push_back(entry);
+			*entry_p = SET_INT_IN_POINTER(eval->entries.size());
+		}
+	}
+	else {
+		entry_p = BLI_ghash_lookup_p(eval->node_entries, node);
+		if (entry_p == NULL) {
+			return -1;
+		}
+	}
+	return GET_INT_FROM_POINTER(*entry_p) - 1;
+}
+
+void DepsgraphDebug::profile_task_ready(DepsgraphProfileEval *eval,
+                                        const OperationDepsNode *node)
+{
+	const double ready_time = PIL_check_seconds_timer();
+	BLI_spin_lock(&eval->lock);
+	const int index = profile_entry_index(eval, node, true);
+	eval->entries[index].ready_time = ready_time;
+	BLI_spin_unlock(&eval->lock);
+}
+
+void DepsgraphDebug::profile_task_completed(DepsgraphProfileEval *eval,
+                                            const OperationDepsNode *node,
+                                            int thread_id,
+                                            double start_time,
+                                            double end_time)
+{
+	BLI_spin_lock(&eval->lock);
+	const int index = profile_entry_index(eval, node, true);
+	DepsgraphProfileEntry &entry = eval->entries[index];
+	if (entry.ready_time == 0.0) {
+		entry.ready_time = start_time;
+	}
+	entry.start_time = start_time;
+	entry.end_time = end_time;
+	entry.thread_id = thread_id;
+	BLI_spin_unlock(&eval->lock);
+}
+
+/* Find the evaluated operation which finished last among the ones the given
+ * node depends on, looking through no-op nodes which are never evaluated.
+ */
+static int profile_critical_parent(DepsgraphProfileEval *eval,
+                                   const OperationDepsNode *node,
+                                   GHash *noop_parents)
+{
+	int best_index = -1;
+	foreach (DepsRelation *rel, node->inlinks) {
+		if (rel->from->type != DEPSNODE_TYPE_OPERATION ||
+		    (rel->flag & DEPSREL_FLAG_CYCLIC) != 0)
+		{
+			continue;
+		}
+		OperationDepsNode *from = (OperationDepsNode *)rel->from;
+		int index = profile_entry_index(eval, from, false);
+		if (index == -1 && from->is_noop()) {
+			void **index_p;
+			if (BLI_ghash_ensure_p(noop_parents, from, &index_p)) {
+				index = GET_INT_FROM_POINTER(*index_p);
+			}
+			else {
+				/* Guard against recursing into ourselves. */
+				*index_p = SET_INT_IN_POINTER(-1);
+				index = profile_critical_parent(eval, from, noop_parents);
+				index_p = BLI_ghash_lookup_p(noop_parents, from);
+				*index_p = SET_INT_IN_POINTER(index);
+			}
+		}
+		if (index != -1 &&
+		    (best_index == -1 ||
+		     eval->entries[index].end_time > eval->entries[best_index].end_time))
+		{
+			best_index = index;
+		}
+	}
+	return best_index;
+}
+
+void DepsgraphDebug::profile_eval_end(Depsgraph *UNUSED(graph),
+                                      DepsgraphProfileEval *eval)
+{
+	const double eval_end_time = PIL_check_seconds_timer();
+
+	/* Resolve names and dependencies while the nodes are still alive. */
+	GHash *noop_parents = BLI_ghash_ptr_new("Depsgraph Profile NOOP Parents");
+	int last_index = -1;
+	for (size_t i = 0; i < eval->entries.size(); ++i) {
+		DepsgraphProfileEntry &entry = eval->entries[i];
+		const OperationDepsNode *node = entry.node;
+		entry.name = node->full_identifier();
+		entry.category = deg_get_node_factory(node->owner->type)->tname();
+		entry.critical_parent = profile_critical_parent(eval, node, noop_parents);
+		if (last_index == -1 ||
+		    entry.end_time > eval->entries[last_index].end_time)
+		{
+			last_index = i;
+		}
+	}
+	BLI_ghash_free(noop_parents, NULL, NULL);
+	BLI_ghash_free(eval->node_entries, NULL, NULL);
+	BLI_spin_end(&eval->lock);
+
+	BLI_mutex_lock(&profile_lock);
+	/* Walk the critical path back from the operation which finished last. */
+	for (int index = last_index;
+	     index != -1;
+	     index = eval->entries[index].critical_parent)
+	{
+		const DepsgraphProfileEntry &entry = eval->entries[index];
+		DepsgraphProfileCriticalStat &stat = profile->critical_stats[entry.name];
+		stat.count++;
+		stat.duration += entry.end_time - entry.start_time;
+		stat.wait += entry.start_time - entry.ready_time;
+		profile->critical_time += entry.end_time - entry.ready_time;
+	}
+	const int first_index = (int)profile->entries.size();
+	foreach (DepsgraphProfileEntry &entry, eval->entries) {
+		entry.node = NULL;
+		if (entry.critical_parent != -1) {
+			entry.critical_parent += first_index;
+		}
+		profile->entries.push_back(entry);
+	}
+	profile->evaluations.push_back(std::make_pair(eval->begin_time,
+	                                              eval_end_time));
+	profile->num_running_evals--;
+	BLI_mutex_unlock(&profile_lock);
+
+	delete eval;
+}
+
+static void profile_write_json_string(FILE *f, const string &str)
+{
+	fputc('"', f);
+	for (size_t i = 0; i < str.size(); ++i) {
+		const char c = str[i];
+		if (c == '"' || c == '\\') {
+			fputc('\\', f);
+			fputc(c, f);
+		}
+		else if ((unsigned char)c < 0x20) {
+			fprintf(f, "\\u%04x", (int)c);
+		}
+		else {
+			fputc(c, f);
+		}
+	}
+	fputc('"', f);
+}
+
+/* Write events in Chrome's trace event format, can be loaded by
+ * chrome://tracing and other trace viewers.
+ */
+static bool profile_write_trace(const DepsgraphProfile *profile, const char *filepath)
+{
+	FILE *f = BLI_fopen(filepath, "w");
+	if (f == NULL) {
+		return false;
+	}
+	const double begin_time = profile->begin_time;
+	bool first = true;
+	fprintf(f, "{\"traceEvents\": [\n");
+	for (size_t i = 0; i < profile->evaluations.size(); ++i) {
+		const double eval_begin = profile->evaluations[i].first;
+		const double eval_end = profile->evaluations[i].second;
+		fprintf(f,
+		        "%s{\"name\": \"Evaluation\", \"cat\": \"depsgraph\", \"ph\": \"X\", "
+		        "\"pid\": 0, \"tid\": 0, \"ts\": %.3f, \"dur\": %.3f}",
+		        first ? "" : ",\n",
+		        (eval_begin - begin_time) * 1e6,
+		        (eval_end - eval_begin) * 1e6);
+		first = false;
+	}
+	foreach (const DepsgraphProfileEntry &entry, profile->entries) {
+		fprintf(f, "%s{\"name\": ", first ? "" : ",\n");
+		profile_write_json_string(f, entry.name);
+		fprintf(f, ", \"cat\": ");
+		profile_write_json_string(f, entry.category);
+		fprintf(f,
+		        ", \"ph\": \"X\", \"pid\": 0, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f, "
+		        "\"args\": {\"wait_ms\": %.3f}}",
+		        entry.thread_id,
+		        (entry.start_time - begin_time) * 1e6,
+		        (entry.end_time - entry.start_time) * 1e6,
+		        (entry.start_time - entry.ready_time) * 1e3);
+		first = false;
+	}
+	fprintf(f, "\n]}\n");
+	fclose(f);
+	return true;
+}
+
+static bool profile_critical_stat_cmp(
+        const std::pair<string, DepsgraphProfileCriticalStat> &a,
+        const std::pair<string, DepsgraphProfileCriticalStat> &b)
+{
+	return a.second.duration > b.second.duration;
+}
+
+static void profile_print_critical_path(const DepsgraphProfile *profile)
+{
+	double eval_time = 0.0;
+	for (size_t i = 0; i < profile->evaluations.size(); ++i) {
+		eval_time += profile->evaluations[i].second - profile->evaluations[i].first;
+	}
+	printf("Depsgraph profile: %d evaluations, %d operations, %.3f ms evaluating, "
+	       "%.3f ms on critical path\n",
+	       (int)profile->evaluations.size(),
+	       (int)profile->entries.size(),
+	       eval_time * 1e3,
+	       profile->critical_time * 1e3);
+
+	vector<std::pair<string, DepsgraphProfileCriticalStat> > stats(
+	        profile->critical_stats.begin(), profile->critical_stats.end());
+	std::sort(stats.begin(), stats.end(), profile_critical_stat_cmp);
+
+	printf("%12s %12s %8s  %s\n", "Time (ms)", "Wait (ms)", "Count", "Critical path operation");
+	for (size_t i = 0; i < stats.size(); ++i) {
+		const DepsgraphProfileCriticalStat &stat = stats[i].second;
+		printf("%12.3f %12.3f %8d  %s\n",
+		       stat.duration * 1e3,
+		       stat.wait * 1e3,
+		       stat.count,
+		       stats[i].first.c_str());
+	}
+}
+
+static bool profile_finish(DepsgraphProfile *profile)
+{
+	bool result = true;
+	if (!profile->trace_filepath.empty()) {
+		result = profile_write_trace(profile, profile->trace_filepath.c_str());
+		if (result) {
+			printf("Depsgraph profile trace written to '%s'\n",
+			       profile->trace_filepath.c_str());
+		}
+		else {
+			printf("Failed to write depsgraph profile trace to '%s'\n",
+			       profile->trace_filepath.c_str());
+		}
+	}
+	profile_print_critical_path(profile);
+	delete profile;
+	return result;
+}
+
+bool DepsgraphDebug::profile_end()
+{
+	BLI_mutex_lock(&profile_lock);
+	DepsgraphProfile *ended_profile = profile;
+	if (ended_profile == NULL) {
+		BLI_mutex_unlock(&profile_lock);
+		return false;
+	}
+	if (ended_profile->num_running_evals != 0) {
+		BLI_mutex_unlock(&profile_lock);
+		printf("Depsgraph profile can't end while an evaluation is running\n");
+		return false;
+	}
+	profile = NULL;
+	BLI_mutex_unlock(&profile_lock);
+
+	return profile_finish(ended_profile);
+}
+
 /* ********** */
 /* Statistics */
 
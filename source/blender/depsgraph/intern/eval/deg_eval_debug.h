@@ -42,11 +42,14 @@ struct DepsgraphStatsComponent;
 namespace DEG {
 
 struct Depsgraph;
+struct DepsgraphProfile;
+struct DepsgraphProfileEval;
 struct DepsgraphSettings;
 struct OperationDepsNode;
 
 struct DepsgraphDebug {
 	static DepsgraphStats *stats;
+	static DepsgraphProfile *profile;
 
 	static void stats_init();
 	static void stats_free();
@@ -64,6 +67,25 @@ struct DepsgraphDebug {
 	                           const OperationDepsNode *node,
 	                           double time);
 
+	/* Evaluation profiler, records timing of every evaluated operation
+	 * between profile_begin() and profile_end(). Ending fails while an
+	 * evaluation is still recording.
+	 */
+	static bool profile_is_running();
+	static void profile_begin(const char *trace_filepath);
+	static bool profile_end();
+
+	/* Returns NULL when the profiler isn't running. */
+	static DepsgraphProfileEval *profile_eval_begin(Depsgraph *graph);
+	static void profile_eval_end(Depsgraph *graph, DepsgraphProfileEval *eval);
+	static void profile_task_ready(DepsgraphProfileEval *eval,
+	                               const OperationDepsNode *node);
+	static void profile_task_completed(DepsgraphProfileEval *eval,
+	                                   const OperationDepsNode *node,
+	                                   int thread_id,
+	                                   double start_time,
+	                                   double end_time);
+
 	static DepsgraphStatsID *get_id_stats(ID *id, bool create);
 	static DepsgraphStatsComponent *get_component_stats(DepsgraphStatsID *id_stats,
 	                                                    const char *name,
@@ -249,8 +249,10 @@ void ComponentDepsNode::clear_operations()
 		                comp_node_hash_key_free,
 		                comp_node_hash_value_free);
 	}
-	foreach (OperationDepsNode *op_node, operations) {
-		OBJECT_GUARDED_DELETE(op_node, OperationDepsNode);
+	else {
+		foreach (OperationDepsNode *op_node, operations) {
+			OBJECT_GUARDED_DELETE(op_node, OperationDepsNode);
+		}
 	}
 	operations.clear();
 }
@@ -322,16 +324,16 @@ OperationDepsNode *ComponentDepsNode::get_exit_operation()
 
 void ComponentDepsNode::finalize_build()
 {
+	/* NOTE: Finalization happens again after incremental relations update,
+	 * so the list is always re-created from the map.
+	 */
+	operations.clear();
 	operations.reserve(BLI_ghash_size(operations_map));
 	GHASH_FOREACH_BEGIN(OperationDepsNode *, op_node, operations_map)
 	{
 		operations.push_back(op_node);
 	}
 	GHASH_FOREACH_END();
-	BLI_ghash_free(operations_map,
-	               comp_node_hash_key_free,
-	               NULL);
-	operations_map = NULL;
 }
 
 /* Parameter Component Defines ============================ */
@@ -132,7 +132,8 @@ struct ComponentDepsNode : public DepsNode {
 	/* ** Inner nodes for this component ** */
 
 	/* Operations stored as a hash map, for faster build.
-	 * This hash map will be freed when graph is fully built.
+	 * This hash map is kept after the graph is built, so relations can be
+	 * updated incrementally.
 	 */
 	GHash *operations_map;
 
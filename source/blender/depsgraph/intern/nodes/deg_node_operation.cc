@@ -47,6 +47,7 @@ namespace DEG {
 
 OperationDepsNode::OperationDepsNode() :
     eval_priority(0.0f),
+    eval_cost(-1.0f),
     flag(0),
     customdata_mask(0)
 {
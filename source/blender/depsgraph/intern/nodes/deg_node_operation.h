@@ -81,7 +81,14 @@ struct OperationDepsNode : public DepsNode {
 
 	/* How many inlinks are we still waiting on before we can be evaluated. */
 	uint32_t num_links_pending;
+	/* Estimated time needed to evaluate this node and the most expensive
+	 * chain of nodes depending on it.
+	 */
 	float eval_priority;
+	/* Time in seconds the evaluation took, averaged over previous evaluations,
+	 * negative if the node was not evaluated yet.
+	 */
+	float eval_cost;
 	bool scheduled;
 
 	/* Stage of evaluation */
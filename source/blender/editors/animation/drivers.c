@@ -841,7 +841,7 @@ static int add_driver_button_none(bContext *C, wmOperator *op, short mapping_typ
 	if (success) {
 		/* send updates */
 		UI_context_update_anim_flag(C);
-		DAG_relations_tag_update(CTX_data_main(C));
+		DAG_id_tag_relations_update(CTX_data_main(C), ptr.id.data);
 		WM_event_add_notifier(C, NC_ANIMATION | ND_FCURVES_ORDER, NULL);  // XXX
 		
 		return OPERATOR_FINISHED;
@@ -939,7 +939,7 @@ static int remove_driver_button_exec(bContext *C, wmOperator *op)
 	if (success) {
 		/* send updates */
 		UI_context_update_anim_flag(C);
-		DAG_relations_tag_update(CTX_data_main(C));
+		DAG_id_tag_relations_update(CTX_data_main(C), ptr.id.data);
 		WM_event_add_notifier(C, NC_ANIMATION | ND_FCURVES_ORDER, NULL);  // XXX
 	}
 	
@@ -43,6 +43,7 @@
 
 #include "BKE_context.h"
 #include "BKE_depsgraph.h"
+#include "BKE_key.h"
 #include "BKE_library.h"
 #include "BKE_main.h"
 #include "BKE_mesh.h"
@@ -972,6 +973,11 @@ void ED_mesh_update(Mesh *mesh, bContext *C, int calc_edges, int calc_tessface)
 
 	BKE_mesh_calc_normals(mesh);
 
+	/* shape keys may have been set in place without an RNA update (foreach_set) */
+	if (mesh->key) {
+		BKE_key_delta_cache_free(mesh->key);
+	}
+
 	DAG_id_tag_update(&mesh->id, 0);
 	WM_event_add_notifier(C, NC_GEOM | ND_DATA, mesh);
 }
@@ -175,6 +175,7 @@ int join_mesh_exec(bContext *C, wmOperator *op)
 		nkey = BKE_key_copy(bmain, key);
 		
 		/* for all keys in old block, clear data-arrays */
+		BKE_key_delta_cache_free(key);
 		for (kb = key->block.first; kb; kb = kb->next) {
 			if (kb->data) MEM_freeN(kb->data);
 			kb->data = MEM_callocN(sizeof(float) * 3 * totvert, "join_shapekey");
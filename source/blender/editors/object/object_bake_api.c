@@ -624,61 +624,38 @@ static Mesh *bake_mesh_new_from_object(Main *bmain, Scene *scene, Object *ob)
 	return me;
 }
 
-static int bake(
-        Render *re, Main *bmain, Scene *scene, Object *ob_low, ListBase *selected_objects, ReportList *reports,
-        const ScenePassType pass_type, const int pass_filter, const int margin,
-        const BakeSaveMode save_mode, const bool is_clear, const bool is_split_materials,
-        const bool is_automatic_name, const bool is_selected_to_active, const bool is_cage,
-        const float cage_extrusion, const int normal_space, const BakeNormalSwizzle normal_swizzle[],
-        const char *custom_cage, const char *filepath, const int width, const int height,
-        const char *identifier, ScrArea *sa, const char *uv_layer)
-{
-	int op_result = OPERATOR_CANCELLED;
-	bool ok = false;
-
-	Object *ob_cage = NULL;
-
-	BakeHighPolyData *highpoly = NULL;
-	int tot_highpoly = 0;
-
-	char restrict_flag_low = ob_low->restrictflag;
-	char restrict_flag_cage = 0;
-
-	Mesh *me_low = NULL;
-	Mesh *me_cage = NULL;
-
-	MultiresModifierData *mmd_low = NULL;
-	int mmd_flags_low = 0;
-
-	float *result = NULL;
-
-	BakePixel *pixel_array_low = NULL;
-	BakePixel *pixel_array_high = NULL;
-
-	const bool is_save_internal = (save_mode == R_BAKE_SAVE_INTERNAL);
-	const bool is_noncolor = is_noncolor_pass(pass_type);
-	const int depth = RE_pass_depth(pass_type);
+/* object baked to its own images, the render engine gets all of them at once */
+typedef struct BakeLowPolyData {
+	Object *ob;
+	Mesh *me;
+	char restrict_flag;
 
-	BakeImages bake_images = {NULL};
+	MultiresModifierData *mmd;
+	int mmd_flags;
 
+	BakeImages bake_images;
 	size_t num_pixels;
-	int tot_materials;
-
-	RE_bake_engine_set_engine_parameters(re, bmain, scene);
-
-	if (!RE_bake_has_engine(re)) {
-		BKE_report(reports, RPT_ERROR, "Current render engine does not support baking");
-		goto cleanup;
-	}
+	BakePixel *pixel_array;
+	float *result;
+} BakeLowPolyData;
+
+static bool bake_lowpoly_init(
+        BakeLowPolyData *lowpoly, Main *bmain, Scene *scene, Object *ob, ReportList *reports,
+        const int depth, const bool is_save_internal, const bool is_split_materials, const bool is_plain_uv,
+        const int width, const int height, const char *uv_layer)
+{
+	BakeImages *bake_images = &lowpoly->bake_images;
+	int tot_materials = ob->totcol;
 
-	tot_materials = ob_low->totcol;
+	lowpoly->ob = ob;
+	lowpoly->restrict_flag = ob->restrictflag;
 
 	if (uv_layer && uv_layer[0] != '\0') {
-		Mesh *me = (Mesh *)ob_low->data;
+		Mesh *me = (Mesh *)ob->data;
 		if (CustomData_get_named_layer(&me->ldata, CD_MLOOPUV, uv_layer) == -1) {
 			BKE_reportf(reports, RPT_ERROR,
-			            "No UV layer named \"%s\" found in the object \"%s\"", uv_layer, ob_low->id.name + 2);
-			goto cleanup;
+			            "No UV layer named \"%s\" found in the object \"%s\"", uv_layer, ob->id.name + 2);
+			return false;
 		}
 	}
 
@@ -687,13 +664,13 @@ static int bake(
 			BKE_report(reports, RPT_ERROR,
 			           "No active image found, add a material or bake to an external file");
 
-			goto cleanup;
+			return false;
 		}
 		else if (is_split_materials) {
 			BKE_report(reports, RPT_ERROR,
 			           "No active image found, add a material or bake without the Split Materials option");
 
-			goto cleanup;
+			return false;
 		}
 		else {
 			/* baking externally without splitting materials */
@@ -702,40 +679,350 @@ static int bake(
 	}
 
 	/* we overallocate in case there is more materials than images */
-	bake_images.data = MEM_mallocN(sizeof(BakeImage) * tot_materials, "bake images dimensions (width, height, offset)");
-	bake_images.lookup = MEM_mallocN(sizeof(int) * tot_materials, "bake images lookup (from material to BakeImage)");
+	bake_images->data = MEM_mallocN(sizeof(BakeImage) * tot_materials, "bake images dimensions (width, height, offset)");
+	bake_images->lookup = MEM_mallocN(sizeof(int) * tot_materials, "bake images lookup (from material to BakeImage)");
 
-	build_image_lookup(bmain, ob_low, &bake_images);
+	build_image_lookup(bmain, ob, bake_images);
 
 	if (is_save_internal) {
-		num_pixels = initialize_internal_images(&bake_images, reports);
+		lowpoly->num_pixels = initialize_internal_images(bake_images, reports);
 
-		if (num_pixels == 0) {
-			goto cleanup;
+		if (lowpoly->num_pixels == 0) {
+			return false;
 		}
 	}
 	else {
 		/* when saving extenally always use the size specified in the UI */
 
-		num_pixels = (size_t)width * (size_t)height * bake_images.size;
+		lowpoly->num_pixels = (size_t)width * (size_t)height * bake_images->size;
 
-		for (int i = 0; i < bake_images.size; i++) {
-			bake_images.data[i].width = width;
-			bake_images.data[i].height = height;
-			bake_images.data[i].offset = (is_split_materials ? num_pixels : 0);
-			bake_images.data[i].image = NULL;
+		for (int i = 0; i < bake_images->size; i++) {
+			bake_images->data[i].width = width;
+			bake_images->data[i].height = height;
+			bake_images->data[i].offset = (is_split_materials ? lowpoly->num_pixels : 0);
+			bake_images->data[i].image = NULL;
 		}
 
 		if (!is_split_materials) {
 			/* saving a single image */
 			for (int i = 0; i < tot_materials; i++) {
-				bake_images.lookup[i] = 0;
+				bake_images->lookup[i] = 0;
+			}
+		}
+	}
+
+	lowpoly->pixel_array = MEM_mallocN(sizeof(BakePixel) * lowpoly->num_pixels, "bake pixels low poly");
+	lowpoly->result = MEM_callocN(sizeof(float) * depth * lowpoly->num_pixels, "bake return pixels");
+
+	/* for multires bake, use linear UV subdivision to match low res UVs */
+	if (is_plain_uv) {
+		lowpoly->mmd = (MultiresModifierData *) modifiers_findByType(ob, eModifierType_Multires);
+		if (lowpoly->mmd) {
+			lowpoly->mmd_flags = lowpoly->mmd->flags;
+			lowpoly->mmd->flags |= eMultiresModifierFlag_PlainUv;
+		}
+	}
+
+	/* get the mesh as it arrives in the renderer */
+	lowpoly->me = bake_mesh_new_from_object(bmain, scene, ob);
+
+	return true;
+}
+
+static void bake_lowpoly_free(Main *bmain, BakeLowPolyData *lowpoly)
+{
+	if (lowpoly->ob)
+		lowpoly->ob->restrictflag = lowpoly->restrict_flag;
+
+	if (lowpoly->mmd)
+		lowpoly->mmd->flags = lowpoly->mmd_flags;
+
+	if (lowpoly->pixel_array)
+		MEM_freeN(lowpoly->pixel_array);
+
+	if (lowpoly->bake_images.data)
+		MEM_freeN(lowpoly->bake_images.data);
+
+	if (lowpoly->bake_images.lookup)
+		MEM_freeN(lowpoly->bake_images.lookup);
+
+	if (lowpoly->result)
+		MEM_freeN(lowpoly->result);
+
+	if (lowpoly->me)
+		BKE_libblock_free(bmain, lowpoly->me);
+}
+
+/* objects baked to their own images are handed to the render engine in batches,
+ * the pixel and result arrays of a batch are kept below this size unless a
+ * single object needs more */
+#define BAKE_BATCH_MEMORY_LIMIT ((size_t)1024 * 1024 * 1024)
+
+static size_t bake_lowpoly_memory(const BakeLowPolyData *lowpoly, const int depth)
+{
+	return lowpoly->num_pixels * (sizeof(BakePixel) + sizeof(float) * depth);
+}
+
+/* convert the baked normals and save the images of a baked object */
+static int bake_lowpoly_write(
+        BakeLowPolyData *lowpoly, Main *bmain, Scene *scene, ReportList *reports,
+        const ScenePassType pass_type, const int margin, const BakeSaveMode save_mode,
+        const bool is_clear, const bool is_split_materials, const bool is_automatic_name,
+        const bool is_selected_to_active, const int normal_space, const BakeNormalSwizzle normal_swizzle[],
+        const char *filepath, const char *identifier, ScrArea *sa, const char *uv_layer)
+{
+	int op_result = OPERATOR_CANCELLED;
+	bool ok;
+
+	Object *ob_low = lowpoly->ob;
+	Mesh *me_low = lowpoly->me;
+	BakeImages *bake_images = &lowpoly->bake_images;
+	BakePixel *pixel_array_low = lowpoly->pixel_array;
+	const size_t num_pixels = lowpoly->num_pixels;
+	float *result = lowpoly->result;
+
+	const bool is_save_internal = (save_mode == R_BAKE_SAVE_INTERNAL);
+	const bool is_noncolor = is_noncolor_pass(pass_type);
+	const int depth = RE_pass_depth(pass_type);
+
+	/* normal space conversion
+	 * the normals are expected to be in world space, +X +Y +Z */
+	if (pass_type == SCE_PASS_NORMAL) {
+		switch (normal_space) {
+			case R_BAKE_SPACE_WORLD:
+			{
+				/* Cycles internal format */
+				if ((normal_swizzle[0] == R_BAKE_POSX) &&
+				    (normal_swizzle[1] == R_BAKE_POSY) &&
+				    (normal_swizzle[2] == R_BAKE_POSZ))
+				{
+					break;
+				}
+				else {
+					RE_bake_normal_world_to_world(pixel_array_low, num_pixels,  depth, result, normal_swizzle);
+				}
+				break;
+			}
+			case R_BAKE_SPACE_OBJECT:
+			{
+				RE_bake_normal_world_to_object(pixel_array_low, num_pixels, depth, result, ob_low, normal_swizzle);
+				break;
+			}
+			case R_BAKE_SPACE_TANGENT:
+			{
+				if (is_selected_to_active) {
+					RE_bake_normal_world_to_tangent(pixel_array_low, num_pixels, depth, result, me_low, normal_swizzle, ob_low->obmat);
+				}
+				else {
+					/* from multiresolution */
+					Mesh *me_nores = NULL;
+					ModifierData *md = NULL;
+					int mode;
+
+					md = modifiers_findByType(ob_low, eModifierType_Multires);
+
+					if (md) {
+						mode = md->mode;
+						md->mode &= ~eModifierMode_Render;
+					}
+
+					me_nores = bake_mesh_new_from_object(bmain, scene, ob_low);
+					RE_bake_pixels_populate(me_nores, pixel_array_low, num_pixels, bake_images, uv_layer);
+
+					RE_bake_normal_world_to_tangent(pixel_array_low, num_pixels, depth, result, me_nores, normal_swizzle, ob_low->obmat);
+					BKE_libblock_free(bmain, me_nores);
+
+					if (md)
+						md->mode = mode;
+				}
+				break;
 			}
+			default:
+				break;
 		}
 	}
 
+	/* save the results */
+	for (int i = 0; i < bake_images->size; i++) {
+		BakeImage *bk_image = &bake_images->data[i];
+
+		if (is_save_internal) {
+			ok = write_internal_bake_pixels(
+			         bk_image->image,
+			         pixel_array_low + bk_image->offset,
+			         result + bk_image->offset * depth,
+			         bk_image->width, bk_image->height,
+			         margin, is_clear, is_noncolor);
+
+			/* might be read by UI to set active image for display */
+			bake_update_image(sa, bk_image->image);
+
+			if (!ok) {
+				BKE_reportf(reports, RPT_ERROR,
+				           "Problem saving the bake map internally for object \"%s\"", ob_low->id.name + 2);
+				op_result = OPERATOR_CANCELLED;
+			}
+			else {
+				BKE_report(reports, RPT_INFO,
+				           "Baking map saved to internal image, save it externally or pack it");
+				op_result = OPERATOR_FINISHED;
+			}
+		}
+		/* save externally */
+		else {
+			BakeData *bake = &scene->r.bake;
+			char name[FILE_MAX];
+
+			BKE_image_path_from_imtype(name, filepath, bmain->name, 0, bake->im_format.imtype, true, false, NULL);
+
+			if (is_automatic_name) {
+				BLI_path_suffix(name, FILE_MAX, ob_low->id.name + 2, "_");
+				BLI_path_suffix(name, FILE_MAX, identifier, "_");
+			}
+
+			if (is_split_materials) {
+				if (bk_image->image) {
+					BLI_path_suffix(name, FILE_MAX, bk_image->image->id.name + 2, "_");
+				}
+				else {
+					if (ob_low->mat[i]) {
+						BLI_path_suffix(name, FILE_MAX, ob_low->mat[i]->id.name + 2, "_");
+					}
+					else if (me_low->mat[i]) {
+						BLI_path_suffix(name, FILE_MAX, me_low->mat[i]->id.name + 2, "_");
+					}
+					else {
+						/* if everything else fails, use the material index */
+						char tmp[4];
+						sprintf(tmp, "%d", i % 1000);
+						BLI_path_suffix(name, FILE_MAX, tmp, "_");
+					}
+				}
+			}
+
+			/* save it externally */
+			ok = write_external_bake_pixels(
+			        name,
+			        pixel_array_low + bk_image->offset,
+			        result + bk_image->offset * depth,
+			        bk_image->width, bk_image->height,
+			        margin, &bake->im_format, is_noncolor);
+
+			if (!ok) {
+				BKE_reportf(reports, RPT_ERROR, "Problem saving baked map in \"%s\"", name);
+				op_result = OPERATOR_CANCELLED;
+			}
+			else {
+				BKE_reportf(reports, RPT_INFO, "Baking map written to \"%s\"", name);
+				op_result = OPERATOR_FINISHED;
+			}
+
+			if (!is_split_materials) {
+				break;
+			}
+		}
+	}
+
+	return op_result;
+}
+
+/* save the images of baked objects */
+static int bake_lowpoly_write_all(
+        BakeLowPolyData *lowpoly, const int tot_lowpoly, Main *bmain, Scene *scene, ReportList *reports,
+        const ScenePassType pass_type, const int margin, const BakeSaveMode save_mode,
+        const bool is_clear, const bool is_split_materials, const bool is_automatic_name,
+        const bool is_selected_to_active, const int normal_space, const BakeNormalSwizzle normal_swizzle[],
+        const char *filepath, const char *identifier, ScrArea *sa, const char *uv_layer)
+{
+	int op_result = OPERATOR_FINISHED;
+	int i;
+
+	for (i = 0; i < tot_lowpoly; i++) {
+		if (bake_lowpoly_write(
+		        &lowpoly[i], bmain, scene, reports, pass_type, margin, save_mode,
+		        is_clear, is_split_materials, is_automatic_name, is_selected_to_active,
+		        normal_space, normal_swizzle, filepath, identifier, sa, uv_layer) != OPERATOR_FINISHED)
+		{
+			op_result = OPERATOR_CANCELLED;
+		}
+	}
+
+	if (save_mode == R_BAKE_SAVE_INTERNAL) {
+		for (i = 0; i < tot_lowpoly; i++) {
+			refresh_images(&lowpoly[i].bake_images);
+		}
+	}
+
+	return op_result;
+}
+
+/* bakes the selected objects to the active one with a single call to the render
+ * engine, or every selected object to its own images in batches of objects */
+static int bake(
+        Render *re, Main *bmain, Scene *scene, Object *ob_active, ListBase *selected_objects, ReportList *reports,
+        const ScenePassType pass_type, const int pass_filter, const int margin,
+        const BakeSaveMode save_mode, const bool is_clear, const bool is_split_materials,
+        const bool is_automatic_name, const bool is_selected_to_active, const bool is_cage,
+        const float cage_extrusion, const int normal_space, const BakeNormalSwizzle normal_swizzle[],
+        const char *custom_cage, const char *filepath, const int width, const int height,
+        const char *identifier, ScrArea *sa, const char *uv_layer)
+{
+	int op_result = OPERATOR_CANCELLED;
+	bool ok = false;
+
+	Object *ob_cage = NULL;
+
+	BakeLowPolyData *lowpoly = NULL;
+	int tot_lowpoly = 0;
+
+	BakeHighPolyData *highpoly = NULL;
+	int tot_highpoly = 0;
+
+	char restrict_flag_cage = 0;
+
+	Mesh *me_cage = NULL;
+
+	BakePixel *pixel_array_high = NULL;
+	BakeJob *jobs = NULL;
+
+	const bool is_save_internal = (save_mode == R_BAKE_SAVE_INTERNAL);
+	const bool is_plain_uv = (pass_type == SCE_PASS_NORMAL && normal_space == R_BAKE_SPACE_TANGENT && !is_selected_to_active);
+	const int depth = RE_pass_depth(pass_type);
+
+	int i;
+
+	RE_bake_engine_set_engine_parameters(re, bmain, scene);
+
+	if (!RE_bake_has_engine(re)) {
+		BKE_report(reports, RPT_ERROR, "Current render engine does not support baking");
+		goto cleanup;
+	}
+
+	/* the active object gets the bake of the selected ones, otherwise
+	 * every selected object is baked to its own images */
+	tot_lowpoly = is_selected_to_active ? 1 : BLI_listbase_count(selected_objects);
+	lowpoly = MEM_callocN(sizeof(BakeLowPolyData) * tot_lowpoly, "bake low poly objects");
+
 	if (is_selected_to_active) {
 		CollectionPointerLink *link;
+		ModifierData *md, *nmd;
+		ListBase modifiers_tmp, modifiers_original;
+		Object *ob_low;
+		Mesh *me_low;
+		BakePixel *pixel_array_low;
+		size_t num_pixels;
+
+		if (!bake_lowpoly_init(&lowpoly[0], bmain, scene, ob_active, reports, depth, is_save_internal,
+		                       is_split_materials, is_plain_uv, width, height, uv_layer))
+		{
+			goto cleanup;
+		}
+
+		ob_low = lowpoly[0].ob;
+		me_low = lowpoly[0].me;
+		pixel_array_low = lowpoly[0].pixel_array;
+		num_pixels = lowpoly[0].num_pixels;
+
 		tot_highpoly = 0;
 
 		for (link = selected_objects->first; link; link = link->next) {
@@ -759,34 +1046,13 @@ static int bake(
 				ob_cage->restrictflag |= OB_RESTRICT_RENDER;
 			}
 		}
-	}
 
-	pixel_array_low = MEM_mallocN(sizeof(BakePixel) * num_pixels, "bake pixels low poly");
-	pixel_array_high = MEM_mallocN(sizeof(BakePixel) * num_pixels, "bake pixels high poly");
-	result = MEM_callocN(sizeof(float) * depth * num_pixels, "bake return pixels");
+		pixel_array_high = MEM_mallocN(sizeof(BakePixel) * num_pixels, "bake pixels high poly");
 
-	/* for multires bake, use linear UV subdivision to match low res UVs */
-	if (pass_type == SCE_PASS_NORMAL && normal_space == R_BAKE_SPACE_TANGENT && !is_selected_to_active) {
-		mmd_low = (MultiresModifierData *) modifiers_findByType(ob_low, eModifierType_Multires);
-		if (mmd_low) {
-			mmd_flags_low = mmd_low->flags;
-			mmd_low->flags |= eMultiresModifierFlag_PlainUv;
-		}
-	}
-
-	/* get the mesh as it arrives in the renderer */
-	me_low = bake_mesh_new_from_object(bmain, scene, ob_low);
-
-	/* populate the pixel array with the face data */
-	if ((is_selected_to_active && (ob_cage == NULL) && is_cage) == false)
-		RE_bake_pixels_populate(me_low, pixel_array_low, num_pixels, &bake_images, uv_layer);
-	/* else populate the pixel array with the 'cage' mesh (the smooth version of the mesh)  */
-
-	if (is_selected_to_active) {
-		CollectionPointerLink *link;
-		ModifierData *md, *nmd;
-		ListBase modifiers_tmp, modifiers_original;
-		int i = 0;
+		/* populate the pixel array with the face data */
+		if ((ob_cage == NULL && is_cage) == false)
+			RE_bake_pixels_populate(me_low, pixel_array_low, num_pixels, &lowpoly[0].bake_images, uv_layer);
+		/* else populate the pixel array with the 'cage' mesh (the smooth version of the mesh)  */
 
 		/* prepare cage mesh */
 		if (ob_cage) {
@@ -823,12 +1089,13 @@ static int bake(
 
 			/* get the cage mesh as it arrives in the renderer */
 			me_cage = bake_mesh_new_from_object(bmain, scene, ob_low);
-			RE_bake_pixels_populate(me_cage, pixel_array_low, num_pixels, &bake_images, uv_layer);
+			RE_bake_pixels_populate(me_cage, pixel_array_low, num_pixels, &lowpoly[0].bake_images, uv_layer);
 		}
 
 		highpoly = MEM_callocN(sizeof(BakeHighPolyData) * tot_highpoly, "bake high poly objects");
 
 		/* populate highpoly array */
+		i = 0;
 		for (link = selected_objects->first; link; link = link->next) {
 			TriangulateModifierData *tmd;
 			Object *ob_iter = link->ptr.data;
@@ -873,14 +1140,21 @@ static int bake(
 			goto cage_cleanup;
 		}
 
-		/* the baking itself */
+		/* the baking itself, the pixels of all high poly objects are in the
+		 * same array and identified by the object id */
+		jobs = MEM_mallocN(sizeof(BakeJob) * tot_highpoly, "bake jobs");
+
 		for (i = 0; i < tot_highpoly; i++) {
-			ok = RE_bake_engine(re, highpoly[i].ob, i, pixel_array_high,
-			                    num_pixels, depth, pass_type, pass_filter, result);
-			if (!ok) {
-				BKE_reportf(reports, RPT_ERROR, "Error baking from object \"%s\"", highpoly[i].ob->id.name + 2);
-				goto cage_cleanup;
-			}
+			jobs[i].object = highpoly[i].ob;
+			jobs[i].object_id = i;
+			jobs[i].num_pixels = (int)num_pixels;
+			jobs[i].pixel_array = pixel_array_high;
+			jobs[i].result = lowpoly[0].result;
+		}
+
+		ok = RE_bake_engine_multi(re, jobs, tot_highpoly, depth, pass_type, pass_filter);
+		if (!ok) {
+			BKE_report(reports, RPT_ERROR, "Error baking from selected objects");
 		}
 
 cage_cleanup:
@@ -896,171 +1170,94 @@ cage_cleanup:
 		if (!ok) {
 			goto cleanup;
 		}
-	}
-	else {
-		/* make sure low poly renders */
-		ob_low->restrictflag &= ~OB_RESTRICT_RENDER;
 
-		if (RE_bake_has_engine(re)) {
-			ok = RE_bake_engine(re, ob_low, 0, pixel_array_low, num_pixels, depth, pass_type, pass_filter, result);
-		}
-		else {
-			BKE_report(reports, RPT_ERROR, "Current render engine does not support baking");
-			goto cleanup;
-		}
+		op_result = bake_lowpoly_write_all(
+		        lowpoly, 1, bmain, scene, reports, pass_type, margin, save_mode,
+		        is_clear, is_split_materials, is_automatic_name, is_selected_to_active,
+		        normal_space, normal_swizzle, filepath, identifier, sa, uv_layer);
 	}
-
-	/* normal space conversion
-	 * the normals are expected to be in world space, +X +Y +Z */
-	if (ok && pass_type == SCE_PASS_NORMAL) {
-		switch (normal_space) {
-			case R_BAKE_SPACE_WORLD:
-			{
-				/* Cycles internal format */
-				if ((normal_swizzle[0] == R_BAKE_POSX) &&
-				    (normal_swizzle[1] == R_BAKE_POSY) &&
-				    (normal_swizzle[2] == R_BAKE_POSZ))
+	else {
+		CollectionPointerLink *link = selected_objects->first;
+		/* images can be shared by the baked objects, only clear them when
+		 * there is a single one */
+		const bool is_clear_images = is_clear && (tot_lowpoly == 1);
+		int tot_baked = 0;
+
+		jobs = MEM_mallocN(sizeof(BakeJob) * tot_lowpoly, "bake jobs");
+		ok = true;
+
+		/* objects that can't be baked are skipped, the others are baked in
+		 * batches so the memory used doesn't grow with the number of objects */
+		while (link && !G.is_break) {
+			size_t batch_memory = 0;
+			int tot_batch = 0;
+
+			for (; link && (tot_batch == 0 || batch_memory < BAKE_BATCH_MEMORY_LIMIT); link = link->next) {
+				Object *ob_iter = link->ptr.data;
+				BakeLowPolyData *lowpoly_iter = &lowpoly[tot_batch];
+
+				if (!bake_lowpoly_init(lowpoly_iter, bmain, scene, ob_iter, reports, depth, is_save_internal,
+				                       is_split_materials, is_plain_uv, width, height, uv_layer))
 				{
-					break;
-				}
-				else {
-					RE_bake_normal_world_to_world(pixel_array_low, num_pixels,  depth, result, normal_swizzle);
-				}
-				break;
-			}
-			case R_BAKE_SPACE_OBJECT:
-			{
-				RE_bake_normal_world_to_object(pixel_array_low, num_pixels, depth, result, ob_low, normal_swizzle);
-				break;
-			}
-			case R_BAKE_SPACE_TANGENT:
-			{
-				if (is_selected_to_active) {
-					RE_bake_normal_world_to_tangent(pixel_array_low, num_pixels, depth, result, me_low, normal_swizzle, ob_low->obmat);
+					BKE_reportf(reports, RPT_WARNING, "Skipping object \"%s\"", ob_iter->id.name + 2);
+					bake_lowpoly_free(bmain, lowpoly_iter);
+					memset(lowpoly_iter, 0, sizeof(*lowpoly_iter));
+					continue;
 				}
-				else {
-					/* from multiresolution */
-					Mesh *me_nores = NULL;
-					ModifierData *md = NULL;
-					int mode;
 
-					md = modifiers_findByType(ob_low, eModifierType_Multires);
+				batch_memory += bake_lowpoly_memory(lowpoly_iter, depth);
+				tot_batch++;
+			}
 
-					if (md) {
-						mode = md->mode;
-						md->mode &= ~eModifierMode_Render;
-					}
+			if (tot_batch == 0)
+				break;
 
-					me_nores = bake_mesh_new_from_object(bmain, scene, ob_low);
-					RE_bake_pixels_populate(me_nores, pixel_array_low, num_pixels, &bake_images, uv_layer);
+			for (i = 0; i < tot_batch; i++) {
+				/* populate the pixel array with the face data */
+				RE_bake_pixels_populate(lowpoly[i].me, lowpoly[i].pixel_array, lowpoly[i].num_pixels,
+				                        &lowpoly[i].bake_images, uv_layer);
 
-					RE_bake_normal_world_to_tangent(pixel_array_low, num_pixels, depth, result, me_nores, normal_swizzle, ob_low->obmat);
-					BKE_libblock_free(bmain, me_nores);
+				/* make sure low poly renders */
+				lowpoly[i].ob->restrictflag &= ~OB_RESTRICT_RENDER;
 
-					if (md)
-						md->mode = mode;
-				}
-				break;
+				jobs[i].object = lowpoly[i].ob;
+				jobs[i].object_id = 0;
+				jobs[i].num_pixels = (int)lowpoly[i].num_pixels;
+				jobs[i].pixel_array = lowpoly[i].pixel_array;
+				jobs[i].result = lowpoly[i].result;
 			}
-			default:
-				break;
-		}
-	}
 
-	if (!ok) {
-		BKE_reportf(reports, RPT_ERROR, "Problem baking object \"%s\"", ob_low->id.name + 2);
-		op_result = OPERATOR_CANCELLED;
-	}
-	else {
-		/* save the results */
-		for (int i = 0; i < bake_images.size; i++) {
-			BakeImage *bk_image = &bake_images.data[i];
-
-			if (is_save_internal) {
-				ok = write_internal_bake_pixels(
-				         bk_image->image,
-				         pixel_array_low + bk_image->offset,
-				         result + bk_image->offset * depth,
-				         bk_image->width, bk_image->height,
-				         margin, is_clear, is_noncolor);
-
-				/* might be read by UI to set active image for display */
-				bake_update_image(sa, bk_image->image);
-
-				if (!ok) {
-					BKE_reportf(reports, RPT_ERROR,
-					           "Problem saving the bake map internally for object \"%s\"", ob_low->id.name + 2);
-					op_result = OPERATOR_CANCELLED;
-				}
-				else {
-					BKE_report(reports, RPT_INFO,
-					           "Baking map saved to internal image, save it externally or pack it");
-					op_result = OPERATOR_FINISHED;
+			if (!RE_bake_engine_multi(re, jobs, tot_batch, depth, pass_type, pass_filter)) {
+				for (i = 0; i < tot_batch; i++) {
+					BKE_reportf(reports, RPT_ERROR, "Problem baking object \"%s\"", lowpoly[i].ob->id.name + 2);
 				}
+				op_result = OPERATOR_CANCELLED;
+				goto cleanup;
 			}
-			/* save externally */
-			else {
-				BakeData *bake = &scene->r.bake;
-				char name[FILE_MAX];
-
-				BKE_image_path_from_imtype(name, filepath, bmain->name, 0, bake->im_format.imtype, true, false, NULL);
 
-				if (is_automatic_name) {
-					BLI_path_suffix(name, FILE_MAX, ob_low->id.name + 2, "_");
-					BLI_path_suffix(name, FILE_MAX, identifier, "_");
-				}
-
-				if (is_split_materials) {
-					if (bk_image->image) {
-						BLI_path_suffix(name, FILE_MAX, bk_image->image->id.name + 2, "_");
-					}
-					else {
-						if (ob_low->mat[i]) {
-							BLI_path_suffix(name, FILE_MAX, ob_low->mat[i]->id.name + 2, "_");
-						}
-						else if (me_low->mat[i]) {
-							BLI_path_suffix(name, FILE_MAX, me_low->mat[i]->id.name + 2, "_");
-						}
-						else {
-							/* if everything else fails, use the material index */
-							char tmp[4];
-							sprintf(tmp, "%d", i % 1000);
-							BLI_path_suffix(name, FILE_MAX, tmp, "_");
-						}
-					}
-				}
+			if (bake_lowpoly_write_all(
+			        lowpoly, tot_batch, bmain, scene, reports, pass_type, margin, save_mode,
+			        is_clear_images, is_split_materials, is_automatic_name, is_selected_to_active,
+			        normal_space, normal_swizzle, filepath, identifier, sa, uv_layer) != OPERATOR_FINISHED)
+			{
+				ok = false;
+			}
 
-				/* save it externally */
-				ok = write_external_bake_pixels(
-				        name,
-				        pixel_array_low + bk_image->offset,
-				        result + bk_image->offset * depth,
-				        bk_image->width, bk_image->height,
-				        margin, &bake->im_format, is_noncolor);
-
-				if (!ok) {
-					BKE_reportf(reports, RPT_ERROR, "Problem saving baked map in \"%s\"", name);
-					op_result = OPERATOR_CANCELLED;
-				}
-				else {
-					BKE_reportf(reports, RPT_INFO, "Baking map written to \"%s\"", name);
-					op_result = OPERATOR_FINISHED;
-				}
+			tot_baked += tot_batch;
 
-				if (!is_split_materials) {
-					break;
-				}
+			/* the next batch reuses the low poly data */
+			for (i = 0; i < tot_batch; i++) {
+				bake_lowpoly_free(bmain, &lowpoly[i]);
 			}
+			memset(lowpoly, 0, sizeof(BakeLowPolyData) * tot_batch);
 		}
-	}
 
-	if (is_save_internal)
-		refresh_images(&bake_images);
+		op_result = (ok && tot_baked != 0) ? OPERATOR_FINISHED : OPERATOR_CANCELLED;
+	}
 
 cleanup:
 
 	if (highpoly) {
-		int i;
 		for (i = 0; i < tot_highpoly; i++) {
 			highpoly[i].ob->restrictflag = highpoly[i].restrict_flag;
 
@@ -1073,31 +1270,21 @@ cleanup:
 		MEM_freeN(highpoly);
 	}
 
-	ob_low->restrictflag = restrict_flag_low;
-
-	if (mmd_low)
-		mmd_low->flags = mmd_flags_low;
+	if (lowpoly) {
+		for (i = 0; i < tot_lowpoly; i++) {
+			bake_lowpoly_free(bmain, &lowpoly[i]);
+		}
+		MEM_freeN(lowpoly);
+	}
 
 	if (ob_cage)
 		ob_cage->restrictflag = restrict_flag_cage;
 
-	if (pixel_array_low)
-		MEM_freeN(pixel_array_low);
-
 	if (pixel_array_high)
 		MEM_freeN(pixel_array_high);
 
-	if (bake_images.data)
-		MEM_freeN(bake_images.data);
-
-	if (bake_images.lookup)
-		MEM_freeN(bake_images.lookup);
-
-	if (result)
-		MEM_freeN(result);
-
-	if (me_low)
-		BKE_libblock_free(bmain, me_low);
+	if (jobs)
+		MEM_freeN(jobs);
 
 	if (me_cage)
 		BKE_libblock_free(bmain, me_cage);
@@ -1190,29 +1377,13 @@ static int bake_exec(bContext *C, wmOperator *op)
 
 	RE_SetReports(re, bkr.reports);
 
-	if (bkr.is_selected_to_active) {
-		result = bake(
-		        bkr.render, bkr.main, bkr.scene, bkr.ob, &bkr.selected_objects, bkr.reports,
-		        bkr.pass_type, bkr.pass_filter, bkr.margin, bkr.save_mode,
-		        bkr.is_clear, bkr.is_split_materials, bkr.is_automatic_name, true, bkr.is_cage,
-		        bkr.cage_extrusion, bkr.normal_space, bkr.normal_swizzle,
-		        bkr.custom_cage, bkr.filepath, bkr.width, bkr.height, bkr.identifier, bkr.sa,
-		        bkr.uv_layer);
-	}
-	else {
-		CollectionPointerLink *link;
-		const bool is_clear = bkr.is_clear && BLI_listbase_is_single(&bkr.selected_objects);
-		for (link = bkr.selected_objects.first; link; link = link->next) {
-			Object *ob_iter = link->ptr.data;
-			result = bake(
-			        bkr.render, bkr.main, bkr.scene, ob_iter, NULL, bkr.reports,
-			        bkr.pass_type, bkr.pass_filter, bkr.margin, bkr.save_mode,
-			        is_clear, bkr.is_split_materials, bkr.is_automatic_name, false, bkr.is_cage,
-			        bkr.cage_extrusion, bkr.normal_space, bkr.normal_swizzle,
-			        bkr.custom_cage, bkr.filepath, bkr.width, bkr.height, bkr.identifier, bkr.sa,
-			        bkr.uv_layer);
-		}
-	}
+	result = bake(
+	        bkr.render, bkr.main, bkr.scene, bkr.ob, &bkr.selected_objects, bkr.reports,
+	        bkr.pass_type, bkr.pass_filter, bkr.margin, bkr.save_mode,
+	        bkr.is_clear, bkr.is_split_materials, bkr.is_automatic_name, bkr.is_selected_to_active, bkr.is_cage,
+	        bkr.cage_extrusion, bkr.normal_space, bkr.normal_swizzle,
+	        bkr.custom_cage, bkr.filepath, bkr.width, bkr.height, bkr.identifier, bkr.sa,
+	        bkr.uv_layer);
 
 	RE_SetReports(re, NULL);
 
@@ -1247,32 +1418,13 @@ static void bake_startjob(void *bkv, short *UNUSED(stop), short *do_update, floa
 		bake_images_clear(bkr->main, is_tangent);
 	}
 
-	if (bkr->is_selected_to_active) {
-		bkr->result = bake(
-		        bkr->render, bkr->main, bkr->scene, bkr->ob, &bkr->selected_objects, bkr->reports,
-		        bkr->pass_type, bkr->pass_filter, bkr->margin, bkr->save_mode,
-		        bkr->is_clear, bkr->is_split_materials, bkr->is_automatic_name, true, bkr->is_cage,
-		        bkr->cage_extrusion, bkr->normal_space, bkr->normal_swizzle,
-		        bkr->custom_cage, bkr->filepath, bkr->width, bkr->height, bkr->identifier, bkr->sa,
-		        bkr->uv_layer);
-	}
-	else {
-		CollectionPointerLink *link;
-		const bool is_clear = bkr->is_clear && BLI_listbase_is_single(&bkr->selected_objects);
-		for (link = bkr->selected_objects.first; link; link = link->next) {
-			Object *ob_iter = link->ptr.data;
-			bkr->result = bake(
-			        bkr->render, bkr->main, bkr->scene, ob_iter, NULL, bkr->reports,
-			        bkr->pass_type, bkr->pass_filter, bkr->margin, bkr->save_mode,
-			        is_clear, bkr->is_split_materials, bkr->is_automatic_name, false, bkr->is_cage,
-			        bkr->cage_extrusion, bkr->normal_space, bkr->normal_swizzle,
-			        bkr->custom_cage, bkr->filepath, bkr->width, bkr->height, bkr->identifier, bkr->sa,
-			        bkr->uv_layer);
-
-			if (bkr->result == OPERATOR_CANCELLED)
-				return;
-		}
-	}
+	bkr->result = bake(
+	        bkr->render, bkr->main, bkr->scene, bkr->ob, &bkr->selected_objects, bkr->reports,
+	        bkr->pass_type, bkr->pass_filter, bkr->margin, bkr->save_mode,
+	        bkr->is_clear, bkr->is_split_materials, bkr->is_automatic_name, bkr->is_selected_to_active, bkr->is_cage,
+	        bkr->cage_extrusion, bkr->normal_space, bkr->normal_swizzle,
+	        bkr->custom_cage, bkr->filepath, bkr->width, bkr->height, bkr->identifier, bkr->sa,
+	        bkr->uv_layer);
 
 	RE_SetReports(bkr->render, NULL);
 }
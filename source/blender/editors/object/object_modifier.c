@@ -172,7 +172,7 @@ ModifierData *ED_object_modifier_add(ReportList *reports, Main *bmain, Scene *sc
 	}
 
 	DAG_id_tag_update(&ob->id, OB_RECALC_DATA);
-	DAG_relations_tag_update(bmain);
+	DAG_id_tag_relations_update(bmain, &ob->id);
 
 	return new_md;
 }
@@ -320,7 +320,7 @@ static bool object_modifier_remove(Main *bmain, Object *ob, ModifierData *md,
 		ob->mode &= ~OB_MODE_PARTICLE_EDIT;
 	}
 
-	DAG_relations_tag_update(bmain);
+	DAG_id_tag_relations_update(bmain, &ob->id);
 
 	BLI_remlink(&ob->modifiers, md);
 	modifier_free(md);
@@ -342,7 +342,7 @@ bool ED_object_modifier_remove(ReportList *reports, Main *bmain, Object *ob, Mod
 	}
 
 	DAG_id_tag_update(&ob->id, OB_RECALC_DATA);
-	DAG_relations_tag_update(bmain);
+	DAG_id_tag_relations_update(bmain, &ob->id);
 
 	return 1;
 }
@@ -366,7 +366,7 @@ void ED_object_modifier_clear(Main *bmain, Object *ob)
 	}
 
 	DAG_id_tag_update(&ob->id, OB_RECALC_DATA);
-	DAG_relations_tag_update(bmain);
+	DAG_id_tag_relations_update(bmain, &ob->id);
 }
 
 int ED_object_modifier_move_up(ReportList *reports, Object *ob, ModifierData *md)
@@ -163,6 +163,8 @@ static bool object_shape_key_mirror(bContext *C, Object *ob,
 			}
 
 			ED_mesh_mirror_spatial_table(ob, NULL, NULL, NULL, 'e');
+
+			BKE_keyblock_delta_cache_invalidate(key, kb);
 		}
 		else if (ob->type == OB_LATTICE) {
 			Lattice *lt = ob->data;
@@ -264,6 +264,8 @@ typedef struct FileListEntryPreview {
 	char path[FILE_MAX];
 	unsigned int flags;
 	int index;
+	/* Index of the library for datablock previews, owned by FileList.libindices. */
+	const struct BlendIndex *libindex;
 	ImBuf *img;
 } FileListEntryPreview;
 
@@ -309,6 +311,10 @@ typedef struct FileList {
 
 	struct BlendHandle *libfiledata;
 
+	/* Indices of the listed libraries, {lib file path : BlendIndex}. Filled by the read job and kept until
+	 * the next listing, so previews of all datablocks of a library use the same index. */
+	GHash *libindices;
+
 	/* Set given path as root directory, if last bool is true may change given string in place to a valid value.
 	 * Returns True if valid dir. */
 	bool (*checkdirf)(struct FileList *, char *, const bool);
@@ -1101,7 +1107,7 @@ static void filelist_cache_preview_runf(TaskPool *__restrict pool, void *taskdat
 	}
 
 	IMB_thumb_path_lock(preview->path);
-	preview->img = IMB_thumb_manage(preview->path, THB_LARGE, source);
+	preview->img = IMB_thumb_manage_ex(preview->path, THB_LARGE, source, preview->libindex);
 	IMB_thumb_path_unlock(preview->path);
 
 	preview->flags = 0;  /* Used to tell free func to not free anything! */
@@ -1186,7 +1192,16 @@ static void filelist_cache_previews_push(FileList *filelist, FileDirEntry *entry
 		BLI_join_dirfile(preview->path, sizeof(preview->path), filelist->filelist.root, entry->relpath);
 		preview->index = index;
 		preview->flags = entry->typeflag;
+		preview->libindex = NULL;
 		preview->img = NULL;
+
+		if ((entry->typeflag & FILE_TYPE_BLENDERLIB) && filelist->libindices) {
+			char libpath[FILE_MAX_LIBEXTRA], *group, *name;
+
+			if (BLO_library_path_explode(preview->path, libpath, &group, &name) && group && name) {
+				preview->libindex = BLI_ghash_lookup(filelist->libindices, libpath);
+			}
+		}
 //		printf("%s: %d - %s - %p\n", __func__, preview->index, preview->path, preview->img);
 
 		filelist_cache_preview_ensure_running(cache);
@@ -1347,11 +1362,23 @@ void filelist_free(struct FileList *filelist)
 	filelist->sort = FILE_SORT_NONE;
 }
 
+static void filelist_libindex_free(void *libindex)
+{
+	BLO_blendindex_free(libindex);
+}
+
 void filelist_freelib(struct FileList *filelist)
 {
 	if (filelist->libfiledata)
 		BLO_blendhandle_close(filelist->libfiledata);
 	filelist->libfiledata = NULL;
+
+	if (filelist->libindices) {
+		/* Preview tasks use the indices, wait for them to stop first. */
+		filelist_cache_previews_clear(&filelist->filelist_cache);
+		BLI_ghash_free(filelist->libindices, MEM_freeN, filelist_libindex_free);
+	}
+	filelist->libindices = NULL;
 }
 
 BlendHandle *filelist_lib(struct FileList *filelist)
@@ -2233,7 +2260,8 @@ static int filelist_readjob_list_dir(
 	return nbr_entries;
 }
 
-static int filelist_readjob_list_lib(const char *root, ListBase *entries, const bool skip_currpar)
+static int filelist_readjob_list_lib(
+        const char *root, ListBase *entries, const bool skip_currpar, struct BlendIndex **r_libindex)
 {
 	FileListInternEntry *entry;
 	LinkNode *ln, *names;
@@ -2241,7 +2269,7 @@ static int filelist_readjob_list_lib(const char *root, ListBase *entries, const
 	char dir[FILE_MAX_LIBEXTRA], *group;
 	bool ok;
 
-	struct BlendHandle *libfiledata = NULL;
+	struct BlendIndex *libindex = NULL;
 
 	/* name test */
 	ok = BLO_library_path_explode(root, dir, &group, NULL);
@@ -2250,22 +2278,23 @@ static int filelist_readjob_list_lib(const char *root, ListBase *entries, const
 	}
 
 	/* there we go */
-	libfiledata = BLO_blendhandle_from_file(dir, NULL);
-	if (libfiledata == NULL) {
+	libindex = BLO_blendindex_from_file(dir, NULL);
+	if (libindex == NULL) {
 		return nbr_entries;
 	}
 
 	/* memory for strings is passed into filelist[i].entry->relpath and freed in filelist_entry_free. */
 	if (group) {
 		idcode = groupname_to_code(group);
-		names = BLO_blendhandle_get_datablock_names(libfiledata, idcode, &nnames);
+		names = BLO_blendindex_get_datablock_names(libindex, idcode, &nnames);
 	}
 	else {
-		names = BLO_blendhandle_get_linkable_groups(libfiledata);
+		names = BLO_blendindex_get_linkable_groups(libindex);
 		nnames = BLI_linklist_count(names);
 	}
 
-	BLO_blendhandle_close(libfiledata);
+	/* Kept for the previews of the datablocks. */
+	*r_libindex = libindex;
 
 	if (!skip_currpar) {
 		entry = MEM_callocN(sizeof(*entry), __func__);
@@ -2471,6 +2500,7 @@ static void filelist_readjob_do(
 
 	while (!BLI_stack_is_empty(todo_dirs) && !(*stop)) {
 		FileListInternEntry *entry;
+		struct BlendIndex *libindex = NULL;
 		int nbr_entries = 0;
 		bool is_lib = do_lib;
 
@@ -2495,7 +2525,7 @@ static void filelist_readjob_do(
 		BLI_path_rel(rel_subdir, root);
 
 		if (do_lib) {
-			nbr_entries = filelist_readjob_list_lib(subdir, &entries, skip_currpar);
+			nbr_entries = filelist_readjob_list_lib(subdir, &entries, skip_currpar, &libindex);
 		}
 		if (!nbr_entries) {
 			is_lib = false;
@@ -2547,9 +2577,29 @@ static void filelist_readjob_do(
 			BLI_movelisttolist(&filelist->filelist.entries, &entries);
 			filelist->filelist.nbr_entries += nbr_entries;
 
+			if (libindex) {
+				char libpath[FILE_MAX_LIBEXTRA];
+
+				BLO_library_path_explode(subdir, libpath, NULL, NULL);
+				if (filelist->libindices == NULL) {
+					filelist->libindices = BLI_ghash_str_new(__func__);
+				}
+				if (BLI_ghash_haskey(filelist->libindices, libpath)) {
+					BLO_blendindex_free(libindex);
+				}
+				else {
+					BLI_ghash_insert(filelist->libindices, BLI_strdup(libpath), libindex);
+				}
+				libindex = NULL;
+			}
+
 			BLI_mutex_unlock(lock);
 		}
 
+		if (libindex) {
+			BLO_blendindex_free(libindex);
+		}
+
 		nbr_done_dirs++;
 		*progress = (float)nbr_done_dirs / (float)nbr_todo_dirs;
 		MEM_freeN(subdir);
@@ -2612,6 +2662,7 @@ static void filelist_readjob_startjob(void *flrjv, short *stop, short *do_update
 	memset(flrj->tmp_filelist->filelist_intern.curr_uuid, 0, sizeof(flrj->tmp_filelist->filelist_intern.curr_uuid));
 
 	flrj->tmp_filelist->libfiledata = NULL;
+	flrj->tmp_filelist->libindices = NULL;
 	memset(&flrj->tmp_filelist->filelist_cache, 0, sizeof(flrj->tmp_filelist->filelist_cache));
 	flrj->tmp_filelist->selection_state = NULL;
 
@@ -2639,6 +2690,28 @@ static void filelist_readjob_update(void *flrjv)
 		flrj->tmp_filelist->filelist.nbr_entries = 0;
 	}
 
+	if (flrj->tmp_filelist->libindices) {
+		GHashIterator gh_iter;
+
+		if (flrj->filelist->libindices == NULL) {
+			flrj->filelist->libindices = BLI_ghash_str_new(__func__);
+		}
+		/* Previews may already be using indices of the final list, never replace those. */
+		GHASH_ITER (gh_iter, flrj->tmp_filelist->libindices) {
+			char *libpath = BLI_ghashIterator_getKey(&gh_iter);
+			struct BlendIndex *libindex = BLI_ghashIterator_getValue(&gh_iter);
+
+			if (BLI_ghash_haskey(flrj->filelist->libindices, libpath)) {
+				MEM_freeN(libpath);
+				BLO_blendindex_free(libindex);
+			}
+			else {
+				BLI_ghash_insert(flrj->filelist->libindices, libpath, libindex);
+			}
+		}
+		BLI_ghash_clear(flrj->tmp_filelist->libindices, NULL, NULL);
+	}
+
 	BLI_mutex_unlock(&flrj->lock);
 
 	if (new_nbr_entries) {
@@ -2695,6 +2768,9 @@ void filelist_readjob_start(FileList *filelist, const bContext *C)
 	flrj->filelist = filelist;
 	BLI_strncpy(flrj->main_name, G.main->name, sizeof(flrj->main_name));
 
+	/* Libraries are indexed again by the new listing. */
+	filelist_freelib(filelist);
+
 	filelist->flags &= ~(FL_FORCE_RESET | FL_IS_READY);
 	filelist->flags |= FL_IS_PENDING;
 
@@ -37,6 +37,7 @@
 extern "C" {
 #endif
 
+struct BlendIndex;
 struct ImBuf;
 
 /** Thumbnail creation and retrieval according to the 'Thumbnail Management Standard'
@@ -79,12 +80,16 @@ void IMB_thumb_delete(const char *path, ThumbSize size);
 
 /* return the state of the thumb, needed to determine how to manage the thumb */
 ImBuf *IMB_thumb_manage(const char *path, ThumbSize size, ThumbSource source);
+/* same, blend datablock previews are taken from the given index of their file */
+ImBuf *IMB_thumb_manage_ex(const char *path, ThumbSize size, ThumbSource source,
+                           const struct BlendIndex *blen_index);
 
 /* create the necessary dirs to store the thumbnails */
 void IMB_thumb_makedirs(void);
 
 /* special function for loading a thumbnail embedded into a blend file */
-ImBuf *IMB_thumb_load_blend(const char *blen_path, const char *blen_group, const char *blen_id);
+ImBuf *IMB_thumb_load_blend(const char *blen_path, const char *blen_group, const char *blen_id,
+                            const struct BlendIndex *blen_index);
 void   IMB_thumb_overlay_blend(unsigned int *thumb, int width, int height, float aspect);
 
 /* special function for previewing fonts */
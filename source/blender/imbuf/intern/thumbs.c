@@ -311,7 +311,7 @@ void IMB_thumb_makedirs(void)
 /* create thumbnail for file and returns new imbuf for thumbnail */
 static ImBuf *thumb_create_ex(
         const char *file_path, const char *uri, const char *thumb, const bool use_hash, const char *hash,
-        const char *blen_group, const char *blen_id,
+        const char *blen_group, const char *blen_id, const struct BlendIndex *blen_index,
         ThumbSize size, ThumbSource source, ImBuf *img)
 {
 	char desc[URI_MAX + 22];
@@ -369,7 +369,7 @@ static ImBuf *thumb_create_ex(
 							img = IMB_loadiffname(file_path, IB_rect | IB_metadata, NULL);
 							break;
 						case THB_SOURCE_BLEND:
-							img = IMB_thumb_load_blend(file_path, blen_group, blen_id);
+							img = IMB_thumb_load_blend(file_path, blen_group, blen_id, blen_index);
 							break;
 						case THB_SOURCE_FONT:
 							img = IMB_thumb_load_font(file_path, tsize, tsize);
@@ -462,13 +462,16 @@ static ImBuf *thumb_create_ex(
 
 static ImBuf *thumb_create_or_fail(
         const char *file_path, const char *uri, const char *thumb, const bool use_hash, const char *hash,
-        const char *blen_group, const char *blen_id, ThumbSize size, ThumbSource source)
+        const char *blen_group, const char *blen_id, const struct BlendIndex *blen_index,
+        ThumbSize size, ThumbSource source)
 {
-	ImBuf *img = thumb_create_ex(file_path, uri, thumb, use_hash, hash, blen_group, blen_id, size, source, NULL);
+	ImBuf *img = thumb_create_ex(
+	        file_path, uri, thumb, use_hash, hash, blen_group, blen_id, blen_index, size, source, NULL);
 
 	if (!img) {
 		/* thumb creation failed, write fail thumb */
-		img = thumb_create_ex(file_path, uri, thumb, use_hash, hash, blen_group, blen_id, THB_FAIL, source, NULL);
+		img = thumb_create_ex(
+		        file_path, uri, thumb, use_hash, hash, blen_group, blen_id, blen_index, THB_FAIL, source, NULL);
 		if (img) {
 			/* we don't need failed thumb anymore */
 			IMB_freeImBuf(img);
@@ -489,7 +492,7 @@ ImBuf *IMB_thumb_create(const char *path, ThumbSize size, ThumbSource source, Im
 	}
 	thumbname_from_uri(uri, thumb_name, sizeof(thumb_name));
 
-	return thumb_create_ex(path, uri, thumb_name, false, THUMB_DEFAULT_HASH, NULL, NULL, size, source, img);
+	return thumb_create_ex(path, uri, thumb_name, false, THUMB_DEFAULT_HASH, NULL, NULL, NULL, size, source, img);
 }
 
 /* read thumbnail for file and returns new imbuf for thumbnail */
@@ -529,8 +532,10 @@ void IMB_thumb_delete(const char *path, ThumbSize size)
 }
 
 
-/* create the thumb if necessary and manage failed and old thumbs */
-ImBuf *IMB_thumb_manage(const char *org_path, ThumbSize size, ThumbSource source)
+/* create the thumb if necessary and manage failed and old thumbs,
+ * previews of blend datablocks are taken from blen_index when given (it must be the index of their file) */
+ImBuf *IMB_thumb_manage_ex(
+        const char *org_path, ThumbSize size, ThumbSource source, const struct BlendIndex *blen_index)
 {
 	char thumb_path[FILE_MAX];
 	char thumb_name[40];
@@ -614,7 +619,7 @@ ImBuf *IMB_thumb_manage(const char *org_path, ThumbSize size, ThumbSource source
 					IMB_thumb_delete(path, THB_LARGE);
 					IMB_thumb_delete(path, THB_FAIL);
 					img = thumb_create_or_fail(
-					          file_path, uri, thumb_name, use_hash, thumb_hash, blen_group, blen_id, size, source);
+					          file_path, uri, thumb_name, use_hash, thumb_hash, blen_group, blen_id, blen_index, size, source);
 				}
 			}
 			else {
@@ -622,7 +627,7 @@ ImBuf *IMB_thumb_manage(const char *org_path, ThumbSize size, ThumbSource source
 				const bool use_hash = thumbhash_from_path(file_path, source, thumb_hash);
 
 				img = thumb_create_or_fail(
-				          file_path, uri, thumb_name, use_hash, thumb_hash, blen_group, blen_id, size, source);
+				          file_path, uri, thumb_name, use_hash, thumb_hash, blen_group, blen_id, blen_index, size, source);
 			}
 		}
 	}
@@ -638,6 +643,11 @@ ImBuf *IMB_thumb_manage(const char *org_path, ThumbSize size, ThumbSource source
 	return img;
 }
 
+ImBuf *IMB_thumb_manage(const char *org_path, ThumbSize size, ThumbSource source)
+{
+	return IMB_thumb_manage_ex(org_path, size, source, NULL);
+}
+
 /* ***** Threading ***** */
 /* Thumbnail handling is not really threadsafe in itself.
  * However, as long as we do not operate on the same file, we shall have no collision.
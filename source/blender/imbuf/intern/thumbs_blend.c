@@ -50,59 +50,40 @@
 
 #include "MEM_guardedalloc.h"
 
-ImBuf *IMB_thumb_load_blend(const char *blen_path, const char *blen_group, const char *blen_id)
+ImBuf *IMB_thumb_load_blend(const char *blen_path, const char *blen_group, const char *blen_id,
+                            const BlendIndex *blen_index)
 {
 	ImBuf *ima = NULL;
 
 	if (blen_group && blen_id) {
-		LinkNode *ln, *names, *lp, *previews = NULL;
-		struct BlendHandle *libfiledata = BLO_blendhandle_from_file(blen_path, NULL);
-		int idcode = BKE_idcode_from_name(blen_group);
-		int i, nprevs, nnames;
-
-		if (libfiledata == NULL) {
-			return ima;
-		}
-
-		/* Note: we should handle all previews for a same group at once, would avoid reopening .blend file
-		 *       for each and every ID. However, this adds some complexity, so keep it for later. */
-		names = BLO_blendhandle_get_datablock_names(libfiledata, idcode, &nnames);
-		previews = BLO_blendhandle_get_previews(libfiledata, idcode, &nprevs);
-
-		BLO_blendhandle_close(libfiledata);
-
-		if (!previews || (nnames != nprevs)) {
-			if (previews != 0) {
-				/* No previews at all is not a bug! */
-				printf("%s: error, found %d items, %d previews\n", __func__, nnames, nprevs);
+		BlendIndex *libindex = NULL;
+		const PreviewImage *img;
+
+		/* Note: when listing a library, the caller passes the index of the file loaded once for all its IDs,
+		 *       see BLO_blendindex_from_file(). */
+		if (blen_index == NULL) {
+			blen_index = libindex = BLO_blendindex_from_file(blen_path, NULL);
+			if (libindex == NULL) {
+				return ima;
 			}
-			BLI_linklist_free(previews, BKE_previewimg_freefunc);
-			BLI_linklist_free(names, free);
-			return ima;
 		}
 
-		for (i = 0, ln = names, lp = previews; i < nnames; i++, ln = ln->next, lp = lp->next) {
-			const char *blockname = ln->link;
-			PreviewImage *img = lp->link;
+		img = BLO_blendindex_get_preview(blen_index, BKE_idcode_from_name(blen_group), blen_id);
+		if (img) {
+			unsigned int w = img->w[ICON_SIZE_PREVIEW];
+			unsigned int h = img->h[ICON_SIZE_PREVIEW];
+			unsigned int *rect = img->rect[ICON_SIZE_PREVIEW];
 
-			if (STREQ(blockname, blen_id)) {
-				if (img) {
-					unsigned int w = img->w[ICON_SIZE_PREVIEW];
-					unsigned int h = img->h[ICON_SIZE_PREVIEW];
-					unsigned int *rect = img->rect[ICON_SIZE_PREVIEW];
-
-					if (w > 0 && h > 0 && rect) {
-						/* first allocate imbuf for copying preview into it */
-						ima = IMB_allocImBuf(w, h, 32, IB_rect);
-						memcpy(ima->rect, rect, w * h * sizeof(unsigned int));
-					}
-				}
-				break;
+			if (w > 0 && h > 0 && rect) {
+				/* first allocate imbuf for copying preview into it */
+				ima = IMB_allocImBuf(w, h, 32, IB_rect);
+				memcpy(ima->rect, rect, w * h * sizeof(unsigned int));
 			}
 		}
 
-		BLI_linklist_free(previews, BKE_previewimg_freefunc);
-		BLI_linklist_free(names, free);
+		if (libindex) {
+			BLO_blendindex_free(libindex);
+		}
 	}
 	else {
 		BlendThumbnail *data;
@@ -60,6 +60,9 @@ typedef struct KeyBlock {
 	int uid;           /* for meshes only, match the unique number with the customdata layer */
 	
 	void  *data;       /* array of shape key values, size is (Key->elemsize * KeyBlock->totelem) */
+	struct KeyBlockDeltaCache *delta_cache;  /* runtime only, sparse offsets to the relative key, see key.c */
+	void  *data_sparse; /* file only, for keys saved sparse 'data' and 'totelem' are cleared,
+	                     * this holds 'totsparse' vertex indices followed by their coordinates */
 	char   name[64];   /* MAX_NAME (unique name, user assigned) */
 	char   vgroup[64]; /* MAX_VGROUP_NAME (optional vertex group), array gets allocated into 'weights' when set */
 
@@ -67,6 +70,9 @@ typedef struct KeyBlock {
 	float slidermin;
 	float slidermax;
 
+	int totsparse;     /* file only, see 'data_sparse' */
+	int pad2;
+
 } KeyBlock;
 
 
@@ -111,6 +111,9 @@ typedef struct ModifierData {
 	struct Scene *scene;
 
 	char *error;
+
+	/* runtime, copy of the stack result after this modifier, see modifier_result_cache_store() */
+	struct ModifierResultCache *result_cache;
 } ModifierData;
 
 typedef enum {
@@ -147,6 +150,9 @@ typedef struct LatticeModifierData {
 	char name[64];          /* optional vertexgroup name, MAX_VGROUP_NAME */
 	float strength;
 	char pad[4];
+
+	/* runtime only, lattice cells of the deformed points, see lattice_deform_verts_ex() */
+	struct LatticeDeformCache *cache;
 } LatticeModifierData;
 
 typedef struct CurveModifierData {
@@ -547,6 +553,9 @@ typedef struct ArmatureModifierData {
 	struct Object *object;
 	float *prevCos;           /* stored input of previous modifier, for vertexgroup blending */
 	char defgrp_name[64];     /* MAX_VGROUP_NAME */
+
+	/* runtime only, channels and weights of each vertex, see armature_deform_verts_ex() */
+	struct ArmatureSkinCache *skin_cache;
 } ArmatureModifierData;
 
 enum {
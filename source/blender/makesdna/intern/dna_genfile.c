@@ -46,6 +46,8 @@
 #include "BLI_utildefines.h"
 #include "BLI_endian_switch.h"
 
+#include "atomic_ops.h"
+
 #ifdef WITH_DNA_GHASH
 #  include "BLI_ghash.h"
 #endif
@@ -751,28 +753,18 @@ static eSDNA_Type sdna_type_nr(const char *dna_type)
  * Note there is no optimization for the case where otype and ctype are the same:
  * assumption is that caller will handle this case.
  *
- * \param ctype  Name of type to convert to
- * \param otype  Name of type to convert from
- * \param name  Field name to extract array-size information
+ * \param ctypenr  Type to convert to
+ * \param otypenr  Type to convert from
+ * \param arrlen  Number of elements to convert
  * \param curdata  Where to put converted data
  * \param olddata  Data of type otype to convert
  */
 static void cast_elem(
-        const char *ctype, const char *otype, const char *name,
+        eSDNA_Type ctypenr, eSDNA_Type otypenr, int arrlen,
         char *curdata, const char *olddata)
 {
 	double val = 0.0;
-	int arrlen, curlen = 1, oldlen = 1;
-
-	eSDNA_Type ctypenr, otypenr;
-
-	arrlen = DNA_elem_array_size(name);
-
-	if ( (otypenr = sdna_type_nr(otype)) == -1 ||
-	     (ctypenr = sdna_type_nr(ctype)) == -1)
-	{
-		return;
-	}
+	int curlen = 1, oldlen = 1;
 
 	/* define lengths */
 	oldlen = DNA_elem_type_size(otypenr);
@@ -836,23 +828,17 @@ static void cast_elem(
  *
  * \param curlen  Pointer length to conver to
  * \param oldlen  Length of pointers in olddata
- * \param name  Field name to extract array-size information
+ * \param arrlen  Number of pointers to convert
  * \param curdata  Where to put converted data
  * \param olddata  Data to convert
  */
-static void cast_pointer(int curlen, int oldlen, const char *name, char *curdata, const char *olddata)
+static void cast_pointer(int curlen, int oldlen, int arrlen, char *curdata, const char *olddata)
 {
 	int64_t lval;
-	int arrlen;
-	
-	arrlen = DNA_elem_array_size(name);
 	
 	while (arrlen > 0) {
 	
-		if (curlen == oldlen) {
-			memcpy(curdata, olddata, curlen);
-		}
-		else if (curlen == 4 && oldlen == 8) {
+		if (curlen == 4 && oldlen == 8) {
 			lval = *((int64_t *)olddata);
 
 			/* WARNING: 32-bit Blender trying to load file saved by 64-bit Blender,
@@ -863,10 +849,6 @@ static void cast_pointer(int curlen, int oldlen, const char *name, char *curdata
 		else if (curlen == 8 && oldlen == 4) {
 			*((int64_t *)curdata) = *((int *)olddata);
 		}
-		else {
-			/* for debug */
-			printf("errpr: illegal pointersize!\n");
-		}
 		
 		olddata += oldlen;
 		curdata += curlen;
@@ -892,27 +874,25 @@ static int elem_strcmp(const char *name, const char *oname)
 }
 
 /**
- * Returns the address of the data for the specified field within olddata
- * according to the struct format pointed to by old, or NULL if no such
+ * Returns the offset of the data for the specified field
+ * according to the struct format pointed to by old, or -1 if no such
  * field can be found.
  *
  * \param sdna  Old SDNA
  * \param type  Current field type name
  * \param name  Current field name
  * \param old  Pointer to struct information in sdna
- * \param olddata  Struct data
  * \param sppo  Optional place to return pointer to field info in sdna
- * \return Data address.
+ * \return Data offset.
  */
-static const char *find_elem(
+static int find_elem_offset(
         const SDNA *sdna,
         const char *type,
         const char *name,
         const short *old,
-        const char *olddata,
         const short **sppo)
 {
-	int a, elemcount, len;
+	int a, elemcount, len, offset = 0;
 	const char *otype, *oname;
 	
 	/* without arraypart, so names can differ: return old namenr and type */
@@ -930,37 +910,182 @@ static const char *find_elem(
 		if (elem_strcmp(name, oname) == 0) {  /* name equal */
 			if (strcmp(type, otype) == 0) {   /* type equal */
 				if (sppo) *sppo = old;
-				return olddata;
+				return offset;
 			}
 			
-			return NULL;
+			return -1;
 		}
 		
-		olddata += len;
+		offset += len;
 	}
-	return NULL;
+	return -1;
 }
 
 /**
- * Converts the contents of a single field of a struct, of a non-struct type,
+ * Returns the address of the data for the specified field within olddata
+ * according to the struct format pointed to by old, or NULL if no such
+ * field can be found.
+ *
+ * \param sdna  Old SDNA
+ * \param type  Current field type name
+ * \param name  Current field name
+ * \param old  Pointer to struct information in sdna
+ * \param olddata  Struct data
+ * \param sppo  Optional place to return pointer to field info in sdna
+ * \return Data address.
+ */
+static const char *find_elem(
+        const SDNA *sdna,
+        const char *type,
+        const char *name,
+        const short *old,
+        const char *olddata,
+        const short **sppo)
+{
+	const int offset = find_elem_offset(sdna, type, name, old, sppo);
+	return (offset != -1) ? olddata + offset : NULL;
+}
+
+/* -------------------------------------------------------------------- */
+
+/** \name Reconstruct Plans
+ *
+ * Converting a struct from oldsdna to newsdna format only depends on both SDNA's,
+ * so the field lookups (string comparisons) are done once per struct type,
+ * resulting in a list of steps which is then applied to all blocks of that type.
+ * \{ */
+
+typedef enum eReconstructStepType {
+	/* plain copy, also used for (nested) structs which didn't change */
+	RECONSTRUCT_STEP_MEMCPY,
+	/* convert an array of primitive values, see #cast_elem */
+	RECONSTRUCT_STEP_CAST_PRIMITIVE,
+	/* convert an array of pointers to a different pointer size, see #cast_pointer */
+	RECONSTRUCT_STEP_CAST_POINTER,
+} eReconstructStepType;
+
+typedef struct ReconstructStep {
+	eReconstructStepType type;
+	int old_offset, new_offset;
+	union {
+		struct {
+			int size;
+		} memcpy;
+		struct {
+			eSDNA_Type old_type, new_type;
+			int array_len;
+		} cast_primitive;
+		struct {
+			int array_len;
+		} cast_pointer;
+	} data;
+} ReconstructStep;
+
+typedef struct ReconstructPlan {
+	ReconstructStep *steps;
+	int steps_len, steps_alloc;
+	/* size of the struct in newsdna, zero when it's removed */
+	int new_len;
+} ReconstructPlan;
+
+typedef struct DNA_ReconstructInfo {
+	const SDNA *oldsdna;
+	const SDNA *newsdna;
+	const char *compflags;
+
+	/* plans for the structs of oldsdna, created on first use */
+	ReconstructPlan **plans;
+} DNA_ReconstructInfo;
+
+static void reconstruct_plan_add_step(ReconstructPlan *plan, const ReconstructStep *step)
+{
+	if ((step->type == RECONSTRUCT_STEP_MEMCPY) && plan->steps_len) {
+		ReconstructStep *step_prev = &plan->steps[plan->steps_len - 1];
+
+		/* merge with the previous copy when they are contiguous (most of the fields) */
+		if ((step_prev->type == RECONSTRUCT_STEP_MEMCPY) &&
+		    (step_prev->old_offset + step_prev->data.memcpy.size == step->old_offset) &&
+		    (step_prev->new_offset + step_prev->data.memcpy.size == step->new_offset))
+		{
+			step_prev->data.memcpy.size += step->data.memcpy.size;
+			return;
+		}
+	}
+
+	if (plan->steps_len == plan->steps_alloc) {
+		plan->steps_alloc = plan->steps_alloc ? plan->steps_alloc * 2 : 8;
+		plan->steps = MEM_reallocN(plan->steps, sizeof(*plan->steps) * plan->steps_alloc);
+	}
+	plan->steps[plan->steps_len++] = *step;
+}
+
+static void reconstruct_plan_add_memcpy(ReconstructPlan *plan, int old_offset, int new_offset, int size)
+{
+	if (size > 0) {
+		const ReconstructStep step = {
+			.type = RECONSTRUCT_STEP_MEMCPY, .old_offset = old_offset, .new_offset = new_offset,
+			.data.memcpy.size = size,
+		};
+		reconstruct_plan_add_step(plan, &step);
+	}
+}
+
+static void reconstruct_plan_add_cast_primitive(
+        ReconstructPlan *plan, int old_offset, int new_offset,
+        const char *otype, const char *type, int array_len)
+{
+	const eSDNA_Type otypenr = sdna_type_nr(otype);
+	const eSDNA_Type ctypenr = sdna_type_nr(type);
+
+	if ((otypenr != -1) && (ctypenr != -1)) {
+		const ReconstructStep step = {
+			.type = RECONSTRUCT_STEP_CAST_PRIMITIVE, .old_offset = old_offset, .new_offset = new_offset,
+			.data.cast_primitive = {.old_type = otypenr, .new_type = ctypenr, .array_len = array_len},
+		};
+		reconstruct_plan_add_step(plan, &step);
+	}
+}
+
+static void reconstruct_plan_add_cast_pointer(
+        const DNA_ReconstructInfo *info, ReconstructPlan *plan, int old_offset, int new_offset, int array_len)
+{
+	const int curlen = info->newsdna->pointerlen;
+	const int oldlen = info->oldsdna->pointerlen;
+
+	if (curlen == oldlen) {
+		reconstruct_plan_add_memcpy(plan, old_offset, new_offset, curlen * array_len);
+	}
+	else if ((curlen == 4 && oldlen == 8) || (curlen == 8 && oldlen == 4)) {
+		const ReconstructStep step = {
+			.type = RECONSTRUCT_STEP_CAST_POINTER, .old_offset = old_offset, .new_offset = new_offset,
+			.data.cast_pointer.array_len = array_len,
+		};
+		reconstruct_plan_add_step(plan, &step);
+	}
+	else {
+		/* for debug */
+		printf("errpr: illegal pointersize!\n");
+	}
+}
+
+/**
+ * Adds the steps converting the contents of a single field of a struct, of a non-struct type,
  * from oldsdna to newsdna format.
  *
- * \param newsdna  SDNA of current Blender
- * \param oldsdna  SDNA of Blender that saved file
  * \param type  current field type name
  * \param name  current field name
- * \param curdata  put field data converted to newsdna here
+ * \param new_offset  where to put the converted field
  * \param old  pointer to struct info in oldsdna
- * \param olddata  struct contents laid out according to oldsdna
+ * \param old_offset  offset of the struct laid out according to oldsdna
  */
-static void reconstruct_elem(
-        const SDNA *newsdna,
-        const SDNA *oldsdna,
+static void reconstruct_plan_add_elem(
+        const DNA_ReconstructInfo *info,
+        ReconstructPlan *plan,
         const char *type,
         const char *name,
-        char *curdata,
+        int new_offset,
         const short *old,
-        const char *olddata)
+        int old_offset)
 {
 	/* rules: test for NAME:
 	 *      - name equal:
@@ -971,6 +1096,7 @@ static void reconstruct_elem(
 	 * (nzc 2-4-2001 I want the 'unsigned' bit to be parsed as well. Where
 	 * can I force this?)
 	 */
+	const SDNA *oldsdna = info->oldsdna;
 	int a, elemcount, len, countpos, oldsize, cursize, mul;
 	const char *otype, *oname, *cp;
 	
@@ -993,13 +1119,14 @@ static void reconstruct_elem(
 		if (strcmp(name, oname) == 0) { /* name equal */
 			
 			if (ispointer(name)) {  /* pointer of functionpointer afhandelen */
-				cast_pointer(newsdna->pointerlen, oldsdna->pointerlen, name, curdata, olddata);
+				reconstruct_plan_add_cast_pointer(info, plan, old_offset, new_offset, DNA_elem_array_size(name));
 			}
 			else if (strcmp(type, otype) == 0) {    /* type equal */
-				memcpy(curdata, olddata, len);
+				reconstruct_plan_add_memcpy(plan, old_offset, new_offset, len);
 			}
 			else {
-				cast_elem(type, otype, name, curdata, olddata);
+				reconstruct_plan_add_cast_primitive(
+				        plan, old_offset, new_offset, otype, type, DNA_elem_array_size(name));
 			}
 
 			return;
@@ -1012,78 +1139,71 @@ static void reconstruct_elem(
 				oldsize = DNA_elem_array_size(oname);
 
 				if (ispointer(name)) {  /* handle pointer or functionpointer */
-					cast_pointer(newsdna->pointerlen, oldsdna->pointerlen,
-					             cursize > oldsize ? oname : name,
-					             curdata, olddata);
+					reconstruct_plan_add_cast_pointer(
+					        info, plan, old_offset, new_offset, MIN2(cursize, oldsize));
 				}
 				else if (strcmp(type, otype) == 0) {  /* type equal */
 					mul = len / oldsize; /* size of single old array element */
 					mul *= (cursize < oldsize) ? cursize : oldsize; /* smaller of sizes of old and new arrays */
-					memcpy(curdata, olddata, mul);
-					
+
 					if (oldsize > cursize && strcmp(type, "char") == 0) {
-						/* string had to be truncated, ensure it's still null-terminated */
-						curdata[mul - 1] = '\0';
+						/* string had to be truncated, ensure it's still null-terminated
+						 * (reconstructed data is zero initialized, skip the last char) */
+						mul -= 1;
 					}
+
+					reconstruct_plan_add_memcpy(plan, old_offset, new_offset, mul);
 				}
 				else {
-					cast_elem(type, otype,
-					          cursize > oldsize ? oname : name,
-					          curdata, olddata);
+					reconstruct_plan_add_cast_primitive(
+					        plan, old_offset, new_offset, otype, type, MIN2(cursize, oldsize));
 				}
 				return;
 			}
 		}
-		olddata += len;
+		old_offset += len;
 	}
 }
 
+static const ReconstructPlan *reconstruct_plan_ensure(const DNA_ReconstructInfo *info, int oldSDNAnr);
+
 /**
- * Converts the contents of an entire struct from oldsdna to newsdna format.
+ * Adds the steps converting the contents of an entire struct from oldsdna to newsdna format.
  *
- * \param newsdna  SDNA of current Blender
- * \param oldsdna  SDNA of Blender that saved file
- * \param compflags
- *
- * Result from DNA_struct_get_compareflags to avoid needless conversions.
  * \param oldSDNAnr  Index of old struct definition in oldsdna
- * \param data  Struct contents laid out according to oldsdna
+ * \param old_offset  Offset of the struct contents laid out according to oldsdna
  * \param curSDNAnr  Index of current struct definition in newsdna
- * \param cur  Where to put converted struct contents
+ * \param new_offset  Where to put converted struct contents
  */
-static void reconstruct_struct(
-        const SDNA *newsdna,
-        const SDNA *oldsdna,
-        const char *compflags,
-
+static void reconstruct_plan_add_struct(
+        const DNA_ReconstructInfo *info,
+        ReconstructPlan *plan,
         int oldSDNAnr,
-        const char *data,
+        int old_offset,
         int curSDNAnr,
-        char *cur)
+        int new_offset)
 {
 	/* Recursive!
 	 * Per element from cur_struct, read data from old_struct.
-	 * If element is a struct, call recursive.
+	 * If element is a struct, add the steps of its own plan.
 	 */
-	int a, elemcount, elen, eleno, mul, mulo, firststructtypenr;
+	const SDNA *oldsdna = info->oldsdna;
+	const SDNA *newsdna = info->newsdna;
+	int a, elemcount, elen, elen_item, eleno, mul, mulo, firststructtypenr;
 	const short *spo, *spc, *sppo;
 	const char *type;
-	const char *cpo;
-	char *cpc;
 	const char *name, *nameo;
 
 	unsigned int oldsdna_index_last = UINT_MAX;
-	unsigned int cursdna_index_last = UINT_MAX;
-
 
 	if (oldSDNAnr == -1) return;
 	if (curSDNAnr == -1) return;
 
-	if (compflags[oldSDNAnr] == SDNA_CMP_EQUAL) {
+	if (info->compflags[oldSDNAnr] == SDNA_CMP_EQUAL) {
 		/* if recursive: test for equal */
 		spo = oldsdna->structs[oldSDNAnr];
 		elen = oldsdna->typelens[spo[0]];
-		memcpy(cur, data, elen);
+		reconstruct_plan_add_memcpy(plan, old_offset, new_offset, elen);
 		
 		return;
 	}
@@ -1096,7 +1216,6 @@ static void reconstruct_struct(
 	elemcount = spc[1];
 
 	spc += 2;
-	cpc = cur;
 	for (a = 0; a < elemcount; a++, spc += 2) {  /* convert each field */
 		type = newsdna->types[spc[0]];
 		name = newsdna->names[spc[1]];
@@ -1107,44 +1226,162 @@ static void reconstruct_struct(
 		if (spc[0] >= firststructtypenr && !ispointer(name)) {
 			/* struct field type */
 			/* where does the old struct data start (and is there an old one?) */
-			cpo = (char *)find_elem(oldsdna, type, name, spo, data, &sppo);
+			const int elem_offset = find_elem_offset(oldsdna, type, name, spo, &sppo);
 			
-			if (cpo) {
+			if (elem_offset != -1) {
+				const ReconstructPlan *plan_elem;
+				int elem_old_offset = old_offset + elem_offset;
+				int elem_new_offset = new_offset;
+
 				oldSDNAnr = DNA_struct_find_nr_ex(oldsdna, type, &oldsdna_index_last);
-				curSDNAnr = DNA_struct_find_nr_ex(newsdna, type, &cursdna_index_last);
+				if (oldSDNAnr == -1) {
+					new_offset += elen;
+					continue;
+				}
+				plan_elem = reconstruct_plan_ensure(info, oldSDNAnr);
 				
 				/* array! */
 				mul = DNA_elem_array_size(name);
 				nameo = oldsdna->names[sppo[1]];
 				mulo = DNA_elem_array_size(nameo);
 				
-				eleno = elementsize(oldsdna, sppo[0], sppo[1]);
-				
-				elen /= mul;
-				eleno /= mulo;
+				/* size of a single array element */
+				eleno = elementsize(oldsdna, sppo[0], sppo[1]) / mulo;
+				elen_item = elen / mul;
 				
 				while (mul--) {
-					reconstruct_struct(newsdna, oldsdna, compflags, oldSDNAnr, cpo, curSDNAnr, cpc);
-					cpo += eleno;
-					cpc += elen;
+					int b;
+					for (b = 0; b < plan_elem->steps_len; b++) {
+						ReconstructStep step = plan_elem->steps[b];
+						step.old_offset += elem_old_offset;
+						step.new_offset += elem_new_offset;
+						reconstruct_plan_add_step(plan, &step);
+					}
+					elem_old_offset += eleno;
+					elem_new_offset += elen_item;
 					
 					/* new struct array larger than old */
 					mulo--;
 					if (mulo <= 0) break;
 				}
 			}
-			else {
-				cpc += elen;  /* skip field no longer present */
-			}
 		}
 		else {
 			/* non-struct field type */
-			reconstruct_elem(newsdna, oldsdna, type, name, cpc, spo, data);
-			cpc += elen;
+			reconstruct_plan_add_elem(info, plan, type, name, new_offset, spo, old_offset);
+		}
+
+		new_offset += elen;
+	}
+}
+
+static ReconstructPlan *reconstruct_plan_create(const DNA_ReconstructInfo *info, int oldSDNAnr)
+{
+	const SDNA *oldsdna = info->oldsdna;
+	const SDNA *newsdna = info->newsdna;
+	const short *spo = oldsdna->structs[oldSDNAnr];
+	const int curSDNAnr = DNA_struct_find_nr(newsdna, oldsdna->types[spo[0]]);
+	ReconstructPlan *plan = MEM_callocN(sizeof(*plan), __func__);
+
+	if (curSDNAnr != -1) {
+		const short *spc = newsdna->structs[curSDNAnr];
+		plan->new_len = newsdna->typelens[spc[0]];
+		reconstruct_plan_add_struct(info, plan, oldSDNAnr, 0, curSDNAnr, 0);
+	}
+
+	return plan;
+}
+
+static void reconstruct_plan_free(ReconstructPlan *plan)
+{
+	MEM_SAFE_FREE(plan->steps);
+	MEM_freeN(plan);
+}
+
+/**
+ * Plans are created on first use, blocks may be reconstructed from multiple threads
+ * so when two threads create the same plan, only the first one is kept.
+ */
+static const ReconstructPlan *reconstruct_plan_ensure(const DNA_ReconstructInfo *info, int oldSDNAnr)
+{
+	ReconstructPlan *plan = info->plans[oldSDNAnr];
+
+	if (plan == NULL) {
+		ReconstructPlan *plan_prev;
+
+		plan = reconstruct_plan_create(info, oldSDNAnr);
+		plan_prev = (ReconstructPlan *)atomic_cas_z((size_t *)&info->plans[oldSDNAnr], 0, (size_t)plan);
+		if (plan_prev != NULL) {
+			reconstruct_plan_free(plan);
+			plan = plan_prev;
+		}
+	}
+
+	return plan;
+}
+
+/**
+ * \param oldsdna  SDNA of Blender that saved file
+ * \param newsdna  SDNA of current Blender
+ * \param compflags
+ *
+ * Result from DNA_struct_get_compareflags to avoid needless conversions,
+ * must stay valid as long as the returned info is used.
+ */
+DNA_ReconstructInfo *DNA_reconstruct_info_create(
+        const SDNA *oldsdna, const SDNA *newsdna, const char *compflags)
+{
+	DNA_ReconstructInfo *info = MEM_mallocN(sizeof(*info), __func__);
+
+	info->oldsdna = oldsdna;
+	info->newsdna = newsdna;
+	info->compflags = compflags;
+	info->plans = MEM_callocN(sizeof(*info->plans) * oldsdna->nr_structs, __func__);
+
+	return info;
+}
+
+void DNA_reconstruct_info_free(DNA_ReconstructInfo *info)
+{
+	int a;
+
+	for (a = 0; a < info->oldsdna->nr_structs; a++) {
+		if (info->plans[a]) {
+			reconstruct_plan_free(info->plans[a]);
 		}
 	}
+	MEM_freeN(info->plans);
+	MEM_freeN(info);
 }
 
+static void reconstruct_struct(
+        const DNA_ReconstructInfo *info, const ReconstructPlan *plan,
+        const char *olddata, char *curdata)
+{
+	const ReconstructStep *step = plan->steps;
+	int a;
+
+	for (a = 0; a < plan->steps_len; a++, step++) {
+		switch (step->type) {
+			case RECONSTRUCT_STEP_MEMCPY:
+				memcpy(curdata + step->new_offset, olddata + step->old_offset, step->data.memcpy.size);
+				break;
+			case RECONSTRUCT_STEP_CAST_PRIMITIVE:
+				cast_elem(step->data.cast_primitive.new_type, step->data.cast_primitive.old_type,
+				          step->data.cast_primitive.array_len,
+				          curdata + step->new_offset, olddata + step->old_offset);
+				break;
+			case RECONSTRUCT_STEP_CAST_POINTER:
+				cast_pointer(info->newsdna->pointerlen, info->oldsdna->pointerlen,
+				             step->data.cast_pointer.array_len,
+				             curdata + step->new_offset, olddata + step->old_offset);
+				break;
+		}
+	}
+}
+
+/** \} */
+
 /**
  * Does endian swapping on the fields of a struct value.
  *
@@ -1234,46 +1471,32 @@ void DNA_struct_switch_endian(const SDNA *oldsdna, int oldSDNAnr, char *data)
 }
 
 /**
- * \param newsdna  SDNA of current Blender
- * \param oldsdna  SDNA of Blender that saved file
- * \param compflags
- *
- * Result from DNA_struct_get_compareflags to avoid needless conversions
+ * \param reconstruct_info  Result from #DNA_reconstruct_info_create
  * \param oldSDNAnr  Index of struct info within oldsdna
  * \param blocks  The number of array elements
  * \param data  Array of struct data
  * \return An allocated reconstructed struct
  */
 void *DNA_struct_reconstruct(
-        const SDNA *newsdna, const SDNA *oldsdna,
-        const char *compflags, int oldSDNAnr, int blocks, const void *data)
+        const DNA_ReconstructInfo *reconstruct_info, int oldSDNAnr, int blocks, const void *data)
 {
-	int a, curSDNAnr, curlen = 0, oldlen;
-	const short *spo, *spc;
+	const ReconstructPlan *plan = reconstruct_plan_ensure(reconstruct_info, oldSDNAnr);
+	const int oldlen = reconstruct_info->oldsdna->typelens[reconstruct_info->oldsdna->structs[oldSDNAnr][0]];
+	const int curlen = plan->new_len;
+	int a;
 	char *cur, *cpc;
 	const char *cpo;
-	const char *type;
-	
-	/* oldSDNAnr == structnr, we're looking for the corresponding 'cur' number */
-	spo = oldsdna->structs[oldSDNAnr];
-	type = oldsdna->types[spo[0]];
-	oldlen = oldsdna->typelens[spo[0]];
-	curSDNAnr = DNA_struct_find_nr(newsdna, type);
 
-	/* init data and alloc */
-	if (curSDNAnr != -1) {
-		spc = newsdna->structs[curSDNAnr];
-		curlen = newsdna->typelens[spc[0]];
-	}
 	if (curlen == 0) {
 		return NULL;
 	}
 
+	/* zero initialized, see #reconstruct_plan_add_elem */
 	cur = MEM_callocN(blocks * curlen, "reconstruct");
 	cpc = cur;
 	cpo = data;
 	for (a = 0; a < blocks; a++) {
-		reconstruct_struct(newsdna, oldsdna, compflags, oldSDNAnr, cpo, curSDNAnr, cpc);
+		reconstruct_struct(reconstruct_info, plan, cpo, cpc);
 		cpc += curlen;
 		cpo += oldlen;
 	}
@@ -79,6 +79,16 @@ static void rna_Depsgraph_debug_stats(Depsgraph *graph, ReportList *reports)
 	            ops, rels, outer);
 }
 
+static void rna_Depsgraph_debug_profile_begin(Depsgraph *UNUSED(graph), const char *filename)
+{
+	DEG_debug_profile_begin(filename[0] ? filename : NULL);
+}
+
+static int rna_Depsgraph_debug_profile_end(Depsgraph *UNUSED(graph))
+{
+	return DEG_debug_profile_end();
+}
+
 #else
 
 static void rna_def_depsgraph(BlenderRNA *brna)
@@ -101,6 +111,16 @@ static void rna_def_depsgraph(BlenderRNA *brna)
 	func = RNA_def_function(srna, "debug_stats", "rna_Depsgraph_debug_stats");
 	RNA_def_function_ui_description(func, "Report the number of elements in the Dependency Graph");
 	RNA_def_function_flag(func, FUNC_USE_REPORTS);
+
+	func = RNA_def_function(srna, "debug_profile_begin", "rna_Depsgraph_debug_profile_begin");
+	RNA_def_function_ui_description(func, "Start recording the evaluation time of every operation");
+	RNA_def_string_file_path(func, "filename", NULL, FILE_MAX, "File Name",
+	                         "File in which to store the Chrome trace of the evaluations when profiling ends");
+
+	func = RNA_def_function(srna, "debug_profile_end", "rna_Depsgraph_debug_profile_end");
+	RNA_def_function_ui_description(func, "Stop profiling, write the trace and print the critical path summary");
+	parm = RNA_def_boolean(func, "result", false, "Result", "False if the trace failed to write");
+	RNA_def_function_return(func, parm);
 }
 
 void RNA_def_depsgraph(BlenderRNA *brna)
@@ -481,6 +481,9 @@ static void rna_Key_update_data(Main *bmain, Scene *UNUSED(scene), PointerRNA *p
 	Key *key = ptr->id.data;
 	Object *ob;
 
+	/* key data may have been changed in place, done once here rather than for every point set */
+	BKE_key_delta_cache_free(key);
+
 	for (ob = bmain->object.first; ob; ob = ob->id.next) {
 		if (BKE_key_from_object(ob) == key) {
 			DAG_id_tag_update(&ob->id, OB_RECALC_DATA);
@@ -204,6 +204,30 @@ static void engine_bake(RenderEngine *engine, struct Scene *scene,
 	RNA_parameter_list_free(&list);
 }
 
+static void engine_bake_multi(RenderEngine *engine, struct Scene *scene,
+                              const struct BakeJob *jobs, const int num_jobs,
+                              const int pass_type, const int pass_filter, const int depth)
+{
+	extern FunctionRNA rna_RenderEngine_bake_multi_func;
+	PointerRNA ptr;
+	ParameterList list;
+	FunctionRNA *func;
+
+	RNA_pointer_create(NULL, engine->type->ext.srna, engine, &ptr);
+	func = &rna_RenderEngine_bake_multi_func;
+
+	RNA_parameter_list_create(&list, &ptr, func);
+	RNA_parameter_set_lookup(&list, "scene", &scene);
+	RNA_parameter_set_lookup(&list, "jobs", &jobs);
+	RNA_parameter_set_lookup(&list, "num_jobs", &num_jobs);
+	RNA_parameter_set_lookup(&list, "pass_type", &pass_type);
+	RNA_parameter_set_lookup(&list, "pass_filter", &pass_filter);
+	RNA_parameter_set_lookup(&list, "depth", &depth);
+	engine->type->ext.call(NULL, &ptr, func, &list);
+
+	RNA_parameter_list_free(&list);
+}
+
 static void engine_view_update(RenderEngine *engine, const struct bContext *context)
 {
 	extern FunctionRNA rna_RenderEngine_view_update_func;
@@ -276,7 +300,7 @@ static StructRNA *rna_RenderEngine_register(Main *bmain, ReportList *reports, vo
 	RenderEngineType *et, dummyet = {NULL};
 	RenderEngine dummyengine = {NULL};
 	PointerRNA dummyptr;
-	int have_function[6];
+	int have_function[7];
 
 	/* setup dummy engine & engine type to store static properties in */
 	dummyengine.type = &dummyet;
@@ -315,9 +339,10 @@ static StructRNA *rna_RenderEngine_register(Main *bmain, ReportList *reports, vo
 	et->update = (have_function[0]) ? engine_update : NULL;
 	et->render = (have_function[1]) ? engine_render : NULL;
 	et->bake = (have_function[2]) ? engine_bake : NULL;
-	et->view_update = (have_function[3]) ? engine_view_update : NULL;
-	et->view_draw = (have_function[4]) ? engine_view_draw : NULL;
-	et->update_script_node = (have_function[5]) ? engine_update_script_node : NULL;
+	et->bake_multi = (have_function[3]) ? engine_bake_multi : NULL;
+	et->view_update = (have_function[4]) ? engine_view_update : NULL;
+	et->view_draw = (have_function[5]) ? engine_view_draw : NULL;
+	et->update_script_node = (have_function[6]) ? engine_update_script_node : NULL;
 
 	BLI_addtail(&R_engines, et);
 
@@ -409,6 +434,30 @@ static PointerRNA rna_BakePixel_next_get(PointerRNA *ptr)
 	return rna_pointer_inherit_refine(ptr, &RNA_BakePixel, bp + 1);
 }
 
+static PointerRNA rna_BakeJob_object_get(PointerRNA *ptr)
+{
+	BakeJob *job = ptr->data;
+	return rna_pointer_inherit_refine(ptr, &RNA_Object, job->object);
+}
+
+static PointerRNA rna_BakeJob_pixel_array_get(PointerRNA *ptr)
+{
+	BakeJob *job = ptr->data;
+	return rna_pointer_inherit_refine(ptr, &RNA_BakePixel, (void *)job->pixel_array);
+}
+
+static PointerRNA rna_BakeJob_result_get(PointerRNA *ptr)
+{
+	BakeJob *job = ptr->data;
+	return rna_pointer_inherit_refine(ptr, &RNA_AnyType, job->result);
+}
+
+static PointerRNA rna_BakeJob_next_get(PointerRNA *ptr)
+{
+	BakeJob *job = ptr->data;
+	return rna_pointer_inherit_refine(ptr, &RNA_BakeJob, job + 1);
+}
+
 static RenderPass *rna_RenderPass_find_by_type(RenderLayer *rl, int passtype, const char *view)
 {
 	return RE_pass_find_by_type(rl, passtype, view);
@@ -466,6 +515,22 @@ static void rna_def_render_engine(BlenderRNA *brna)
 	parm = RNA_def_pointer(func, "result", "AnyType", "", "");
 	RNA_def_parameter_flags(parm, 0, PARM_REQUIRED);
 
+	func = RNA_def_function(srna, "bake_multi", NULL);
+	RNA_def_function_ui_description(func, "Bake a pass of several objects at once");
+	RNA_def_function_flag(func, FUNC_REGISTER_OPTIONAL | FUNC_ALLOW_WRITE);
+	parm = RNA_def_pointer(func, "scene", "Scene", "", "");
+	RNA_def_parameter_flags(parm, 0, PARM_REQUIRED);
+	parm = RNA_def_pointer(func, "jobs", "BakeJob", "", "First of the jobs to bake");
+	RNA_def_parameter_flags(parm, 0, PARM_REQUIRED);
+	parm = RNA_def_int(func, "num_jobs", 0, 0, INT_MAX, "Number of Jobs", "Number of jobs to bake", 0, INT_MAX);
+	RNA_def_parameter_flags(parm, 0, PARM_REQUIRED);
+	parm = RNA_def_enum(func, "pass_type", rna_enum_bake_pass_type_items, 0, "Pass", "Pass to bake");
+	RNA_def_parameter_flags(parm, 0, PARM_REQUIRED);
+	parm = RNA_def_int(func, "pass_filter", 0, 0, INT_MAX, "Pass Filter", "Filter to combined, diffuse, glossy, transmission and subsurface passes", 0, INT_MAX);
+	RNA_def_parameter_flags(parm, 0, PARM_REQUIRED);
+	parm = RNA_def_int(func, "depth", 0, 0, INT_MAX, "Pixels depth", "Number of channels", 1, INT_MAX);
+	RNA_def_parameter_flags(parm, 0, PARM_REQUIRED);
+
 	/* viewport render callbacks */
 	func = RNA_def_function(srna, "view_update", NULL);
 	RNA_def_function_ui_description(func, "Update on data changes for viewport render");
@@ -900,6 +965,47 @@ static void rna_def_render_bake_pixel(BlenderRNA *brna)
 	RNA_define_verify_sdna(1);
 }
 
+static void rna_def_render_bake_job(BlenderRNA *brna)
+{
+	StructRNA *srna;
+	PropertyRNA *prop;
+
+	srna = RNA_def_struct(brna, "BakeJob", NULL);
+	RNA_def_struct_ui_text(srna, "Bake Job", "Pixels of an object to bake");
+
+	RNA_define_verify_sdna(0);
+
+	prop = RNA_def_property(srna, "object", PROP_POINTER, PROP_NONE);
+	RNA_def_property_struct_type(prop, "Object");
+	RNA_def_property_pointer_funcs(prop, "rna_BakeJob_object_get", NULL, NULL, NULL);
+	RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+
+	prop = RNA_def_property(srna, "object_id", PROP_INT, PROP_NONE);
+	RNA_def_property_int_sdna(prop, NULL, "object_id");
+	RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+
+	prop = RNA_def_property(srna, "num_pixels", PROP_INT, PROP_NONE);
+	RNA_def_property_int_sdna(prop, NULL, "num_pixels");
+	RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+
+	prop = RNA_def_property(srna, "pixel_array", PROP_POINTER, PROP_NONE);
+	RNA_def_property_struct_type(prop, "BakePixel");
+	RNA_def_property_pointer_funcs(prop, "rna_BakeJob_pixel_array_get", NULL, NULL, NULL);
+	RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+
+	prop = RNA_def_property(srna, "result", PROP_POINTER, PROP_NONE);
+	RNA_def_property_struct_type(prop, "AnyType");
+	RNA_def_property_pointer_funcs(prop, "rna_BakeJob_result_get", NULL, NULL, NULL);
+	RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+
+	prop = RNA_def_property(srna, "next", PROP_POINTER, PROP_NONE);
+	RNA_def_property_struct_type(prop, "BakeJob");
+	RNA_def_property_pointer_funcs(prop, "rna_BakeJob_next_get", NULL, NULL, NULL);
+	RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+
+	RNA_define_verify_sdna(1);
+}
+
 void RNA_def_render(BlenderRNA *brna)
 {
 	rna_def_render_engine(brna);
@@ -908,6 +1014,7 @@ void RNA_def_render(BlenderRNA *brna)
 	rna_def_render_layer(brna);
 	rna_def_render_pass(brna);
 	rna_def_render_bake_pixel(brna);
+	rna_def_render_bake_job(brna);
 }
 
 #endif /* RNA_RUNTIME */
@@ -59,6 +59,11 @@ EnumPropertyItem rna_enum_abc_compression_items[] = {
 
 #ifdef RNA_RUNTIME
 
+#include "MEM_guardedalloc.h"
+
+#include "BLI_listbase.h"
+#include "BLI_math_base.h"
+
 #include "BKE_animsys.h"
 #include "BKE_depsgraph.h"
 #include "BKE_editmesh.h"
@@ -107,6 +112,41 @@ static void rna_Scene_frame_set(Scene *scene, int frame, float subframe)
 	}
 }
 
+static void rna_Scene_frame_set_ids(Scene *scene, int frame, CollectionListBase ids, float subframe)
+{
+	double cfra = (double)frame + (double)subframe;
+	CollectionPointerLink *link;
+	ID **id_array;
+	int num_ids = 0;
+
+	id_array = MEM_mallocN(sizeof(*id_array) * max_ii(BLI_listbase_count((ListBase *)&ids), 1), __func__);
+	for (link = ids.first; link; link = link->next) {
+		if (link->ptr.data && RNA_struct_is_ID(link->ptr.type)) {
+			id_array[num_ids++] = link->ptr.data;
+		}
+	}
+
+	CLAMP(cfra, MINAFRAME, MAXFRAME);
+	BKE_scene_frame_set(scene, cfra);
+
+#ifdef WITH_PYTHON
+	BPy_BEGIN_ALLOW_THREADS;
+#endif
+
+	BKE_scene_update_ids_for_newframe(G.main->eval_ctx, G.main, scene, (1 << 20) - 1, id_array, num_ids);
+
+#ifdef WITH_PYTHON
+	BPy_END_ALLOW_THREADS;
+#endif
+
+	MEM_freeN(id_array);
+
+	if (!G.is_rendering) {
+		/* see rna_Scene_frame_set */
+		WM_main_add_notifier(NC_WINDOW, NULL);
+	}
+}
+
 static void rna_Scene_uvedit_aspect(Scene *scene, Object *ob, float *aspect)
 {
 	if ((ob->type == OB_MESH) && (ob->mode == OB_MODE_EDIT)) {
@@ -308,6 +348,15 @@ void RNA_api_scene(StructRNA *srna)
 	RNA_def_parameter_flags(parm, 0, PARM_REQUIRED);
 	RNA_def_float(func, "subframe", 0.0, 0.0, 1.0, "", "Sub-frame time, between 0.0 and 1.0", 0.0, 1.0);
 
+	func = RNA_def_function(srna, "frame_set_ids", "rna_Scene_frame_set_ids");
+	RNA_def_function_ui_description(func, "Set scene frame updating only the given datablocks and what they depend on, "
+	                                "the rest of the scene is updated by the next update");
+	parm = RNA_def_int(func, "frame", 0, MINAFRAME, MAXFRAME, "", "Frame number to set", MINAFRAME, MAXFRAME);
+	RNA_def_parameter_flags(parm, 0, PARM_REQUIRED);
+	parm = RNA_def_collection(func, "ids", "ID", "", "Datablocks to bring up to date");
+	RNA_def_parameter_flags(parm, 0, PARM_REQUIRED);
+	RNA_def_float(func, "subframe", 0.0, 0.0, 1.0, "", "Sub-frame time, between 0.0 and 1.0", 0.0, 1.0);
+
 	func = RNA_def_function(srna, "update", "rna_Scene_update_tagged");
 	RNA_def_function_ui_description(func,
 	                                "Update data tagged to be updated from previous access to data or operators");
@@ -43,6 +43,7 @@
 #include "BLI_string.h"
 
 
+#include "BKE_armature.h"
 #include "BKE_cdderivedmesh.h"
 #include "BKE_lattice.h"
 #include "BKE_library_query.h"
@@ -73,6 +74,27 @@ static void copyData(ModifierData *md, ModifierData *target)
 	BLI_strncpy(tamd->defgrp_name, amd->defgrp_name, sizeof(tamd->defgrp_name));
 }
 
+static void freeData(ModifierData *md)
+{
+	ArmatureModifierData *amd = (ArmatureModifierData *) md;
+
+	BKE_armature_skin_cache_free(amd->skin_cache);
+	amd->skin_cache = NULL;
+}
+
+/* render and orco evaluations deform other data, don't let them trash the cache,
+ * virtual modifiers (armature parenting) are temporary copies which are never freed */
+static struct ArmatureSkinCache **armature_skin_cache_get(ModifierData *md, ModifierApplyFlag flag)
+{
+	ArmatureModifierData *amd = (ArmatureModifierData *) md;
+
+	if ((flag & (MOD_APPLY_RENDER | MOD_APPLY_ORCO)) || (md->mode & eModifierMode_Virtual)) {
+		return NULL;
+	}
+
+	return &amd->skin_cache;
+}
+
 static CustomDataMask requiredDataMask(Object *UNUSED(ob), ModifierData *UNUSED(md))
 {
 	CustomDataMask dataMask = 0;
@@ -132,14 +154,15 @@ static void deformVerts(ModifierData *md, Object *ob,
                         DerivedMesh *derivedData,
                         float (*vertexCos)[3],
                         int numVerts,
-                        ModifierApplyFlag UNUSED(flag))
+                        ModifierApplyFlag flag)
 {
 	ArmatureModifierData *amd = (ArmatureModifierData *) md;
 
 	modifier_vgroup_cache(md, vertexCos); /* if next modifier needs original vertices */
 	
-	armature_deform_verts(amd->object, ob, derivedData, vertexCos, NULL,
-	                      numVerts, amd->deformflag, (float(*)[3])amd->prevCos, amd->defgrp_name);
+	armature_deform_verts_ex(amd->object, ob, derivedData, vertexCos, NULL,
+	                         numVerts, amd->deformflag, (float(*)[3])amd->prevCos, amd->defgrp_name,
+	                         armature_skin_cache_get(md, flag));
 
 	/* free cache */
 	if (amd->prevCos) {
@@ -159,8 +182,9 @@ static void deformVertsEM(
 
 	modifier_vgroup_cache(md, vertexCos); /* if next modifier needs original vertices */
 
-	armature_deform_verts(amd->object, ob, dm, vertexCos, NULL,
-	                      numVerts, amd->deformflag, (float(*)[3])amd->prevCos, amd->defgrp_name);
+	armature_deform_verts_ex(amd->object, ob, dm, vertexCos, NULL,
+	                         numVerts, amd->deformflag, (float(*)[3])amd->prevCos, amd->defgrp_name,
+	                         armature_skin_cache_get(md, 0));
 
 	/* free cache */
 	if (amd->prevCos) {
@@ -219,7 +243,7 @@ ModifierTypeInfo modifierType_Armature = {
 	/* applyModifierEM */   NULL,
 	/* initData */          initData,
 	/* requiredDataMask */  requiredDataMask,
-	/* freeData */          NULL,
+	/* freeData */          freeData,
 	/* isDisabled */        isDisabled,
 	/* updateDepgraph */    updateDepgraph,
 	/* updateDepsgraph */   updateDepsgraph,
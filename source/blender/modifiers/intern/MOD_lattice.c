@@ -56,12 +56,19 @@ static void initData(ModifierData *md)
 
 static void copyData(ModifierData *md, ModifierData *target)
 {
-#if 0
-	LatticeModifierData *lmd = (LatticeModifierData *) md;
 	LatticeModifierData *tlmd = (LatticeModifierData *) target;
-#endif
 
 	modifier_copyData_generic(md, target);
+
+	tlmd->cache = NULL;
+}
+
+static void freeData(ModifierData *md)
+{
+	LatticeModifierData *lmd = (LatticeModifierData *) md;
+
+	BKE_lattice_deform_cache_free(lmd->cache);
+	lmd->cache = NULL;
 }
 
 static CustomDataMask requiredDataMask(Object *UNUSED(ob), ModifierData *md)
@@ -125,15 +132,20 @@ static void deformVerts(ModifierData *md, Object *ob,
                         DerivedMesh *derivedData,
                         float (*vertexCos)[3],
                         int numVerts,
-                        ModifierApplyFlag UNUSED(flag))
+                        ModifierApplyFlag flag)
 {
 	LatticeModifierData *lmd = (LatticeModifierData *) md;
+	/* render and orco evaluations deform other coordinates, don't let them trash the cache,
+	 * virtual modifiers (lattice parenting) are temporary copies which are never freed */
+	const bool use_cache = ((flag & (MOD_APPLY_RENDER | MOD_APPLY_ORCO)) == 0 &&
+	                        (md->mode & eModifierMode_Virtual) == 0);
 
 
 	modifier_vgroup_cache(md, vertexCos); /* if next modifier needs original vertices */
 	
-	lattice_deform_verts(lmd->object, ob, derivedData,
-	                     vertexCos, numVerts, lmd->name, lmd->strength);
+	lattice_deform_verts_ex(lmd->object, ob, derivedData,
+	                        vertexCos, numVerts, lmd->name, lmd->strength,
+	                        use_cache ? &lmd->cache : NULL);
 }
 
 static void deformVertsEM(
@@ -167,7 +179,7 @@ ModifierTypeInfo modifierType_Lattice = {
 	/* applyModifierEM */   NULL,
 	/* initData */          initData,
 	/* requiredDataMask */  requiredDataMask,
-	/* freeData */          NULL,
+	/* freeData */          freeData,
 	/* isDisabled */        isDisabled,
 	/* updateDepgraph */    updateDepgraph,
 	/* updateDepsgraph */   updateDepsgraph,
@@ -56,6 +56,16 @@ typedef struct BakePixel {
 	float dv_dx, dv_dy;
 } BakePixel;
 
+/* pixels of one object to be baked by the render engine, the jobs of a
+ * bake are handed over together so the engine can sync the scene once */
+typedef struct BakeJob {
+	struct Object *object;
+	int object_id;
+	int num_pixels;
+	const BakePixel *pixel_array;
+	float *result;
+} BakeJob;
+
 typedef struct BakeHighPolyData {
 	struct Object *ob;
 	struct ModifierData *tri_mod;
@@ -73,6 +83,9 @@ bool RE_bake_has_engine(struct Render *re);
 bool RE_bake_engine(
         struct Render *re, struct Object *object, const int object_id, const BakePixel pixel_array[],
         const size_t num_pixels, const int depth, const ScenePassType pass_type, const int pass_filter, float result[]);
+bool RE_bake_engine_multi(
+        struct Render *re, const BakeJob jobs[], const int num_jobs,
+        const int depth, const ScenePassType pass_type, const int pass_filter);
 
 /* bake.c */
 int RE_pass_depth(const ScenePassType pass_type);
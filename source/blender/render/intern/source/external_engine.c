@@ -68,7 +68,7 @@
 static RenderEngineType internal_render_type = {
 	NULL, NULL,
 	"BLENDER_RENDER", N_("Blender Render"), RE_INTERNAL,
-	NULL, NULL, NULL, NULL, NULL, NULL,
+	NULL, NULL, NULL, NULL, NULL, NULL, NULL,
 	{NULL, NULL, NULL}
 };
 
@@ -77,7 +77,7 @@ static RenderEngineType internal_render_type = {
 static RenderEngineType internal_game_type = {
 	NULL, NULL,
 	"BLENDER_GAME", N_("Blender Game"), RE_INTERNAL | RE_GAME,
-	NULL, NULL, NULL, NULL, NULL, NULL,
+	NULL, NULL, NULL, NULL, NULL, NULL, NULL,
 	{NULL, NULL, NULL}
 };
 
@@ -485,14 +485,10 @@ bool RE_bake_has_engine(Render *re)
 	return (type->bake != NULL);
 }
 
-bool RE_bake_engine(
-        Render *re, Object *object,
-        const int object_id, const BakePixel pixel_array[],
-        const size_t num_pixels, const int depth,
-        const ScenePassType pass_type, const int pass_filter,
-        float result[])
+static void engine_bake_jobs(
+        Render *re, RenderEngineType *type, const BakeJob jobs[], const int num_jobs,
+        const int depth, const ScenePassType pass_type, const int pass_filter)
 {
-	RenderEngineType *type = RE_engines_find(re->r.engine);
 	RenderEngine *engine;
 	bool persistent_data = (re->r.mode & R_PERSISTENT_DATA) != 0;
 
@@ -525,8 +521,13 @@ bool RE_bake_engine(
 	if (type->update)
 		type->update(engine, re->main, re->scene);
 
-	if (type->bake)
-		type->bake(engine, re->scene, object, pass_type, pass_filter, object_id, pixel_array, num_pixels, depth, result);
+	if (num_jobs > 1) {
+		type->bake_multi(engine, re->scene, jobs, num_jobs, pass_type, pass_filter, depth);
+	}
+	else if (type->bake) {
+		type->bake(engine, re->scene, jobs[0].object, pass_type, pass_filter, jobs[0].object_id,
+		           jobs[0].pixel_array, jobs[0].num_pixels, depth, jobs[0].result);
+	}
 
 	engine->tile_x = 0;
 	engine->tile_y = 0;
@@ -545,6 +546,42 @@ bool RE_bake_engine(
 
 	if (BKE_reports_contain(re->reports, RPT_ERROR))
 		G.is_break = true;
+}
+
+bool RE_bake_engine(
+        Render *re, Object *object,
+        const int object_id, const BakePixel pixel_array[],
+        const size_t num_pixels, const int depth,
+        const ScenePassType pass_type, const int pass_filter,
+        float result[])
+{
+	BakeJob job;
+
+	job.object = object;
+	job.object_id = object_id;
+	job.num_pixels = (int)num_pixels;
+	job.pixel_array = pixel_array;
+	job.result = result;
+
+	return RE_bake_engine_multi(re, &job, 1, depth, pass_type, pass_filter);
+}
+
+bool RE_bake_engine_multi(
+        Render *re, const BakeJob jobs[], const int num_jobs,
+        const int depth, const ScenePassType pass_type, const int pass_filter)
+{
+	RenderEngineType *type = RE_engines_find(re->r.engine);
+	int i;
+
+	/* engines which can bake all jobs with a single scene sync get them at once,
+	 * others sync the scene for every job */
+	if (type->bake_multi) {
+		engine_bake_jobs(re, type, jobs, num_jobs, depth, pass_type, pass_filter);
+	}
+	else {
+		for (i = 0; i < num_jobs; i++)
+			engine_bake_jobs(re, type, &jobs[i], 1, depth, pass_type, pass_filter);
+	}
 
 	return true;
 }
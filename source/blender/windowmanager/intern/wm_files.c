@@ -89,6 +89,7 @@
 
 #include "BLO_readfile.h"
 #include "BLO_writefile.h"
+#include "BLO_undofile.h"
 
 #include "RNA_access.h"
 #include "RNA_define.h"
@@ -372,6 +373,9 @@ static int wm_read_exotic(const char *name)
 	if (len > 0 && ELEM(name[len - 1], '/', '\\')) {
 		retval = BKE_READ_EXOTIC_FAIL_PATH;
 	}
+	else if (BLO_has_chunked_header(name)) {
+		retval = BKE_READ_EXOTIC_OK_BLEND;
+	}
 	else {
 		gzfile = BLI_gzopen(name, "rb");
 		if (gzfile == NULL) {
@@ -1055,6 +1059,8 @@ static int wm_file_write(bContext *C, const char *filepath, int fileflags, Repor
 		}
 
 		BKE_BIT_TEST_SET(G.fileflags, fileflags & G_FILE_COMPRESS, G_FILE_COMPRESS);
+		BKE_BIT_TEST_SET(G.fileflags, fileflags & G_FILE_COMPRESS_CHUNKED, G_FILE_COMPRESS_CHUNKED);
+		BKE_BIT_TEST_SET(G.fileflags, fileflags & G_FILE_KEYS_SPARSE, G_FILE_KEYS_SPARSE);
 		BKE_BIT_TEST_SET(G.fileflags, fileflags & G_FILE_AUTOPLAY, G_FILE_AUTOPLAY);
 
 		/* prevent background mode scripts from clobbering history */
@@ -1131,11 +1137,57 @@ void WM_autosave_init(wmWindowManager *wm)
 		wm->autosavetimer = WM_event_add_timer(wm, NULL, TIMERAUTOSAVE, U.savetime * 60.0);
 }
 
+/* Autosave only takes a snapshot of the file in memory,
+ * writing it to disk is done in a job, so the UI doesn't hang on slow drives. */
+typedef struct AutosaveJob {
+	MemFile memfile;
+	char filepath[FILE_MAX];
+} AutosaveJob;
+
+/* Held while the job writes and renames the file, so wm_autosave_delete() can't run in between. */
+static ThreadMutex autosave_lock = BLI_MUTEX_INITIALIZER;
+
+static void wm_autosave_job_startjob(
+        void *customdata, short *UNUSED(stop), short *UNUSED(do_update), float *UNUSED(progress))
+{
+	AutosaveJob *asj = customdata;
+	char tempname[FILE_MAX + 1];
+
+	/* the job is not stopped on exit, a partial file would be of no use */
+
+	/* write to a temporary file, so a previous autosave isn't lost in case we crash */
+	BLI_snprintf(tempname, sizeof(tempname), "%s@", asj->filepath);
+
+	BLI_mutex_lock(&autosave_lock);
+
+	if (BLO_memfile_write_file(&asj->memfile, tempname)) {
+		if (BLI_rename(tempname, asj->filepath) != 0) {
+			fprintf(stderr, "Unable to save '%s': %s\n",
+			        asj->filepath, errno ? strerror(errno) : "Unknown error renaming file");
+		}
+	}
+	else {
+		BLI_delete(tempname, false, false);
+	}
+
+	BLI_mutex_unlock(&autosave_lock);
+}
+
+static void wm_autosave_job_free(void *customdata)
+{
+	AutosaveJob *asj = customdata;
+
+	BLO_memfile_free(&asj->memfile);
+	MEM_freeN(asj);
+}
+
 void wm_autosave_timer(const bContext *C, wmWindowManager *wm, wmTimer *UNUSED(wt))
 {
 	wmWindow *win;
 	wmEventHandler *handler;
-	char filepath[FILE_MAX];
+	AutosaveJob *asj;
+	wmJob *wm_job;
+	bool ok;
 	
 	WM_event_remove_timer(wm, NULL, wm->autosavetimer);
 
@@ -1152,11 +1204,21 @@ void wm_autosave_timer(const bContext *C, wmWindowManager *wm, wmTimer *UNUSED(w
 		}
 	}
 
-	wm_autosave_location(filepath);
+	/* previous auto-save still being written (slow drive), try again in 10 seconds too */
+	if (WM_jobs_test(wm, wm, WM_JOB_TYPE_AUTOSAVE)) {
+		wm->autosavetimer = WM_event_add_timer(wm, NULL, TIMERAUTOSAVE, 10.0);
+		if (G.debug) {
+			printf("Skipping auto-save, previous auto-save still running, retrying in ten seconds...\n");
+		}
+		return;
+	}
+
+	asj = MEM_callocN(sizeof(*asj), "AutosaveJob");
+	wm_autosave_location(asj->filepath);
 
 	if (U.uiflag & USER_GLOBALUNDO) {
-		/* fast save of last undobuffer, now with UI */
-		BKE_undo_save_file(filepath);
+		/* fast copy of last undobuffer, now with UI */
+		ok = BKE_undo_copy_memfile(&asj->memfile);
 	}
 	else {
 		/*  save as regular blend file */
@@ -1164,10 +1226,20 @@ void wm_autosave_timer(const bContext *C, wmWindowManager *wm, wmTimer *UNUSED(w
 
 		ED_editors_flush_edits(C, false);
 
-		/* Error reporting into console */
-		BLO_write_file(CTX_data_main(C), filepath, fileflags, NULL, NULL);
+		ok = BLO_write_file_snapshot(CTX_data_main(C), &asj->memfile, fileflags);
+	}
+
+	if (ok) {
+		wm_job = WM_jobs_get(wm, NULL, wm, "Auto-Save", 0, WM_JOB_TYPE_AUTOSAVE);
+		WM_jobs_customdata_set(wm_job, asj, wm_autosave_job_free);
+		WM_jobs_timer(wm_job, 0.5, 0, 0);
+		WM_jobs_callbacks(wm_job, wm_autosave_job_startjob, NULL, NULL, NULL);
+		WM_jobs_start(wm, wm_job);
 	}
-	/* do timer after file write, just in case file write takes a long time */
+	else {
+		wm_autosave_job_free(asj);
+	}
+
 	wm->autosavetimer = WM_event_add_timer(wm, NULL, TIMERAUTOSAVE, U.savetime * 60.0);
 }
 
@@ -1185,6 +1257,9 @@ void wm_autosave_delete(void)
 	
 	wm_autosave_location(filename);
 
+	/* wait for a running auto-save, it would write the file again after it's deleted */
+	BLI_mutex_lock(&autosave_lock);
+
 	if (BLI_exists(filename)) {
 		char str[FILE_MAX];
 		BLI_make_file_string("/", str, BKE_tempdir_base(), BLENDER_QUIT_FILE);
@@ -1193,6 +1268,8 @@ void wm_autosave_delete(void)
 		if (U.uiflag & USER_GLOBALUNDO) BLI_delete(filename, false, false);
 		else BLI_rename(filename, str);
 	}
+
+	BLI_mutex_unlock(&autosave_lock);
 }
 
 void wm_autosave_read(bContext *C, ReportList *reports)
@@ -1794,6 +1871,20 @@ static void save_set_compress(wmOperator *op)
 			RNA_property_boolean_set(op->ptr, prop, (U.flag & USER_FILECOMPRESS) != 0);
 		}
 	}
+
+	prop = RNA_struct_find_property(op->ptr, "compress_chunked");
+	if (!RNA_property_is_set(op->ptr, prop)) {
+		if (G.save_over) {  /* keep flag for existing file */
+			RNA_property_boolean_set(op->ptr, prop, (G.fileflags & G_FILE_COMPRESS_CHUNKED) != 0);
+		}
+	}
+
+	prop = RNA_struct_find_property(op->ptr, "sparse_shape_keys");
+	if (!RNA_property_is_set(op->ptr, prop)) {
+		if (G.save_over) {  /* keep flag for existing file */
+			RNA_property_boolean_set(op->ptr, prop, (G.fileflags & G_FILE_KEYS_SPARSE) != 0);
+		}
+	}
 }
 
 static void save_set_filepath(wmOperator *op)
@@ -1849,6 +1940,10 @@ static int wm_save_as_mainfile_exec(bContext *C, wmOperator *op)
 	/* set compression flag */
 	BKE_BIT_TEST_SET(fileflags, RNA_boolean_get(op->ptr, "compress"),
 	                 G_FILE_COMPRESS);
+	BKE_BIT_TEST_SET(fileflags, RNA_boolean_get(op->ptr, "compress_chunked"),
+	                 G_FILE_COMPRESS_CHUNKED);
+	BKE_BIT_TEST_SET(fileflags, RNA_boolean_get(op->ptr, "sparse_shape_keys"),
+	                 G_FILE_KEYS_SPARSE);
 	BKE_BIT_TEST_SET(fileflags, RNA_boolean_get(op->ptr, "relative_remap"),
 	                 G_FILE_RELATIVE_REMAP);
 	BKE_BIT_TEST_SET(fileflags,
@@ -1905,6 +2000,12 @@ void WM_OT_save_as_mainfile(wmOperatorType *ot)
 	        ot, FILE_TYPE_FOLDER | FILE_TYPE_BLENDER, FILE_BLENDER, FILE_SAVE,
 	        WM_FILESEL_FILEPATH, FILE_DEFAULTDISPLAY, FILE_SORT_ALPHA);
 	RNA_def_boolean(ot->srna, "compress", false, "Compress", "Write compressed .blend file");
+	RNA_def_boolean(ot->srna, "compress_chunked", false, "Chunked Compression",
+	                "Compress in chunks using multiple threads, faster to save and load "
+	                "(not readable by older Blender versions)");
+	RNA_def_boolean(ot->srna, "sparse_shape_keys", false, "Sparse Shape Keys",
+	                "Only save the vertices mesh shape keys move, smaller files "
+	                "(older Blender versions load these shape keys empty)");
 	RNA_def_boolean(ot->srna, "relative_remap", true, "Remap Relative",
 	                "Remap relative paths when saving in a different directory");
 	prop = RNA_def_boolean(ot->srna, "copy", false, "Save Copy",
@@ -1971,6 +2072,12 @@ void WM_OT_save_mainfile(wmOperatorType *ot)
 	        ot, FILE_TYPE_FOLDER | FILE_TYPE_BLENDER, FILE_BLENDER, FILE_SAVE,
 	        WM_FILESEL_FILEPATH, FILE_DEFAULTDISPLAY, FILE_SORT_ALPHA);
 	RNA_def_boolean(ot->srna, "compress", false, "Compress", "Write compressed .blend file");
+	RNA_def_boolean(ot->srna, "compress_chunked", false, "Chunked Compression",
+	                "Compress in chunks using multiple threads, faster to save and load "
+	                "(not readable by older Blender versions)");
+	RNA_def_boolean(ot->srna, "sparse_shape_keys", false, "Sparse Shape Keys",
+	                "Only save the vertices mesh shape keys move, smaller files "
+	                "(older Blender versions load these shape keys empty)");
 	RNA_def_boolean(ot->srna, "relative_remap", false, "Remap Relative",
 	                "Remap relative paths when saving in a different directory");
 }
@@ -478,7 +478,8 @@ void WM_jobs_kill_all(wmWindowManager *wm)
 	
 }
 
-/* wait until every job ended, except for one owner (used in undo to keep screen job alive) */
+/* wait until every job ended, except for one owner (used in undo to keep screen job alive)
+ * and auto-save, which only writes its own copy of the file and can't be stopped halfway */
 void WM_jobs_kill_all_except(wmWindowManager *wm, void *owner)
 {
 	wmJob *wm_job, *next_job;
@@ -486,7 +487,7 @@ void WM_jobs_kill_all_except(wmWindowManager *wm, void *owner)
 	for (wm_job = wm->jobs.first; wm_job; wm_job = next_job) {
 		next_job = wm_job->next;
 
-		if (wm_job->owner != owner)
+		if (wm_job->owner != owner && wm_job->job_type != WM_JOB_TYPE_AUTOSAVE)
 			wm_jobs_kill_job(wm, wm_job);
 	}
 }
@@ -0,0 +1,389 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+#include "BLI_ressource_strings.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_ghash.h"
+#include "BLI_flathash.h"
+#include "BLI_rand.h"
+#include "BLI_string.h"
+#include "PIL_time.h"
+}
+
+/* Compares FlatHash against GHash, running the same operations on both. */
+
+/* Run the longest tests! */
+//#define FLATHASH_RUN_BIG
+
+/* Size of 'small case' hashes (number of entries). */
+#define TESTCASE_SIZE_SMALL 17
+
+#define TIMEIT_COMPARE_START(var) \
+	{ \
+		double _timeit_##var = PIL_check_seconds_timer(); \
+		{
+
+#define TIMEIT_COMPARE_END(var, name) \
+		} \
+		var = PIL_check_seconds_timer() - _timeit_##var; \
+		printf("  %-24s %-9s %.6f s\n", #var, name, var); \
+	} (void)0
+
+#define PRINTF_COMPARE(_id, _t_ghash, _t_flathash) \
+	printf("%s: FlatHash is %.2fx the speed of GHash\n", _id, (_t_ghash) / MAX2(_t_flathash, 1e-9))
+
+/* Str: whole text, lines and words from the 'words10k' text. */
+
+static void str_split_words(char *data, char ***r_words, unsigned int *r_words_len)
+{
+	unsigned int words_len = 0, words_alloc = 1024;
+	char **words = (char **)MEM_mallocN(sizeof(*words) * words_alloc, __func__);
+	char *c, *w;
+
+	for (w = c = data; *c; c++) {
+		if (ELEM(*c, ' ', '.')) {
+			*c = '\0';
+			if (words_len == words_alloc) {
+				words_alloc *= 2;
+				words = (char **)MEM_reallocN(words, sizeof(*words) * words_alloc);
+			}
+			words[words_len++] = w;
+			w = c + 1;
+		}
+	}
+
+	*r_words = words;
+	*r_words_len = words_len;
+}
+
+static void str_compare_tests(const char *id)
+{
+	printf("\n========== STARTING %s ==========\n", id);
+
+	char *data = BLI_strdup(words10k);
+	char *data_lookup = BLI_strdup(words10k);
+	char **words, **words_lookup;
+	unsigned int words_len, i;
+	double str_insert_ghash, str_insert_flathash, str_lookup_ghash, str_lookup_flathash;
+
+	str_split_words(data, &words, &words_len);
+	str_split_words(data_lookup, &words_lookup, &words_len);
+
+	GHash *ghash = BLI_ghash_str_new(__func__);
+	FlatHash *flathash = BLI_flathash_str_new(__func__);
+
+	TIMEIT_COMPARE_START(str_insert_ghash)
+	{
+		for (i = 0; i < words_len; i++) {
+			void **val;
+			if (!BLI_ghash_ensure_p(ghash, words[i], &val)) {
+				*val = words[i];
+			}
+		}
+	}
+	TIMEIT_COMPARE_END(str_insert_ghash, "GHash");
+
+	TIMEIT_COMPARE_START(str_insert_flathash)
+	{
+		for (i = 0; i < words_len; i++) {
+			void **val;
+			if (!BLI_flathash_ensure_p(flathash, words[i], &val)) {
+				*val = words[i];
+			}
+		}
+	}
+	TIMEIT_COMPARE_END(str_insert_flathash, "FlatHash");
+
+	EXPECT_EQ(BLI_ghash_size(ghash), BLI_flathash_size(flathash));
+
+	/* Lookups use other pointers than the keys, so comparing isn't shortcut. */
+	TIMEIT_COMPARE_START(str_lookup_ghash)
+	{
+		for (i = 0; i < words_len; i++) {
+			const char *v = (const char *)BLI_ghash_lookup(ghash, words_lookup[i]);
+			EXPECT_STREQ(words_lookup[i], v);
+		}
+	}
+	TIMEIT_COMPARE_END(str_lookup_ghash, "GHash");
+
+	TIMEIT_COMPARE_START(str_lookup_flathash)
+	{
+		for (i = 0; i < words_len; i++) {
+			const char *v = (const char *)BLI_flathash_lookup(flathash, words_lookup[i]);
+			EXPECT_STREQ(words_lookup[i], v);
+		}
+	}
+	TIMEIT_COMPARE_END(str_lookup_flathash, "FlatHash");
+
+	PRINTF_COMPARE("insert", str_insert_ghash, str_insert_flathash);
+	PRINTF_COMPARE("lookup", str_lookup_ghash, str_lookup_flathash);
+
+	BLI_ghash_free(ghash, NULL, NULL);
+	BLI_flathash_free(flathash, NULL, NULL);
+	MEM_freeN(words);
+	MEM_freeN(words_lookup);
+	MEM_freeN(data);
+	MEM_freeN(data_lookup);
+
+	printf("========== ENDED %s ==========\n\n", id);
+}
+
+TEST(flathash, TextCompare)
+{
+	str_compare_tests("Str - GHash vs FlatHash");
+}
+
+/* Int: random integers, insert, lookup (hit and miss) and remove. */
+
+static void randint_compare_tests(
+        GHashHashFP hashfp, const char *id, const unsigned int nbr, const bool use_reserve)
+{
+	printf("\n========== STARTING %s ==========\n", id);
+
+	unsigned int *data = (unsigned int *)MEM_mallocN(sizeof(*data) * (size_t)nbr * 2, __func__);
+	unsigned int *data_miss = data + nbr;
+	unsigned int i;
+	double int_insert_ghash, int_insert_flathash;
+	double int_lookup_ghash, int_lookup_flathash;
+	double int_miss_ghash, int_miss_flathash;
+	double int_remove_ghash, int_remove_flathash;
+
+	{
+		RNG *rng = BLI_rng_new(0);
+		for (i = 0; i < nbr * 2; i++) {
+			/* Even keys are inserted, odd ones are missing. */
+			data[i] = (BLI_rng_get_uint(rng) & ~1u) | (i >= nbr ? 1u : 0u);
+		}
+		BLI_rng_free(rng);
+	}
+
+	GHash *ghash = BLI_ghash_new_ex(hashfp, BLI_ghashutil_intcmp, __func__, use_reserve ? nbr : 0);
+	FlatHash *flathash = BLI_flathash_new_ex(hashfp, BLI_ghashutil_intcmp, __func__, use_reserve ? nbr : 0);
+
+	TIMEIT_COMPARE_START(int_insert_ghash)
+	{
+		for (i = 0; i < nbr; i++) {
+			BLI_ghash_reinsert(ghash, SET_UINT_IN_POINTER(data[i]), SET_UINT_IN_POINTER(data[i]), NULL, NULL);
+		}
+	}
+	TIMEIT_COMPARE_END(int_insert_ghash, "GHash");
+
+	TIMEIT_COMPARE_START(int_insert_flathash)
+	{
+		for (i = 0; i < nbr; i++) {
+			BLI_flathash_reinsert(flathash, SET_UINT_IN_POINTER(data[i]), SET_UINT_IN_POINTER(data[i]), NULL, NULL);
+		}
+	}
+	TIMEIT_COMPARE_END(int_insert_flathash, "FlatHash");
+
+	EXPECT_EQ(BLI_ghash_size(ghash), BLI_flathash_size(flathash));
+
+	TIMEIT_COMPARE_START(int_lookup_ghash)
+	{
+		for (i = 0; i < nbr; i++) {
+			void *v = BLI_ghash_lookup(ghash, SET_UINT_IN_POINTER(data[i]));
+			EXPECT_EQ(data[i], GET_UINT_FROM_POINTER(v));
+		}
+	}
+	TIMEIT_COMPARE_END(int_lookup_ghash, "GHash");
+
+	TIMEIT_COMPARE_START(int_lookup_flathash)
+	{
+		for (i = 0; i < nbr; i++) {
+			void *v = BLI_flathash_lookup(flathash, SET_UINT_IN_POINTER(data[i]));
+			EXPECT_EQ(data[i], GET_UINT_FROM_POINTER(v));
+		}
+	}
+	TIMEIT_COMPARE_END(int_lookup_flathash, "FlatHash");
+
+	TIMEIT_COMPARE_START(int_miss_ghash)
+	{
+		for (i = 0; i < nbr; i++) {
+			EXPECT_FALSE(BLI_ghash_haskey(ghash, SET_UINT_IN_POINTER(data_miss[i])));
+		}
+	}
+	TIMEIT_COMPARE_END(int_miss_ghash, "GHash");
+
+	TIMEIT_COMPARE_START(int_miss_flathash)
+	{
+		for (i = 0; i < nbr; i++) {
+			EXPECT_FALSE(BLI_flathash_haskey(flathash, SET_UINT_IN_POINTER(data_miss[i])));
+		}
+	}
+	TIMEIT_COMPARE_END(int_miss_flathash, "FlatHash");
+
+	TIMEIT_COMPARE_START(int_remove_ghash)
+	{
+		for (i = 0; i < nbr; i++) {
+			BLI_ghash_remove(ghash, SET_UINT_IN_POINTER(data[i]), NULL, NULL);
+		}
+	}
+	TIMEIT_COMPARE_END(int_remove_ghash, "GHash");
+
+	TIMEIT_COMPARE_START(int_remove_flathash)
+	{
+		for (i = 0; i < nbr; i++) {
+			BLI_flathash_remove(flathash, SET_UINT_IN_POINTER(data[i]), NULL, NULL);
+		}
+	}
+	TIMEIT_COMPARE_END(int_remove_flathash, "FlatHash");
+
+	EXPECT_EQ(0, BLI_ghash_size(ghash));
+	EXPECT_EQ(0, BLI_flathash_size(flathash));
+
+	PRINTF_COMPARE("insert", int_insert_ghash, int_insert_flathash);
+	PRINTF_COMPARE("lookup", int_lookup_ghash, int_lookup_flathash);
+	PRINTF_COMPARE("lookup (missing)", int_miss_ghash, int_miss_flathash);
+	PRINTF_COMPARE("remove", int_remove_ghash, int_remove_flathash);
+
+	BLI_ghash_free(ghash, NULL, NULL);
+	BLI_flathash_free(flathash, NULL, NULL);
+	MEM_freeN(data);
+
+	printf("========== ENDED %s ==========\n\n", id);
+}
+
+TEST(flathash, IntRandCompare100000)
+{
+	randint_compare_tests(BLI_ghashutil_inthash_p, "RandInt - 100000", 100000, false);
+}
+
+TEST(flathash, IntRandCompareReserve100000)
+{
+	randint_compare_tests(BLI_ghashutil_inthash_p, "RandInt - Reserved - 100000", 100000, true);
+}
+
+TEST(flathash, IntRandCompareSimple100000)
+{
+	randint_compare_tests(BLI_ghashutil_inthash_p_simple, "RandInt - No Hash - 100000", 100000, false);
+}
+
+#ifdef FLATHASH_RUN_BIG
+TEST(flathash, IntRandCompare10000000)
+{
+	randint_compare_tests(BLI_ghashutil_inthash_p, "RandInt - 10000000", 10000000, false);
+}
+#endif
+
+/* Ptr: pointers to allocated memory, as most Blender hashes use (e.g. ID or BMesh element pointers). */
+
+static void ptr_compare_tests(const char *id, const unsigned int nbr)
+{
+	printf("\n========== STARTING %s ==========\n", id);
+
+	/* 16 bytes per element, as a BMVert-like array would be. */
+	char *elems = (char *)MEM_mallocN((size_t)nbr * 16, __func__);
+	unsigned int i;
+	double ptr_insert_ghash, ptr_insert_flathash, ptr_lookup_ghash, ptr_lookup_flathash;
+
+	GSet *gset = BLI_gset_ptr_new(__func__);
+	FlatSet *flatset = BLI_flatset_ptr_new(__func__);
+
+	TIMEIT_COMPARE_START(ptr_insert_ghash)
+	{
+		for (i = 0; i < nbr; i++) {
+			BLI_gset_add(gset, &elems[i * 16]);
+		}
+	}
+	TIMEIT_COMPARE_END(ptr_insert_ghash, "GSet");
+
+	TIMEIT_COMPARE_START(ptr_insert_flathash)
+	{
+		for (i = 0; i < nbr; i++) {
+			BLI_flatset_add(flatset, &elems[i * 16]);
+		}
+	}
+	TIMEIT_COMPARE_END(ptr_insert_flathash, "FlatSet");
+
+	TIMEIT_COMPARE_START(ptr_lookup_ghash)
+	{
+		for (i = 0; i < nbr; i++) {
+			EXPECT_TRUE(BLI_gset_haskey(gset, &elems[((i * 7919) % nbr) * 16]));
+		}
+	}
+	TIMEIT_COMPARE_END(ptr_lookup_ghash, "GSet");
+
+	TIMEIT_COMPARE_START(ptr_lookup_flathash)
+	{
+		for (i = 0; i < nbr; i++) {
+			EXPECT_TRUE(BLI_flatset_haskey(flatset, &elems[((i * 7919) % nbr) * 16]));
+		}
+	}
+	TIMEIT_COMPARE_END(ptr_lookup_flathash, "FlatSet");
+
+	PRINTF_COMPARE("insert", ptr_insert_ghash, ptr_insert_flathash);
+	PRINTF_COMPARE("lookup", ptr_lookup_ghash, ptr_lookup_flathash);
+
+	BLI_gset_free(gset, NULL);
+	BLI_flatset_free(flatset, NULL);
+	MEM_freeN(elems);
+
+	printf("========== ENDED %s ==========\n\n", id);
+}
+
+TEST(flathash, PtrSetCompare100000)
+{
+	ptr_compare_tests("PtrSet - 100000", 100000);
+}
+
+/* MultiSmall: create and manipulate a lot of very small hashes (90% < 10 items, 9% < 100 items, 1% < 1000 items). */
+
+static void multi_small_compare_tests(const char *id, const unsigned int nbr)
+{
+	printf("\n========== STARTING %s ==========\n", id);
+
+	GHash *ghash = BLI_ghash_int_new(__func__);
+	FlatHash *flathash = BLI_flathash_int_new(__func__);
+	unsigned int data[TESTCASE_SIZE_SMALL * 100];
+	double multi_small_ghash = 0.0, multi_small_flathash = 0.0;
+	RNG *rng = BLI_rng_new(0);
+	unsigned int i, j;
+
+	for (i = nbr; i--; ) {
+		const unsigned int len = 1 + (BLI_rng_get_uint(rng) % TESTCASE_SIZE_SMALL) *
+		                         (!(i % 100) ? 100 : (!(i % 10) ? 10 : 1));
+		double t;
+
+		for (j = 0; j < len; j++) {
+			data[j] = BLI_rng_get_uint(rng);
+		}
+
+		t = PIL_check_seconds_timer();
+		for (j = 0; j < len; j++) {
+			BLI_ghash_reinsert(ghash, SET_UINT_IN_POINTER(data[j]), SET_UINT_IN_POINTER(data[j]), NULL, NULL);
+		}
+		for (j = 0; j < len; j++) {
+			EXPECT_EQ(data[j], GET_UINT_FROM_POINTER(BLI_ghash_lookup(ghash, SET_UINT_IN_POINTER(data[j]))));
+		}
+		BLI_ghash_clear(ghash, NULL, NULL);
+		multi_small_ghash += PIL_check_seconds_timer() - t;
+
+		t = PIL_check_seconds_timer();
+		for (j = 0; j < len; j++) {
+			BLI_flathash_reinsert(flathash, SET_UINT_IN_POINTER(data[j]), SET_UINT_IN_POINTER(data[j]), NULL, NULL);
+		}
+		for (j = 0; j < len; j++) {
+			EXPECT_EQ(data[j], GET_UINT_FROM_POINTER(BLI_flathash_lookup(flathash, SET_UINT_IN_POINTER(data[j]))));
+		}
+		BLI_flathash_clear(flathash, NULL, NULL);
+		multi_small_flathash += PIL_check_seconds_timer() - t;
+	}
+
+	printf("  %-24s %-9s %.6f s\n", "multi_small_ghash", "GHash", multi_small_ghash);
+	printf("  %-24s %-9s %.6f s\n", "multi_small_flathash", "FlatHash", multi_small_flathash);
+	PRINTF_COMPARE("multi small", multi_small_ghash, multi_small_flathash);
+
+	BLI_ghash_free(ghash, NULL, NULL);
+	BLI_flathash_free(flathash, NULL, NULL);
+	BLI_rng_free(rng);
+
+	printf("========== ENDED %s ==========\n\n", id);
+}
+
+TEST(flathash, MultiSmallCompare20000)
+{
+	multi_small_compare_tests("MultiSmall RandInt - 20000", 20000);
+}
@@ -0,0 +1,252 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "BLI_utildefines.h"
+#include "BLI_flathash.h"
+#include "BLI_rand.h"
+#include "BLI_string.h"
+}
+
+#define TESTCASE_SIZE 10000
+
+/* Note: as for GHash tests, nature of the keys and data have no importance,
+ *       so here we just use unique random integers stored in pointers. */
+
+static void init_keys(unsigned int keys[TESTCASE_SIZE], const int seed)
+{
+	RNG *rng = BLI_rng_new(seed);
+	GSet *keys_set = BLI_gset_new(BLI_ghashutil_inthash_p, BLI_ghashutil_intcmp, __func__);
+	int i;
+
+	for (i = 0; i < TESTCASE_SIZE; ) {
+		const unsigned int k = BLI_rng_get_uint(rng);
+		if (BLI_gset_add(keys_set, SET_UINT_IN_POINTER(k))) {
+			keys[i++] = k;
+		}
+	}
+	BLI_gset_free(keys_set, NULL);
+	BLI_rng_free(rng);
+}
+
+/* Here we simply insert and then lookup all keys, ensuring we do get back the expected stored 'data'. */
+TEST(flathash, InsertLookup)
+{
+	FlatHash *fh = BLI_flathash_new(BLI_ghashutil_inthash_p, BLI_ghashutil_intcmp, __func__);
+	unsigned int keys[TESTCASE_SIZE], *k;
+	int i;
+
+	init_keys(keys, 0);
+
+	for (i = TESTCASE_SIZE, k = keys; i--; k++) {
+		BLI_flathash_insert(fh, SET_UINT_IN_POINTER(*k), SET_UINT_IN_POINTER(*k));
+	}
+
+	EXPECT_EQ(TESTCASE_SIZE, BLI_flathash_size(fh));
+
+	for (i = TESTCASE_SIZE, k = keys; i--; k++) {
+		void *v = BLI_flathash_lookup(fh, SET_UINT_IN_POINTER(*k));
+		EXPECT_EQ(*k, GET_UINT_FROM_POINTER(v));
+	}
+
+	BLI_flathash_free(fh, NULL, NULL);
+}
+
+/* Insert and remove all keys, then insert them again (reusing deleted slots). */
+TEST(flathash, InsertRemove)
+{
+	FlatHash *fh = BLI_flathash_new(BLI_ghashutil_inthash_p, BLI_ghashutil_intcmp, __func__);
+	unsigned int keys[TESTCASE_SIZE], *k;
+	int i, pass;
+
+	init_keys(keys, 10);
+
+	for (pass = 0; pass < 3; pass++) {
+		for (i = TESTCASE_SIZE, k = keys; i--; k++) {
+			BLI_flathash_insert(fh, SET_UINT_IN_POINTER(*k), SET_UINT_IN_POINTER(*k));
+		}
+
+		EXPECT_EQ(TESTCASE_SIZE, BLI_flathash_size(fh));
+
+		for (i = TESTCASE_SIZE, k = keys; i--; k++) {
+			void *v = BLI_flathash_popkey(fh, SET_UINT_IN_POINTER(*k), NULL);
+			EXPECT_EQ(*k, GET_UINT_FROM_POINTER(v));
+		}
+
+		EXPECT_EQ(0, BLI_flathash_size(fh));
+	}
+
+	BLI_flathash_free(fh, NULL, NULL);
+}
+
+/* Keep the table at a constant size while replacing its content, many deleted slots are created. */
+TEST(flathash, RemoveInsertChurn)
+{
+	FlatHash *fh = BLI_flathash_new(BLI_ghashutil_inthash_p, BLI_ghashutil_intcmp, __func__);
+	unsigned int keys[TESTCASE_SIZE];
+	const int window = 100;
+	int i;
+
+	init_keys(keys, 20);
+
+	for (i = 0; i < TESTCASE_SIZE; i++) {
+		BLI_flathash_insert(fh, SET_UINT_IN_POINTER(keys[i]), SET_UINT_IN_POINTER(i));
+		if (i >= window) {
+			EXPECT_TRUE(BLI_flathash_remove(fh, SET_UINT_IN_POINTER(keys[i - window]), NULL, NULL));
+		}
+	}
+
+	EXPECT_EQ(window, BLI_flathash_size(fh));
+
+	for (i = 0; i < TESTCASE_SIZE; i++) {
+		void **v = BLI_flathash_lookup_p(fh, SET_UINT_IN_POINTER(keys[i]));
+		if (i < TESTCASE_SIZE - window) {
+			EXPECT_EQ(NULL, v);
+		}
+		else {
+			ASSERT_NE((void **)NULL, v);
+			EXPECT_EQ(i, GET_INT_FROM_POINTER(*v));
+		}
+	}
+
+	BLI_flathash_free(fh, NULL, NULL);
+}
+
+TEST(flathash, EnsureReinsert)
+{
+	FlatHash *fh = BLI_flathash_new(BLI_ghashutil_inthash_p, BLI_ghashutil_intcmp, __func__);
+	unsigned int keys[TESTCASE_SIZE], *k;
+	int i;
+
+	init_keys(keys, 30);
+
+	for (i = TESTCASE_SIZE, k = keys; i--; k++) {
+		void **val;
+		EXPECT_FALSE(BLI_flathash_ensure_p(fh, SET_UINT_IN_POINTER(*k), &val));
+		*val = SET_UINT_IN_POINTER(*k);
+	}
+	for (i = TESTCASE_SIZE, k = keys; i--; k++) {
+		void **val;
+		EXPECT_TRUE(BLI_flathash_ensure_p(fh, SET_UINT_IN_POINTER(*k), &val));
+		EXPECT_EQ(*k, GET_UINT_FROM_POINTER(*val));
+		EXPECT_FALSE(BLI_flathash_reinsert(fh, SET_UINT_IN_POINTER(*k), SET_UINT_IN_POINTER(*k + 1), NULL, NULL));
+	}
+
+	EXPECT_EQ(TESTCASE_SIZE, BLI_flathash_size(fh));
+
+	for (i = TESTCASE_SIZE, k = keys; i--; k++) {
+		void *v = BLI_flathash_lookup(fh, SET_UINT_IN_POINTER(*k));
+		EXPECT_EQ(*k + 1, GET_UINT_FROM_POINTER(v));
+	}
+
+	BLI_flathash_free(fh, NULL, NULL);
+}
+
+/* Check copy. */
+TEST(flathash, Copy)
+{
+	FlatHash *fh = BLI_flathash_new(BLI_ghashutil_inthash_p, BLI_ghashutil_intcmp, __func__);
+	FlatHash *fh_copy;
+	unsigned int keys[TESTCASE_SIZE], *k;
+	int i;
+
+	init_keys(keys, 40);
+
+	for (i = TESTCASE_SIZE, k = keys; i--; k++) {
+		BLI_flathash_insert(fh, SET_UINT_IN_POINTER(*k), SET_UINT_IN_POINTER(*k));
+	}
+
+	fh_copy = BLI_flathash_copy(fh, NULL, NULL);
+
+	EXPECT_EQ(TESTCASE_SIZE, BLI_flathash_size(fh_copy));
+
+	for (i = TESTCASE_SIZE, k = keys; i--; k++) {
+		void *v = BLI_flathash_lookup(fh_copy, SET_UINT_IN_POINTER(*k));
+		EXPECT_EQ(*k, GET_UINT_FROM_POINTER(v));
+	}
+
+	BLI_flathash_free(fh, NULL, NULL);
+	BLI_flathash_free(fh_copy, NULL, NULL);
+}
+
+/* Check pop and iteration. */
+TEST(flathash, PopIter)
+{
+	FlatHash *fh = BLI_flathash_new(BLI_ghashutil_inthash_p, BLI_ghashutil_intcmp, __func__);
+	FlatHashIterator fh_iter;
+	FlatHashIterState pop_state = {0};
+	unsigned int keys[TESTCASE_SIZE], *k;
+	void *k_p, *v_p;
+	int i;
+
+	init_keys(keys, 50);
+
+	for (i = TESTCASE_SIZE, k = keys; i--; k++) {
+		BLI_flathash_insert(fh, SET_UINT_IN_POINTER(*k), SET_UINT_IN_POINTER(*k));
+	}
+
+	FLATHASH_ITER_INDEX (fh_iter, fh, i) {
+		EXPECT_EQ(BLI_flathashIterator_getKey(&fh_iter), BLI_flathashIterator_getValue(&fh_iter));
+	}
+	EXPECT_EQ(TESTCASE_SIZE, i);
+
+	for (i = TESTCASE_SIZE / 2; i--; ) {
+		EXPECT_TRUE(BLI_flathash_pop(fh, &pop_state, &k_p, &v_p));
+		EXPECT_EQ(k_p, v_p);
+	}
+
+	EXPECT_EQ(TESTCASE_SIZE - TESTCASE_SIZE / 2, BLI_flathash_size(fh));
+
+	/* Popping from a changed hash restarts from the state, all keys are still found. */
+	for (i = TESTCASE_SIZE / 2, k = keys; i--; k++) {
+		BLI_flathash_reinsert(fh, SET_UINT_IN_POINTER(*k), SET_UINT_IN_POINTER(*k), NULL, NULL);
+	}
+	pop_state.curr_slot = 0;
+
+	while (BLI_flathash_pop(fh, &pop_state, &k_p, &v_p)) {
+		EXPECT_EQ(k_p, v_p);
+	}
+
+	EXPECT_EQ(0, BLI_flathash_size(fh));
+
+	BLI_flathash_free(fh, NULL, NULL);
+}
+
+/* Set API with string keys. */
+TEST(flathash, SetStr)
+{
+	FlatSet *fs = BLI_flatset_str_new(__func__);
+	FlatSetIterator fs_iter;
+	const char *strings[] = {"Suzanne", "Cube", "Plane", "Circle", "UVSphere", "IcoSphere", "Cylinder", "Cone"};
+	char buf[32];
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(strings); i++) {
+		EXPECT_TRUE(BLI_flatset_add(fs, (void *)strings[i]));
+	}
+	for (i = 0; i < ARRAY_SIZE(strings); i++) {
+		/* Different pointer, same string. */
+		BLI_strncpy(buf, strings[i], sizeof(buf));
+		EXPECT_TRUE(BLI_flatset_haskey(fs, buf));
+		EXPECT_FALSE(BLI_flatset_add(fs, buf));
+	}
+	EXPECT_FALSE(BLI_flatset_haskey(fs, "Torus"));
+
+	i = 0;
+	FLATSET_ITER (fs_iter, fs) {
+		i++;
+	}
+	EXPECT_EQ(ARRAY_SIZE(strings), i);
+	EXPECT_EQ(ARRAY_SIZE(strings), BLI_flatset_size(fs));
+
+	EXPECT_TRUE(BLI_flatset_remove(fs, "Cube", NULL));
+	EXPECT_FALSE(BLI_flatset_remove(fs, "Cube", NULL));
+	EXPECT_EQ(ARRAY_SIZE(strings) - 1, BLI_flatset_size(fs));
+
+	BLI_flatset_clear(fs, NULL);
+	EXPECT_EQ(0, BLI_flatset_size(fs));
+	EXPECT_FALSE(BLI_flatset_haskey(fs, "Suzanne"));
+
+	BLI_flatset_free(fs, NULL);
+}
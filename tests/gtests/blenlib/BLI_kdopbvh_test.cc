@@ -0,0 +1,161 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "BLI_compiler_attrs.h"
+#include "BLI_kdopbvh.h"
+#include "BLI_rand.h"
+#include "BLI_math_vector.h"
+#include "BLI_threads.h"
+#include "MEM_guardedalloc.h"
+}
+
+#define POINTS_NUM 10000
+#define QUERIES_NUM 2000
+#define SPHERE_RADIUS 0.01f
+
+static void rng_points_init(RNG *rng, float (*points)[3], const int points_num)
+{
+	for (int i = 0; i < points_num; i++) {
+		BLI_rng_get_float_unit_v3(rng, points[i]);
+		mul_v3_fl(points[i], BLI_rng_get_float(rng));
+	}
+}
+
+static BVHTree *bvhtree_points_new(const float (*points)[3], const int points_num, const float epsilon)
+{
+	BVHTree *tree = BLI_bvhtree_new(points_num, epsilon, 4, 6);
+	for (int i = 0; i < points_num; i++) {
+		BLI_bvhtree_insert(tree, i, points[i], 1);
+	}
+	BLI_bvhtree_balance(tree);
+	return tree;
+}
+
+static void nearest_point_cb(void *userdata, int index, const float co[3], BVHTreeNearest *nearest)
+{
+	const float (*points)[3] = (const float (*)[3])userdata;
+	const float dist_sq = len_squared_v3v3(co, points[index]);
+	if (dist_sq < nearest->dist_sq) {
+		nearest->index = index;
+		nearest->dist_sq = dist_sq;
+		copy_v3_v3(nearest->co, points[index]);
+	}
+}
+
+static void raycast_sphere_cb(void *userdata, int index, const BVHTreeRay *ray, BVHTreeRayHit *hit)
+{
+	const float (*points)[3] = (const float (*)[3])userdata;
+	float to_center[3];
+	sub_v3_v3v3(to_center, points[index], ray->origin);
+	const float t_center = dot_v3v3(to_center, ray->direction);
+	const float dist_sq = len_squared_v3(to_center) - t_center * t_center;
+	if (dist_sq < SPHERE_RADIUS * SPHERE_RADIUS) {
+		const float dist = t_center - sqrtf(SPHERE_RADIUS * SPHERE_RADIUS - dist_sq);
+		if (dist >= 0.0f && dist < hit->dist) {
+			hit->index = index;
+			hit->dist = dist;
+			madd_v3_v3v3fl(hit->co, ray->origin, ray->direction, dist);
+		}
+	}
+}
+
+/* The tree is built in parallel, check it against brute force. */
+TEST(kdopbvh, FindNearestBatch)
+{
+	BLI_threadapi_init();
+	RNG *rng = BLI_rng_new(0);
+	float (*points)[3] = (float (*)[3])MEM_mallocN(sizeof(*points) * POINTS_NUM, __func__);
+	float (*co)[3] = (float (*)[3])MEM_mallocN(sizeof(*co) * QUERIES_NUM, __func__);
+	BVHTreeNearest *nearest = (BVHTreeNearest *)MEM_mallocN(sizeof(*nearest) * QUERIES_NUM, __func__);
+
+	rng_points_init(rng, points, POINTS_NUM);
+	rng_points_init(rng, co, QUERIES_NUM);
+	BVHTree *tree = bvhtree_points_new(points, POINTS_NUM, 0.0f);
+
+	for (int i = 0; i < QUERIES_NUM; i++) {
+		nearest[i].index = -1;
+		nearest[i].dist_sq = FLT_MAX;
+	}
+	BLI_bvhtree_find_nearest_batch(tree, co, nearest, QUERIES_NUM, nearest_point_cb, points);
+
+	for (int i = 0; i < QUERIES_NUM; i++) {
+		int index_best = -1;
+		float dist_sq_best = FLT_MAX;
+		for (int j = 0; j < POINTS_NUM; j++) {
+			const float dist_sq = len_squared_v3v3(co[i], points[j]);
+			if (dist_sq < dist_sq_best) {
+				dist_sq_best = dist_sq;
+				index_best = j;
+			}
+		}
+		EXPECT_EQ(index_best, nearest[i].index);
+		EXPECT_EQ(dist_sq_best, nearest[i].dist_sq);
+	}
+
+	BLI_bvhtree_free(tree);
+	MEM_freeN(points);
+	MEM_freeN(co);
+	MEM_freeN(nearest);
+	BLI_rng_free(rng);
+	BLI_threadapi_exit();
+}
+
+static void raycast_batch_test(const bool use_callback)
+{
+	BLI_threadapi_init();
+	RNG *rng = BLI_rng_new(1);
+	float (*points)[3] = (float (*)[3])MEM_mallocN(sizeof(*points) * POINTS_NUM, __func__);
+	float (*co)[3] = (float (*)[3])MEM_mallocN(sizeof(*co) * QUERIES_NUM, __func__);
+	float (*dir)[3] = (float (*)[3])MEM_mallocN(sizeof(*dir) * QUERIES_NUM, __func__);
+	BVHTreeRayHit *hits = (BVHTreeRayHit *)MEM_mallocN(sizeof(*hits) * QUERIES_NUM, __func__);
+
+	rng_points_init(rng, points, POINTS_NUM);
+	BVHTree *tree = bvhtree_points_new(points, POINTS_NUM, SPHERE_RADIUS);
+
+	/* rays from outside the points, aimed around some of them */
+	for (int i = 0; i < QUERIES_NUM; i++) {
+		float target[3];
+		BLI_rng_get_float_unit_v3(rng, co[i]);
+		mul_v3_fl(co[i], 2.0f);
+		madd_v3_v3v3fl(target, points[i], co[i], 0.005f * BLI_rng_get_float(rng));
+		sub_v3_v3v3(dir[i], target, co[i]);
+		normalize_v3(dir[i]);
+		hits[i].index = -1;
+		hits[i].dist = BVH_RAYCAST_DIST_MAX;
+	}
+
+	BVHTree_RayCastCallback callback = use_callback ? raycast_sphere_cb : NULL;
+	BLI_bvhtree_ray_cast_batch(tree, co, dir, 0.0f, hits, QUERIES_NUM, callback, points, BVH_RAYCAST_DEFAULT);
+
+	int hits_num = 0;
+	for (int i = 0; i < QUERIES_NUM; i++) {
+		BVHTreeRayHit hit;
+		hit.index = -1;
+		hit.dist = BVH_RAYCAST_DIST_MAX;
+		BLI_bvhtree_ray_cast_ex(tree, co[i], dir[i], 0.0f, &hit, callback, points, BVH_RAYCAST_DEFAULT);
+		EXPECT_EQ(hit.index, hits[i].index);
+		EXPECT_EQ(hit.dist, hits[i].dist);
+		hits_num += (hits[i].index != -1);
+	}
+	EXPECT_GT(hits_num, QUERIES_NUM / 2);
+
+	BLI_bvhtree_free(tree);
+	MEM_freeN(points);
+	MEM_freeN(co);
+	MEM_freeN(dir);
+	MEM_freeN(hits);
+	BLI_rng_free(rng);
+	BLI_threadapi_exit();
+}
+
+TEST(kdopbvh, RayCastBatch)
+{
+	raycast_batch_test(false);
+}
+
+TEST(kdopbvh, RayCastBatchCallback)
+{
+	raycast_batch_test(true);
+}
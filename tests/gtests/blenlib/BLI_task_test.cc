@@ -0,0 +1,191 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "BLI_task.h"
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+
+#include "atomic_ops.h"
+};
+
+#define NUM_THREADS 4
+#define NUM_TASKS 10000
+
+static void task_count_run(TaskPool *__restrict pool, void *UNUSED(taskdata), int UNUSED(threadid))
+{
+	size_t *counter = (size_t *)BLI_task_pool_userdata(pool);
+	atomic_add_and_fetch_z(counter, 1);
+}
+
+static void task_spawn_run(TaskPool *__restrict pool, void *UNUSED(taskdata), int threadid)
+{
+	for (int i = 0; i < 10; i++) {
+		BLI_task_pool_push_from_thread(pool, task_count_run, NULL, false, TASK_PRIORITY_HIGH, threadid);
+	}
+	task_count_run(pool, NULL, threadid);
+}
+
+static void test_pool_push(const bool use_thread_affinity)
+{
+	BLI_threadapi_init();
+	TaskScheduler *scheduler = BLI_task_scheduler_create_ex(NUM_THREADS, use_thread_affinity);
+	size_t counter = 0;
+
+	TaskPool *pool = BLI_task_pool_create(scheduler, &counter);
+	for (int i = 0; i < NUM_TASKS; i++) {
+		BLI_task_pool_push(pool, task_count_run, NULL, false, TASK_PRIORITY_LOW);
+	}
+	BLI_task_pool_work_and_wait(pool);
+	EXPECT_EQ(counter, NUM_TASKS);
+	EXPECT_EQ(BLI_task_pool_tasks_done(pool), NUM_TASKS);
+	BLI_task_pool_free(pool);
+
+	BLI_task_scheduler_free(scheduler);
+	BLI_threadapi_exit();
+}
+
+TEST(task, PoolPush)
+{
+	test_pool_push(false);
+}
+
+TEST(task, PoolPushThreadAffinity)
+{
+	test_pool_push(true);
+}
+
+TEST(task, PoolPushFromThread)
+{
+	BLI_threadapi_init();
+	TaskScheduler *scheduler = BLI_task_scheduler_create(NUM_THREADS);
+	size_t counter = 0;
+
+	TaskPool *pool = BLI_task_pool_create(scheduler, &counter);
+	for (int i = 0; i < NUM_TASKS / 10; i++) {
+		BLI_task_pool_push(pool, task_spawn_run, NULL, false, TASK_PRIORITY_LOW);
+	}
+	BLI_task_pool_work_and_wait(pool);
+	EXPECT_EQ(counter, NUM_TASKS / 10 * 11);
+	BLI_task_pool_free(pool);
+
+	BLI_task_scheduler_free(scheduler);
+	BLI_threadapi_exit();
+}
+
+TEST(task, PoolSingleThread)
+{
+	BLI_threadapi_init();
+	TaskScheduler *scheduler = BLI_task_scheduler_create(TASK_SCHEDULER_SINGLE_THREAD);
+	size_t counter = 0;
+
+	TaskPool *pool = BLI_task_pool_create(scheduler, &counter);
+	for (int i = 0; i < NUM_TASKS; i++) {
+		BLI_task_pool_push(pool, task_count_run, NULL, false, TASK_PRIORITY_LOW);
+	}
+	BLI_task_pool_work_and_wait(pool);
+	EXPECT_EQ(counter, NUM_TASKS);
+	BLI_task_pool_free(pool);
+
+	BLI_task_scheduler_free(scheduler);
+	BLI_threadapi_exit();
+}
+
+/* Priority */
+
+#define NUM_PRIORITY_TASKS 100
+
+typedef struct PriorityData {
+	int order[NUM_PRIORITY_TASKS];
+	int order_index;
+} PriorityData;
+
+static void task_priority_run(TaskPool *__restrict pool, void *taskdata, int UNUSED(threadid))
+{
+	PriorityData *data = (PriorityData *)BLI_task_pool_userdata(pool);
+	data->order[data->order_index++] = (int)(intptr_t)taskdata;
+}
+
+TEST(task, PriorityOrder)
+{
+	BLI_threadapi_init();
+	/* no worker thread runs the pool, so the order is only decided by the queues */
+	TaskScheduler *scheduler = BLI_task_scheduler_create(TASK_SCHEDULER_SINGLE_THREAD);
+	PriorityData data = {{0}, 0};
+
+	TaskPool *pool = BLI_task_pool_create(scheduler, &data);
+	for (int i = 0; i < NUM_PRIORITY_TASKS; i++) {
+		BLI_task_pool_push(pool, task_priority_run, (void *)(intptr_t)i, false,
+		                   (i % 2) ? TASK_PRIORITY_HIGH : TASK_PRIORITY_LOW);
+	}
+	BLI_task_pool_work_and_wait(pool);
+
+	/* high priority tasks first, the one pushed last first */
+	EXPECT_EQ(data.order_index, NUM_PRIORITY_TASKS);
+	for (int i = 0; i < NUM_PRIORITY_TASKS / 2; i++) {
+		EXPECT_EQ(data.order[i], NUM_PRIORITY_TASKS - 1 - i * 2);
+	}
+	BLI_task_pool_free(pool);
+
+	BLI_task_scheduler_free(scheduler);
+	BLI_threadapi_exit();
+}
+
+/* Dependencies */
+
+#define NUM_LAYERS 50
+#define LAYER_SIZE 20
+
+typedef struct DependencyData {
+	/* order in which the task ran */
+	unsigned int *order;
+	unsigned int order_index;
+} DependencyData;
+
+static void task_order_run(TaskPool *__restrict pool, void *taskdata, int UNUSED(threadid))
+{
+	DependencyData *data = (DependencyData *)BLI_task_pool_userdata(pool);
+	const unsigned int index = (unsigned int)(intptr_t)taskdata;
+	data->order[index] = atomic_fetch_and_add_u(&data->order_index, 1);
+}
+
+TEST(task, Dependencies)
+{
+	BLI_threadapi_init();
+	TaskScheduler *scheduler = BLI_task_scheduler_create(NUM_THREADS);
+	unsigned int order[NUM_LAYERS * LAYER_SIZE];
+	DependencyData data = {order, 0};
+	Task *tasks[NUM_LAYERS * LAYER_SIZE];
+
+	TaskPool *pool = BLI_task_pool_create(scheduler, &data);
+
+	/* every task depends on two tasks of the previous layer */
+	for (int i = 0; i < NUM_LAYERS * LAYER_SIZE; i++) {
+		tasks[i] = BLI_task_pool_create_task(
+		        pool, task_order_run, (void *)(intptr_t)i, false, NULL, TASK_PRIORITY_LOW);
+		if (i >= LAYER_SIZE) {
+			const int layer_start = (i / LAYER_SIZE - 1) * LAYER_SIZE;
+			BLI_task_add_dependency(tasks[i], tasks[i - LAYER_SIZE]);
+			BLI_task_add_dependency(tasks[i], tasks[layer_start + (i * 7) % LAYER_SIZE]);
+		}
+	}
+	/* submit in reverse order, so tasks are never runnable right away */
+	for (int i = NUM_LAYERS * LAYER_SIZE - 1; i >= 0; i--) {
+		BLI_task_submit(tasks[i]);
+	}
+
+	BLI_task_pool_work_and_wait(pool);
+
+	EXPECT_EQ(data.order_index, NUM_LAYERS * LAYER_SIZE);
+	for (int i = LAYER_SIZE; i < NUM_LAYERS * LAYER_SIZE; i++) {
+		const int layer_start = (i / LAYER_SIZE - 1) * LAYER_SIZE;
+		EXPECT_GT(order[i], order[i - LAYER_SIZE]);
+		EXPECT_GT(order[i], order[layer_start + (i * 7) % LAYER_SIZE]);
+	}
+
+	BLI_task_pool_free(pool);
+
+	BLI_task_scheduler_free(scheduler);
+	BLI_threadapi_exit();
+}
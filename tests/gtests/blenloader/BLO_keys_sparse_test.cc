@@ -0,0 +1,364 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <stdio.h>
+#include <string.h>
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+
+#include "DNA_genfile.h"
+#include "DNA_key_types.h"
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_sdna_types.h"
+
+#include "BLI_utildefines.h"
+#include "BLI_endian_switch.h"
+#include "BLI_listbase.h"
+#include "BLI_path_util.h"
+#include "BLI_threads.h"
+
+#include "BKE_appdir.h"
+#include "BKE_customdata.h"
+#include "BKE_global.h"
+#include "BKE_key.h"
+#include "BKE_library.h"
+#include "BKE_main.h"
+#include "BKE_mesh.h"
+
+#include "BLO_blend_defs.h"
+#include "BLO_readfile.h"
+#include "BLO_writefile.h"
+}
+
+#define TOT_VERT 64
+
+class KeysSparseTest : public testing::Test {
+protected:
+	static void SetUpTestCase()
+	{
+		BLI_threadapi_init();
+		DNA_sdna_current_init();
+		BKE_tempdir_init(NULL);
+	}
+
+	static void TearDownTestCase()
+	{
+		BKE_tempdir_session_purge();
+		DNA_sdna_current_free();
+		BLI_threadapi_exit();
+	}
+};
+
+static void keys_filepath(char *filepath, const char *name)
+{
+	BLI_join_dirfile(filepath, FILE_MAX, BKE_tempdir_session(), name);
+}
+
+static KeyBlock *keys_keyblock_add(Key *key, const char *name, const float (*refco)[3])
+{
+	KeyBlock *kb = BKE_keyblock_add(key, name);
+
+	kb->totelem = TOT_VERT;
+	kb->data = MEM_mallocN(sizeof(float[3]) * TOT_VERT, __func__);
+	memcpy(kb->data, refco, sizeof(float[3]) * TOT_VERT);
+	return kb;
+}
+
+/**
+ * A mesh key where the reference key isn't the first block,
+ * with keys saved sparse and keys which have to stay dense.
+ */
+static Main *keys_main_create(void)
+{
+	Main *bmain = BKE_main_new();
+	float refco[TOT_VERT][3];
+	float (*co)[3];
+	Mesh *me;
+	Key *key;
+	KeyBlock *kb;
+	int a;
+
+	for (a = 0; a < TOT_VERT; a++) {
+		refco[a][0] = (float)a;
+		refco[a][1] = (float)a * 0.5f;
+		refco[a][2] = -(float)a;
+	}
+
+	me = BKE_mesh_add(bmain, "Mesh");
+	me->totvert = TOT_VERT;
+	me->mvert = (MVert *)CustomData_add_layer(&me->vdata, CD_MVERT, CD_CALLOC, NULL, TOT_VERT);
+
+	/* BKE_key_add() adds to G.main */
+	G.main = bmain;
+	key = me->key = BKE_key_add(&me->id);
+	G.main = NULL;
+	key->type = KEY_RELATIVE;
+
+	/* a few vertices moved, 0.0 and -0.0 only differ bitwise */
+	kb = keys_keyblock_add(key, "Sparse", refco);
+	co = (float (*)[3])kb->data;
+	co[0][0] = -0.0f;
+	co[5][1] += 1.0f;
+	co[TOT_VERT - 1][2] -= 1.0f;
+
+	key->refkey = keys_keyblock_add(key, "Basis", refco);
+
+	/* every vertex moved */
+	kb = keys_keyblock_add(key, "Dense", refco);
+	co = (float (*)[3])kb->data;
+	for (a = 0; a < TOT_VERT; a++) {
+		co[a][2] += 2.0f;
+	}
+
+	/* equal to the reference key */
+	keys_keyblock_add(key, "Equal", refco);
+
+	/* the most vertices which are still saved sparse */
+	kb = keys_keyblock_add(key, "Half", refco);
+	co = (float (*)[3])kb->data;
+	for (a = 0; a < TOT_VERT; a += 2) {
+		co[a][0] *= 3.0f;
+	}
+
+	return bmain;
+}
+
+static void keys_compare(const Key *key, const Key *key_read)
+{
+	const KeyBlock *kb, *kb_read;
+
+	ASSERT_TRUE(key_read != NULL);
+	ASSERT_TRUE(key_read->refkey != NULL);
+	EXPECT_STREQ(key->refkey->name, key_read->refkey->name);
+	EXPECT_EQ(BLI_listbase_count(&key->block), BLI_listbase_count(&key_read->block));
+
+	for (kb = (const KeyBlock *)key->block.first, kb_read = (const KeyBlock *)key_read->block.first;
+	     kb && kb_read;
+	     kb = kb->next, kb_read = kb_read->next)
+	{
+		EXPECT_STREQ(kb->name, kb_read->name);
+		EXPECT_TRUE(kb_read->data_sparse == NULL);
+		EXPECT_EQ(0, kb_read->totsparse);
+		ASSERT_EQ(kb->totelem, kb_read->totelem);
+		ASSERT_TRUE(kb_read->data != NULL);
+		EXPECT_EQ(0, memcmp(kb->data, kb_read->data, sizeof(float[3]) * (size_t)kb->totelem));
+	}
+}
+
+static void keys_write_read_compare(Main *bmain, const char *filepath, const int write_flags)
+{
+	BlendFileData *bfd;
+
+	ASSERT_TRUE(BLO_write_file(bmain, filepath, write_flags, NULL, NULL));
+
+	bfd = BLO_read_from_file(filepath, NULL);
+	ASSERT_TRUE(bfd != NULL);
+	keys_compare((const Key *)bmain->key.first, (const Key *)bfd->main->key.first);
+	BLO_blendfiledata_free(bfd);
+}
+
+static char *blend_file_read(const char *filepath, size_t *r_len)
+{
+	FILE *fp = fopen(filepath, "rb");
+	char *buf = NULL;
+	long len;
+
+	if (fp == NULL) {
+		return NULL;
+	}
+	if ((fseek(fp, 0, SEEK_END) == 0) && ((len = ftell(fp)) > 0) && (fseek(fp, 0, SEEK_SET) == 0)) {
+		buf = (char *)MEM_mallocN((size_t)len, __func__);
+		if (fread(buf, 1, (size_t)len, fp) == (size_t)len) {
+			*r_len = (size_t)len;
+		}
+		else {
+			MEM_freeN(buf);
+			buf = NULL;
+		}
+	}
+	fclose(fp);
+	return buf;
+}
+
+static char *sdna_pad_up_4(char *data, char *cp)
+{
+	return data + ((cp - data + 3) & ~3);
+}
+
+/* the encoded SDNA, see DNA_sdna_from_data() */
+static void sdna_switch_endian(char *data)
+{
+	int nr_names, nr_types, nr_structs;
+	int *ip;
+	short *sp;
+	char *cp;
+	int a;
+
+	/* "SDNA" "NAME" */
+	ip = (int *)data + 2;
+	nr_names = *ip;
+	BLI_endian_switch_int32(ip);
+	cp = (char *)(ip + 1);
+	for (a = 0; a < nr_names; a++) {
+		cp += strlen(cp) + 1;
+	}
+
+	/* "TYPE" */
+	ip = (int *)sdna_pad_up_4(data, cp) + 1;
+	nr_types = *ip;
+	BLI_endian_switch_int32(ip);
+	cp = (char *)(ip + 1);
+	for (a = 0; a < nr_types; a++) {
+		cp += strlen(cp) + 1;
+	}
+
+	/* "TLEN" */
+	sp = (short *)((int *)sdna_pad_up_4(data, cp) + 1);
+	BLI_endian_switch_int16_array(sp, nr_types);
+	sp += nr_types;
+	if (nr_types & 1) {
+		sp++;
+	}
+
+	/* "STRC" */
+	ip = (int *)sp + 1;
+	nr_structs = *ip;
+	BLI_endian_switch_int32(ip);
+	sp = (short *)(ip + 1);
+	for (a = 0; a < nr_structs; a++) {
+		const int len = 2 + sp[1] * 2;
+		BLI_endian_switch_int16_array(sp, len);
+		sp += len;
+	}
+}
+
+static bool keys_is_data(const Key *key, const void *old)
+{
+	for (const KeyBlock *kb = (const KeyBlock *)key->block.first; kb; kb = kb->next) {
+		if (kb->data == old) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * Write \a filepath_src as if it was saved on a platform with the other endianness.
+ * Only structs, the SDNA and the (all 4 byte) shape key data are switched,
+ * which is all a file with only a mesh and its key contains.
+ */
+static bool blend_file_switch_endian(const char *filepath_src, const char *filepath_dst, const Key *key)
+{
+	const SDNA *sdna = DNA_sdna_current_get();
+	const size_t bhead_len = sizeof(int[4]) + sizeof(void *);
+	size_t len, ofs;
+	char *buf;
+	FILE *fp;
+	bool ok;
+
+	buf = blend_file_read(filepath_src, &len);
+	if (buf == NULL || len < 12 || !STREQLEN(buf, "BLENDER", 7)) {
+		MEM_SAFE_FREE(buf);
+		return false;
+	}
+	buf[8] = (buf[8] == 'v') ? 'V' : 'v';
+
+	for (ofs = 12; ofs + bhead_len <= len; ) {
+		char *bhead = buf + ofs;
+		char *data = bhead + bhead_len;
+		int code, data_len, SDNAnr, nr;
+		const void *old;
+
+		memcpy(&code, bhead, sizeof(int));
+		if (code == ENDB) {
+			break;
+		}
+		memcpy(&data_len, bhead + sizeof(int), sizeof(int));
+		memcpy(&old, bhead + sizeof(int[2]), sizeof(void *));
+		memcpy(&SDNAnr, bhead + sizeof(int[2]) + sizeof(void *), sizeof(int));
+		memcpy(&nr, bhead + sizeof(int[3]) + sizeof(void *), sizeof(int));
+
+		if (code == DNA1) {
+			sdna_switch_endian(data);
+		}
+		else if (SDNAnr != 0) {
+			const int struct_len = sdna->typelens[sdna->structs[SDNAnr][0]];
+			for (int a = 0; a < nr; a++) {
+				DNA_struct_switch_endian(sdna, SDNAnr, data + a * struct_len);
+			}
+		}
+		else if (keys_is_data(key, old)) {
+			BLI_endian_switch_int32_array((int *)data, data_len / 4);
+		}
+
+		/* two character ID codes are read from the upper half */
+		if ((code & 0xFFFF0000) == 0) {
+			code <<= 16;
+		}
+		memcpy(bhead, &code, sizeof(int));
+
+		/* block addresses are only switched when the pointer size differs,
+		 * the pointers inside structs are switched back to match them */
+		BLI_endian_switch_int32((int *)(bhead + sizeof(int)));
+		BLI_endian_switch_int32((int *)(bhead + sizeof(int[2]) + sizeof(void *)));
+		BLI_endian_switch_int32((int *)(bhead + sizeof(int[3]) + sizeof(void *)));
+
+		ofs += bhead_len + (size_t)data_len;
+	}
+
+	fp = fopen(filepath_dst, "wb");
+	ok = (fp != NULL) && (fwrite(buf, 1, len, fp) == len);
+	if (fp) {
+		ok = (fclose(fp) == 0) && ok;
+	}
+	MEM_freeN(buf);
+	return ok;
+}
+
+TEST_F(KeysSparseTest, WriteRead)
+{
+	Main *bmain = keys_main_create();
+	char filepath[FILE_MAX], filepath_dense[FILE_MAX];
+	size_t len, len_dense;
+	char *buf;
+
+	keys_filepath(filepath, "keys_sparse.blend");
+	keys_filepath(filepath_dense, "keys_dense.blend");
+
+	keys_write_read_compare(bmain, filepath, G_FILE_KEYS_SPARSE);
+	keys_write_read_compare(bmain, filepath_dense, 0);
+
+	/* sparse keys are only written when asked for */
+	buf = blend_file_read(filepath, &len);
+	ASSERT_TRUE(buf != NULL);
+	MEM_freeN(buf);
+	buf = blend_file_read(filepath_dense, &len_dense);
+	ASSERT_TRUE(buf != NULL);
+	MEM_freeN(buf);
+	EXPECT_LT(len, len_dense);
+
+	BKE_main_free(bmain);
+}
+
+TEST_F(KeysSparseTest, WriteReadSwitchEndian)
+{
+	Main *bmain = keys_main_create();
+	char filepath[FILE_MAX], filepath_switch[FILE_MAX];
+	BlendFileData *bfd;
+
+	keys_filepath(filepath, "keys_sparse_native.blend");
+	keys_filepath(filepath_switch, "keys_sparse_switch.blend");
+
+	ASSERT_TRUE(BLO_write_file(bmain, filepath, G_FILE_KEYS_SPARSE, NULL, NULL));
+	ASSERT_TRUE(blend_file_switch_endian(filepath, filepath_switch, (const Key *)bmain->key.first));
+
+	bfd = BLO_read_from_file(filepath_switch, NULL);
+	ASSERT_TRUE(bfd != NULL);
+	keys_compare((const Key *)bmain->key.first, (const Key *)bfd->main->key.first);
+	BLO_blendfiledata_free(bfd);
+
+	BKE_main_free(bmain);
+}